@@ -1,7 +1,7 @@
 #ifndef CPU_HPP
 #define CPU_HPP
 
-#include 
+#include <cstdint>
 
 namespace Arch {
 namespace x86_64 {
@@ -54,6 +54,90 @@ public:
     void shutdown();
 };
 
+// Where the executing logical processor sits, decoded from its x2APIC ID.
+// CPUID describes only the CPU it runs on, so topology discovery reads
+// this on each CPU in turn.
+struct TopologyIds {
+    uint32_t apicId = 0;
+    uint32_t coreId = 0;    // APIC ID without the SMT bits: equal for siblings
+    uint32_t l3Id = 0;      // APIC ID without the bits of CPUs sharing the L3
+    uint32_t packageId = 0;
+    bool hybrid = false;         // Mixed performance and efficiency cores
+    bool efficiencyCore = false; // An efficiency (Atom) core on a hybrid part
+};
+
+inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t& eax, uint32_t& ebx, uint32_t& ecx, uint32_t& edx) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile(
+        "cpuid"
+        : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+        : "a"(leaf), "c"(subleaf)
+    );
+#else
+    eax = ebx = ecx = edx = 0;
+#endif
+}
+
+inline uint32_t idShift(uint32_t sharing) {
+    uint32_t shift = 0;
+    while ((1u << shift) < sharing) shift++;
+    return shift;
+}
+
+inline TopologyIds readTopologyIds() {
+    TopologyIds ids;
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(0, 0, eax, ebx, ecx, edx);
+    uint32_t maxLeaf = eax;
+    bool amd = ebx == 0x68747541; // "Auth"enticAMD
+
+    // Extended topology enumeration (0x1F adds die levels to 0xB): the
+    // SMT level's shift strips siblings, the last level's the package
+    uint32_t smtShift = 0, packageShift = 0;
+    uint32_t leaf = maxLeaf >= 0x1F ? 0x1F : 0xB;
+    cpuid(leaf, 0, eax, ebx, ecx, edx);
+    if (maxLeaf >= 0xB && ebx != 0) {
+        ids.apicId = edx;
+        for (uint32_t level = 0; level < 8; level++) {
+            cpuid(leaf, level, eax, ebx, ecx, edx);
+            uint32_t type = (ecx >> 8) & 0xFF;
+            if (type == 0) break;
+            if (type == 1) smtShift = eax & 0x1F;
+            packageShift = eax & 0x1F;
+        }
+    } else {
+        cpuid(1, 0, eax, ebx, ecx, edx);
+        ids.apicId = ebx >> 24;
+        packageShift = idShift((ebx >> 16) & 0xFF);
+    }
+
+    // Deterministic cache parameters: how many IDs share the L3
+    uint32_t l3Shift = packageShift;
+    uint32_t cacheLeaf = amd ? 0x8000001D : 4;
+    cpuid(amd ? 0x80000000 : 0, 0, eax, ebx, ecx, edx);
+    if (eax >= cacheLeaf) {
+        for (uint32_t index = 0; index < 16; index++) {
+            cpuid(cacheLeaf, index, eax, ebx, ecx, edx);
+            if ((eax & 0x1F) == 0) break;
+            if (((eax >> 5) & 0x7) == 3) l3Shift = idShift(((eax >> 14) & 0xFFF) + 1);
+        }
+    }
+
+    if (maxLeaf >= 7) {
+        cpuid(7, 0, eax, ebx, ecx, edx);
+        ids.hybrid = (edx >> 15) & 1;
+    }
+    if (ids.hybrid && maxLeaf >= 0x1A) {
+        cpuid(0x1A, 0, eax, ebx, ecx, edx);
+        ids.efficiencyCore = (eax >> 24) == 0x20;
+    }
+
+    ids.coreId = ids.apicId >> smtShift;
+    ids.l3Id = ids.apicId >> l3Shift;
+    ids.packageId = ids.apicId >> packageShift;
+    return ids;
+}
+
 }} // namespace Arch::x86_64
 
 #endif
\ No newline at end of file
@@ -0,0 +1,448 @@
+#ifndef ASYNC_IO_ENGINE_HPP
+#define ASYNC_IO_ENGINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<liburing.h>)
+#include <liburing.h>
+#define KERNEL_VFS_IO_URING 1
+#endif
+
+namespace Kernel {
+namespace FileSystem {
+
+// Submission/completion engine for file reads. Requests are queued,
+// adjacent ranges on the same file are merged into one read, and the
+// merged reads are issued through io_uring when available or through a
+// pread worker pool otherwise. Files stay open between requests.
+class AsyncIOEngine {
+public:
+    struct ReadRequest {
+        std::string path;
+        size_t offset;
+        size_t length;
+    };
+
+    // result < 0 is -errno; otherwise data holds result bytes (short at EOF)
+    using Completion = std::function<void(ssize_t result, std::vector<char> data)>;
+
+    struct Stats {
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> submittedReads{0};
+        std::atomic<uint64_t> coalescedRequests{0};
+        std::atomic<uint64_t> handleOpens{0};
+    };
+
+    static constexpr size_t COALESCE_GAP = 4 * 1024;
+    static constexpr size_t MAX_COALESCED_BYTES = 1024 * 1024;
+    static constexpr size_t MAX_OPEN_HANDLES = 1024;
+
+    explicit AsyncIOEngine(size_t workerCount = 4, unsigned queueDepth = 256)
+        : queueDepth(queueDepth) {
+#ifdef KERNEL_VFS_IO_URING
+        useUring = io_uring_queue_init(queueDepth, &ring, 0) == 0;
+#endif
+        if (!useUring) {
+            for (size_t i = 0; i < std::max<size_t>(workerCount, 1); i++) {
+                workers.emplace_back([this]() { workerLoop(); });
+            }
+        }
+        dispatcher = std::thread([this]() { dispatchLoop(); });
+    }
+
+    ~AsyncIOEngine() {
+        // Drain the submission queue first so workers see every merged read
+        {
+            std::lock_guard lock(queueMutex);
+            running = false;
+        }
+        queueCV.notify_all();
+        if (dispatcher.joinable()) dispatcher.join();
+
+        {
+            std::lock_guard lock(workMutex);
+            workersRunning = false;
+        }
+        workCV.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+#ifdef KERNEL_VFS_IO_URING
+        if (useUring) io_uring_queue_exit(&ring);
+#endif
+    }
+
+    AsyncIOEngine(const AsyncIOEngine&) = delete;
+    AsyncIOEngine& operator=(const AsyncIOEngine&) = delete;
+
+    void readAsync(const std::string& path, size_t offset, size_t length,
+                   Completion completion) {
+        auto handle = acquireHandle(path);
+        if (!handle) {
+            completion(-errno, {});
+            return;
+        }
+        stats.requests++;
+        {
+            std::lock_guard lock(queueMutex);
+            pending.push_back({std::move(handle), offset, length, std::move(completion)});
+        }
+        queueCV.notify_one();
+    }
+
+    std::future<std::vector<char>> readAsync(const std::string& path, size_t offset,
+                                             size_t length) {
+        auto promise = std::make_shared<std::promise<std::vector<char>>>();
+        auto future = promise->get_future();
+        readAsync(path, offset, length, [promise](ssize_t result, std::vector<char> data) {
+            if (result < 0) {
+                promise->set_exception(std::make_exception_ptr(
+                    std::system_error(static_cast<int>(-result), std::generic_category())));
+            } else {
+                promise->set_value(std::move(data));
+            }
+        });
+        return future;
+    }
+
+    // Queues all requests under one lock so the dispatcher sees them together
+    // and can coalesce neighbouring ranges.
+    std::vector<std::future<std::vector<char>>> readBatch(
+            const std::vector<ReadRequest>& requests) {
+        std::vector<std::future<std::vector<char>>> futures;
+        std::vector<PendingRead> batch;
+        futures.reserve(requests.size());
+        batch.reserve(requests.size());
+
+        for (const auto& request : requests) {
+            auto promise = std::make_shared<std::promise<std::vector<char>>>();
+            futures.push_back(promise->get_future());
+            auto handle = acquireHandle(request.path);
+            if (!handle) {
+                promise->set_exception(std::make_exception_ptr(
+                    std::system_error(errno, std::generic_category())));
+                continue;
+            }
+            batch.push_back({std::move(handle), request.offset, request.length,
+                [promise](ssize_t result, std::vector<char> data) {
+                    if (result < 0) {
+                        promise->set_exception(std::make_exception_ptr(
+                            std::system_error(static_cast<int>(-result), std::generic_category())));
+                    } else {
+                        promise->set_value(std::move(data));
+                    }
+                }});
+        }
+
+        stats.requests += batch.size();
+        {
+            std::lock_guard lock(queueMutex);
+            for (auto& read : batch) {
+                pending.push_back(std::move(read));
+            }
+        }
+        queueCV.notify_one();
+        return futures;
+    }
+
+    // Blocking positional read on the persistent handle (page cache fills)
+    ssize_t readSync(const std::string& path, size_t offset, void* buffer, size_t length) {
+        auto handle = acquireHandle(path);
+        if (!handle) return -1;
+        return ::pread(handle->fd, buffer, length, static_cast<off_t>(offset));
+    }
+
+    // Size from the cached handle; returns 0 if the file cannot be opened
+    size_t fileSize(const std::string& path) {
+        auto handle = acquireHandle(path);
+        if (!handle) return 0;
+        struct stat sb;
+        if (fstat(handle->fd, &sb) == -1) return 0;
+        return static_cast<size_t>(sb.st_size);
+    }
+
+    // Drops the cached handle; in-flight reads keep it open until they finish
+    void closeFile(const std::string& path) {
+        std::lock_guard lock(handleMutex);
+        handles.erase(path);
+    }
+
+    bool usingIoUring() const { return useUring; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct FileHandle {
+        int fd;
+        explicit FileHandle(int fd) : fd(fd) {}
+        ~FileHandle() { ::close(fd); }
+    };
+
+    struct PendingRead {
+        std::shared_ptr<FileHandle> handle;
+        size_t offset;
+        size_t length;
+        Completion completion;
+    };
+
+    // One device read covering one or more adjacent requests
+    struct MergedRead {
+        std::shared_ptr<FileHandle> handle;
+        size_t offset;
+        size_t length;
+        std::vector<PendingRead> parts;
+        std::vector<char> buffer;
+        size_t transferred = 0; // Bytes read so far, across short reads
+        bool done = false;      // Completed; the ring no longer owns buffer
+    };
+
+    std::shared_ptr<FileHandle> acquireHandle(const std::string& path) {
+        {
+            std::shared_lock lock(handleMutex);
+            auto it = handles.find(path);
+            if (it != handles.end()) {
+                return it->second;
+            }
+        }
+
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) return nullptr;
+        auto handle = std::make_shared<FileHandle>(fd);
+        stats.handleOpens++;
+
+        std::lock_guard lock(handleMutex);
+        if (handles.size() >= MAX_OPEN_HANDLES) {
+            handles.erase(handles.begin());
+        }
+        auto [it, inserted] = handles.emplace(path, handle);
+        return it->second; // A racing opener may have won; ours closes on scope exit
+    }
+
+    std::vector<MergedRead> coalesce(std::deque<PendingRead>& reads) {
+        std::sort(reads.begin(), reads.end(), [](const PendingRead& a, const PendingRead& b) {
+            if (a.handle != b.handle) return a.handle < b.handle;
+            return a.offset < b.offset;
+        });
+
+        std::vector<MergedRead> merged;
+        for (auto& read : reads) {
+            if (!merged.empty()) {
+                auto& last = merged.back();
+                size_t lastEnd = last.offset + last.length;
+                size_t readEnd = read.offset + read.length;
+                if (last.handle == read.handle &&
+                    read.offset <= lastEnd + COALESCE_GAP &&
+                    std::max(lastEnd, readEnd) - last.offset <= MAX_COALESCED_BYTES) {
+                    last.length = std::max(lastEnd, readEnd) - last.offset;
+                    last.parts.push_back(std::move(read));
+                    stats.coalescedRequests++;
+                    continue;
+                }
+            }
+            MergedRead next{read.handle, read.offset, read.length, {}, {}};
+            next.parts.push_back(std::move(read));
+            merged.push_back(std::move(next));
+        }
+        reads.clear();
+        return merged;
+    }
+
+    // Hands each request its slice of the merged buffer
+    static void complete(MergedRead& read, ssize_t result) {
+        for (auto& part : read.parts) {
+            if (result < 0) {
+                part.completion(result, {});
+                continue;
+            }
+            size_t available = static_cast<size_t>(result);
+            size_t start = part.offset - read.offset;
+            size_t count = start < available ? std::min(part.length, available - start) : 0;
+            std::vector<char> data(read.buffer.begin() + start,
+                                   read.buffer.begin() + start + count);
+            part.completion(static_cast<ssize_t>(count), std::move(data));
+        }
+    }
+
+    void dispatchLoop() {
+        while (true) {
+            std::deque<PendingRead> batch;
+            {
+                std::unique_lock lock(queueMutex);
+                queueCV.wait(lock, [this]() { return !pending.empty() || !running; });
+                if (pending.empty() && !running) return;
+                batch.swap(pending);
+            }
+
+            auto merged = coalesce(batch);
+            stats.submittedReads += merged.size();
+            if (useUring) {
+                submitUring(merged);
+            } else {
+                {
+                    std::lock_guard lock(workMutex);
+                    for (auto& read : merged) {
+                        work.push_back(std::move(read));
+                    }
+                }
+                workCV.notify_all();
+            }
+        }
+    }
+
+    void workerLoop() {
+        while (true) {
+            MergedRead read;
+            {
+                std::unique_lock lock(workMutex);
+                workCV.wait(lock, [this]() { return !work.empty() || !workersRunning; });
+                if (work.empty()) return;
+                read = std::move(work.front());
+                work.pop_front();
+            }
+
+            read.buffer.resize(read.length);
+            size_t total = 0;
+            ssize_t result = 0;
+            while (total < read.length) {
+                result = ::pread(read.handle->fd, read.buffer.data() + total,
+                                 read.length - total, static_cast<off_t>(read.offset + total));
+                if (result <= 0) break;
+                total += static_cast<size_t>(result);
+            }
+            complete(read, result < 0 && total == 0 ? -errno : static_cast<ssize_t>(total));
+        }
+    }
+
+    // Returns only once the ring has handed back every read it was given:
+    // their buffers live in merged, which the caller destroys next
+    void submitUring(std::vector<MergedRead>& merged) {
+#ifdef KERNEL_VFS_IO_URING
+        // Keeps up to queueDepth reads in flight, topping the ring up as
+        // each completion frees a slot rather than waiting for whole waves
+        size_t next = 0;
+        size_t inFlight = 0;
+        bool cancelled = false;
+        while (next < merged.size() || inFlight > 0) {
+            while (!cancelled && next < merged.size() && inFlight < queueDepth) {
+                merged[next].buffer.resize(merged[next].length);
+                if (!queueRead(merged[next])) break;
+                next++;
+                inFlight++;
+            }
+            if (inFlight == 0) {
+                for (; next < merged.size(); next++) complete(merged[next], cancelled ? -ECANCELED : -EBUSY);
+                return;
+            }
+
+            io_uring_submit_and_wait(&ring, 1);
+            io_uring_cqe* cqe = nullptr;
+            int waited = io_uring_wait_cqe(&ring, &cqe);
+            if (waited != 0) {
+                // Stop feeding the ring and cancel what it holds, then keep
+                // reaping: every submitted read still completes, if only
+                // with -ECANCELED
+                if (waited != -EINTR && !cancelled) {
+                    cancelled = true;
+                    cancelInFlight(merged, next);
+                }
+                continue;
+            }
+            unsigned head;
+            unsigned seen = 0;
+            io_uring_for_each_cqe(&ring, head, cqe) {
+                seen++;
+                auto* read = static_cast<MergedRead*>(io_uring_cqe_get_data(cqe));
+                if (!read) continue; // Completion of a cancel request
+                int result = cqe->res;
+                if (result > 0) read->transferred += static_cast<size_t>(result);
+                // A short read is not EOF; ask for the rest
+                bool partial = result > 0 && read->transferred < read->length;
+                bool retry = result == -EINTR || result == -EAGAIN;
+                if (!cancelled && (partial || retry) && queueRead(*read)) continue;
+                inFlight--;
+                read->done = true;
+                complete(*read, result < 0 && read->transferred == 0
+                                    ? static_cast<ssize_t>(result)
+                                    : static_cast<ssize_t>(read->transferred));
+            }
+            io_uring_cq_advance(&ring, seen);
+        }
+#else
+        (void)merged;
+#endif
+    }
+
+#ifdef KERNEL_VFS_IO_URING
+    // Queues a read of whatever part of the merged range is still missing
+    bool queueRead(MergedRead& read) {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        if (!sqe) return false;
+        io_uring_prep_read(sqe, read.handle->fd, read.buffer.data() + read.transferred,
+                           static_cast<unsigned>(read.length - read.transferred),
+                           read.offset + read.transferred);
+        io_uring_sqe_set_data(sqe, &read);
+        return true;
+    }
+
+    // Asks the ring to cancel every read among the first submitted that
+    // has not completed; the cancels themselves complete with no data
+    void cancelInFlight(std::vector<MergedRead>& merged, size_t submitted) {
+        for (size_t i = 0; i < submitted; i++) {
+            if (merged[i].done) continue;
+            io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            if (!sqe) {
+                io_uring_submit(&ring); // Full of earlier cancels: flush them
+                sqe = io_uring_get_sqe(&ring);
+                if (!sqe) return; // The reads still complete on their own
+            }
+            io_uring_prep_cancel(sqe, &merged[i], 0);
+            io_uring_sqe_set_data(sqe, nullptr);
+        }
+        io_uring_submit(&ring);
+    }
+#endif
+
+    const unsigned queueDepth;
+    bool useUring = false;
+#ifdef KERNEL_VFS_IO_URING
+    io_uring ring;
+#endif
+
+    std::shared_mutex handleMutex;
+    std::unordered_map<std::string, std::shared_ptr<FileHandle>> handles;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCV;
+    std::deque<PendingRead> pending;
+
+    std::mutex workMutex;
+    std::condition_variable workCV;
+    std::deque<MergedRead> work;
+
+    bool running = true;
+    bool workersRunning = true;
+    std::thread dispatcher;
+    std::vector<std::thread> workers;
+    Stats stats;
+};
+
+} // namespace FileSystem
+} // namespace Kernel
+
+#endif
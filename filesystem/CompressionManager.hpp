@@ -0,0 +1,454 @@
+#ifndef COMPRESSION_MANAGER_HPP
+#define COMPRESSION_MANAGER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "../include/lz_codec.hpp"
+#include "./WorkerPool.hpp"
+
+namespace Kernel {
+namespace FileSystem {
+
+// Data is cut into fixed-size frames that are compressed independently on
+// a worker pool. A frame index follows the header, so a range read only
+// decompresses the frames it overlaps. Each frame records its own codec:
+// the fast LZ tier, zlib, or stored when compression does not pay off.
+class CompressionManager {
+public:
+    enum class Codec : uint8_t {
+        Stored = 0,
+        Fast = 1,
+        Zlib = 2
+    };
+
+    // On-disk layout: Header, FrameEntry[frameCount], frame payloads.
+    // Fields are native-endian; frames are cache and pack artifacts.
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+        uint32_t frameSize;
+        uint32_t frameCount;
+        uint64_t originalSize;
+    };
+
+    struct FrameEntry {
+        uint64_t offset; // Relative to the end of the index
+        uint32_t compressedSize;
+        uint32_t originalSize;
+        uint8_t codec;
+        uint8_t reserved[7];
+    };
+
+    struct FrameIndex {
+        Header header;
+        std::vector<FrameEntry> frames;
+        size_t payloadOffset = 0;
+    };
+
+    static constexpr size_t COMPRESS_THRESHOLD = 4096;
+    static constexpr size_t FRAME_SIZE = 128 * 1024;
+    static constexpr size_t MAX_FRAME_SIZE = 16 * 1024 * 1024; // Largest frame a reader will buffer
+    static constexpr uint32_t FRAME_MAGIC = 0x315A464B; // "KFZ1"
+    static constexpr uint16_t FORMAT_VERSION = 1;
+
+private:
+    // Codec/level pairs ordered from best ratio to fastest
+    struct Option {
+        Codec codec;
+        int level;
+        double throughput = 0.0; // MB/s per worker, EWMA
+        double ratio = 1.0;      // Compressed / original, EWMA
+        uint64_t samples = 0;
+    };
+
+    static constexpr double EWMA_WEIGHT = 0.2;
+    static constexpr uint64_t EXPLORE_INTERVAL = 64;
+
+    struct CompressionStats {
+        std::atomic<uint64_t> bytes_saved{0};
+        std::atomic<uint64_t> total_compressed{0};
+        std::atomic<uint64_t> frames_decompressed{0};
+    } stats;
+
+    std::mutex optionsMutex;
+    std::vector<Option> options = {
+        {Codec::Zlib, 6},
+        {Codec::Zlib, 1},
+        {Codec::Fast, 0}
+    };
+    uint64_t selections = 0;
+    double targetThroughput;
+    size_t workerCount;
+    WorkerPool& pool;
+
+public:
+    explicit CompressionManager(double targetThroughputMBps = 100.0,
+                                size_t workers = std::thread::hardware_concurrency(),
+                                WorkerPool& pool = WorkerPool::shared())
+        : targetThroughput(targetThroughputMBps), workerCount(std::max<size_t>(workers, 1)),
+          pool(pool) {}
+
+    void setTargetThroughput(double mbps) {
+        std::lock_guard lock(optionsMutex);
+        targetThroughput = mbps;
+    }
+
+    // Compresses with the codec the throughput model currently favours
+    std::vector<char> compress(const std::vector<char>& data) {
+        if(data.size() < COMPRESS_THRESHOLD || isFramed(data)) return data;
+
+        size_t choice = selectOption();
+        Codec codec;
+        int level;
+        {
+            std::lock_guard lock(optionsMutex);
+            codec = options[choice].codec;
+            level = options[choice].level;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto compressed = compress(data, codec, level);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        recordSample(choice, data.size(), compressed.size(), elapsed);
+
+        if(compressed.size() < data.size()) {
+            stats.bytes_saved += (data.size() - compressed.size());
+            stats.total_compressed++;
+            return compressed;
+        }
+        return data;
+    }
+
+    // Always produces the framed format; frames that do not shrink are stored
+    std::vector<char> compress(const std::vector<char>& data, Codec codec, int level) {
+        const size_t frameCount = (data.size() + FRAME_SIZE - 1) / FRAME_SIZE;
+        std::vector<std::vector<char>> payloads(frameCount);
+        std::vector<FrameEntry> frames(frameCount);
+
+        pool.parallelFor(frameCount, workerCount, [&](size_t i) {
+            size_t begin = i * FRAME_SIZE;
+            size_t length = std::min(FRAME_SIZE, data.size() - begin);
+            frames[i] = {};
+            frames[i].originalSize = static_cast<uint32_t>(length);
+            frames[i].codec = static_cast<uint8_t>(
+                compressFrame(data.data() + begin, length, codec, level, payloads[i]));
+            frames[i].compressedSize = static_cast<uint32_t>(payloads[i].size());
+        });
+
+        Header header{FRAME_MAGIC, FORMAT_VERSION, 0, static_cast<uint32_t>(FRAME_SIZE),
+                      static_cast<uint32_t>(frameCount), data.size()};
+        size_t payloadOffset = sizeof(Header) + frameCount * sizeof(FrameEntry);
+        size_t total = payloadOffset;
+        for(size_t i = 0; i < frameCount; i++) {
+            frames[i].offset = total - payloadOffset;
+            total += payloads[i].size();
+        }
+
+        std::vector<char> output(total);
+        std::memcpy(output.data(), &header, sizeof(Header));
+        if(frameCount) {
+            std::memcpy(output.data() + sizeof(Header), frames.data(),
+                        frameCount * sizeof(FrameEntry));
+        }
+        for(size_t i = 0; i < frameCount; i++) {
+            if(!payloads[i].empty()) {
+                std::memcpy(output.data() + payloadOffset + frames[i].offset,
+                            payloads[i].data(), payloads[i].size());
+            }
+        }
+        return output;
+    }
+
+    std::vector<char> decompress(const std::vector<char>& data) {
+        FrameIndex index;
+        if(!parseIndex(data.data(), data.size(), data.size(), index)) {
+            return inflateLegacy(data);
+        }
+
+        std::vector<char> output;
+        return decompressFrames(data, index, output) ? output : data;
+    }
+
+    // For data known to be framed: false on a bad index or a frame that
+    // does not decode, instead of handing the input back
+    bool decompressFramed(const std::vector<char>& data, std::vector<char>& output) {
+        FrameIndex index;
+        return parseIndex(data.data(), data.size(), data.size(), index) &&
+               decompressFrames(data, index, output);
+    }
+
+    // Decompresses only the frames overlapping [offset, offset + length)
+    std::vector<char> decompressRange(const std::vector<char>& data, size_t offset, size_t length) {
+        FrameIndex index;
+        if(!parseIndex(data.data(), data.size(), data.size(), index)) {
+            if(offset >= data.size()) return {};
+            return std::vector<char>(data.begin() + offset,
+                                     data.begin() + std::min(data.size(), offset + length));
+        }
+
+        return readRange(index, offset, length, [&](const FrameEntry& frame) {
+            return data.data() + index.payloadOffset + frame.offset;
+        });
+    }
+
+    static bool isFramed(const std::vector<char>& data) {
+        uint32_t magic = 0;
+        if(data.size() < sizeof(Header)) return false;
+        std::memcpy(&magic, data.data(), sizeof(magic));
+        return magic == FRAME_MAGIC;
+    }
+
+    // Checks a header before anything is sized from it. totalSize is the
+    // length of the whole framed file, payload included.
+    static bool validHeader(const Header& header, size_t totalSize) {
+        if(header.magic != FRAME_MAGIC || header.version != FORMAT_VERSION ||
+           header.frameSize == 0 || header.frameSize > MAX_FRAME_SIZE) {
+            return false;
+        }
+        uint64_t frames = header.originalSize / header.frameSize +
+                          (header.originalSize % header.frameSize != 0);
+        return header.frameCount == frames && indexSize(header) <= totalSize;
+    }
+
+    // Header plus frame index, i.e. where the payload starts
+    static size_t indexSize(const Header& header) {
+        return sizeof(Header) + static_cast<size_t>(header.frameCount) * sizeof(FrameEntry);
+    }
+
+    // Validates the header and loads the frame index; size may cover just
+    // the header and index when the payload stays on disk, totalSize is the
+    // whole file. Every frame but the last must be full, the last must hold
+    // the remainder, and each must lie inside the payload, so readers can
+    // trust frame sizes and offsets.
+    static bool parseIndex(const char* data, size_t size, size_t totalSize, FrameIndex& index) {
+        if(size < sizeof(Header) || size > totalSize) return false;
+        std::memcpy(&index.header, data, sizeof(Header));
+        if(!validHeader(index.header, totalSize)) return false;
+
+        size_t frameCount = index.header.frameCount;
+        index.payloadOffset = indexSize(index.header);
+        if(size < index.payloadOffset) return false;
+
+        index.frames.resize(frameCount);
+        if(frameCount) {
+            std::memcpy(index.frames.data(), data + sizeof(Header),
+                        frameCount * sizeof(FrameEntry));
+        }
+
+        const size_t payloadSize = totalSize - index.payloadOffset;
+        const uint64_t frameSize = index.header.frameSize;
+        for(size_t i = 0; i < frameCount; i++) {
+            const FrameEntry& frame = index.frames[i];
+            uint64_t expected = i + 1 < frameCount
+                ? frameSize : index.header.originalSize - (frameCount - 1) * frameSize;
+            if(frame.originalSize != expected || frame.offset > payloadSize ||
+               frame.compressedSize > payloadSize - frame.offset) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Range read over any payload source; frameSource returns the frame's
+    // compressed bytes or nullptr on failure
+    template<typename FrameSource>
+    std::vector<char> readRange(const FrameIndex& index, size_t offset, size_t length,
+                                FrameSource&& frameSource) {
+        const size_t originalSize = index.header.originalSize;
+        if(offset >= originalSize || length == 0) return {};
+        length = std::min(length, originalSize - offset);
+
+        const size_t frameSize = index.header.frameSize;
+        size_t first = offset / frameSize;
+        size_t last = std::min((offset + length - 1) / frameSize, index.frames.size() - 1);
+
+        std::vector<char> output(length);
+        std::vector<char> scratch(frameSize);
+        for(size_t i = first; i <= last; i++) {
+            const FrameEntry& frame = index.frames[i];
+            const char* src = frameSource(frame);
+            if(!src || !decompressFrame(frame, src, scratch.data())) return {};
+
+            size_t frameBegin = i * frameSize;
+            size_t copyBegin = std::max(offset, frameBegin);
+            size_t copyEnd = std::min(offset + length, frameBegin + frame.originalSize);
+            std::memcpy(output.data() + (copyBegin - offset),
+                        scratch.data() + (copyBegin - frameBegin), copyEnd - copyBegin);
+        }
+        return output;
+    }
+
+    // dst must hold frame.originalSize bytes
+    bool decompressFrame(const FrameEntry& frame, const char* src, char* dst) {
+        stats.frames_decompressed++;
+        switch(static_cast<Codec>(frame.codec)) {
+            case Codec::Stored:
+                if(frame.compressedSize != frame.originalSize) return false;
+                std::memcpy(dst, src, frame.originalSize);
+                return true;
+            case Codec::Fast: {
+                long size = Compression::LZCodec::decompress(
+                    reinterpret_cast<const uint8_t*>(src), frame.compressedSize,
+                    reinterpret_cast<uint8_t*>(dst), frame.originalSize);
+                return size == static_cast<long>(frame.originalSize);
+            }
+            case Codec::Zlib: {
+                uLongf size = frame.originalSize;
+                int ret = uncompress(reinterpret_cast<Bytef*>(dst), &size,
+                                     reinterpret_cast<const Bytef*>(src), frame.compressedSize);
+                return ret == Z_OK && size == frame.originalSize;
+            }
+        }
+        return false;
+    }
+
+    uint64_t getFramesDecompressed() const { return stats.frames_decompressed; }
+
+private:
+    bool decompressFrames(const std::vector<char>& data, const FrameIndex& index,
+                          std::vector<char>& output) {
+        output.resize(index.header.originalSize);
+        size_t position = 0;
+        for(const auto& frame : index.frames) {
+            const char* src = data.data() + index.payloadOffset + frame.offset;
+            if(!decompressFrame(frame, src, output.data() + position)) {
+                return false;
+            }
+            position += frame.originalSize;
+        }
+        return true;
+    }
+
+    static Codec compressFrame(const char* src, size_t length, Codec codec, int level,
+                               std::vector<char>& out) {
+        if(codec == Codec::Fast) {
+            out.resize(Compression::LZCodec::compressBound(length));
+            size_t size = Compression::LZCodec::compress(
+                reinterpret_cast<const uint8_t*>(src), length,
+                reinterpret_cast<uint8_t*>(out.data()), out.size());
+            if(size > 0 && size < length) {
+                out.resize(size);
+                return Codec::Fast;
+            }
+        } else if(codec == Codec::Zlib) {
+            uLongf size = compressBound(length);
+            out.resize(size);
+            if(compress2(reinterpret_cast<Bytef*>(out.data()), &size,
+                         reinterpret_cast<const Bytef*>(src), length, level) == Z_OK &&
+               size < length) {
+                out.resize(size);
+                return Codec::Zlib;
+            }
+        }
+        out.assign(src, src + length);
+        return Codec::Stored;
+    }
+
+    // Best ratio among options measured to keep up with the target; options
+    // without samples are tried first and every option is re-measured
+    // periodically so the model follows changes in data and load.
+    size_t selectOption() {
+        std::lock_guard lock(optionsMutex);
+        uint64_t round = selections++;
+        for(size_t i = 0; i < options.size(); i++) {
+            if(options[i].samples == 0) return i;
+        }
+        if(round % EXPLORE_INTERVAL == 0) {
+            return (round / EXPLORE_INTERVAL) % options.size();
+        }
+
+        size_t best = options.size();
+        size_t fastest = 0;
+        for(size_t i = 0; i < options.size(); i++) {
+            if(options[i].throughput > options[fastest].throughput) fastest = i;
+            if(options[i].throughput * workersFor(SIZE_MAX) >= targetThroughput &&
+               (best == options.size() || options[i].ratio < options[best].ratio)) {
+                best = i;
+            }
+        }
+        return best == options.size() ? fastest : best;
+    }
+
+    void recordSample(size_t choice, size_t originalSize, size_t compressedSize,
+                      std::chrono::steady_clock::duration elapsed) {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        size_t workers = workersFor((originalSize + FRAME_SIZE - 1) / FRAME_SIZE);
+        // Normalise to one worker so the target scales with the pool
+        double throughput = seconds > 0.0
+            ? originalSize / (1024.0 * 1024.0) / seconds / workers : 0.0;
+        double ratio = static_cast<double>(compressedSize) / originalSize;
+
+        std::lock_guard lock(optionsMutex);
+        Option& option = options[choice];
+        if(option.samples++ == 0) {
+            option.throughput = throughput;
+            option.ratio = ratio;
+        } else {
+            option.throughput += EWMA_WEIGHT * (throughput - option.throughput);
+            option.ratio += EWMA_WEIGHT * (ratio - option.ratio);
+        }
+    }
+
+    // Threads one compress() call of this many frames actually runs on
+    size_t workersFor(size_t frames) const {
+        return std::max<size_t>(std::min({workerCount, frames, pool.helperCount() + 1}), 1);
+    }
+
+    // Unframed zlib stream from before the framed format
+    static std::vector<char> inflateLegacy(const std::vector<char>& data) {
+        z_stream strm;
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        
+        if (inflateInit(&strm) != Z_OK) {
+            return data;
+        }
+
+        std::vector<char> decompressed(std::max<size_t>(data.size() * 4, 4096));
+        
+        strm.avail_in = data.size();
+        strm.next_in = (Bytef*)data.data();
+        strm.avail_out = decompressed.size();
+        strm.next_out = (Bytef*)decompressed.data();
+
+        while (true) {
+            int ret = inflate(&strm, Z_NO_FLUSH);
+            
+            if (ret == Z_STREAM_END) {
+                break;
+            }
+            
+            if (ret != Z_OK) {
+                inflateEnd(&strm);
+                return data;
+            }
+
+            // Expand buffer if needed
+            if (strm.avail_out == 0) {
+                size_t currentSize = decompressed.size();
+                decompressed.resize(currentSize * 2);
+                strm.next_out = (Bytef*)(decompressed.data() + currentSize);
+                strm.avail_out = currentSize;
+            }
+        }
+
+        decompressed.resize(strm.total_out);
+        inflateEnd(&strm);
+        return decompressed;
+    }
+};
+
+} // namespace FileSystem
+} // namespace Kernel
+
+#endif
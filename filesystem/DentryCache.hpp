@@ -0,0 +1,240 @@
+#ifndef DENTRY_CACHE_HPP
+#define DENTRY_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Kernel {
+namespace FileSystem {
+
+class FileSystemDriver;
+
+// Mount points keyed by path component, so resolving a path walks at most
+// its depth instead of prefix-matching every mounted filesystem.
+class MountTrie {
+public:
+    struct Match {
+        std::string mountPoint;
+        FileSystemDriver* driver = nullptr;
+    };
+
+    void insert(const std::string& mountPoint, FileSystemDriver* driver) {
+        std::unique_lock lock(mutex);
+        Node* node = &root;
+        forEachComponent(mountPoint, [&](const std::string& component) {
+            auto& child = node->children[component];
+            if (!child) child = std::make_unique<Node>();
+            node = child.get();
+            return true;
+        });
+        node->mountPoint = mountPoint;
+        node->driver = driver;
+    }
+
+    void remove(const std::string& mountPoint) {
+        std::unique_lock lock(mutex);
+        Node* node = &root;
+        bool found = forEachComponent(mountPoint, [&](const std::string& component) {
+            auto it = node->children.find(component);
+            if (it == node->children.end()) return false;
+            node = it->second.get();
+            return true;
+        });
+        if (found) {
+            node->driver = nullptr;
+            node->mountPoint.clear();
+        }
+    }
+
+    // Deepest mount point containing path
+    std::optional<Match> longestMatch(const std::string& path) const {
+        std::shared_lock lock(mutex);
+        const Node* node = &root;
+        const Node* best = root.driver ? &root : nullptr;
+        forEachComponent(path, [&](const std::string& component) {
+            auto it = node->children.find(component);
+            if (it == node->children.end()) return false;
+            node = it->second.get();
+            if (node->driver) best = node;
+            return true;
+        });
+        if (!best) return std::nullopt;
+        return Match{best->mountPoint, best->driver};
+    }
+
+private:
+    struct Node {
+        std::unordered_map<std::string, std::unique_ptr<Node>> children;
+        std::string mountPoint;
+        FileSystemDriver* driver = nullptr;
+    };
+
+    // Visits non-empty '/'-separated components; stops when visit returns false
+    template<typename Visit>
+    static bool forEachComponent(const std::string& path, Visit&& visit) {
+        size_t start = 0;
+        while (start <= path.size()) {
+            size_t end = path.find('/', start);
+            if (end == std::string::npos) end = path.size();
+            if (end > start && !visit(path.substr(start, end - start))) return false;
+            start = end + 1;
+        }
+        return true;
+    }
+
+    Node root;
+    mutable std::shared_mutex mutex;
+};
+
+// Caches the outcome of resolving a normalized path. Positive entries
+// carry the resolved mount; negative entries remember files the driver
+// reported missing. Mount changes bump a generation that lazily
+// invalidates every entry.
+class DentryCache {
+public:
+    enum class State {
+        Resolved,
+        Missing
+    };
+
+    struct Entry {
+        State state;
+        FileSystemDriver* driver;
+        std::string mountPoint;
+        uint64_t generation;
+        std::chrono::steady_clock::time_point created;
+    };
+
+    static constexpr size_t SHARD_COUNT = 32;
+    static constexpr size_t MAX_ENTRIES_PER_SHARD = 4096;
+    static constexpr std::chrono::seconds NEGATIVE_TTL{5};
+
+    std::optional<Entry> lookup(const std::string& path) {
+        auto& shard = shardFor(path);
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.entries.find(path);
+        if (it == shard.entries.end()) return std::nullopt;
+
+        const Entry& entry = it->second;
+        if (entry.generation != generation.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        if (entry.state == State::Missing &&
+            std::chrono::steady_clock::now() - entry.created > NEGATIVE_TTL) {
+            return std::nullopt;
+        }
+        return entry;
+    }
+
+    // Read before resolving a path and pass to insert, so a mount change
+    // that lands mid-resolution leaves the entry already stale
+    uint64_t currentGeneration() const {
+        return generation.load(std::memory_order_acquire);
+    }
+
+    void insertResolved(const std::string& path, const std::string& mountPoint,
+                        FileSystemDriver* driver, uint64_t resolvedAt) {
+        insert(path, {State::Resolved, driver, mountPoint, resolvedAt, {}});
+    }
+
+    void insertMissing(const std::string& path, uint64_t resolvedAt) {
+        insert(path, {State::Missing, nullptr, {}, resolvedAt, {}});
+    }
+
+    // Call when a file is created, removed or renamed
+    void invalidate(const std::string& path) {
+        auto& shard = shardFor(path);
+        std::unique_lock lock(shard.mutex);
+        shard.entries.erase(path);
+    }
+
+    // Call on mount/unmount; O(1), stale entries are replaced on next lookup
+    void invalidateAll() {
+        generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    void insert(const std::string& path, Entry entry) {
+        if (entry.generation != generation.load(std::memory_order_acquire)) return;
+        entry.created = std::chrono::steady_clock::now();
+
+        auto& shard = shardFor(path);
+        std::unique_lock lock(shard.mutex);
+        if (shard.entries.size() >= MAX_ENTRIES_PER_SHARD && !shard.entries.count(path)) {
+            shard.entries.erase(shard.entries.begin());
+        }
+        shard.entries[path] = std::move(entry);
+    }
+
+    Shard& shardFor(const std::string& path) {
+        return shards[std::hash<std::string>{}(path) % SHARD_COUNT];
+    }
+
+    std::array<Shard, SHARD_COUNT> shards;
+    std::atomic<uint64_t> generation{0};
+};
+
+// Validated, normalized spelling of each raw path callers pass in, so a
+// repeated open skips tokenizing and checking the path. Rejected paths are
+// remembered as an empty string (a normalized path is never empty).
+// Validation consults the mount table for some paths, so entries carry the
+// dentry generation they were computed under.
+class PathNameCache {
+public:
+    static constexpr size_t SHARD_COUNT = 32;
+    static constexpr size_t MAX_ENTRIES_PER_SHARD = 4096;
+
+    std::optional<std::string> lookup(const std::string& raw, uint64_t generation) {
+        auto& shard = shardFor(raw);
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.entries.find(raw);
+        if (it == shard.entries.end() || it->second.generation != generation) {
+            return std::nullopt;
+        }
+        return it->second.normalized;
+    }
+
+    void insert(const std::string& raw, std::string normalized, uint64_t generation) {
+        auto& shard = shardFor(raw);
+        std::unique_lock lock(shard.mutex);
+        if (shard.entries.size() >= MAX_ENTRIES_PER_SHARD && !shard.entries.count(raw)) {
+            shard.entries.erase(shard.entries.begin());
+        }
+        shard.entries[raw] = {std::move(normalized), generation};
+    }
+
+private:
+    struct Entry {
+        std::string normalized;
+        uint64_t generation;
+    };
+
+    struct alignas(64) Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    Shard& shardFor(const std::string& raw) {
+        return shards[std::hash<std::string>{}(raw) % SHARD_COUNT];
+    }
+
+    std::array<Shard, SHARD_COUNT> shards;
+};
+
+} // namespace FileSystem
+} // namespace Kernel
+
+#endif
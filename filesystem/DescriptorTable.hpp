@@ -0,0 +1,192 @@
+#ifndef DESCRIPTOR_TABLE_HPP
+#define DESCRIPTOR_TABLE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace Kernel {
+namespace FileSystem {
+
+// Slab-allocated descriptor table with generation-tagged ids.
+// An id packs a slot index (low SLOT_BITS) with the slot's generation, so
+// lookup is one array index plus a generation compare and a stale or closed
+// id is rejected. Slots never move, so returned pointers stay valid for the
+// table's lifetime; freed slots go to a lock-free free list picked by CPU.
+// Closing a descriptor while another thread still uses it is the caller's
+// responsibility, as with kernel fd tables.
+template<typename T>
+class DescriptorTable {
+public:
+    static constexpr uint32_t SLOT_BITS = 20;
+    static constexpr uint32_t SLOT_MASK = (1u << SLOT_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = (1u << (32 - SLOT_BITS)) - 1;
+    static constexpr size_t SLAB_SIZE = 1024;
+    static constexpr size_t MAX_SLABS = (size_t(1) << SLOT_BITS) / SLAB_SIZE;
+    static constexpr size_t FREE_LISTS = 16;
+    static constexpr uint32_t INVALID_ID = 0;
+
+    DescriptorTable() {
+        for (auto& slab : slabs) slab.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~DescriptorTable() {
+        for (auto& slab : slabs) delete[] slab.load(std::memory_order_relaxed);
+    }
+
+    DescriptorTable(const DescriptorTable&) = delete;
+    DescriptorTable& operator=(const DescriptorTable&) = delete;
+
+    // Stores value in a free slot; returns its id and stable address, or
+    // INVALID_ID / nullptr when the table is full.
+    std::pair<uint32_t, T*> allocate(T value) {
+        uint32_t index;
+        if (!popFree(index)) {
+            index = nextSlot.fetch_add(1, std::memory_order_relaxed);
+            if (index > SLOT_MASK) {
+                nextSlot.store(SLOT_MASK + 1, std::memory_order_relaxed);
+                return {INVALID_ID, nullptr};
+            }
+        }
+
+        Slot& slot = slotAt(index, true);
+        slot.value = std::move(value);
+        // Odd generation marks the slot live; the store publishes the value
+        uint32_t generation = slot.generation.load(std::memory_order_relaxed) + 1;
+        slot.generation.store(generation, std::memory_order_release);
+
+        uint32_t id = ((generation & GENERATION_MASK) << SLOT_BITS) | index;
+        count.fetch_add(1, std::memory_order_relaxed);
+        return {id, &slot.value};
+    }
+
+    T* lookup(uint32_t id) {
+        Slot* slot = find(id);
+        return slot ? &slot->value : nullptr;
+    }
+
+    // Fails for unknown, stale or already-closed ids
+    bool release(uint32_t id) {
+        return take(id).has_value();
+    }
+
+    // Closes id and hands back its value in one step, so of two racing
+    // closers exactly one gets the value. Empty for unknown, stale or
+    // already-closed ids.
+    std::optional<T> take(uint32_t id) {
+        Slot* slot = find(id);
+        if (!slot) return std::nullopt;
+
+        uint32_t generation = slot->generation.load(std::memory_order_acquire);
+        if (!matches(generation, id)) return std::nullopt;
+        // Only one closer wins the transition to the next (even, free) generation
+        if (!slot->generation.compare_exchange_strong(generation, generation + 1,
+                                                      std::memory_order_acq_rel)) {
+            return std::nullopt;
+        }
+
+        std::optional<T> value(std::move(slot->value));
+        slot->value = T();
+        pushFree(id & SLOT_MASK);
+        count.fetch_sub(1, std::memory_order_relaxed);
+        return value;
+    }
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> generation{0};
+        std::atomic<uint32_t> nextFree{0};
+        T value{};
+    };
+
+    // Treiber stack head: high 32 bits ABA tag, low 32 bits slot index + 1
+    struct alignas(64) FreeList {
+        std::atomic<uint64_t> head{0};
+    };
+
+    static bool matches(uint32_t generation, uint32_t id) {
+        return (generation & 1) && (generation & GENERATION_MASK) == (id >> SLOT_BITS);
+    }
+
+    Slot* find(uint32_t id) {
+        uint32_t index = id & SLOT_MASK;
+        Slot* slab = slabs[index / SLAB_SIZE].load(std::memory_order_acquire);
+        if (!slab) return nullptr;
+        Slot& slot = slab[index % SLAB_SIZE];
+        return matches(slot.generation.load(std::memory_order_acquire), id) ? &slot : nullptr;
+    }
+
+    Slot& slotAt(uint32_t index, bool create) {
+        auto& entry = slabs[index / SLAB_SIZE];
+        Slot* slab = entry.load(std::memory_order_acquire);
+        if (!slab && create) {
+            Slot* fresh = new Slot[SLAB_SIZE];
+            if (entry.compare_exchange_strong(slab, fresh, std::memory_order_acq_rel)) {
+                slab = fresh;
+            } else {
+                delete[] fresh; // Another thread installed this slab first
+            }
+        }
+        return slab[index % SLAB_SIZE];
+    }
+
+    static size_t currentList() {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        if (cpu >= 0) return static_cast<size_t>(cpu) % FREE_LISTS;
+#endif
+        return std::hash<std::thread::id>{}(std::this_thread::get_id()) % FREE_LISTS;
+    }
+
+    void pushFree(uint32_t index) {
+        FreeList& list = freeLists[currentList()];
+        Slot& slot = slotAt(index, false);
+        uint64_t head = list.head.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            slot.nextFree.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            next = ((head >> 32) + 1) << 32 | (uint64_t(index) + 1);
+        } while (!list.head.compare_exchange_weak(head, next, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+    }
+
+    // Own CPU's list first, then steal from the others
+    bool popFree(uint32_t& index) {
+        size_t start = currentList();
+        for (size_t i = 0; i < FREE_LISTS; i++) {
+            FreeList& list = freeLists[(start + i) % FREE_LISTS];
+            uint64_t head = list.head.load(std::memory_order_acquire);
+            while (static_cast<uint32_t>(head) != 0) {
+                uint32_t top = static_cast<uint32_t>(head) - 1;
+                uint32_t nextFree = slotAt(top, false).nextFree.load(std::memory_order_relaxed);
+                uint64_t next = ((head >> 32) + 1) << 32 | nextFree;
+                if (list.head.compare_exchange_weak(head, next, std::memory_order_acquire,
+                                                    std::memory_order_acquire)) {
+                    index = top;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    std::array<std::atomic<Slot*>, MAX_SLABS> slabs;
+    std::array<FreeList, FREE_LISTS> freeLists;
+    std::atomic<uint32_t> nextSlot{0};
+    std::atomic<size_t> count{0};
+};
+
+} // namespace FileSystem
+} // namespace Kernel
+
+#endif
@@ -0,0 +1,376 @@
+#ifndef EVICTION_POLICY_HPP
+#define EVICTION_POLICY_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Kernel {
+namespace FileSystem {
+
+// Replacement policy for one byte-budgeted cache level. The owning level
+// reports inserts, hits and removals and asks for victims one at a time
+// until it fits its budget; every operation is O(1) amortized.
+class EvictionPolicy {
+public:
+    virtual ~EvictionPolicy() = default;
+
+    virtual const char* name() const = 0;
+    virtual void setCapacity(size_t bytes) = 0;
+
+    virtual void onInsert(const std::string& key, size_t size) = 0;
+    virtual void onAccess(const std::string& key) = 0;
+    virtual void onResize(const std::string& key, size_t size) = 0;
+    virtual void onRemove(const std::string& key) = 0;
+
+    // Picks and forgets the next entry to evict; false when nothing is tracked
+    virtual bool victim(std::string& key) = 0;
+};
+
+enum class EvictionPolicyType {
+    LRU,
+    ARC,
+    WTinyLFU
+};
+
+namespace Detail {
+
+// Intrusive-style recency list: O(1) move-to-front and removal by key
+class RecencyList {
+public:
+    bool contains(const std::string& key) const { return index.count(key) != 0; }
+    bool empty() const { return order.empty(); }
+    size_t size() const { return order.size(); }
+    size_t bytes() const { return totalBytes; }
+    const std::string& lru() const { return order.back().key; }
+
+    size_t sizeOf(const std::string& key) const { return index.at(key)->size; }
+
+    void pushFront(const std::string& key, size_t size) {
+        order.push_front({key, size});
+        index[key] = order.begin();
+        totalBytes += size;
+    }
+
+    void touch(const std::string& key) {
+        auto it = index.find(key);
+        if (it != index.end()) order.splice(order.begin(), order, it->second);
+    }
+
+    void resize(const std::string& key, size_t size) {
+        auto it = index.find(key);
+        if (it == index.end()) return;
+        totalBytes = totalBytes - it->second->size + size;
+        it->second->size = size;
+    }
+
+    bool remove(const std::string& key, size_t* removedSize = nullptr) {
+        auto it = index.find(key);
+        if (it == index.end()) return false;
+        if (removedSize) *removedSize = it->second->size;
+        totalBytes -= it->second->size;
+        order.erase(it->second);
+        index.erase(it);
+        return true;
+    }
+
+    std::string popLru() {
+        std::string key = std::move(order.back().key);
+        totalBytes -= order.back().size;
+        order.pop_back();
+        index.erase(key);
+        return key;
+    }
+
+private:
+    struct Node {
+        std::string key;
+        size_t size;
+    };
+
+    std::list<Node> order;
+    std::unordered_map<std::string, std::list<Node>::iterator> index;
+    size_t totalBytes = 0;
+};
+
+} // namespace Detail
+
+class LRUPolicy : public EvictionPolicy {
+public:
+    const char* name() const override { return "LRU"; }
+    void setCapacity(size_t) override {}
+
+    void onInsert(const std::string& key, size_t size) override { entries.pushFront(key, size); }
+    void onAccess(const std::string& key) override { entries.touch(key); }
+    void onResize(const std::string& key, size_t size) override { entries.resize(key, size); }
+    void onRemove(const std::string& key) override { entries.remove(key); }
+
+    bool victim(std::string& key) override {
+        if (entries.empty()) return false;
+        key = entries.popLru();
+        return true;
+    }
+
+private:
+    Detail::RecencyList entries;
+};
+
+// Adaptive Replacement Cache (Megiddo & Modha) with ghost lists. The target
+// size of the recency side (p) is tracked in bytes so large and small
+// entries are balanced against the level's byte budget.
+class ARCPolicy : public EvictionPolicy {
+public:
+    explicit ARCPolicy(size_t capacityBytes) : capacity(capacityBytes) {}
+
+    const char* name() const override { return "ARC"; }
+    void setCapacity(size_t bytes) override {
+        capacity = bytes;
+        target = std::min(target, capacity);
+    }
+
+    void onInsert(const std::string& key, size_t size) override {
+        lastMissWasFrequentGhost = false;
+        size_t ghostSize = 0;
+        if (b1.remove(key, &ghostSize)) {
+            // Recency ghost hit: grow the recency side
+            size_t delta = std::max(ghostSize, b1.bytes() ? b2.bytes() * ghostSize / b1.bytes() : 0);
+            target = std::min(capacity, target + delta);
+            t2.pushFront(key, size);
+        } else if (b2.remove(key, &ghostSize)) {
+            // Frequency ghost hit: grow the frequency side
+            size_t delta = std::max(ghostSize, b2.bytes() ? b1.bytes() * ghostSize / b2.bytes() : 0);
+            target = target > delta ? target - delta : 0;
+            lastMissWasFrequentGhost = true;
+            t2.pushFront(key, size);
+        } else {
+            t1.pushFront(key, size);
+        }
+        trimGhosts();
+    }
+
+    void onAccess(const std::string& key) override {
+        size_t size = 0;
+        if (t1.remove(key, &size)) {
+            t2.pushFront(key, size);
+        } else {
+            t2.touch(key);
+        }
+    }
+
+    void onResize(const std::string& key, size_t size) override {
+        t1.resize(key, size);
+        t2.resize(key, size);
+    }
+
+    void onRemove(const std::string& key) override {
+        t1.remove(key) || t2.remove(key);
+    }
+
+    bool victim(std::string& key) override {
+        if (t1.empty() && t2.empty()) return false;
+
+        bool fromRecency = !t1.empty() &&
+            (t1.bytes() > target || (lastMissWasFrequentGhost && t1.bytes() == target) || t2.empty());
+        if (fromRecency) {
+            size_t size = t1.sizeOf(t1.lru());
+            key = t1.popLru();
+            b1.pushFront(key, size);
+        } else {
+            size_t size = t2.sizeOf(t2.lru());
+            key = t2.popLru();
+            b2.pushFront(key, size);
+        }
+        trimGhosts();
+        return true;
+    }
+
+private:
+    // Ghost lists remember keys, not data; bound each by the level budget
+    void trimGhosts() {
+        while (!b1.empty() && b1.bytes() > capacity) b1.popLru();
+        while (!b2.empty() && b2.bytes() > capacity) b2.popLru();
+    }
+
+    size_t capacity;
+    size_t target = 0;
+    bool lastMissWasFrequentGhost = false;
+    Detail::RecencyList t1, t2; // Resident: seen once / seen repeatedly
+    Detail::RecencyList b1, b2; // Ghosts evicted from t1 / t2
+};
+
+// 4-bit-style count-min sketch with periodic halving so old popularity decays
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t expectedEntries = 1024) { resize(expectedEntries); }
+
+    void resize(size_t expectedEntries) {
+        size_t width = 64;
+        while (width < expectedEntries) width <<= 1;
+        mask = width - 1;
+        for (auto& row : rows) row.assign(width, 0);
+        sampleSize = width * 10;
+        additions = 0;
+    }
+
+    void increment(const std::string& key) {
+        uint64_t hash = std::hash<std::string>{}(key);
+        for (size_t i = 0; i < DEPTH; i++) {
+            uint8_t& counter = rows[i][index(hash, i)];
+            if (counter < MAX_COUNT) counter++;
+        }
+        if (++additions >= sampleSize) age();
+    }
+
+    uint8_t estimate(const std::string& key) const {
+        uint64_t hash = std::hash<std::string>{}(key);
+        uint8_t count = MAX_COUNT;
+        for (size_t i = 0; i < DEPTH; i++) {
+            count = std::min(count, rows[i][index(hash, i)]);
+        }
+        return count;
+    }
+
+private:
+    static constexpr size_t DEPTH = 4;
+    static constexpr uint8_t MAX_COUNT = 15;
+
+    size_t index(uint64_t hash, size_t row) const {
+        static constexpr uint64_t seeds[DEPTH] = {
+            0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL,
+            0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL
+        };
+        uint64_t h = (hash + seeds[row]) * seeds[(row + 1) % DEPTH];
+        return static_cast<size_t>(h >> 32) & mask;
+    }
+
+    // Amortized O(1): runs once every sampleSize increments
+    void age() {
+        for (auto& row : rows) {
+            for (auto& counter : row) counter >>= 1;
+        }
+        additions /= 2;
+    }
+
+    std::array<std::vector<uint8_t>, DEPTH> rows;
+    size_t mask = 0;
+    size_t sampleSize = 0;
+    size_t additions = 0;
+};
+
+// W-TinyLFU (Einziger et al.): a 1% LRU admission window in front of a
+// segmented LRU main area. Window overflow becomes an admission candidate
+// that only displaces a main entry when the sketch says it is more popular.
+class WTinyLFUPolicy : public EvictionPolicy {
+public:
+    explicit WTinyLFUPolicy(size_t capacityBytes, size_t expectedEntries = 4096)
+        : capacity(capacityBytes), sketch(expectedEntries) {}
+
+    const char* name() const override { return "W-TinyLFU"; }
+    void setCapacity(size_t bytes) override { capacity = bytes; }
+
+    void onInsert(const std::string& key, size_t size) override {
+        sketch.increment(key);
+        window.pushFront(key, size);
+        while (window.size() > 1 && window.bytes() > windowBudget()) {
+            size_t spilledSize = window.sizeOf(window.lru());
+            candidates.pushFront(window.popLru(), spilledSize);
+        }
+    }
+
+    void onAccess(const std::string& key) override {
+        sketch.increment(key);
+        size_t size = 0;
+        if (window.contains(key)) {
+            window.touch(key);
+        } else if (probation.remove(key, &size) || candidates.remove(key, &size)) {
+            protectedArea.pushFront(key, size);
+            // Keep the protected segment at 80% of main by demoting its LRU
+            while (protectedArea.size() > 1 && protectedArea.bytes() > protectedBudget()) {
+                size_t demotedSize = protectedArea.sizeOf(protectedArea.lru());
+                probation.pushFront(protectedArea.popLru(), demotedSize);
+            }
+        } else {
+            protectedArea.touch(key);
+        }
+    }
+
+    void onResize(const std::string& key, size_t size) override {
+        window.resize(key, size);
+        candidates.resize(key, size);
+        probation.resize(key, size);
+        protectedArea.resize(key, size);
+    }
+
+    void onRemove(const std::string& key) override {
+        window.remove(key) || candidates.remove(key) ||
+            probation.remove(key) || protectedArea.remove(key);
+    }
+
+    bool victim(std::string& key) override {
+        if (!candidates.empty()) {
+            Detail::RecencyList* mainList = !probation.empty() ? &probation
+                : !protectedArea.empty() ? &protectedArea : nullptr;
+            if (!mainList) {
+                key = candidates.popLru();
+                return true;
+            }
+
+            // Admission duel: oldest candidate against main's coldest entry
+            const std::string& candidate = candidates.lru();
+            if (sketch.estimate(candidate) > sketch.estimate(mainList->lru())) {
+                key = mainList->popLru();
+                size_t size = candidates.sizeOf(candidate);
+                probation.pushFront(candidates.popLru(), size);
+            } else {
+                key = candidates.popLru();
+            }
+            return true;
+        }
+
+        if (!probation.empty()) {
+            key = probation.popLru();
+        } else if (!protectedArea.empty()) {
+            key = protectedArea.popLru();
+        } else if (!window.empty()) {
+            key = window.popLru();
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+private:
+    size_t windowBudget() const { return std::max<size_t>(capacity / 100, 1); }
+    size_t protectedBudget() const { return (capacity - windowBudget()) * 4 / 5; }
+
+    size_t capacity;
+    FrequencySketch sketch;
+    Detail::RecencyList window;
+    Detail::RecencyList candidates; // Spilled from the window, awaiting admission
+    Detail::RecencyList probation;
+    Detail::RecencyList protectedArea;
+};
+
+inline std::unique_ptr<EvictionPolicy> createEvictionPolicy(EvictionPolicyType type,
+                                                            size_t capacityBytes) {
+    switch (type) {
+        case EvictionPolicyType::LRU:
+            return std::make_unique<LRUPolicy>();
+        case EvictionPolicyType::ARC:
+            return std::make_unique<ARCPolicy>(capacityBytes);
+        case EvictionPolicyType::WTinyLFU:
+        default:
+            return std::make_unique<WTinyLFUPolicy>(capacityBytes);
+    }
+}
+
+} // namespace FileSystem
+} // namespace Kernel
+
+#endif
@@ -0,0 +1,323 @@
+#ifndef PAGE_CACHE_HPP
+#define PAGE_CACHE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Kernel {
+namespace FileSystem {
+
+// Read-only span into cached or memory-mapped file bytes. The view shares
+// ownership of its backing block or mapping, which pins it: pinned blocks
+// are skipped by eviction and mappings stay valid until the view is released.
+class FileView {
+public:
+    FileView() = default;
+    FileView(std::shared_ptr<const void> owner, const char* bytes, size_t length)
+        : owner(std::move(owner)), bytes(bytes), length(length) {}
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    explicit operator bool() const { return bytes != nullptr; }
+
+    const char* begin() const { return bytes; }
+    const char* end() const { return bytes + length; }
+
+    void release() {
+        owner.reset();
+        bytes = nullptr;
+        length = 0;
+    }
+
+private:
+    std::shared_ptr<const void> owner;
+    const char* bytes = nullptr;
+    size_t length = 0;
+};
+
+// Block-granular page cache keyed by (file id, block index).
+// Lookups only lock the shard owning the block, so readers on different
+// cores touching different blocks never contend on a common mutex.
+class PageCache {
+public:
+    static constexpr size_t SMALL_BLOCK_SIZE = 4 * 1024;
+    static constexpr size_t LARGE_BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t SHARD_COUNT = 64;
+
+    // A cached block; data.size() < blockSize marks the last block of a file
+    struct Block {
+        std::vector<char> data;
+
+        const char* bytes() const { return data.data(); }
+        size_t size() const { return data.size(); }
+    };
+
+    using BlockRef = std::shared_ptr<const Block>;
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        size_t bytesCached;
+    };
+
+    explicit PageCache(size_t capacityBytes = 256 * 1024 * 1024,
+                       size_t blockSize = LARGE_BLOCK_SIZE)
+        : blockSize(blockSize),
+          shardCapacity(std::max(capacityBytes / SHARD_COUNT, blockSize)) {}
+
+    size_t getBlockSize() const { return blockSize; }
+
+    // Interns a path into a stable numeric id; callers cache the result
+    // per descriptor so the hot path never touches the path map.
+    uint64_t fileId(const std::string& path) {
+        {
+            std::shared_lock lock(idMutex);
+            auto it = fileIds.find(path);
+            if (it != fileIds.end()) {
+                return it->second;
+            }
+        }
+        std::lock_guard lock(idMutex);
+        auto [it, inserted] = fileIds.emplace(path, nextFileId);
+        if (inserted) {
+            nextFileId++;
+        }
+        return it->second;
+    }
+
+    BlockRef lookup(uint64_t file, uint64_t blockIndex) {
+        auto& shard = shardFor(file, blockIndex);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.blocks.find({file, blockIndex});
+        if (it == shard.blocks.end()) {
+            shard.misses++;
+            return nullptr;
+        }
+        // Move to the front of the shard's LRU list
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lruPos);
+        shard.hits++;
+        return it->second.block;
+    }
+
+    // Residency check that leaves LRU order and hit/miss counters untouched
+    bool contains(uint64_t file, uint64_t blockIndex) {
+        auto& shard = shardFor(file, blockIndex);
+        std::lock_guard lock(shard.mutex);
+        return shard.blocks.count({file, blockIndex}) != 0;
+    }
+
+    // Sees every block evicted for space (not invalidated ones) once the
+    // shard lock is dropped, so a lower cache tier can keep it. Set before
+    // the cache is shared between threads.
+    using EvictionHandler = std::function<void(uint64_t file, uint64_t blockIndex, BlockRef block)>;
+
+    void setEvictionHandler(EvictionHandler handler) {
+        evictionHandler = std::move(handler);
+    }
+
+    BlockRef insert(uint64_t file, uint64_t blockIndex, std::vector<char> data) {
+        auto block = std::make_shared<Block>();
+        block->data = std::move(data);
+
+        auto& shard = shardFor(file, blockIndex);
+        std::vector<std::pair<BlockKey, BlockRef>> evicted;
+        {
+            std::lock_guard lock(shard.mutex);
+            BlockKey key{file, blockIndex};
+            auto it = shard.blocks.find(key);
+            if (it != shard.blocks.end()) {
+                // Another reader raced us to fill this block; keep theirs
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lruPos);
+                return it->second.block;
+            }
+
+            shard.lru.push_front(key);
+            shard.blocks.emplace(key, ShardEntry{block, shard.lru.begin()});
+            shard.bytes += block->size();
+            evictOverBudget(shard, evicted);
+        }
+        if (evictionHandler) {
+            for (auto& [key, victim] : evicted) {
+                evictionHandler(key.file, key.block, std::move(victim));
+            }
+        }
+        return block;
+    }
+
+    // Returns a view of [offset, offset + length) inside one cached block,
+    // or an empty view if the block is missing or the range crosses it.
+    FileView view(uint64_t file, size_t offset, size_t length) {
+        auto block = lookup(file, offset / blockSize);
+        if (!block) return {};
+
+        size_t blockOffset = offset % blockSize;
+        if (blockOffset >= block->size()) return {};
+        if (blockOffset + length > block->size()) return {};
+
+        const char* bytes = block->bytes() + blockOffset;
+        return FileView(std::move(block), bytes, length);
+    }
+
+    // Copies [offset, offset + size) out of cached blocks only.
+    // Returns the number of bytes served before the first missing block.
+    size_t read(uint64_t file, size_t offset, void* buffer, size_t size) {
+        char* out = static_cast<char*>(buffer);
+        size_t copied = 0;
+        while (copied < size) {
+            size_t position = offset + copied;
+            auto block = lookup(file, position / blockSize);
+            if (!block) break;
+
+            size_t blockOffset = position % blockSize;
+            if (blockOffset >= block->size()) break;
+
+            size_t count = std::min(size - copied, block->size() - blockOffset);
+            std::memcpy(out + copied, block->bytes() + blockOffset, count);
+            copied += count;
+            if (block->size() < blockSize) break; // Last block of the file
+        }
+        return copied;
+    }
+
+    // Drops every cached block of a file (after writes or truncation)
+    void invalidate(uint64_t file) {
+        for (auto& shard : shards) {
+            std::lock_guard lock(shard.mutex);
+            for (auto it = shard.blocks.begin(); it != shard.blocks.end();) {
+                if (it->first.file == file) {
+                    shard.bytes -= it->second.block->size();
+                    shard.lru.erase(it->second.lruPos);
+                    it = shard.blocks.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    // Drops the cached blocks of every file whose path starts with prefix
+    // (e.g. when a directory tree switches representation). Returns the
+    // ids of those files.
+    std::unordered_set<uint64_t> invalidatePrefix(const std::string& prefix) {
+        std::unordered_set<uint64_t> files;
+        {
+            std::shared_lock lock(idMutex);
+            for (const auto& [path, id] : fileIds) {
+                if (path.compare(0, prefix.size(), prefix) == 0) {
+                    files.insert(id);
+                }
+            }
+        }
+        if (files.empty()) {
+            return files;
+        }
+        for (auto& shard : shards) {
+            std::lock_guard lock(shard.mutex);
+            for (auto it = shard.blocks.begin(); it != shard.blocks.end();) {
+                if (files.count(it->first.file)) {
+                    shard.bytes -= it->second.block->size();
+                    shard.lru.erase(it->second.lruPos);
+                    it = shard.blocks.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        return files;
+    }
+
+    Stats getStats() {
+        Stats stats{0, 0, 0, 0};
+        for (auto& shard : shards) {
+            std::lock_guard lock(shard.mutex);
+            stats.hits += shard.hits;
+            stats.misses += shard.misses;
+            stats.evictions += shard.evictions;
+            stats.bytesCached += shard.bytes;
+        }
+        return stats;
+    }
+
+private:
+    struct BlockKey {
+        uint64_t file;
+        uint64_t block;
+
+        bool operator==(const BlockKey& other) const {
+            return file == other.file && block == other.block;
+        }
+    };
+
+    struct BlockKeyHash {
+        size_t operator()(const BlockKey& key) const {
+            // 64-bit mix so sequential blocks spread across buckets and shards
+            uint64_t h = key.file * 0x9E3779B97F4A7C15ULL ^ key.block;
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 33;
+            return static_cast<size_t>(h);
+        }
+    };
+
+    struct ShardEntry {
+        BlockRef block;
+        std::list<BlockKey>::iterator lruPos;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<BlockKey, ShardEntry, BlockKeyHash> blocks;
+        std::list<BlockKey> lru;
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    Shard& shardFor(uint64_t file, uint64_t blockIndex) {
+        return shards[BlockKeyHash{}({file, blockIndex}) % SHARD_COUNT];
+    }
+
+    void evictOverBudget(Shard& shard, std::vector<std::pair<BlockKey, BlockRef>>& evicted) {
+        auto pos = shard.lru.end();
+        while (shard.bytes > shardCapacity && pos != shard.lru.begin()) {
+            --pos;
+            auto it = shard.blocks.find(*pos);
+            if (it->second.block.use_count() > 1) {
+                continue; // Pinned by a FileView or an in-flight read
+            }
+            shard.bytes -= it->second.block->size();
+            evicted.emplace_back(it->first, std::move(it->second.block));
+            shard.blocks.erase(it);
+            pos = shard.lru.erase(pos);
+            shard.evictions++;
+        }
+    }
+
+    const size_t blockSize;
+    const size_t shardCapacity;
+    std::array<Shard, SHARD_COUNT> shards;
+
+    std::shared_mutex idMutex;
+    std::unordered_map<std::string, uint64_t> fileIds;
+    uint64_t nextFileId = 1;
+    EvictionHandler evictionHandler;
+};
+
+} // namespace FileSystem
+} // namespace Kernel
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef READAHEAD_HPP
+#define READAHEAD_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+
+namespace Kernel {
+namespace FileSystem {
+
+// Per-descriptor access pattern detector. Works in page cache block units:
+// sequential runs double the readahead window, a repeated fixed step
+// prefetches along the stride, and random access shrinks the window.
+class ReadaheadState {
+public:
+    static constexpr size_t MIN_WINDOW = 1;
+    static constexpr size_t MAX_WINDOW = 32;
+    static constexpr size_t MAX_STRIDE_WINDOW = 8;
+    static constexpr size_t MAX_OUTSTANDING = 256;
+
+    enum class Pattern {
+        Unknown,
+        Sequential,
+        Strided,
+        Random
+    };
+
+    struct Result {
+        std::vector<uint64_t> prefetch; // Blocks to fetch into the page cache
+        uint64_t hits = 0;              // Accessed blocks that were prefetched
+        uint64_t wasted = 0;            // Prefetched blocks given up on
+    };
+
+    // Records a read covering blocks [firstBlock, lastBlock]
+    Result onAccess(uint64_t firstBlock, uint64_t lastBlock) {
+        Result result;
+        for (uint64_t block = firstBlock; block <= lastBlock; block++) {
+            result.hits += outstanding.erase(block);
+        }
+
+        if (!hasHistory) {
+            hasHistory = true;
+            // Reads starting at the head of a file are almost always streams
+            pattern = firstBlock == 0 ? Pattern::Sequential : Pattern::Unknown;
+        } else if (firstBlock == lastLastBlock || firstBlock == lastLastBlock + 1) {
+            pattern = Pattern::Sequential;
+            if (lastBlock > lastLastBlock) {
+                // Grow only when the stream advances, not on small reads within a block
+                window = std::min(window * 2, MAX_WINDOW);
+            }
+            strideHits = 0;
+        } else {
+            int64_t step = static_cast<int64_t>(firstBlock) - static_cast<int64_t>(lastFirstBlock);
+            if (step != 0 && step == stride) {
+                strideHits++;
+            } else {
+                stride = step;
+                strideHits = 0;
+            }
+
+            if (strideHits >= 1) {
+                pattern = Pattern::Strided;
+                window = std::min(window * 2, MAX_STRIDE_WINDOW);
+            } else {
+                pattern = Pattern::Random;
+                window = std::max(window / 2, MIN_WINDOW);
+                result.wasted += outstanding.size();
+                outstanding.clear();
+                prefetchedUpTo = 0;
+            }
+        }
+
+        if (pattern == Pattern::Sequential) {
+            // Only issue blocks past what an earlier window already covered
+            uint64_t from = std::max(lastBlock + 1, prefetchedUpTo);
+            uint64_t to = lastBlock + window;
+            for (uint64_t block = from; block <= to; block++) {
+                track(block, result);
+            }
+            prefetchedUpTo = std::max(prefetchedUpTo, to + 1);
+        } else if (pattern == Pattern::Strided) {
+            int64_t next = static_cast<int64_t>(firstBlock);
+            for (size_t i = 0; i < window; i++) {
+                next += stride;
+                if (next < 0) break;
+                if (!outstanding.count(static_cast<uint64_t>(next))) {
+                    track(static_cast<uint64_t>(next), result);
+                }
+            }
+        }
+
+        lastFirstBlock = firstBlock;
+        lastLastBlock = lastBlock;
+        return result;
+    }
+
+    // Prefetched blocks never read before the descriptor closes are waste
+    uint64_t reset() {
+        uint64_t wasted = outstanding.size();
+        *this = ReadaheadState();
+        return wasted;
+    }
+
+    Pattern getPattern() const { return pattern; }
+    size_t getWindow() const { return window; }
+
+private:
+    void track(uint64_t block, Result& result) {
+        if (outstanding.size() >= MAX_OUTSTANDING) {
+            outstanding.erase(outstanding.begin());
+            result.wasted++;
+        }
+        outstanding.insert(block);
+        result.prefetch.push_back(block);
+    }
+
+    Pattern pattern = Pattern::Unknown;
+    bool hasHistory = false;
+    uint64_t lastFirstBlock = 0;
+    uint64_t lastLastBlock = 0;
+    uint64_t prefetchedUpTo = 0;
+    int64_t stride = 0;
+    uint32_t strideHits = 0;
+    size_t window = MIN_WINDOW;
+    std::unordered_set<uint64_t> outstanding;
+};
+
+// Queues predicted blocks of path on an async engine; completions land in
+// the page cache. prepare(blockIndex, data) turns the raw file bytes into
+// what the cache holds, e.g. decrypting them as a demand fill would, and
+// returns false to drop the block. Blocks past fileSize or already cached
+// are skipped.
+template<typename Engine, typename Cache, typename Prepare>
+void prefetchBlocks(Engine& engine, Cache& cache, const std::string& path, uint64_t fileId,
+                    size_t fileSize, const std::vector<uint64_t>& blocks, Prepare prepare) {
+    const size_t blockSize = cache.getBlockSize();
+    for (uint64_t blockIndex : blocks) {
+        if (blockIndex * blockSize >= fileSize) continue;
+        if (cache.contains(fileId, blockIndex)) continue;
+
+        engine.readAsync(path, blockIndex * blockSize, blockSize,
+            [&cache, fileId, blockIndex, prepare](ssize_t result, std::vector<char> data) mutable {
+                if (result < 0 || !prepare(blockIndex, data)) return;
+                cache.insert(fileId, blockIndex, std::move(data));
+            });
+    }
+}
+
+} // namespace FileSystem
+} // namespace Kernel
+
+#endif
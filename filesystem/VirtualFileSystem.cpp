@@ -1,6 +1,11 @@
 
 #include "kernel/filesystem/VirtualFileSystem.hpp"
 #include "kernel/filesystem/FileCache.hpp"
+#include "kernel/filesystem/PageCache.hpp"
+#include "kernel/filesystem/AsyncIOEngine.hpp"
+#include "kernel/filesystem/CompressionManager.hpp"
+#include "kernel/filesystem/WorkerPool.hpp"
+#include "kernel/filesystem/EvictionPolicy.hpp"
 #include "kernel/include/types.hpp"
 #include "kernel/loggin/EventLogger.hpp"
 #include 
@@ -10,199 +15,299 @@
 #include 
 #include 
 #include 
+#include <cstdio>
+#include <future>
+#include <system_error>
+#include <shared_mutex>
+#include <openssl/rand.h>
 
 namespace Kernel {
 namespace FileSystem {
 
-// Compression Manager Implementation
-class CompressionManager {
-    static constexpr size_t COMPRESS_THRESHOLD = 4096;
-    
-    struct CompressionStats {
-        std::atomic bytes_saved{0};
-        std::atomic total_compressed{0};
-    } stats;
-
+// File System Encryption
+// Block-addressable encryption for mounted files: every 4 KB block is
+// XTS-AES-256 encrypted with a tweak derived from (file, block), so a
+// random read decrypts only the blocks it touches and blocks can be
+// processed concurrently. Whole buffers (cache entries, keystores) are
+// sealed with AES-256-GCM instead. Cipher contexts are created once per
+// thread and only have their IV/tweak reset per call; OpenSSL dispatches
+// to AES-NI/VAES when the CPU has it.
+class EncryptionManager {
 public:
-    std::vector compress(const std::vector& data) {
-        if(data.size() < COMPRESS_THRESHOLD) return data;
-        
-        // Use zlib for compression
-        z_stream strm;
-        strm.zalloc = Z_NULL;
-        strm.zfree = Z_NULL; 
-        strm.opaque = Z_NULL;
-        
-        if (deflateInit(&strm, Z_BEST_COMPRESSION) != Z_OK) {
-            return data;
-        }
+    static constexpr size_t BLOCK_SIZE = 4096;
+    static constexpr size_t GCM_NONCE_SIZE = 12;
+    static constexpr size_t GCM_TAG_SIZE = 16;
+    static constexpr const char* KEYSTORE_PATH = "keystore.bin";
+    // Blocks before fanning out: 1 MB, well above one 64 KB cache block, so
+    // page-cache fills stay on the calling thread
+    static constexpr size_t PARALLEL_THRESHOLD = 256;
 
-        std::vector compressed(data.size());
-        
-        strm.avail_in = data.size();
-        strm.next_in = (Bytef*)data.data();
-        strm.avail_out = compressed.size();
-        strm.next_out = (Bytef*)compressed.data();
+private:
+    struct KeyMaterial {
+        uint8_t xts[64];  // XTS data key + tweak key
+        uint8_t tail[32]; // CTR key for units shorter than one AES block
+        uint8_t seal[32]; // GCM key for whole-buffer sealing
+    };
 
-        int ret = deflate(&strm, Z_FINISH);
-        deflateEnd(&strm);
+    // Per-thread contexts, rebuilt when the owning manager or key changes
+    struct ThreadContexts {
+        uint64_t owner = 0;
+        uint64_t keyVersion = 0;
+        EVP_CIPHER_CTX* xtsEncrypt = nullptr;
+        EVP_CIPHER_CTX* xtsDecrypt = nullptr;
+        EVP_CIPHER_CTX* tail = nullptr;
+        EVP_CIPHER_CTX* sealEncrypt = nullptr;
+        EVP_CIPHER_CTX* sealDecrypt = nullptr;
 
-        if (ret != Z_STREAM_END) {
-            return data;
+        ~ThreadContexts() {
+            for(auto* ctx : {xtsEncrypt, xtsDecrypt, tail, sealEncrypt, sealDecrypt}) {
+                EVP_CIPHER_CTX_free(ctx);
+            }
         }
+    };
 
-        compressed.resize(strm.total_out);
-        
-        if(compressed.size() < data.size()) {
-            stats.bytes_saved += (data.size() - compressed.size());
-            stats.total_compressed++;
-            return compressed;
-        }
-        return data;
+    static inline std::atomic<uint64_t> nextInstanceId{1};
+
+    KeyMaterial key{};
+    std::shared_mutex key_mutex;
+    std::mutex init_mutex;
+    std::atomic<uint64_t> keyVersion{0};
+    const uint64_t instanceId = nextInstanceId++;
+    size_t workerCount;
+    WorkerPool& pool;
+
+public:
+    explicit EncryptionManager(size_t workers = std::thread::hardware_concurrency(),
+                               WorkerPool& pool = WorkerPool::shared())
+        : workerCount(std::max<size_t>(workers, 1)), pool(pool) {}
+
+    ~EncryptionManager() {
+        OPENSSL_cleanse(&key, sizeof(key));
     }
-    
-    std::vector decompress(const std::vector& data) {
-        z_stream strm;
-        strm.zalloc = Z_NULL;
-        strm.zfree = Z_NULL;
-        strm.opaque = Z_NULL;
-        
-        if (inflateInit(&strm) != Z_OK) {
-            return data;
-        }
 
-        std::vector decompressed(data.size() * 2); // Initial estimate
-        
-        strm.avail_in = data.size();
-        strm.next_in = (Bytef*)data.data();
-        strm.avail_out = decompressed.size();
-        strm.next_out = (Bytef*)decompressed.data();
+    bool isInitialized() const { return keyVersion.load(std::memory_order_acquire) != 0; }
 
-        while (true) {
-            int ret = inflate(&strm, Z_NO_FLUSH);
-            
-            if (ret == Z_STREAM_END) {
-                break;
-            }
-            
-            if (ret != Z_OK) {
-                inflateEnd(&strm);
-                return data;
-            }
+    // Loads keystore.bin when it exists; otherwise generates a key and
+    // persists it. The key is installed only once it is safely on disk, so
+    // encrypted roots stay readable across restarts.
+    bool initialize() {
+        // Concurrent first users must not each generate and persist a key
+        std::lock_guard initLock(init_mutex);
+        if(isInitialized()) return true;
 
-            // Expand buffer if needed
-            if (strm.avail_out == 0) {
-                size_t currentSize = decompressed.size();
-                decompressed.resize(currentSize * 2);
-                strm.next_out = (Bytef*)(decompressed.data() + currentSize);
-                strm.avail_out = currentSize;
-            }
+        KeyMaterial material;
+        std::ifstream existing(KEYSTORE_PATH, std::ios::binary);
+        if(existing) {
+            if(!readKeystore(existing, material)) return false;
+        } else if(!createKeystore(material)) {
+            return false;
         }
 
-        decompressed.resize(strm.total_out);
-        inflateEnd(&strm);
-        return decompressed;
+        {
+            std::unique_lock lock(key_mutex);
+            key = material;
+            keyVersion++;
+        }
+        OPENSSL_cleanse(&material, sizeof(material));
+        return true;
     }
-};
 
-// File System Encryption
-class EncryptionManager {
-    std::vector key;
-    std::mutex key_mutex;
+    // Length-preserving; out may equal in. length is at most BLOCK_SIZE.
+    bool encryptBlock(uint64_t fileId, uint64_t blockIndex, const char* in, char* out,
+                      size_t length) {
+        return transformBlock(fileId, blockIndex, in, out, length, true);
+    }
 
-public:
-    bool initialize() {
-        std::lock_guard lock(key_mutex);
-        
-        // Generate random 256-bit key using secure random number generator
-        std::random_device rd;
-        std::mt19937_64 gen(rd());
-        std::uniform_int_distribution dis;
+    bool decryptBlock(uint64_t fileId, uint64_t blockIndex, const char* in, char* out,
+                      size_t length) {
+        return transformBlock(fileId, blockIndex, in, out, length, false);
+    }
 
-        key.resize(32);
-        for(int i = 0; i < 32; i++) {
-            key[i] = dis(gen);
-        }
+    // Consecutive blocks starting at firstBlock; large ranges run on several threads
+    bool encryptBlocks(uint64_t fileId, uint64_t firstBlock, const char* in, char* out,
+                       size_t length) {
+        return transformBlocks(fileId, firstBlock, in, out, length, true);
+    }
 
-        // Save key securely
-        std::ofstream keyFile("keystore.bin", std::ios::binary);
-        if(!keyFile) return false;
+    bool decryptBlocks(uint64_t fileId, uint64_t firstBlock, const char* in, char* out,
+                       size_t length) {
+        return transformBlocks(fileId, firstBlock, in, out, length, false);
+    }
 
-        // Add salt and iteration count for key derivation
-        uint8_t salt[16];
-        for(int i = 0; i < 16; i++) salt[i] = dis(gen);
-        
-        uint32_t iterations = 10000;
-        
-        keyFile.write((char*)salt, sizeof(salt));
-        keyFile.write((char*)&iterations, sizeof(iterations));
-        keyFile.write((char*)key.data(), key.size());
+    // Sealed layout: nonce | tag | ciphertext
+    std::vector<char> encrypt(const std::vector<char>& data) {
+        ThreadContexts& ctx = contexts();
+        std::vector<char> sealed(GCM_NONCE_SIZE + GCM_TAG_SIZE + data.size());
+        auto* nonce = reinterpret_cast<unsigned char*>(sealed.data());
+        auto* tag = nonce + GCM_NONCE_SIZE;
+        auto* cipherText = tag + GCM_TAG_SIZE;
 
-        return true;
+        int outlen1 = 0, outlen2 = 0;
+        if(RAND_bytes(nonce, GCM_NONCE_SIZE) != 1 ||
+           EVP_EncryptInit_ex(ctx.sealEncrypt, nullptr, nullptr, nullptr, nonce) != 1 ||
+           EVP_EncryptUpdate(ctx.sealEncrypt, cipherText, &outlen1,
+                             reinterpret_cast<const unsigned char*>(data.data()),
+                             static_cast<int>(data.size())) != 1 ||
+           EVP_EncryptFinal_ex(ctx.sealEncrypt, cipherText + outlen1, &outlen2) != 1 ||
+           EVP_CIPHER_CTX_ctrl(ctx.sealEncrypt, EVP_CTRL_GCM_GET_TAG, GCM_TAG_SIZE, tag) != 1) {
+            return {};
+        }
+        return sealed;
     }
     
-    std::vector encrypt(const std::vector& data) {
-        std::lock_guard lock(key_mutex);
-        
-        // Generate random IV
-        std::vector iv(16);
-        std::random_device rd;
-        std::mt19937_64 gen(rd());
-        std::uniform_int_distribution dis;
-        for(int i = 0; i < 16; i++) {
-            iv[i] = dis(gen);
+    // Returns empty when the data was tampered with or sealed under another key
+    std::vector<char> decrypt(const std::vector<char>& data) {
+        if(data.size() < GCM_NONCE_SIZE + GCM_TAG_SIZE) return {};
+
+        ThreadContexts& ctx = contexts();
+        auto* nonce = reinterpret_cast<const unsigned char*>(data.data());
+        auto* tag = nonce + GCM_NONCE_SIZE;
+        auto* cipherText = tag + GCM_TAG_SIZE;
+        std::vector<char> decrypted(data.size() - GCM_NONCE_SIZE - GCM_TAG_SIZE);
+        auto* plainText = reinterpret_cast<unsigned char*>(decrypted.data());
+
+        int outlen1 = 0, outlen2 = 0;
+        if(EVP_DecryptInit_ex(ctx.sealDecrypt, nullptr, nullptr, nullptr, nonce) != 1 ||
+           EVP_DecryptUpdate(ctx.sealDecrypt, plainText, &outlen1, cipherText,
+                             static_cast<int>(decrypted.size())) != 1 ||
+           EVP_CIPHER_CTX_ctrl(ctx.sealDecrypt, EVP_CTRL_GCM_SET_TAG, GCM_TAG_SIZE,
+                               const_cast<unsigned char*>(tag)) != 1 ||
+           EVP_DecryptFinal_ex(ctx.sealDecrypt, plainText + outlen1, &outlen2) != 1) {
+            return {};
         }
+        return decrypted;
+    }
 
-        // Initialize AES in CBC mode
-        EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
-        EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, key.data(), iv.data());
+    // Stable per-path id for tweaks; page cache ids are per-process
+    static uint64_t fileIdFor(const std::string& path) {
+        uint64_t hash = 14695981039346656037ULL; // FNV-1a
+        for(unsigned char c : path) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        return hash;
+    }
 
-        // Allocate encrypted buffer with space for padding
-        std::vector encrypted(data.size() + EVP_MAX_BLOCK_LENGTH);
-        int outlen1, outlen2;
+    static bool hasAesNi() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+        return __builtin_cpu_supports("aes");
+#else
+        return false;
+#endif
+    }
 
-        // Encrypt data
-        EVP_EncryptUpdate(ctx, (unsigned char*)encrypted.data(), &outlen1,
-                          (unsigned char*)data.data(), data.size());
-        EVP_EncryptFinal_ex(ctx, (unsigned char*)(encrypted.data() + outlen1), &outlen2);
+private:
+    ThreadContexts& contexts() {
+        thread_local ThreadContexts local;
+        if(local.owner == instanceId &&
+           local.keyVersion == keyVersion.load(std::memory_order_acquire)) {
+            return local;
+        }
 
-        EVP_CIPHER_CTX_free(ctx);
+        // Expand the key schedules once; later calls only reset IVs
+        std::shared_lock lock(key_mutex);
+        auto ensure = [](EVP_CIPHER_CTX*& ctx) {
+            if(!ctx) ctx = EVP_CIPHER_CTX_new();
+            return ctx;
+        };
+        EVP_CipherInit_ex(ensure(local.xtsEncrypt), EVP_aes_256_xts(), nullptr, key.xts, nullptr, 1);
+        EVP_CipherInit_ex(ensure(local.xtsDecrypt), EVP_aes_256_xts(), nullptr, key.xts, nullptr, 0);
+        EVP_CipherInit_ex(ensure(local.tail), EVP_aes_256_ctr(), nullptr, key.tail, nullptr, 1);
+        EVP_EncryptInit_ex(ensure(local.sealEncrypt), EVP_aes_256_gcm(), nullptr, key.seal, nullptr);
+        EVP_DecryptInit_ex(ensure(local.sealDecrypt), EVP_aes_256_gcm(), nullptr, key.seal, nullptr);
+        local.owner = instanceId;
+        local.keyVersion = keyVersion.load(std::memory_order_acquire);
+        return local;
+    }
 
-        // Resize to actual encrypted size
-        encrypted.resize(outlen1 + outlen2);
+    // Keystore layout: salt[16], uint32 iteration count, KeyMaterial
+    static bool readKeystore(std::istream& in, KeyMaterial& material) {
+        uint8_t salt[16];
+        uint32_t iterations = 0;
+        in.read(reinterpret_cast<char*>(salt), sizeof(salt));
+        in.read(reinterpret_cast<char*>(&iterations), sizeof(iterations));
+        in.read(reinterpret_cast<char*>(&material), sizeof(material));
+        if(!in || std::memcmp(material.xts, material.xts + 32, 32) == 0) {
+            OPENSSL_cleanse(&material, sizeof(material));
+            EventLogger::log("Unreadable keystore: " + std::string(KEYSTORE_PATH));
+            return false;
+        }
+        return true;
+    }
 
-        // Prepend IV to encrypted data
-        encrypted.insert(encrypted.begin(), iv.begin(), iv.end());
-        
-        return encrypted;
+    // Written to a temporary file and renamed, so a failed write never
+    // leaves a truncated keystore behind
+    static bool createKeystore(KeyMaterial& material) {
+        uint8_t salt[16];
+        if(RAND_bytes(reinterpret_cast<unsigned char*>(&material), sizeof(material)) != 1 ||
+           RAND_bytes(salt, sizeof(salt)) != 1) {
+            return false;
+        }
+        // OpenSSL rejects XTS keys whose halves are equal
+        if(std::memcmp(material.xts, material.xts + 32, 32) == 0) return false;
+
+        const std::string staging = std::string(KEYSTORE_PATH) + ".tmp";
+        uint32_t iterations = 10000;
+        std::ofstream keyFile(staging, std::ios::binary | std::ios::trunc);
+        keyFile.write(reinterpret_cast<const char*>(salt), sizeof(salt));
+        keyFile.write(reinterpret_cast<const char*>(&iterations), sizeof(iterations));
+        keyFile.write(reinterpret_cast<const char*>(&material), sizeof(material));
+        keyFile.close();
+        if(!keyFile || std::rename(staging.c_str(), KEYSTORE_PATH) != 0) {
+            std::remove(staging.c_str());
+            OPENSSL_cleanse(&material, sizeof(material));
+            EventLogger::log("Failed to persist keystore: " + std::string(KEYSTORE_PATH));
+            return false;
+        }
+        return true;
     }
-    
-    std::vector decrypt(const std::vector& data) {
-        std::lock_guard lock(key_mutex);
 
-        // Extract IV from beginning of data
-        std::vector iv(data.begin(), data.begin() + 16);
-        std::vector encryptedData(data.begin() + 16, data.end());
+    // Tweak/IV: block index in the low 8 bytes, file id in the high 8
+    static void makeTweak(uint64_t fileId, uint64_t blockIndex, unsigned char tweak[16]) {
+        for(int i = 0; i < 8; i++) {
+            tweak[i] = static_cast<unsigned char>(blockIndex >> (8 * i));
+            tweak[8 + i] = static_cast<unsigned char>(fileId >> (8 * i));
+        }
+    }
 
-        // Initialize AES in CBC mode
-        EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
-        EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, key.data(), iv.data());
+    bool transformBlock(uint64_t fileId, uint64_t blockIndex, const char* in, char* out,
+                        size_t length, bool encrypting) {
+        if(length == 0) return true;
+        if(length > BLOCK_SIZE) return false;
 
-        // Allocate decrypted buffer
-        std::vector decrypted(encryptedData.size());
-        int outlen1, outlen2;
+        ThreadContexts& ctx = contexts();
+        unsigned char tweak[16];
+        makeTweak(fileId, blockIndex, tweak);
 
-        // Decrypt data
-        EVP_DecryptUpdate(ctx, (unsigned char*)decrypted.data(), &outlen1,
-                          (unsigned char*)encryptedData.data(), encryptedData.size());
-        EVP_DecryptFinal_ex(ctx, (unsigned char*)(decrypted.data() + outlen1), &outlen2);
+        // XTS needs at least one AES block; shorter file tails use CTR
+        EVP_CIPHER_CTX* cipher = length < 16 ? ctx.tail
+            : encrypting ? ctx.xtsEncrypt : ctx.xtsDecrypt;
+        int outlen1 = 0, outlen2 = 0;
+        auto* dst = reinterpret_cast<unsigned char*>(out);
+        return EVP_CipherInit_ex(cipher, nullptr, nullptr, nullptr, tweak, -1) == 1 &&
+               EVP_CipherUpdate(cipher, dst, &outlen1,
+                                reinterpret_cast<const unsigned char*>(in),
+                                static_cast<int>(length)) == 1 &&
+               EVP_CipherFinal_ex(cipher, dst + outlen1, &outlen2) == 1 &&
+               static_cast<size_t>(outlen1 + outlen2) == length;
+    }
 
-        EVP_CIPHER_CTX_free(ctx);
+    bool transformBlocks(uint64_t fileId, uint64_t firstBlock, const char* in, char* out,
+                         size_t length, bool encrypting) {
+        const size_t blockCount = (length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        std::atomic<bool> ok{true};
 
-        // Resize to actual decrypted size
-        decrypted.resize(outlen1 + outlen2);
-        
-        return decrypted;
+        // Pool threads keep their cipher contexts from one call to the next
+        size_t workers = blockCount >= PARALLEL_THRESHOLD
+            ? std::min(workerCount, blockCount / (PARALLEL_THRESHOLD / 2)) : 1;
+        pool.parallelFor(blockCount, workers, [&](size_t i) {
+            size_t begin = i * BLOCK_SIZE;
+            size_t size = std::min(BLOCK_SIZE, length - begin);
+            if(ok && !transformBlock(fileId, firstBlock + i, in + begin, out + begin, size,
+                                     encrypting)) {
+                ok = false;
+            }
+        });
+        return ok;
     }
 };
 
@@ -277,40 +382,38 @@ public:
 };
 
 // Multi-level Cache Implementation
+// Levels are exclusive: a hit in a lower level promotes the entry to L1 and
+// entries evicted from level N are demoted into level N+1. Each level has
+// its own lock, byte budget and O(1) eviction policy, so there is no
+// periodic sweep holding every level at once.
 class MultiLevelCache {
+public:
     struct CacheEntry {
-        std::vector data;
+        std::vector<char> data;
         std::chrono::steady_clock::time_point timestamp;
         bool dirty = false;
+        bool compressed = false; // data is in the framed format
     };
 
+private:
     struct CacheLevel {
-        size_t size;
-        double hit_ratio;
-        std::unordered_map data;
-        std::atomic hit_count{0};
-        std::atomic miss_count{0};
+        std::mutex mutex;
+        size_t budget;
+        size_t usedBytes = 0;
+        double hit_ratio = 0.0;
+        std::unordered_map<std::string, CacheEntry> data;
+        std::unique_ptr<EvictionPolicy> policy;
+        std::atomic<uint64_t> hit_count{0};
+        std::atomic<uint64_t> miss_count{0};
+        std::atomic<uint64_t> evictions{0};
     };
 
-    struct CacheMetrics {
-        size_t levelIndex;
-        size_t usedSize;
-        size_t totalSize; 
-        double hitRatio;
-    };
-
-    struct AccessPattern {
-        std::chrono::steady_clock::time_point lastAccess;
-        size_t accessCount = 0;
-        size_t levelIndex;
-        size_t size;
-    };
-
-    std::vector levels;
-    std::shared_mutex cache_mutex;
+    std::vector<std::unique_ptr<CacheLevel>> levels;
+    EvictionPolicyType policyType;
 
 public:
-    MultiLevelCache() {
+    explicit MultiLevelCache(EvictionPolicyType policyType = EvictionPolicyType::WTinyLFU)
+        : policyType(policyType) {
         // Initialize cache levels (L1: 1MB, L2: 8MB, L3: 32MB)
         addLevel(1 * 1024 * 1024);
         addLevel(8 * 1024 * 1024);
@@ -318,163 +421,202 @@ public:
     }
 
     void addLevel(size_t size) {
-        levels.push_back({size, 0.0, {}});
+        auto level = std::make_unique<CacheLevel>();
+        level->budget = size;
+        level->policy = createEvictionPolicy(policyType, size);
+        levels.push_back(std::move(level));
     }
     
-    bool get(const std::string& key, std::vector& data) {
-        std::shared_lock lock(cache_mutex);
+    bool get(const std::string& key, std::vector<char>& data) {
         for(size_t i = 0; i < levels.size(); i++) {
-            auto& level = levels[i];
-            auto it = level.data.find(key);
-            if(it != level.data.end()) {
-                data = it->second.data;
-                it->second.timestamp = std::chrono::steady_clock::now();
+            auto& level = *levels[i];
+            CacheEntry promoted;
+            {
+                std::lock_guard lock(level.mutex);
+                auto it = level.data.find(key);
+                if(it == level.data.end()) {
+                    level.miss_count++;
+                    continue;
+                }
                 level.hit_count++;
-                promoteToHigherLevel(key, data, i);
-                return true;
+                it->second.timestamp = std::chrono::steady_clock::now();
+                data = it->second.data;
+                if(i == 0) {
+                    level.policy->onAccess(key);
+                    return true;
+                }
+                // Lower-level hit: move the entry up to L1
+                promoted = std::move(it->second);
+                level.usedBytes -= promoted.data.size();
+                level.policy->onRemove(key);
+                level.data.erase(it);
             }
-            level.miss_count++;
+            insertIntoLevel(0, key, std::move(promoted));
+            return true;
         }
         return false;
     }
     
-    void put(const std::string& key, const std::vector& data, bool dirty) {
-        std::lock_guard lock(cache_mutex);
+    void put(const std::string& key, const std::vector<char>& data, bool dirty = false) {
         for(size_t i = 0; i < levels.size(); i++) {
-            auto& level = levels[i];
-            auto it = level.data.find(key);
-            if(it != level.data.end()) {
+            auto& level = *levels[i];
+            std::vector<std::pair<std::string, CacheEntry>> demoted;
+            {
+                std::lock_guard lock(level.mutex);
+                auto it = level.data.find(key);
+                if(it == level.data.end()) continue;
+                level.usedBytes = level.usedBytes - it->second.data.size() + data.size();
                 it->second.data = data;
                 it->second.timestamp = std::chrono::steady_clock::now();
                 it->second.dirty = dirty;
-                return;
+                it->second.compressed = false;
+                level.policy->onResize(key, data.size());
+                level.policy->onAccess(key);
+                demoted = evictOverBudget(level);
             }
+            demote(i, std::move(demoted));
+            return;
         }
-        levels[0].data[key] = {data, std::chrono::steady_clock::now(), dirty};
+        insertIntoLevel(0, key, {data, std::chrono::steady_clock::now(), dirty});
     }
     
-    void expandLevel(size_t level, size_t size) {
-        std::lock_guard lock(cache_mutex);
-        levels[level].size += size;
-    }
-    
-    void optimizeCache() {
-        std::lock_guard lock(cache_mutex);
-        
-        // Calculate current cache usage and hit rates for each level
-        std::vector levelMetrics;
-        for(size_t i = 0; i < levels.size(); i++) {
-            auto& level = levels[i];
-            
-            size_t currentSize = 0;
-            for(const auto& [key, entry] : level.data) {
-                currentSize += entry.data.size();
+    // Removes an entry from whichever level holds it, for a tier above
+    // that takes it back
+    bool take(const std::string& key, CacheEntry& entry) {
+        for(auto& level : levels) {
+            std::lock_guard lock(level->mutex);
+            auto it = level->data.find(key);
+            if(it == level->data.end()) {
+                level->miss_count++;
+                continue;
             }
-            
-            CacheMetrics metrics;
-            metrics.levelIndex = i;
-            metrics.usedSize = currentSize;
-            metrics.totalSize = level.size;
-            metrics.hitRatio = level.hit_ratio;
-            levelMetrics.push_back(metrics);
+            level->hit_count++;
+            entry = std::move(it->second);
+            level->usedBytes -= entry.data.size();
+            level->policy->onRemove(key);
+            level->data.erase(it);
+            return true;
         }
+        return false;
+    }
 
-        // Analyze access patterns
-        auto now = std::chrono::steady_clock::now();
-        std::map accessPatterns;
-        
-        for(size_t i = 0; i < levels.size(); i++) {
-            for(const auto& [key, entry] : levels[i].data) {
-                auto timeSinceAccess = std::chrono::duration_cast(
-                    now - entry.timestamp).count();
-                    
-                // Track access frequency and recency
-                accessPatterns[key].lastAccess = entry.timestamp;
-                accessPatterns[key].accessCount++;
-                accessPatterns[key].levelIndex = i;
-                accessPatterns[key].size = entry.data.size();
-            }
+    // Swaps in new contents (e.g. a compressed form) for an entry still
+    // untouched since timestamp; false if it was taken or refreshed since
+    bool replace(const std::string& key, std::chrono::steady_clock::time_point timestamp,
+                 std::vector<char> data, bool compressed) {
+        for(auto& level : levels) {
+            std::lock_guard lock(level->mutex);
+            auto it = level->data.find(key);
+            if(it == level->data.end()) continue;
+            if(it->second.timestamp != timestamp) return false;
+            level->usedBytes = level->usedBytes - it->second.data.size() + data.size();
+            level->policy->onResize(key, data.size());
+            it->second.data = std::move(data);
+            it->second.compressed = compressed;
+            return true;
         }
+        return false;
+    }
 
-        // Optimize cache levels based on metrics
-        for(size_t i = 0; i < levels.size(); i++) {
-            auto& level = levels[i];
-            
-            // If level is too full (>90%), evict least recently used entries
-            if(levelMetrics[i].usedSize > levelMetrics[i].totalSize * 0.9) {
-                std::vector> entries;
-                for(const auto& [key, entry] : level.data) {
-                    entries.emplace_back(key, entry.timestamp);
-                }
-                
-                // Sort by access time
-                std::sort(entries.begin(), entries.end(),
-                    [](const auto& a, const auto& b) {
-                        return a.second < b.second;
-                    });
-                    
-                // Remove oldest entries until usage is below 70%
-                size_t removedSize = 0;
-                for(const auto& entry : entries) {
-                    if(levelMetrics[i].usedSize - removedSize < levelMetrics[i].totalSize * 0.7) {
-                        break;
-                    }
-                    removedSize += level.data[entry.first].data.size();
-                    level.data.erase(entry.first);
+    template<typename Pred>
+    void eraseIf(Pred&& pred) {
+        for(auto& level : levels) {
+            std::lock_guard lock(level->mutex);
+            for(auto it = level->data.begin(); it != level->data.end();) {
+                if(pred(it->first)) {
+                    level->usedBytes -= it->second.data.size();
+                    level->policy->onRemove(it->first);
+                    it = level->data.erase(it);
+                } else {
+                    ++it;
                 }
             }
-            
-            // Move frequently accessed entries to higher cache level
-            if(i > 0) {
-                for(const auto& [key, entry] : level.data) {
-                    auto& pattern = accessPatterns[key];
-                    if(pattern.accessCount > 100 && // High access count
-                       std::chrono::duration_cast(
-                           now - pattern.lastAccess).count() < 60) { // Recent access
-                        
-                        // Move to higher cache level if space permits
-                        if(levelMetrics[i-1].usedSize + entry.data.size() <= levelMetrics[i-1].totalSize) {
-                            levels[i-1].data[key] = entry;
-                            level.data.erase(key);
-                        }
-                    }
-                }
-            }
-        }
-
-        // Update hit ratios
-        for(size_t i = 0; i < levels.size(); i++) {
-            uint64_t hits = levels[i].hit_count;
-            uint64_t misses = levels[i].miss_count;
-            if(hits + misses > 0) {
-                levels[i].hit_ratio = static_cast(hits) / (hits + misses);
-            }
-            // Reset counters
-            levels[i].hit_count = 0;
-            levels[i].miss_count = 0;
         }
-
-        // Log optimization results
+    }
+    
+    void expandLevel(size_t level, size_t size) {
+        std::lock_guard lock(levels[level]->mutex);
+        levels[level]->budget += size;
+        levels[level]->policy->setCapacity(levels[level]->budget);
+    }
+    
+    // Refreshes per-level hit ratios; eviction already happens inline on insert
+    void optimizeCache() {
         std::stringstream log;
         log << "Cache optimization completed:\n";
         for(size_t i = 0; i < levels.size(); i++) {
-            log << "Level " << i << ": "
-                << "Size: " << levelMetrics[i].usedSize << "/" << levelMetrics[i].totalSize
-                << " Hit ratio: " << levels[i].hit_ratio << "\n";
+            auto& level = *levels[i];
+            uint64_t hits = level.hit_count.exchange(0);
+            uint64_t misses = level.miss_count.exchange(0);
+
+            std::lock_guard lock(level.mutex);
+            if(hits + misses > 0) {
+                level.hit_ratio = static_cast<double>(hits) / (hits + misses);
+            }
+            log << "Level " << i << " (" << level.policy->name() << "): "
+                << "Size: " << level.usedBytes << "/" << level.budget
+                << " Hit ratio: " << level.hit_ratio
+                << " Evictions: " << level.evictions.load() << "\n";
         }
         EventLogger::log(log.str());
     }
     
-    std::vector getAllEntries() {
-        std::lock_guard lock(cache_mutex);
-        std::vector entries;
+    // Snapshot for background maintenance; locks one level at a time
+    std::vector<std::pair<std::string, CacheEntry>> getAllEntries() {
+        std::vector<std::pair<std::string, CacheEntry>> entries;
         for(const auto& level : levels) {
-            for(const auto& pair : level.data) {
-                entries.push_back(pair.second);
+            std::lock_guard lock(level->mutex);
+            for(const auto& pair : level->data) {
+                entries.push_back(pair);
             }
         }
         return entries;
     }
+
+private:
+    void insertIntoLevel(size_t index, const std::string& key, CacheEntry entry) {
+        auto& level = *levels[index];
+        std::vector<std::pair<std::string, CacheEntry>> demoted;
+        {
+            std::lock_guard lock(level.mutex);
+            size_t size = entry.data.size();
+            auto it = level.data.find(key);
+            if(it != level.data.end()) {
+                level.usedBytes = level.usedBytes - it->second.data.size() + size;
+                it->second = std::move(entry);
+                level.policy->onResize(key, size);
+                level.policy->onAccess(key);
+            } else {
+                level.data.emplace(key, std::move(entry));
+                level.usedBytes += size;
+                level.policy->onInsert(key, size);
+            }
+            demoted = evictOverBudget(level);
+        }
+        demote(index, std::move(demoted));
+    }
+
+    // Caller holds level.mutex; returns the evicted entries for demotion
+    std::vector<std::pair<std::string, CacheEntry>> evictOverBudget(CacheLevel& level) {
+        std::vector<std::pair<std::string, CacheEntry>> evicted;
+        std::string victim;
+        while(level.usedBytes > level.budget && level.policy->victim(victim)) {
+            auto it = level.data.find(victim);
+            if(it == level.data.end()) continue;
+            level.usedBytes -= it->second.data.size();
+            evicted.emplace_back(std::move(victim), std::move(it->second));
+            level.data.erase(it);
+            level.evictions++;
+        }
+        return evicted;
+    }
+
+    void demote(size_t index, std::vector<std::pair<std::string, CacheEntry>> entries) {
+        if(index + 1 >= levels.size()) return; // Evicted from the last level
+        for(auto& [key, entry] : entries) {
+            insertIntoLevel(index + 1, key, std::move(entry));
+        }
+    }
 };
 
 // Performance Metrics Implementation
@@ -487,6 +629,9 @@ class PerformanceMetrics {
         std::atomic total_bytes_read{0};
         std::atomic total_bytes_written{0};
         std::atomic total_bytes_compressed{0};
+        std::atomic<uint64_t> readahead_issued{0};
+        std::atomic<uint64_t> readahead_hits{0};
+        std::atomic<uint64_t> readahead_wasted{0};
         std::chrono::steady_clock::time_point start_time;
         std::vector read_latencies;
     } metrics;
@@ -509,6 +654,12 @@ public:
         metrics.total_bytes_compressed += bytes;
     }
     
+    void recordReadahead(uint64_t issued, uint64_t hits, uint64_t wasted) {
+        metrics.readahead_issued += issued;
+        metrics.readahead_hits += hits;
+        metrics.readahead_wasted += wasted;
+    }
+    
     void recordReadLatency(std::chrono::microseconds latency) {
         metrics.read_latencies.push_back(latency);
     }
@@ -523,6 +674,17 @@ public:
         return total ? (double)metrics.total_bytes_compressed / total : 0.0;
     }
     
+    // Fraction of prefetched blocks that were later read
+    double getReadaheadHitRatio() {
+        uint64_t issued = metrics.readahead_issued;
+        return issued ? (double)metrics.readahead_hits / issued : 0.0;
+    }
+    
+    double getReadaheadWasteRatio() {
+        uint64_t issued = metrics.readahead_issued;
+        return issued ? (double)metrics.readahead_wasted / issued : 0.0;
+    }
+    
     double getAverageReadLatency() {
         if(metrics.read_latencies.empty()) return 0.0;
         double sum = 0.0;
@@ -620,11 +782,17 @@ class VirtualFileSystem {
 private:
     std::unique_ptr bufferPool;
     std::unique_ptr multiLevelCache;
+    std::unique_ptr<PageCache> pageCache;
+    std::unique_ptr<AsyncIOEngine> asyncIO;
     std::unique_ptr metrics;
     std::unique_ptr compression;
     std::unique_ptr encryption;
     std::unique_ptr errorManager;
-    std::unordered_map> mappedFiles;
+    std::unordered_map<std::string, std::shared_ptr<MemoryMappedFile>> mappedFiles;
+    std::mutex mappedFilesMutex;
+    std::vector<std::string> encryptedRoots;
+    std::shared_mutex encryptedRootsMutex;
+    std::atomic<uint64_t> sizeGeneration{1}; // Bumped by fileChanged
     std::mutex mutex;
     
     // Background Tasks
@@ -633,16 +801,27 @@ private:
     std::thread compressionWorker;
     std::thread metricCollector;
     const double TARGET_THROUGHPUT = 100.0; // MB/s
+    const size_t MMAP_THRESHOLD = 1024 * 1024; // 1MB
     
 public:
     VirtualFileSystem() {
         bufferPool = std::make_unique();
         multiLevelCache = std::make_unique();
+        pageCache = std::make_unique<PageCache>();
+        asyncIO = std::make_unique<AsyncIOEngine>();
         metrics = std::make_unique();
-        compression = std::make_unique();
+        compression = std::make_unique<CompressionManager>(TARGET_THROUGHPUT);
         encryption = std::make_unique();
         errorManager = std::make_unique();
         
+        // Blocks the page cache evicts drop into the multi-level cache, whose
+        // lower levels are compressed once cold; a page cache miss checks
+        // there before going to disk
+        pageCache->setEvictionHandler(
+            [this](uint64_t file, uint64_t blockIndex, PageCache::BlockRef block) {
+                multiLevelCache->put(victimKey(file, blockIndex), block->data);
+            });
+        
         startBackgroundTasks();
         metrics->metrics.start_time = std::chrono::steady_clock::now();
     }
@@ -652,6 +831,9 @@ public:
         if(cacheManager.joinable()) cacheManager.join();
         if(compressionWorker.joinable()) compressionWorker.join();
         if(metricCollector.joinable()) metricCollector.join();
+        
+        // Drain in-flight readahead before the page cache goes away
+        asyncIO.reset();
     }
     
 private:
@@ -678,37 +860,32 @@ private:
         });
     }
     
+    // Works from a snapshot of the cache, so reads and opens are never
+    // blocked behind compression; frames are compressed in parallel
     void compressInactiveFiles() {
-        std::lock_guard lock(mutex);
-        
-        // Get list of files that haven't been accessed in last hour
+        // Evicted blocks that haven't been taken back in the last hour
         auto now = std::chrono::steady_clock::now();
-        std::vector inactiveFiles;
+        size_t compressedBlocks = 0;
         
-        for(const auto& [path, entry] : multiLevelCache->getAllEntries()) {
-            auto timeSinceAccess = std::chrono::duration_cast(
+        for(const auto& [key, entry] : multiLevelCache->getAllEntries()) {
+            auto timeSinceAccess = std::chrono::duration_cast<std::chrono::minutes>(
                 now - entry.timestamp).count();
                 
-            if(timeSinceAccess > 60) { // More than 1 hour
-                inactiveFiles.push_back(path);
+            if(timeSinceAccess <= 60 || entry.compressed) {
+                continue;
             }
-        }
-        
-        // Compress each inactive file
-        for(const auto& path : inactiveFiles) {
-            std::vector data;
-            if(multiLevelCache->get(path, data)) {
-                auto compressed = compression->compress(data);
-                if(compressed.size() < data.size()) {
-                    // Update cache with compressed data
-                    multiLevelCache->put(path, compressed, true);
-                    metrics->recordCompression(data.size() - compressed.size());
-                }
+            
+            auto compressed = compression->compress(entry.data);
+            // Skipped if a reader took the block back in the meantime
+            if(compressed.size() < entry.data.size() &&
+               multiLevelCache->replace(key, entry.timestamp, compressed, true)) {
+                metrics->recordCompression(entry.data.size() - compressed.size());
+                compressedBlocks++;
             }
         }
         
-        EventLogger::log("Compressed " + std::to_string(inactiveFiles.size()) + 
-                        " inactive files");
+        EventLogger::log("Compressed " + std::to_string(compressedBlocks) + 
+                        " inactive cache blocks");
     }
     
     void collectAndAnalyzeMetrics() {
@@ -719,6 +896,8 @@ private:
         auto compressionRatio = metrics->getCompressionRatio();
         auto averageLatency = metrics->getAverageReadLatency();
         auto throughput = metrics->getThroughput();
+        auto readaheadHitRatio = metrics->getReadaheadHitRatio();
+        auto readaheadWasteRatio = metrics->getReadaheadWasteRatio();
         
         // Log metrics
         std::stringstream ss;
@@ -728,7 +907,11 @@ private:
            << "Compression Ratio: " << std::fixed << std::setprecision(2)
            << (compressionRatio * 100) << "%\n" 
            << "Average Latency: " << averageLatency << "ms\n"
-           << "Throughput: " << throughput << " MB/s";
+           << "Throughput: " << throughput << " MB/s\n"
+           << "Readahead Hit Ratio: " << std::fixed << std::setprecision(2)
+           << (readaheadHitRatio * 100) << "%\n"
+           << "Readahead Waste Ratio: " << std::fixed << std::setprecision(2)
+           << (readaheadWasteRatio * 100) << "%";
            
         EventLogger::log(ss.str());
         
@@ -744,111 +927,388 @@ private:
         }
     }
     
+public:
+    // Zero-copy read of [offset, offset + length) that does not move the
+    // file position. Large files are served straight from the mapping; other
+    // files from the page cache, copying only when the range spans blocks.
+    FileView readView(FileDescriptor* fd, size_t offset, size_t length) {
+        if (!fd || length == 0) return {};
+        
+        auto start = std::chrono::steady_clock::now();
+        FileView view;
+        
+        // Encrypted files go through the page cache, which holds plaintext
+        if (getFileSize(fd) > MMAP_THRESHOLD && !isEncrypted(fd->path)) {
+            auto mappedFile = getMappedFile(fd->path);
+            if (!mappedFile || offset >= mappedFile->getSize()) {
+                return {};
+            }
+            size_t viewSize = std::min(length, mappedFile->getSize() - offset);
+            const char* bytes = mappedFile->getData() + offset;
+            view = FileView(std::move(mappedFile), bytes, viewSize);
+        } else {
+            if (!fd->fileId) {
+                fd->fileId = pageCache->fileId(fd->path);
+            }
+            
+            const size_t blockSize = pageCache->getBlockSize();
+            view = pageCache->view(fd->fileId, offset, length);
+            if (!view && offset / blockSize == (offset + length - 1) / blockSize) {
+                // Range fits in one block: fault it in and pin it in place
+                metrics->recordCacheMiss();
+                if (loadBlock(fd, offset / blockSize)) {
+                    view = pageCache->view(fd->fileId, offset, length);
+                }
+            } else if (view) {
+                metrics->recordCacheHit();
+            }
+            
+            if (!view) {
+                // Range spans blocks or runs past EOF: assemble a private copy
+                auto buffer = std::make_shared<std::vector<char>>(length);
+                size_t savedPosition = fd->position;
+                fd->position = offset;
+                ssize_t bytesRead = read(fd, buffer->data(), length);
+                fd->position = savedPosition;
+                if (bytesRead <= 0) {
+                    return {};
+                }
+                const char* bytes = buffer->data();
+                view = FileView(std::move(buffer), bytes, static_cast<size_t>(bytesRead));
+                return view;
+            }
+        }
+        
+        metrics->recordRead(view.size());
+        auto end = std::chrono::steady_clock::now();
+        metrics->recordReadLatency(std::chrono::duration_cast<std::chrono::microseconds>(
+            end - start));
+        return view;
+    }
+    
+    // Non-blocking read; served immediately when the page cache holds the range
+    std::future<std::vector<char>> readAsync(FileDescriptor* fd, size_t offset, size_t length) {
+        if (!fd) {
+            // A ready future carrying the error, never an invalid one
+            std::promise<std::vector<char>> failed;
+            failed.set_exception(std::make_exception_ptr(
+                std::system_error(EBADF, std::generic_category())));
+            return failed.get_future();
+        }
+        
+        if (fd->fileId) {
+            std::vector<char> data(length);
+            if (pageCache->read(fd->fileId, offset, data.data(), length) == length) {
+                metrics->recordCacheHit();
+                std::promise<std::vector<char>> ready;
+                ready.set_value(std::move(data));
+                return ready.get_future();
+            }
+        }
+        if (isEncrypted(fd->path)) {
+            return std::async(std::launch::async, [this, path = fd->path, offset, length]() {
+                return readDecrypted(path, offset, length);
+            });
+        }
+        return asyncIO->readAsync(fd->path, offset, length);
+    }
+    
+    // Level-streaming entry point: adjacent ranges are merged into single reads
+    std::vector<std::future<std::vector<char>>> readBatch(
+            const std::vector<AsyncIOEngine::ReadRequest>& requests) {
+        bool anyEncrypted = false;
+        for (const auto& request : requests) {
+            anyEncrypted = anyEncrypted || isEncrypted(request.path);
+        }
+        if (!anyEncrypted) {
+            return asyncIO->readBatch(requests);
+        }
+        
+        std::vector<std::future<std::vector<char>>> futures;
+        for (const auto& request : requests) {
+            futures.push_back(std::async(std::launch::async, [this, request]() {
+                return readDecrypted(request.path, request.offset, request.length);
+            }));
+        }
+        return futures;
+    }
+    
+    // For the descriptor table's readahead waste handler: blocks a closed
+    // descriptor prefetched and never read
+    std::function<void(uint64_t)> readaheadWasteRecorder() {
+        return [this](uint64_t wasted) { metrics->recordReadahead(0, 0, wasted); };
+    }
+    
+    // Files under root are stored XTS-encrypted per 4 KB block
+    void setEncrypted(const std::string& root, bool enabled) {
+        if (enabled && !encryption->isInitialized() && !encryption->initialize()) {
+            EventLogger::log("Failed to initialize encryption keys for " + root);
+            return;
+        }
+        
+        std::unique_lock lock(encryptedRootsMutex);
+        auto it = std::find(encryptedRoots.begin(), encryptedRoots.end(), root);
+        if (enabled && it == encryptedRoots.end()) {
+            encryptedRoots.push_back(root);
+        } else if (!enabled && it != encryptedRoots.end()) {
+            encryptedRoots.erase(it);
+        } else {
+            return;
+        }
+        lock.unlock();
+        
+        // Cached blocks under root hold the old representation
+        dropEvictedBlocks(pageCache->invalidatePrefix(root));
+    }
+    
+    // Call after fd's file is written or truncated: drops its cached
+    // blocks and mapping, and every descriptor's cached size
+    void fileChanged(FileDescriptor* fd) {
+        if (!fd) return;
+        sizeGeneration.fetch_add(1, std::memory_order_acq_rel);
+        uint64_t file = pageCache->fileId(fd->path);
+        pageCache->invalidate(file);
+        dropEvictedBlocks({file});
+        std::lock_guard lock(mappedFilesMutex);
+        mappedFiles.erase(fd->path);
+    }
+
+    // Reads uncompressed [offset, offset + length) from a framed compressed
+    // file (e.g. an asset pack). Only the header, the frame index and the
+    // overlapping frames are read from disk and decompressed.
+    std::vector<char> readCompressed(FileDescriptor* fd, size_t offset, size_t length) {
+        if (!fd || length == 0) return {};
+        
+        const size_t fileSize = getFileSize(fd);
+        CompressionManager::Header header;
+        if (asyncIO->readSync(fd->path, 0, &header, sizeof(header)) !=
+                static_cast<ssize_t>(sizeof(header)) ||
+            !CompressionManager::validHeader(header, fileSize)) {
+            EventLogger::log("Not a framed compressed file: " + fd->path);
+            return {};
+        }
+        
+        // Sized from a header already checked against the file length
+        std::vector<char> indexData(CompressionManager::indexSize(header));
+        CompressionManager::FrameIndex index;
+        if (asyncIO->readSync(fd->path, 0, indexData.data(), indexData.size()) !=
+                static_cast<ssize_t>(indexData.size()) ||
+            !CompressionManager::parseIndex(indexData.data(), indexData.size(), fileSize, index)) {
+            EventLogger::log("Not a framed compressed file: " + fd->path);
+            return {};
+        }
+        
+        std::vector<char> frameData;
+        auto data = compression->readRange(index, offset, length,
+            [&](const CompressionManager::FrameEntry& frame) -> const char* {
+                frameData.resize(frame.compressedSize);
+                ssize_t bytesRead = asyncIO->readSync(fd->path, index.payloadOffset + frame.offset,
+                                                      frameData.data(), frame.compressedSize);
+                return bytesRead == static_cast<ssize_t>(frame.compressedSize)
+                    ? frameData.data() : nullptr;
+            });
+        metrics->recordRead(data.size());
+        return data;
+    }
+    
+private:
     ssize_t read(FileDescriptor* fd, void* buffer, size_t size) {
         if (!fd || !buffer || size == 0) return -1;
         
         auto start = std::chrono::steady_clock::now();
         
-        // Try to read from cache first
-        std::vector cachedData;
-        if (multiLevelCache->get(fd->path, cachedData)) {
-            metrics->recordCacheHit();
-            size_t copySize = std::min(size, cachedData.size() - fd->position);
-            memcpy(buffer, cachedData.data() + fd->position, copySize);
-            fd->position += copySize;
-            metrics->recordRead(copySize);
-            
-            auto end = std::chrono::steady_clock::now();
-            metrics->recordReadLatency(std::chrono::duration_cast(
-                end - start).count());
-                
-            return copySize;
+        if (!fd->fileId) {
+            fd->fileId = pageCache->fileId(fd->path);
         }
         
-        metrics->recordCacheMiss();
+        // Serve the request block by block, copying only the requested range
+        const size_t blockSize = pageCache->getBlockSize();
+        char* out = static_cast<char*>(buffer);
+        size_t copied = 0;
         
-        // For large files, use memory mapping
-        if (getFileSize(fd->path) > 1024 * 1024) { // 1MB threshold
-            auto& mappedFile = mappedFiles[fd->path];
-            if (!mappedFile) {
-                mappedFile = std::make_unique();
-                if (!mappedFile->map(fd->path)) {
-                    EventLogger::log("Failed to memory map file: " + fd->path);
-                    return -1;
+        while (copied < size) {
+            size_t position = fd->position + copied;
+            uint64_t blockIndex = position / blockSize;
+            
+            auto block = pageCache->lookup(fd->fileId, blockIndex);
+            if (block) {
+                metrics->recordCacheHit();
+            } else {
+                metrics->recordCacheMiss();
+                block = loadBlock(fd, blockIndex);
+                if (!block) {
+                    if (copied == 0) return -1;
+                    break;
                 }
             }
             
-            // Read from mapped memory
-            char* mappedData = mappedFile->getData();
-            size_t mappedSize = mappedFile->getSize();
-            
-            if(fd->position >= mappedSize) {
-                return 0; // EOF
+            size_t blockOffset = position % blockSize;
+            if (blockOffset >= block->size()) {
+                break; // EOF
             }
             
-            size_t copySize = std::min(size, mappedSize - fd->position);
-            memcpy(buffer, mappedData + fd->position, copySize);
-            fd->position += copySize;
-            
-            // Update cache
-            std::vector data(mappedData + fd->position - copySize, 
-                                 mappedData + fd->position);
-            multiLevelCache->put(fd->path, data);
+            size_t copySize = std::min(size - copied, block->size() - blockOffset);
+            memcpy(out + copied, block->bytes() + blockOffset, copySize);
+            copied += copySize;
             
-            auto end = std::chrono::steady_clock::now();
-            metrics->recordReadLatency(std::chrono::duration_cast(
-                end - start).count());
-                
-            return copySize;
-        }
-        
-        // Use buffer pool for regular reads
-        auto* bufferPoolBuffer = bufferPool->acquire();
-        if (!bufferPoolBuffer) {
-            EventLogger::log("Failed to acquire buffer from pool");
-            return -1;
+            if (block->size() < blockSize) {
+                break; // Short block is the tail of the file
+            }
         }
         
-        // Perform read operation using buffer
-        std::ifstream file(fd->path, std::ios::binary);
-        if (!file) {
-            bufferPool->release(bufferPoolBuffer);
-            EventLogger::log("Failed to open file: " + fd->path);
-            return -1;
+        if (copied > 0) {
+            uint64_t firstBlock = fd->position / blockSize;
+            uint64_t lastBlock = (fd->position + copied - 1) / blockSize;
+            auto readahead = fd->readahead.onAccess(firstBlock, lastBlock);
+            issueReadahead(fd, readahead.prefetch);
+            metrics->recordReadahead(readahead.prefetch.size(), readahead.hits,
+                                     readahead.wasted);
         }
         
-        file.seekg(fd->position);
-        file.read(bufferPoolBuffer->data.data(), bufferPoolBuffer->data.size());
+        fd->position += copied;
+        metrics->recordRead(copied);
         
-        ssize_t bytesRead = file.gcount();
-        if(bytesRead > 0) {
-            size_t copySize = std::min(static_cast(bytesRead), size);
-            memcpy(buffer, bufferPoolBuffer->data.data(), copySize);
-            fd->position += copySize;
+        auto end = std::chrono::steady_clock::now();
+        metrics->recordReadLatency(std::chrono::duration_cast<std::chrono::microseconds>(
+            end - start));
             
-            // Update cache
-            std::vector data(bufferPoolBuffer->data.data(),
-                                 bufferPoolBuffer->data.data() + copySize);
-            multiLevelCache->put(fd->path, data);
+        return copied;
+    }
+    
+    // Queues predicted blocks on the async engine; completions land in the
+    // page cache, decrypted like loadBlock's so the cache only holds plaintext
+    void issueReadahead(FileDescriptor* fd, const std::vector<uint64_t>& blocks) {
+        if (blocks.empty()) return;
+        
+        const size_t blockSize = pageCache->getBlockSize();
+        const bool encrypted = isEncrypted(fd->path);
+        const uint64_t cipherFileId = encrypted ? EncryptionManager::fileIdFor(fd->path) : 0;
+        prefetchBlocks(*asyncIO, *pageCache, fd->path, fd->fileId, getFileSize(fd), blocks,
+            [this, encrypted, cipherFileId, blockSize](uint64_t blockIndex, std::vector<char>& data) {
+                return !encrypted ||
+                       encryption->decryptBlocks(cipherFileId,
+                                                 blockIndex * blockSize / EncryptionManager::BLOCK_SIZE,
+                                                 data.data(), data.data(), data.size());
+            });
+    }
+    
+    // Fills one page cache block from the multi-level cache or the backing file
+    PageCache::BlockRef loadBlock(FileDescriptor* fd, uint64_t blockIndex) {
+        const size_t blockSize = pageCache->getBlockSize();
+        const size_t blockStart = blockIndex * blockSize;
+        std::vector<char> data;
+        
+        // Evicted blocks hold plaintext, possibly compressed since
+        MultiLevelCache::CacheEntry evicted;
+        if (multiLevelCache->take(victimKey(fd->fileId, blockIndex), evicted)) {
+            if (!evicted.compressed) {
+                return pageCache->insert(fd->fileId, blockIndex, std::move(evicted.data));
+            }
+            if (compression->decompressFramed(evicted.data, data)) {
+                return pageCache->insert(fd->fileId, blockIndex, std::move(data));
+            }
+            EventLogger::log("Dropping undecodable cached block of " + fd->path);
+        }
+        
+        // For large files, use memory mapping
+        if (getFileSize(fd) > MMAP_THRESHOLD) {
+            auto mappedFile = getMappedFile(fd->path);
+            if (!mappedFile) {
+                return nullptr;
+            }
             
-            bytesRead = copySize;
+            char* mappedData = mappedFile->getData();
+            size_t mappedSize = mappedFile->getSize();
+            if (blockStart < mappedSize) {
+                size_t length = std::min(blockSize, mappedSize - blockStart);
+                data.assign(mappedData + blockStart, mappedData + blockStart + length);
+            }
+        } else {
+            data.resize(blockSize);
+            ssize_t bytesRead = asyncIO->readSync(fd->path, blockStart, data.data(), blockSize);
+            if (bytesRead < 0) {
+                EventLogger::log("Failed to read file: " + fd->path);
+                return nullptr;
+            }
+            data.resize(static_cast<size_t>(bytesRead));
         }
         
-        bufferPool->release(bufferPoolBuffer);
+        // Page cache blocks are whole multiples of the encryption block
+        if (isEncrypted(fd->path) &&
+            !encryption->decryptBlocks(EncryptionManager::fileIdFor(fd->path),
+                                       blockStart / EncryptionManager::BLOCK_SIZE,
+                                       data.data(), data.data(), data.size())) {
+            EventLogger::log("Failed to decrypt file: " + fd->path);
+            return nullptr;
+        }
         
-        auto end = std::chrono::steady_clock::now();
-        metrics->recordReadLatency(std::chrono::duration_cast(
-            end - start).count());
-            
-        return bytesRead;
+        return pageCache->insert(fd->fileId, blockIndex, std::move(data));
+    }
+    
+    bool isEncrypted(const std::string& path) {
+        std::shared_lock lock(encryptedRootsMutex);
+        for (const auto& root : encryptedRoots) {
+            if (path.compare(0, root.size(), root) == 0) return true;
+        }
+        return false;
+    }
+    
+    // Reads the covering encryption blocks and decrypts only those
+    std::vector<char> readDecrypted(const std::string& path, size_t offset, size_t length) {
+        const size_t blockSize = EncryptionManager::BLOCK_SIZE;
+        size_t alignedStart = offset / blockSize * blockSize;
+        std::vector<char> data(offset - alignedStart + length);
+        data.resize((data.size() + blockSize - 1) / blockSize * blockSize);
+        
+        ssize_t bytesRead = asyncIO->readSync(path, alignedStart, data.data(), data.size());
+        if (bytesRead <= static_cast<ssize_t>(offset - alignedStart)) return {};
+        data.resize(static_cast<size_t>(bytesRead));
+        
+        if (!encryption->decryptBlocks(EncryptionManager::fileIdFor(path),
+                                       alignedStart / blockSize,
+                                       data.data(), data.data(), data.size())) {
+            return {};
+        }
+        data.erase(data.begin(), data.begin() + (offset - alignedStart));
+        data.resize(std::min(data.size(), length));
+        return data;
+    }
+    
+    std::shared_ptr<MemoryMappedFile> getMappedFile(const std::string& path) {
+        std::lock_guard lock(mappedFilesMutex);
+        auto& mappedFile = mappedFiles[path];
+        if (!mappedFile) {
+            auto file = std::make_shared<MemoryMappedFile>();
+            if (!file->map(path)) {
+                mappedFiles.erase(path);
+                EventLogger::log("Failed to memory map file: " + path);
+                return nullptr;
+            }
+            mappedFile = std::move(file);
+        }
+        return mappedFile;
     }
     
-    size_t getFileSize(const std::string& path) {
-        std::ifstream file(path, std::ios::binary | std::ios::ate);
-        if (!file) {
-            return 0;
+    // Cached per descriptor until fileChanged moves the generation on, so
+    // block misses do not fstat
+    size_t getFileSize(FileDescriptor* fd) {
+        uint64_t generation = sizeGeneration.load(std::memory_order_acquire);
+        if (fd->sizeGeneration != generation) {
+            fd->size = asyncIO->fileSize(fd->path);
+            fd->sizeGeneration = generation;
         }
-        return file.tellg();
+        return fd->size;
+    }
+    
+    static std::string victimKey(uint64_t file, uint64_t blockIndex) {
+        return std::to_string(file) + ':' + std::to_string(blockIndex);
+    }
+    
+    void dropEvictedBlocks(const std::unordered_set<uint64_t>& files) {
+        if (files.empty()) return;
+        multiLevelCache->eraseIf([&files](const std::string& key) {
+            return files.count(std::stoull(key.substr(0, key.find(':')))) != 0;
+        });
     }
 };
 
@@ -9,8 +9,13 @@
 #include 
 #include 
 #include 
+#include <functional>
+#include <unordered_set>
 #include "./types.hpp"
 #include "./FileCache.hpp"
+#include "./Readahead.hpp"
+#include "./DescriptorTable.hpp"
+#include "./DentryCache.hpp"
 
 namespace Kernel {
 namespace FileSystem {
@@ -33,12 +38,23 @@ private:
         std::string path;
         uint32_t flags;
         size_t position;
+        uint64_t fileId = 0; // Page cache id, resolved on first read
+        size_t size = 0;             // File size as of sizeGeneration
+        uint64_t sizeGeneration = 0; // 0 until the size is first fetched
+        ReadaheadState readahead;
     };
     
-    std::mutex mutex;
-    uint32_t nextFileDescriptorId;
-    std::vector openFiles;
+    DescriptorTable<FileDescriptor> openFiles;
+    // Held shared while a resolved driver is in use, exclusively to mount
+    // or unmount, so a driver cannot be destroyed under an open
+    std::shared_mutex mountMutex;
     std::unordered_map> fsDrivers;
+    MountTrie mounts;
+    DentryCache dentries;
+    PathNameCache pathNames;
+    // Set by whoever owns the performance metrics; sees readahead blocks
+    // a descriptor prefetched and closed without reading
+    std::function<void(uint64_t wastedBlocks)> readaheadWasteHandler;
 
 public:
     static VirtualFileSystem& getInstance() {
@@ -50,50 +66,108 @@ public:
     }
 
     Result openFile(const std::string& path, uint32_t flags) {
-        if (!validatePath(path)) {
+        // Repeat opens of the same spelling skip validation and normalization
+        uint64_t generation = dentries.currentGeneration();
+        std::string normalized;
+        if (auto known = pathNames.lookup(path, generation)) {
+            normalized = std::move(*known);
+        } else {
+            normalized = validatePath(path) ? normalizePath(path) : std::string();
+            pathNames.insert(path, normalized, generation);
+        }
+        if (normalized.empty()) {
             return Result::error("Invalid path");
         }
 
+        // A dentry hit skips mount resolution; entries are keyed by the
+        // normalized path so aliases of one file share an entry
+        std::shared_lock mountLock(mountMutex);
+        FileSystemDriver* driver = nullptr;
+        if (auto dentry = dentries.lookup(normalized)) {
+            if (dentry->state == DentryCache::State::Missing) {
+                return Result::error("File not found");
+            }
+            driver = dentry->driver;
+        } else {
+            auto mount = mounts.longestMatch(normalized);
+            if (mount && ensureInitialized(mount->driver)) {
+                driver = mount->driver;
+                dentries.insertResolved(normalized, mount->mountPoint, driver, generation);
+            }
+        }
+
         auto cachedFile = cache.get(path);
         if (cachedFile) {
             auto fd = createFileDescriptor(path, flags);
+            if (!fd) {
+                return Result::error("Too many open files");
+            }
             return Result::ok(fd);
         }
 
-        auto driver = getDriverForPath(path);
         if (!driver) {
             return Result::error("No driver found");
         }
 
         auto result = driver->openFile(path, flags);
         if (!result) {
+            if (!driver->exists(path)) {
+                dentries.insertMissing(normalized, generation);
+            }
             return Result::error(result.error());
         }
 
         auto fd = createFileDescriptor(path, flags);
+        if (!fd) {
+            return Result::error("Too many open files");
+        }
         cache.store(path, result.value());
         return Result::ok(fd);
     }
 
     FileSystemDriver* getDriverForPath(const std::string& path) {
         // Get mount point from path
-        std::string mountPoint = getMountPoint(path);
-        if (mountPoint.empty()) {
+        std::shared_lock mountLock(mountMutex);
+        auto mount = mounts.longestMatch(path);
+        if (!mount) {
             return nullptr;
         }
 
         // Get appropriate driver based on filesystem type
-        try {
-            auto& driver = fsDrivers.at(mountPoint);
-            if (!driver->isInitialized()) {
-                if (!driver->initialize()) {
-                    return nullptr;
-                }
-            }
-            return driver.get();
-        } catch (const std::out_of_range&) {
-            return nullptr;
+        return ensureInitialized(mount->driver) ? mount->driver : nullptr;
+    }
+
+    Result<void> mount(const std::string& mountPoint, std::unique_ptr<FileSystemDriver> driver) {
+        if (!driver) {
+            return Result<void>::error("Invalid driver");
         }
+        std::string normalized = normalizePath(mountPoint);
+        std::unique_lock mountLock(mountMutex);
+        mounts.insert(normalized, driver.get());
+        fsDrivers[normalized] = std::move(driver);
+        dentries.invalidateAll();
+        return Result<void>::ok();
+    }
+
+    Result<void> unmount(const std::string& mountPoint) {
+        std::string normalized = normalizePath(mountPoint);
+        std::unique_lock mountLock(mountMutex);
+        if (fsDrivers.find(normalized) == fsDrivers.end()) {
+            return Result<void>::error("Not mounted");
+        }
+        mounts.remove(normalized);
+        dentries.invalidateAll();
+        fsDrivers.erase(normalized);
+        return Result<void>::ok();
+    }
+
+    void setReadaheadWasteHandler(std::function<void(uint64_t wastedBlocks)> handler) {
+        readaheadWasteHandler = std::move(handler);
+    }
+
+    // Drop cached lookups for a path after it is created, removed or renamed
+    void invalidatePath(const std::string& path) {
+        dentries.invalidate(path);
     }
 
     bool validatePath(const std::string& path) {
@@ -130,16 +204,18 @@ public:
                     return false;
                 }
 
-                // Check for reserved names
-                static const std::vector reserved = {
+                // Check for reserved names (all 3 to 6 characters long)
+                static const std::unordered_set<std::string> reserved = {
                     "CON", "PRN", "AUX", "NUL", "COM1", "COM2", "COM3",
                     "LPT1", "LPT2", "LPT3", "CLOCK$"
                 };
 
-                std::string upper = component;
-                std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-                if (std::find(reserved.begin(), reserved.end(), upper) != reserved.end()) {
-                    return false;
+                if (component.length() >= 3 && component.length() <= 6) {
+                    std::string upper = component;
+                    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+                    if (reserved.count(upper)) {
+                        return false;
+                    }
                 }
             }
 
@@ -160,46 +236,49 @@ public:
 private:
     // Private implementation methods
     FileDescriptor* createFileDescriptor(const std::string& path, uint32_t flags) {
-        std::lock_guard lock(mutex);
         FileDescriptor fd;
-        fd.id = nextFileDescriptorId++;
         fd.path = path;
         fd.flags = flags;
         fd.position = 0;
-        openFiles.push_back(fd);
-        return &openFiles.back();
+        auto [id, slot] = openFiles.allocate(std::move(fd));
+        if (slot) {
+            slot->id = id;
+        }
+        return slot;
+    }
+
+    FileDescriptor* getFileDescriptor(uint32_t id) {
+        return openFiles.lookup(id);
     }
 
     Result<void> closeFileDescriptor(uint32_t id) {
-        std::lock_guard lock(mutex);
-        auto it = std::find_if(openFiles.begin(), openFiles.end(),
-            [id](const FileDescriptor& fd) { return fd.id == id; });
-        if (it == openFiles.end()) {
+        // Taking the slot is the close; a racing close of the same id fails
+        auto fd = openFiles.take(id);
+        if (!fd) {
             return Result<void>::error("Invalid file descriptor");
         }
-        openFiles.erase(it);
+        // Blocks prefetched for this descriptor and never read are waste
+        uint64_t wasted = fd->readahead.reset();
+        if (wasted && readaheadWasteHandler) {
+            readaheadWasteHandler(wasted);
+        }
         return Result<void>::ok();
     }
 
+    bool ensureInitialized(FileSystemDriver* driver) {
+        return driver->isInitialized() || driver->initialize();
+    }
+
     bool isWithinPermittedBoundaries(const std::string& path) {
-        for (const auto& mount : fsDrivers) {
-            if (path.find(mount.first) == 0) {
-                return securityManager->checkAccess(path);
-            }
+        if (!mounts.longestMatch(path)) {
+            return false;
         }
-        return false;
+        return securityManager->checkAccess(path);
     }
 
     std::string getMountPoint(const std::string& path) {
-        std::string bestMatch;
-        size_t bestLength = 0;
-        for (const auto& mount : fsDrivers) {
-            if (path.find(mount.first) == 0 && mount.first.length() > bestLength) {
-                bestMatch = mount.first;
-                bestLength = mount.first.length();
-            }
-        }
-        return bestMatch;
+        auto mount = mounts.longestMatch(path);
+        return mount ? mount->mountPoint : std::string();
     }
 
     std::string normalizePath(const std::string& path) {
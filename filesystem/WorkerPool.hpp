@@ -0,0 +1,123 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Kernel {
+namespace FileSystem {
+
+// Persistent threads for spreading one call's work across cores
+// (compression frames, encryption blocks), so a call never pays for
+// creating threads. parallelFor hands indices out from a shared counter
+// and the calling thread takes them too. It returns once every index is
+// done. A helper that has not started by then is skipped, so a busy pool
+// delays nobody and nested calls cannot deadlock.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t helpers) {
+        for (size_t i = 0; i < helpers; i++) {
+            threads.emplace_back([this] { run(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard lock(queueMutex);
+            stopping = true;
+        }
+        queueCV.notify_all();
+        for (auto& thread : threads) thread.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // One helper per hardware thread besides the caller
+    static WorkerPool& shared() {
+        static WorkerPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        return pool;
+    }
+
+    size_t helperCount() const { return threads.size(); }
+
+    // Runs body(i) for every i in [0, count) on at most maxWorkers threads,
+    // the caller included. body must not throw.
+    void parallelFor(size_t count, size_t maxWorkers, const std::function<void(size_t)>& body) {
+        size_t helpers = std::min({count, maxWorkers, threads.size() + 1});
+        helpers = helpers > 0 ? helpers - 1 : 0;
+        if (helpers == 0) {
+            for (size_t i = 0; i < count; i++) body(i);
+            return;
+        }
+
+        auto job = std::make_shared<Job>(body, count);
+        {
+            std::lock_guard lock(queueMutex);
+            for (size_t i = 0; i < helpers; i++) queue.push_back(job);
+        }
+        queueCV.notify_all();
+
+        job->drain();
+        std::unique_lock lock(job->mutex);
+        job->closed = true;
+        job->idle.wait(lock, [&] { return job->active == 0; });
+    }
+
+private:
+    struct Job {
+        Job(const std::function<void(size_t)>& body, size_t count) : body(body), count(count) {}
+
+        void drain() {
+            for (size_t i = next++; i < count; i = next++) body(i);
+        }
+
+        const std::function<void(size_t)>& body; // Lives until the caller returns
+        const size_t count;
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable idle;
+        size_t active = 0;   // Helpers inside drain()
+        bool closed = false; // Caller finished; late helpers must not start
+    };
+
+    void run() {
+        while (true) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock lock(queueMutex);
+                queueCV.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            {
+                std::lock_guard lock(job->mutex);
+                if (job->closed) continue;
+                job->active++;
+            }
+            job->drain();
+            std::lock_guard lock(job->mutex);
+            if (--job->active == 0) job->idle.notify_all();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex queueMutex;
+    std::condition_variable queueCV;
+    std::deque<std::shared_ptr<Job>> queue;
+    bool stopping = false;
+};
+
+} // namespace FileSystem
+} // namespace Kernel
+
+#endif
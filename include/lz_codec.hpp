@@ -0,0 +1,197 @@
+// Fast LZ77 codec (LZ4 block format)
+#ifndef LZ_CODEC_HPP
+#define LZ_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Kernel {
+namespace Compression {
+
+// Speed-first tier next to zlib: a single hash probe per position, 64 KB
+// window and byte-aligned tokens. Output follows the LZ4 block format, so
+// data can be cross-checked with the reference implementation.
+class LZCodec {
+public:
+    static size_t compressBound(size_t size) {
+        return size + size / 255 + 16;
+    }
+
+    // Returns the compressed size, or 0 if dst is too small
+    static size_t compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) {
+        uint8_t* op = dst;
+        uint8_t* const opEnd = dst + dstCapacity;
+        size_t anchor = 0;
+
+        if (srcSize > MF_LIMIT) {
+            uint32_t table[HASH_SIZE] = {}; // Position + 1; 0 means empty
+            const size_t matchLimit = srcSize - LAST_LITERALS;
+            const size_t inputLimit = srcSize - MF_LIMIT;
+            size_t ip = 0;
+            uint32_t misses = 0;
+
+            while (ip < inputLimit) {
+                uint32_t sequence = read32(src + ip);
+                uint32_t& slot = table[hash(sequence)];
+                size_t ref = slot;
+                slot = static_cast<uint32_t>(ip + 1);
+
+                if (ref == 0 || ip - (ref - 1) > MAX_DISTANCE || read32(src + ref - 1) != sequence) {
+                    // Skip faster through incompressible data
+                    ip += 1 + (misses++ >> SKIP_TRIGGER);
+                    continue;
+                }
+                misses = 0;
+                ref--;
+
+                // Extend backwards over pending literals, then forwards
+                while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                    ip--;
+                    ref--;
+                }
+                size_t matchLength = MIN_MATCH;
+                while (ip + matchLength < matchLimit && src[ip + matchLength] == src[ref + matchLength]) {
+                    matchLength++;
+                }
+
+                if (!emitSequence(op, opEnd, src + anchor, ip - anchor,
+                                  static_cast<uint16_t>(ip - ref), matchLength)) {
+                    return 0;
+                }
+                ip += matchLength;
+                anchor = ip;
+            }
+        }
+
+        // Final literal run
+        size_t literals = srcSize - anchor;
+        if (!emitLiterals(op, opEnd, src + anchor, literals)) {
+            return 0;
+        }
+        return static_cast<size_t>(op - dst);
+    }
+
+    // Returns the decompressed size, or -1 on malformed input or overflow
+    static long decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) {
+        const uint8_t* ip = src;
+        const uint8_t* const ipEnd = src + srcSize;
+        uint8_t* op = dst;
+        uint8_t* const opEnd = dst + dstCapacity;
+
+        while (ip < ipEnd) {
+            uint8_t token = *ip++;
+
+            size_t literals = token >> 4;
+            if (literals == 15 && !readLength(ip, ipEnd, literals)) return -1;
+            if (literals > static_cast<size_t>(ipEnd - ip) ||
+                literals > static_cast<size_t>(opEnd - op)) {
+                return -1;
+            }
+            if (literals) std::memcpy(op, ip, literals);
+            ip += literals;
+            op += literals;
+
+            if (ip == ipEnd) break; // Last sequence carries literals only
+
+            if (ipEnd - ip < 2) return -1;
+            size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+            if (offset == 0 || offset > static_cast<size_t>(op - dst)) return -1;
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !readLength(ip, ipEnd, matchLength)) return -1;
+            matchLength += MIN_MATCH;
+            if (matchLength > static_cast<size_t>(opEnd - op)) return -1;
+
+            copyMatch(op, op - offset, matchLength);
+            op += matchLength;
+        }
+        return static_cast<long>(op - dst);
+    }
+
+private:
+    static constexpr size_t MIN_MATCH = 4;
+    static constexpr size_t LAST_LITERALS = 5;
+    static constexpr size_t MF_LIMIT = 12;
+    static constexpr size_t MAX_DISTANCE = 65535;
+    static constexpr unsigned HASH_LOG = 12;
+    static constexpr size_t HASH_SIZE = size_t(1) << HASH_LOG;
+    static constexpr unsigned SKIP_TRIGGER = 6;
+
+    static uint32_t read32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static uint32_t hash(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_LOG);
+    }
+
+    static bool writeLength(uint8_t*& op, uint8_t* opEnd, size_t length) {
+        while (length >= 255) {
+            if (op >= opEnd) return false;
+            *op++ = 255;
+            length -= 255;
+        }
+        if (op >= opEnd) return false;
+        *op++ = static_cast<uint8_t>(length);
+        return true;
+    }
+
+    static bool readLength(const uint8_t*& ip, const uint8_t* ipEnd, size_t& length) {
+        uint8_t byte;
+        do {
+            if (ip >= ipEnd) return false;
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    static bool emitLiterals(uint8_t*& op, uint8_t* opEnd, const uint8_t* literals, size_t count) {
+        if (op >= opEnd) return false;
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>((count >= 15 ? 15 : count) << 4);
+        if (count >= 15 && !writeLength(op, opEnd, count - 15)) return false;
+        if (count > static_cast<size_t>(opEnd - op)) return false;
+        if (count) std::memcpy(op, literals, count);
+        op += count;
+        return true;
+    }
+
+    static bool emitSequence(uint8_t*& op, uint8_t* opEnd, const uint8_t* literals,
+                             size_t literalCount, uint16_t offset, size_t matchLength) {
+        uint8_t* token = op;
+        if (!emitLiterals(op, opEnd, literals, literalCount)) return false;
+        if (opEnd - op < 2) return false;
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+
+        size_t extra = matchLength - MIN_MATCH;
+        *token |= static_cast<uint8_t>(extra >= 15 ? 15 : extra);
+        if (extra >= 15 && !writeLength(op, opEnd, extra - 15)) return false;
+        return true;
+    }
+
+    // Overlapping matches (offset < length) replicate the pattern; offsets of
+    // 8 or more can still move whole words since each chunk is disjoint
+    static void copyMatch(uint8_t* op, const uint8_t* match, size_t length) {
+        size_t offset = static_cast<size_t>(op - match);
+        if (offset >= length) {
+            std::memcpy(op, match, length);
+            return;
+        }
+        size_t i = 0;
+        if (offset >= 8) {
+            for (; i + 8 <= length; i += 8) std::memcpy(op + i, match + i, 8);
+        }
+        for (; i < length; i++) op[i] = match[i];
+    }
+};
+
+} // namespace Compression
+} // namespace Kernel
+
+#endif // LZ_CODEC_HPP
@@ -0,0 +1,332 @@
+#ifndef MESSAGE_CHANNEL_HPP
+#define MESSAGE_CHANNEL_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Kernel {
+
+using ProcessId = int;
+
+// Names a payload in a SharedPayloadArena segment instead of carrying it
+struct PayloadDescriptor {
+    uint32_t segment = 0;
+    uint32_t offset = 0;
+    uint32_t length = 0; // 0: no payload
+    uint32_t generation = 0;
+};
+
+struct Message {
+    ProcessId sender;
+    ProcessId receiver;
+    std::string data;
+    size_t priority; // Higher is more urgent
+    uint64_t timestamp;
+    PayloadDescriptor payload; // Zero-copy alternative to data
+};
+
+// Futex-style sleep/wake on a 32-bit sequence word. A waiter flags that
+// it may sleep, re-checks its condition, then sleeps only if the sequence
+// is unchanged. notifyAll() clears the flag, so a burst of notifications
+// costs one wake syscall and then a single load each.
+class FutexWaitQueue {
+public:
+    // Call before the final re-check of the condition, then wait() or just return
+    uint32_t prepareWait() {
+        wakeNeeded.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return sequence.load(std::memory_order_acquire);
+    }
+
+    // Returns false on timeout. May return early (spurious wakeup).
+    bool wait(uint32_t expected, std::chrono::nanoseconds timeout) {
+#ifdef __linux__
+        timespec relative{};
+        bool bounded = timeout != std::chrono::nanoseconds::max();
+        if (bounded) {
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+            relative.tv_sec = static_cast<time_t>(seconds.count());
+            relative.tv_nsec = static_cast<long>((timeout - seconds).count());
+        }
+        long result = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sequence), FUTEX_WAIT_PRIVATE,
+                              expected, bounded ? &relative : nullptr, nullptr, 0);
+        return result == 0 || errno != ETIMEDOUT;
+#else
+        auto deadline = std::chrono::steady_clock::now() + std::min(timeout, std::chrono::nanoseconds(std::chrono::hours(24)));
+        while (sequence.load(std::memory_order_acquire) == expected) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::yield();
+        }
+        return true;
+#endif
+    }
+
+    // Call after publishing the state waiters are checking for
+    void notifyAll() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!wakeNeeded.load(std::memory_order_relaxed)) return;
+        if (!wakeNeeded.exchange(false, std::memory_order_acq_rel)) return;
+        sequence.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sequence), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+private:
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<bool> wakeNeeded{false};
+};
+
+inline size_t roundUpToPowerOfTwo(size_t value) {
+    size_t power = 1;
+    while (power < value) power <<= 1;
+    return power;
+}
+
+// Bounded single-producer/single-consumer ring. Each side caches the
+// other's index and only reloads it when the ring looks full or empty.
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : mask(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2)) - 1), slots(mask + 1) {}
+
+    // Leaves value untouched when the ring is full
+    bool tryPush(T&& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead > mask) return false;
+        }
+        slots[position & mask] = std::move(value);
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail) return false;
+        }
+        out = std::move(slots[position & mask]);
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    alignas(64) std::atomic<size_t> head{0}; // Consumer side
+    size_t cachedTail = 0;
+    alignas(64) std::atomic<size_t> tail{0}; // Producer side
+    size_t cachedHead = 0;
+    alignas(64) const size_t mask;
+    std::vector<T> slots;
+};
+
+// Bounded multi-producer/single-consumer ring. Producers claim a slot with
+// one CAS on the tail; per-slot sequence numbers tell the consumer when
+// the slot's value is published and producers when it is free again.
+template<typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity)
+        : mask(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2)) - 1), slots(new Slot[mask + 1]) {
+        for (size_t i = 0; i <= mask; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(T&& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[position & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (difference < 0) {
+                return false; // Full
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        size_t position = head.load(std::memory_order_relaxed);
+        Slot& slot = slots[position & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) return false;
+        out = std::move(slot.value);
+        slot.sequence.store(position + mask + 1, std::memory_order_release);
+        head.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool empty() const {
+        size_t position = head.load(std::memory_order_relaxed);
+        return slots[position & mask].sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<size_t> head{0}; // Written by the consumer only
+    alignas(64) const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+};
+
+// A receiver's inbox: one bounded ring per priority lane, drained highest
+// lane first. Senders block on a full lane and the receiver on an empty
+// channel through futex waits rather than polling. Messages are moved in
+// and out, so their payload is never copied.
+template<template<typename> class Ring>
+class BasicChannel {
+public:
+    static constexpr size_t LANES = 4;
+    static constexpr size_t DEFAULT_LANE_CAPACITY = 256;
+    static constexpr auto FOREVER = std::chrono::nanoseconds::max();
+
+    explicit BasicChannel(size_t laneCapacity = DEFAULT_LANE_CAPACITY) {
+        for (auto& lane : lanes) lane = std::make_unique<Ring<Message>>(laneCapacity);
+    }
+
+    BasicChannel(const BasicChannel&) = delete;
+    BasicChannel& operator=(const BasicChannel&) = delete;
+
+    // Priorities at or above LANES - 1 share the top lane
+    static size_t laneFor(size_t priority) {
+        return LANES - 1 - std::min(priority, LANES - 1);
+    }
+
+    // Fails without touching msg when its lane is full
+    bool trySend(Message&& msg) {
+        if (!lanes[laneFor(msg.priority)]->tryPush(std::move(msg))) return false;
+        dataReady.notifyAll();
+        return true;
+    }
+
+    // Waits up to timeout for room in the lane
+    bool send(Message&& msg, std::chrono::nanoseconds timeout = FOREVER) {
+        auto& lane = *lanes[laneFor(msg.priority)];
+        auto deadline = deadlineAfter(timeout);
+        while (!lane.tryPush(std::move(msg))) {
+            uint32_t sequence = spaceFreed.prepareWait();
+            if (lane.tryPush(std::move(msg))) break;
+            if (!spaceFreed.wait(sequence, remaining(deadline))) return false;
+        }
+        dataReady.notifyAll();
+        return true;
+    }
+
+    // Sends from the front of batch until a lane is full; one wakeup for
+    // the lot. Returns the number sent, which are erased from batch.
+    size_t sendBatch(std::vector<Message>& batch) {
+        size_t sent = 0;
+        while (sent < batch.size() && lanes[laneFor(batch[sent].priority)]->tryPush(std::move(batch[sent]))) sent++;
+        batch.erase(batch.begin(), batch.begin() + sent);
+        if (sent) dataReady.notifyAll();
+        return sent;
+    }
+
+    bool tryReceive(Message& out) {
+        for (auto& lane : lanes) {
+            if (lane->tryPop(out)) {
+                spaceFreed.notifyAll();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns false if nothing arrived within timeout
+    bool receive(Message& out, std::chrono::nanoseconds timeout = FOREVER) {
+        auto deadline = deadlineAfter(timeout);
+        while (!tryReceive(out)) {
+            uint32_t sequence = dataReady.prepareWait();
+            if (tryReceive(out)) return true;
+            if (!dataReady.wait(sequence, remaining(deadline))) return tryReceive(out);
+        }
+        return true;
+    }
+
+    // Appends up to max messages, highest lane first, waiting up to
+    // timeout for the first. Senders are woken once per batch.
+    size_t receiveBatch(std::vector<Message>& out, size_t max, std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0)) {
+        size_t received = 0;
+        Message msg;
+        for (auto& lane : lanes) {
+            while (received < max && lane->tryPop(msg)) {
+                out.push_back(std::move(msg));
+                received++;
+            }
+        }
+        if (received) {
+            spaceFreed.notifyAll();
+        } else if (max > 0 && timeout.count() > 0 && receive(msg, timeout)) {
+            out.push_back(std::move(msg));
+            received = 1 + receiveBatch(out, max - 1);
+        }
+        return received;
+    }
+
+    bool empty() const {
+        return std::all_of(lanes.begin(), lanes.end(), [](const auto& lane) { return lane->empty(); });
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static Clock::time_point deadlineAfter(std::chrono::nanoseconds timeout) {
+        auto now = Clock::now();
+        return timeout >= Clock::time_point::max() - now ? Clock::time_point::max() : now + timeout;
+    }
+
+    static std::chrono::nanoseconds remaining(Clock::time_point deadline) {
+        if (deadline == Clock::time_point::max()) return FOREVER;
+        return std::max(std::chrono::nanoseconds(0), deadline - Clock::now());
+    }
+
+    std::array<std::unique_ptr<Ring<Message>>, LANES> lanes;
+    FutexWaitQueue dataReady;
+    FutexWaitQueue spaceFreed;
+};
+
+// One sending process (e.g. a client/server pair)
+using SpscChannel = BasicChannel<SpscRing>;
+// Any number of senders, one receiving process
+using MpscChannel = BasicChannel<MpscRing>;
+
+} // namespace Kernel
+
+#endif
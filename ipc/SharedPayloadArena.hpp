@@ -0,0 +1,220 @@
+#ifndef SHARED_PAYLOAD_ARENA_HPP
+#define SHARED_PAYLOAD_ARENA_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <thread>
+#include "MessageChannel.hpp"
+
+namespace Kernel {
+
+// Payload allocator living entirely inside one shared segment, so every
+// process mapping the segment can resolve and release what another
+// process allocated. Payloads are runs of BLOCK_SIZE blocks handed out
+// next-fit, which suits streams of similar-sized frames freed roughly in
+// order. Each run carries a reference count; the last release frees it.
+//
+// Segment layout:
+//   Header | refs[blocks] | runs[blocks] | bitmap | blocks...
+// Everything past the header is addressed by offset, never by pointer,
+// so the segment may sit at a different address in each process.
+class SharedPayloadArena {
+public:
+    static constexpr size_t BLOCK_SIZE = 4096;
+    static constexpr uint32_t MAGIC = 0x50415931; // "PAY1"
+
+    // Segment bytes needed for payloadBytes of payload space
+    static size_t segmentSizeFor(size_t payloadBytes) {
+        size_t blocks = (payloadBytes + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        return dataOffsetFor(blocks) + blocks * BLOCK_SIZE;
+    }
+
+    // Whether a segment already holds an arena: another process formatted
+    // it, and creating over it would wipe that process's payloads
+    static bool isFormatted(const void* base, size_t size) {
+        return size >= sizeof(Header) && static_cast<const Header*>(base)->magic == MAGIC;
+    }
+
+    // create formats the segment; otherwise it must already be formatted
+    // (attaching from another process)
+    SharedPayloadArena(uint32_t segmentId, void* base, size_t size, bool create)
+        : segmentId(segmentId), base(static_cast<uint8_t*>(base)) {
+        header = reinterpret_cast<Header*>(base);
+        if (create) {
+            size_t blocks = 0;
+            while (segmentSizeFor((blocks + 1) * BLOCK_SIZE) <= size) blocks++;
+            new (header) Header{};
+            header->blocks = static_cast<uint32_t>(blocks);
+            header->dataOffset = static_cast<uint32_t>(dataOffsetFor(blocks));
+            header->freeBlocks = static_cast<uint32_t>(blocks);
+            for (size_t i = 0; i < blocks; i++) {
+                new (&refs()[i]) std::atomic<uint32_t>(0);
+                runs()[i] = {0, 0};
+            }
+            for (size_t i = 0; i < bitmapWords(); i++) bitmap()[i] = 0;
+            header->magic = MAGIC;
+        }
+        valid = header->magic == MAGIC && segmentSizeFor(size_t(header->blocks) * BLOCK_SIZE) <= size;
+    }
+
+    SharedPayloadArena(const SharedPayloadArena&) = delete;
+    SharedPayloadArena& operator=(const SharedPayloadArena&) = delete;
+
+    bool isValid() const { return valid; }
+
+    // The sender holds the only reference until it sends the descriptor
+    std::optional<PayloadDescriptor> allocate(size_t length) {
+        if (!valid || length == 0) return std::nullopt;
+        size_t count = (length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if (count > header->blocks) return std::nullopt;
+
+        lock();
+        size_t first = findFree(header->nextFit, count);
+        if (first == NOT_FOUND && header->nextFit != 0) first = findFree(0, count);
+        if (first == NOT_FOUND) {
+            unlock();
+            return std::nullopt;
+        }
+        setBits(first, count, true);
+        header->nextFit = static_cast<uint32_t>((first + count) % header->blocks);
+        header->freeBlocks -= static_cast<uint32_t>(count);
+        Run& run = runs()[first];
+        run.blocks = static_cast<uint32_t>(count);
+        run.generation++;
+        refs()[first].store(1, std::memory_order_release);
+        unlock();
+
+        return PayloadDescriptor{segmentId, static_cast<uint32_t>(first * BLOCK_SIZE),
+                                 static_cast<uint32_t>(length), run.generation};
+    }
+
+    // Pointer to the payload, or nullptr for a descriptor that does not
+    // name a live allocation in this segment
+    uint8_t* data(const PayloadDescriptor& payload) const {
+        size_t first = firstBlock(payload);
+        if (first == NOT_FOUND) return nullptr;
+        return base + header->dataOffset + payload.offset;
+    }
+
+    // One extra reference per additional receiver (fan-out)
+    bool retain(const PayloadDescriptor& payload, uint32_t count = 1) {
+        size_t first = firstBlock(payload);
+        if (first == NOT_FOUND) return false;
+        refs()[first].fetch_add(count, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Drops one reference. Returns true if that freed the payload.
+    bool release(const PayloadDescriptor& payload) {
+        size_t first = firstBlock(payload);
+        if (first == NOT_FOUND) return false;
+        if (refs()[first].fetch_sub(1, std::memory_order_acq_rel) != 1) return false;
+
+        lock();
+        size_t count = runs()[first].blocks;
+        setBits(first, count, false);
+        header->freeBlocks += static_cast<uint32_t>(count);
+        unlock();
+        return true;
+    }
+
+    uint32_t getSegmentId() const { return segmentId; }
+    size_t getBlockCount() const { return valid ? header->blocks : 0; }
+    size_t getFreeBlockCount() const { return valid ? header->freeBlocks : 0; }
+
+private:
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t blocks;
+        uint32_t dataOffset;
+        uint32_t nextFit;
+        uint32_t freeBlocks;
+        std::atomic<uint32_t> lock;
+    };
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+
+    struct Run {
+        uint32_t blocks;     // Length, valid at the first block of a live run
+        uint32_t generation; // Bumped per allocation; stale descriptors mismatch
+    };
+
+    static size_t dataOffsetFor(size_t blocks) {
+        size_t metadata = sizeof(Header) + blocks * (sizeof(std::atomic<uint32_t>) + sizeof(Run)) + 4 +
+                          (blocks + 63) / 64 * sizeof(uint64_t);
+        return (metadata + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    }
+
+    std::atomic<uint32_t>* refs() const {
+        return reinterpret_cast<std::atomic<uint32_t>*>(base + sizeof(Header));
+    }
+
+    Run* runs() const {
+        return reinterpret_cast<Run*>(refs() + header->blocks + (header->blocks & 1));
+    }
+
+    uint64_t* bitmap() const {
+        return reinterpret_cast<uint64_t*>(runs() + header->blocks);
+    }
+
+    size_t bitmapWords() const { return (header->blocks + 63) / 64; }
+
+    // Validates a descriptor against the live allocation it claims
+    size_t firstBlock(const PayloadDescriptor& payload) const {
+        if (!valid || payload.segment != segmentId || payload.offset % BLOCK_SIZE != 0) return NOT_FOUND;
+        size_t first = payload.offset / BLOCK_SIZE;
+        if (first >= header->blocks || refs()[first].load(std::memory_order_acquire) == 0) return NOT_FOUND;
+        const Run& run = runs()[first];
+        if (run.generation != payload.generation || payload.length > size_t(run.blocks) * BLOCK_SIZE) return NOT_FOUND;
+        return first;
+    }
+
+    void lock() {
+        while (header->lock.exchange(1, std::memory_order_acquire)) {
+            while (header->lock.load(std::memory_order_relaxed)) std::this_thread::yield();
+        }
+    }
+
+    void unlock() { header->lock.store(0, std::memory_order_release); }
+
+    bool testBit(size_t block) const { return (bitmap()[block / 64] >> (block % 64)) & 1; }
+
+    void setBits(size_t first, size_t count, bool value) {
+        for (size_t block = first; block < first + count; block++) {
+            uint64_t mask = 1ULL << (block % 64);
+            if (value) {
+                bitmap()[block / 64] |= mask;
+            } else {
+                bitmap()[block / 64] &= ~mask;
+            }
+        }
+    }
+
+    // First run of count free blocks at or after from, without wrapping
+    size_t findFree(size_t from, size_t count) const {
+        size_t run = 0;
+        for (size_t block = from; block < header->blocks; block++) {
+            if (block % 64 == 0 && bitmap()[block / 64] == ~0ULL) {
+                run = 0;
+                block += 63; // Skip a full word
+                continue;
+            }
+            run = testBit(block) ? 0 : run + 1;
+            if (run == count) return block + 1 - count;
+        }
+        return NOT_FOUND;
+    }
+
+    const uint32_t segmentId;
+    uint8_t* const base;
+    Header* header;
+    bool valid = false;
+};
+
+} // namespace Kernel
+
+#endif
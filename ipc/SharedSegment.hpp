@@ -0,0 +1,195 @@
+#ifndef SHARED_SEGMENT_HPP
+#define SHARED_SEGMENT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Kernel {
+
+struct SegmentOptions {
+    enum class HugePages : uint8_t {
+        None,
+        Transparent, // madvise(MADV_HUGEPAGE); effective when shmem THP allows it
+        Explicit     // MAP_HUGETLB from the reserved pool, else Transparent
+    };
+
+    HugePages hugePages = HugePages::None;
+    bool populate = false; // Prefault at creation instead of on first touch
+    int numaNode = -1;     // Bind to this node; -1 leaves placement to first touch
+};
+
+struct SharedSegment {
+    void* address = nullptr;
+    size_t size = 0;        // Rounded up to pageSize
+    size_t pageSize = 4096; // HUGE_PAGE_SIZE when backed by hugetlb
+    bool numaBound = false;
+};
+
+constexpr size_t SEGMENT_PAGE_SIZE = 4096;
+constexpr size_t SEGMENT_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Maps an anonymous shared segment. A NUMA binding must be in place before
+// any page is faulted, so binding happens between mmap and prefaulting.
+inline SharedSegment mapSharedSegment(size_t size, const SegmentOptions& options = {}) {
+    SharedSegment segment;
+    if (size == 0) return segment;
+    bool bind = options.numaNode >= 0 && options.numaNode < 64;
+    // MAP_POPULATE only read-faults a shared mapping, so the first write
+    // pass still takes a fault per page; MADV_POPULATE_WRITE does not.
+    // The flag is kept for kernels without it.
+    constexpr int POPULATE_WRITE = 23; // MADV_POPULATE_WRITE, Linux 5.14
+    bool populateWrite = options.populate && madvise(nullptr, 0, POPULATE_WRITE) == 0;
+    int prefault = options.populate && !populateWrite && !bind ? MAP_POPULATE : 0;
+
+#ifdef MAP_HUGETLB
+    if (options.hugePages == SegmentOptions::HugePages::Explicit) {
+        size_t hugeSize = (size + SEGMENT_HUGE_PAGE_SIZE - 1) & ~(SEGMENT_HUGE_PAGE_SIZE - 1);
+        void* address = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_ANONYMOUS | MAP_HUGETLB | prefault, -1, 0);
+        if (address != MAP_FAILED) {
+            segment = {address, hugeSize, SEGMENT_HUGE_PAGE_SIZE, false};
+        }
+    }
+#endif
+    if (!segment.address) {
+        size_t pageSize = options.hugePages == SegmentOptions::HugePages::None ? SEGMENT_PAGE_SIZE : SEGMENT_HUGE_PAGE_SIZE;
+        size_t rounded = (size + pageSize - 1) & ~(pageSize - 1);
+        void* address = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | prefault, -1, 0);
+        if (address == MAP_FAILED) return {};
+        segment = {address, rounded, SEGMENT_PAGE_SIZE, false};
+#ifdef MADV_HUGEPAGE
+        if (options.hugePages != SegmentOptions::HugePages::None) madvise(address, rounded, MADV_HUGEPAGE);
+#endif
+    }
+
+#ifdef __linux__
+    if (bind) {
+        constexpr int MPOL_BIND_MODE = 2; // MPOL_BIND from <numaif.h>
+        unsigned long nodeMask = 1UL << options.numaNode;
+        segment.numaBound = syscall(SYS_mbind, segment.address, segment.size, MPOL_BIND_MODE,
+                                    &nodeMask, sizeof(nodeMask) * 8 + 1, 0) == 0;
+    }
+#endif
+
+    if (options.populate && !prefault) {
+        if (!populateWrite || madvise(segment.address, segment.size, POPULATE_WRITE) != 0) {
+            auto* bytes = static_cast<volatile uint8_t*>(segment.address);
+            for (size_t offset = 0; offset < segment.size; offset += segment.pageSize) bytes[offset] = 0;
+        }
+    }
+    return segment;
+}
+
+inline void unmapSharedSegment(const SharedSegment& segment) {
+    if (segment.address) munmap(segment.address, segment.size);
+}
+
+struct SegmentHandle {
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    uint32_t index = INVALID;
+    uint32_t generation = 0;
+
+    bool isValid() const { return index != INVALID; }
+};
+
+// Segments indexed by handle. attach() and detach() never lock: each
+// slot packs its generation and reference count into one word, so a
+// handle to a destroyed segment fails its compare-and-swap even if the
+// slot has been reused. The last detach unmaps the segment.
+class SharedSegmentTable {
+public:
+    static constexpr size_t CAPACITY = 1024;
+
+    SharedSegmentTable() : slots(new Slot[CAPACITY]) {
+        freeSlots.reserve(CAPACITY);
+        for (size_t i = CAPACITY; i-- > 0;) freeSlots.push_back(static_cast<uint32_t>(i));
+    }
+
+    SharedSegmentTable(const SharedSegmentTable&) = delete;
+    SharedSegmentTable& operator=(const SharedSegmentTable&) = delete;
+
+    ~SharedSegmentTable() {
+        for (size_t i = 0; i < CAPACITY; i++) {
+            if (references(slots[i].state.load(std::memory_order_acquire)) > 0) unmapSharedSegment(slots[i].segment);
+        }
+    }
+
+    // The caller holds the first reference
+    SegmentHandle insert(const SharedSegment& segment) {
+        std::lock_guard lock(freeMutex);
+        if (freeSlots.empty()) return {};
+        uint32_t index = freeSlots.back();
+        freeSlots.pop_back();
+
+        Slot& slot = slots[index];
+        slot.segment = segment;
+        uint32_t generation = generationOf(slot.state.load(std::memory_order_relaxed)) + 1;
+        slot.state.store(pack(generation, 1), std::memory_order_release);
+        return {index, generation};
+    }
+
+    // Adds a reference; nullptr if the handle is stale
+    const SharedSegment* attach(SegmentHandle handle) {
+        if (handle.index >= CAPACITY) return nullptr;
+        Slot& slot = slots[handle.index];
+        uint64_t state = slot.state.load(std::memory_order_acquire);
+        do {
+            if (generationOf(state) != handle.generation || references(state) == 0) return nullptr;
+        } while (!slot.state.compare_exchange_weak(state, state + 1, std::memory_order_acquire));
+        return &slot.segment;
+    }
+
+    enum class DetachResult { Stale, Released, Destroyed };
+
+    // Drops a reference; the last one unmaps the segment and frees the slot
+    DetachResult detach(SegmentHandle handle) {
+        if (handle.index >= CAPACITY) return DetachResult::Stale;
+        Slot& slot = slots[handle.index];
+        uint64_t state = slot.state.load(std::memory_order_acquire);
+        do {
+            if (generationOf(state) != handle.generation || references(state) == 0) return DetachResult::Stale;
+        } while (!slot.state.compare_exchange_weak(state, state - 1, std::memory_order_acq_rel));
+        if (references(state) != 1) return DetachResult::Released;
+
+        unmapSharedSegment(slot.segment);
+        std::lock_guard lock(freeMutex);
+        freeSlots.push_back(handle.index);
+        return DetachResult::Destroyed;
+    }
+
+    // Borrowed view; valid while the caller holds a reference
+    const SharedSegment* get(SegmentHandle handle) const {
+        if (handle.index >= CAPACITY) return nullptr;
+        uint64_t state = slots[handle.index].state.load(std::memory_order_acquire);
+        if (generationOf(state) != handle.generation || references(state) == 0) return nullptr;
+        return &slots[handle.index].segment;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> state{0}; // generation << 32 | references
+        SharedSegment segment;
+    };
+
+    static uint64_t pack(uint32_t generation, uint32_t refs) { return uint64_t(generation) << 32 | refs; }
+    static uint32_t generationOf(uint64_t state) { return static_cast<uint32_t>(state >> 32); }
+    static uint32_t references(uint64_t state) { return static_cast<uint32_t>(state); }
+
+    std::unique_ptr<Slot[]> slots;
+    std::mutex freeMutex;
+    std::vector<uint32_t> freeSlots;
+};
+
+} // namespace Kernel
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef SIGNAL_DISPATCH_HPP
+#define SIGNAL_DISPATCH_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MessageChannel.hpp"
+
+namespace Kernel {
+
+constexpr int MAX_SIGNALS = 64;
+
+// A process's pending signals as one 64-bit mask. Raising an already
+// pending signal coalesces into it, as with POSIX standard signals;
+// take() claims everything pending in one exchange.
+class PendingSignals {
+public:
+    // Returns false if the signal was already pending (or out of range)
+    bool raise(int signal) {
+        if (signal < 0 || signal >= MAX_SIGNALS) return false;
+        uint64_t bit = 1ULL << signal;
+        if (mask.fetch_or(bit, std::memory_order_acq_rel) & bit) return false;
+        arrived.notifyAll();
+        return true;
+    }
+
+    uint64_t take() { return mask.exchange(0, std::memory_order_acq_rel); }
+
+    uint64_t peek() const { return mask.load(std::memory_order_acquire); }
+
+    // Sleeps until something is pending. Returns false on timeout.
+    bool wait(std::chrono::nanoseconds timeout) {
+        using Clock = std::chrono::steady_clock;
+        auto start = Clock::now();
+        auto deadline = timeout >= Clock::time_point::max() - start ? Clock::time_point::max() : start + timeout;
+        while (!peek()) {
+            uint32_t sequence = arrived.prepareWait();
+            if (peek()) break;
+            auto now = Clock::now();
+            if (now >= deadline) return false;
+            arrived.wait(sequence, deadline == Clock::time_point::max() ? std::chrono::nanoseconds::max() : deadline - now);
+        }
+        return true;
+    }
+
+private:
+    std::atomic<uint64_t> mask{0};
+    FutexWaitQueue arrived;
+};
+
+// Signal number -> handler, read without locks. Registration copies the
+// table, publishes the copy and retires the old one, which is freed after
+// a grace period: once every dispatch that might still be reading it has
+// returned. Registration never waits for running handlers.
+//
+// Readers announce themselves on one of two counters chosen by the
+// current parity, and each registration flips the parity. A retired table
+// is freed once both counters have been seen at zero since it was
+// retired; the side new readers are not joining always drains, so a
+// stream of dispatches cannot hold a table forever.
+class SignalDispatchTable {
+public:
+    using Callback = std::function<void(int)>;
+
+    SignalDispatchTable() : current(new Table{}) {}
+
+    SignalDispatchTable(const SignalDispatchTable&) = delete;
+    SignalDispatchTable& operator=(const SignalDispatchTable&) = delete;
+
+    ~SignalDispatchTable() {
+        synchronize();
+        delete current.load(std::memory_order_acquire);
+    }
+
+    void set(int signal, Callback callback) {
+        if (signal < 0 || signal >= MAX_SIGNALS) return;
+        std::lock_guard lock(writerMutex);
+        auto* next = new Table(*current.load(std::memory_order_relaxed));
+        next->handlers[signal] = std::move(callback);
+        publish(next);
+    }
+
+    void clear(int signal) { set(signal, nullptr); }
+
+    void clearAll() {
+        std::lock_guard lock(writerMutex);
+        publish(new Table{});
+    }
+
+    // Waits until no dispatch is still running a replaced handler. Must
+    // not be called from a handler.
+    void synchronize() {
+        std::lock_guard lock(writerMutex);
+        while (!retired.empty()) {
+            parity.store(parity.load(std::memory_order_relaxed) ^ 1, std::memory_order_seq_cst);
+            std::this_thread::yield();
+            reclaim();
+        }
+    }
+
+    size_t getRetiredCount() {
+        std::lock_guard lock(writerMutex);
+        return retired.size();
+    }
+
+    // Returns false if no handler is registered
+    bool dispatch(int signal) {
+        if (signal < 0 || signal >= MAX_SIGNALS) return false;
+        ReadSection section(*this);
+        const Callback& callback = section.table->handlers[signal];
+        if (!callback) return false;
+        callback(signal);
+        return true;
+    }
+
+    // Runs the handler of every signal in mask, lowest number first, in
+    // one read section. Returns the number of handlers run.
+    size_t dispatchAll(uint64_t mask) {
+        if (!mask) return 0;
+        size_t handled = 0;
+        ReadSection section(*this);
+        while (mask) {
+            int signal = __builtin_ctzll(mask);
+            mask &= mask - 1;
+            const Callback& callback = section.table->handlers[signal];
+            if (callback) {
+                callback(signal);
+                handled++;
+            }
+        }
+        return handled;
+    }
+
+private:
+    struct Table {
+        std::array<Callback, MAX_SIGNALS> handlers;
+    };
+
+    class ReadSection {
+    public:
+        explicit ReadSection(SignalDispatchTable& owner) : owner(owner) {
+            for (;;) {
+                side = owner.parity.load(std::memory_order_seq_cst);
+                owner.readers[side].value.fetch_add(1, std::memory_order_seq_cst);
+                if (owner.parity.load(std::memory_order_seq_cst) == side) break;
+                owner.readers[side].value.fetch_sub(1, std::memory_order_release); // Raced a flip
+            }
+            table = owner.current.load(std::memory_order_seq_cst);
+        }
+
+        ~ReadSection() { owner.readers[side].value.fetch_sub(1, std::memory_order_release); }
+
+        const Table* table;
+
+    private:
+        SignalDispatchTable& owner;
+        unsigned side;
+    };
+
+    struct RetiredTable {
+        Table* table;
+        bool drained[2];
+    };
+
+    // Called with writerMutex held
+    void publish(Table* next) {
+        Table* old = current.exchange(next, std::memory_order_seq_cst);
+        retired.push_back({old, {false, false}});
+        parity.store(parity.load(std::memory_order_relaxed) ^ 1, std::memory_order_seq_cst);
+        reclaim();
+    }
+
+    // A counter seen at zero after a table was retired means every reader
+    // counted there before the retirement has left
+    void reclaim() {
+        bool idle[2] = {readers[0].value.load(std::memory_order_seq_cst) == 0,
+                        readers[1].value.load(std::memory_order_seq_cst) == 0};
+        size_t kept = 0;
+        for (RetiredTable& entry : retired) {
+            entry.drained[0] |= idle[0];
+            entry.drained[1] |= idle[1];
+            if (entry.drained[0] && entry.drained[1]) {
+                delete entry.table;
+            } else {
+                retired[kept++] = entry;
+            }
+        }
+        retired.resize(kept);
+    }
+
+    struct alignas(64) ReaderCount {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::atomic<Table*> current;
+    std::atomic<unsigned> parity{0};
+    ReaderCount readers[2];
+    std::mutex writerMutex;
+    std::vector<RetiredTable> retired; // Guarded by writerMutex
+};
+
+} // namespace Kernel
+
+#endif
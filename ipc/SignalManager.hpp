@@ -3,7 +3,14 @@
 
 #include 
 #include 
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "../process/process.hpp"
+#include "SignalDispatch.hpp"
 
 namespace Kernel {
 
@@ -16,27 +23,76 @@ enum class Signal {
     SIGCHLD
 };
 
+// Per-process pending masks and a lock-free dispatch table (see
+// SignalDispatch.hpp). Repeated sends of a pending signal coalesce, and
+// handlePendingSignals() drains each process's mask in one pass.
 class SignalManager {
 public:
-    static SignalManager& getInstance();
+    static SignalManager& getInstance() {
+        static SignalManager instance;
+        return instance;
+    }
 
-    void registerHandler(Signal sig, std::function handler);
-    void unregisterHandler(Signal sig);
-    void sendSignal(pid_t pid, Signal sig);
-    void handlePendingSignals();
+    void registerHandler(Signal sig, std::function<void(Signal)> handler) {
+        handlers.set(static_cast<int>(sig), [handler = std::move(handler)](int signal) {
+            handler(static_cast<Signal>(signal));
+        });
+    }
+
+    void unregisterHandler(Signal sig) {
+        handlers.clear(static_cast<int>(sig));
+    }
+
+    void sendSignal(pid_t pid, Signal sig) {
+        if (pendingFor(pid).raise(static_cast<int>(sig))) {
+            std::lock_guard lock(signalledMutex);
+            if (!signalled.count(pid)) {
+                signalled.insert(pid);
+                signalledOrder.push_back(pid);
+            }
+        }
+    }
+
+    // Delivers everything pending, one mask exchange per process
+    size_t handlePendingSignals() {
+        std::vector<pid_t> pids;
+        {
+            std::lock_guard lock(signalledMutex);
+            pids.swap(signalledOrder);
+            signalled.clear();
+        }
+        size_t handled = 0;
+        for (pid_t pid : pids) handled += handlePendingSignals(pid);
+        return handled;
+    }
+
+    size_t handlePendingSignals(pid_t pid) {
+        return handlers.dispatchAll(pendingFor(pid).take());
+    }
 
 private:
     SignalManager() = default;
     ~SignalManager() = default;
 
-    struct SignalInfo {
-        Signal signal;
-        pid_t sender;
-        pid_t receiver;
-    };
+    PendingSignals& pendingFor(pid_t pid) {
+        {
+            std::shared_lock lock(pendingMutex);
+            auto it = pending.find(pid);
+            if (it != pending.end()) return *it->second;
+        }
+        std::unique_lock lock(pendingMutex);
+        auto& signals = pending[pid];
+        if (!signals) signals = std::make_unique<PendingSignals>();
+        return *signals;
+    }
 
-    std::map> handlers;
-    std::vector pendingSignals;
+    SignalDispatchTable handlers;
+    std::unordered_map<pid_t, std::unique_ptr<PendingSignals>> pending;
+    std::shared_mutex pendingMutex;
+    // Processes with something newly pending, in arrival order
+    std::unordered_set<pid_t> signalled;
+    std::vector<pid_t> signalledOrder;
+    std::mutex signalledMutex;
 };
 
 } // namespace Kernel
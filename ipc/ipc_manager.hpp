@@ -10,166 +10,259 @@
 #include 
 #include 
 #include 
+#include <shared_mutex>
+#include <unordered_set>
+#include "MessageChannel.hpp"
+#include "SharedPayloadArena.hpp"
+#include "SharedSegment.hpp"
+#include "SignalDispatch.hpp"
 
 namespace Kernel {
 
-using ProcessId = int;
-
-struct Message {
-    ProcessId sender;
-    ProcessId receiver; 
-    std::string data;
-    size_t priority;
-    uint64_t timestamp;
-};
-
+// Per-receiver inboxes. Each process gets its own bounded MPSC channel
+// with priority lanes, so traffic to one receiver never holds up another.
+// Only a process with an open inbox can be sent to. The ring has a single
+// consumer, so a process's receiving threads take turns on its inbox.
 class MessageQueue {
 private:
-    std::priority_queue messages;
-    std::mutex queueMutex;
-    
+    struct Inbox {
+        explicit Inbox(size_t laneCapacity) : channel(laneCapacity) {}
+        MpscChannel channel;
+        std::mutex receiveMutex; // One consumer at a time
+    };
+
+    std::unordered_map<ProcessId, std::shared_ptr<Inbox>> channels;
+    mutable std::shared_mutex channelsMutex;
+    const size_t laneCapacity;
+
 public:
-    void optimizedSend(ProcessId dest, const Message& msg) {
-        std::lock_guard lock(queueMutex);
-        // Copy message and set timestamp
-        Message msgCopy = msg;
-        msgCopy.timestamp = getCurrentTimestamp();
-        messages.push(msgCopy);
-        notifyReceiver(dest);
+    // How long a sender waits on a full lane before giving up
+    static constexpr auto DEFAULT_SEND_TIMEOUT = std::chrono::milliseconds(100);
+
+    explicit MessageQueue(size_t laneCapacity = MpscChannel::DEFAULT_LANE_CAPACITY)
+        : laneCapacity(laneCapacity) {}
+
+    // Makes receiver reachable; a no-op if its inbox is already open
+    void openChannel(ProcessId receiver) {
+        std::unique_lock lock(channelsMutex);
+        auto& inbox = channels[receiver];
+        if (!inbox) inbox = std::make_shared<Inbox>(laneCapacity);
     }
-    
+
+    // Waits up to timeout while the receiver's lane is full. False if
+    // dest has no open inbox or the lane stayed full; msg is then dropped.
+    bool optimizedSend(ProcessId dest, Message msg, std::chrono::nanoseconds timeout = DEFAULT_SEND_TIMEOUT) {
+        auto inbox = find(dest);
+        if (!inbox) return false;
+        msg.receiver = dest;
+        msg.timestamp = getCurrentTimestamp();
+        return inbox->channel.send(std::move(msg), timeout);
+    }
+
     Message receive(ProcessId receiver) {
-        std::lock_guard lock(queueMutex);
-        if(!messages.empty()) {
-            Message msg = messages.top();
-            if(msg.receiver == receiver) {
-                messages.pop();
-                return msg;
-            }
-        }
-        return Message{}; // Return empty message if none found
+        Message msg{};
+        auto inbox = inboxFor(receiver);
+        std::lock_guard lock(inbox->receiveMutex);
+        inbox->channel.tryReceive(msg);
+        return msg; // Empty message if none was queued
+    }
+
+    // Sleeps until a message arrives or timeout expires
+    bool receive(ProcessId receiver, Message& msg, std::chrono::nanoseconds timeout) {
+        auto inbox = inboxFor(receiver);
+        std::lock_guard lock(inbox->receiveMutex);
+        return inbox->channel.receive(msg, timeout);
+    }
+
+    size_t receiveBatch(ProcessId receiver, std::vector<Message>& out, size_t max) {
+        auto inbox = inboxFor(receiver);
+        std::lock_guard lock(inbox->receiveMutex);
+        return inbox->channel.receiveBatch(out, max);
+    }
+
+    // Drops the receiver's inbox; later sends to it fail, and senders
+    // already waiting on it time out
+    void closeChannel(ProcessId receiver) {
+        std::unique_lock lock(channelsMutex);
+        channels.erase(receiver);
     }
 
     bool empty() const {
-        std::lock_guard lock(queueMutex);
-        return messages.empty();
+        std::shared_lock lock(channelsMutex);
+        for (const auto& [receiver, inbox] : channels) {
+            if (!inbox->channel.empty()) return false;
+        }
+        return true;
     }
 
     void clear() {
-        std::lock_guard lock(queueMutex);
-        while(!messages.empty()) {
-            messages.pop();
-        }
+        std::unique_lock lock(channelsMutex);
+        channels.clear();
     }
 
 private:
+    std::shared_ptr<Inbox> find(ProcessId receiver) const {
+        std::shared_lock lock(channelsMutex);
+        auto it = channels.find(receiver);
+        return it != channels.end() ? it->second : nullptr;
+    }
+
+    // A receiving process evidently exists, so its inbox opens on demand
+    std::shared_ptr<Inbox> inboxFor(ProcessId receiver) {
+        if (auto inbox = find(receiver)) return inbox;
+        std::unique_lock lock(channelsMutex);
+        auto& inbox = channels[receiver];
+        if (!inbox) inbox = std::make_shared<Inbox>(laneCapacity);
+        return inbox;
+    }
+
     uint64_t getCurrentTimestamp() const {
-        return std::chrono::duration_cast(
+        return std::chrono::duration_cast<std::chrono::microseconds>(
             std::chrono::system_clock::now().time_since_epoch()
         ).count();
     }
-
-    void notifyReceiver(ProcessId dest) {
-        // Implementation to notify receiving process
-        // This could involve system calls or signals
-    }
 };
 
 class SharedMemoryManager {
 private:
-    struct SharedSegment {
-        void* address;
-        size_t size;
-        int refCount;
-        std::mutex segmentMutex;
-    };
-    
-    std::unordered_map segments;
-    std::mutex managerMutex;
+    // Names resolve to handles once; attach/detach by handle go straight
+    // to the segment table without touching the name map or its lock
+    SharedSegmentTable table;
+    std::unordered_map<std::string, SegmentHandle> names;
+    mutable std::mutex managerMutex;
     
 public:
-    void* allocate(const std::string& name, size_t size) {
+    // Creates a segment, or attaches to the existing one of that name
+    // (whose options then stand). The caller holds one reference.
+    SegmentHandle create(const std::string& name, size_t size, const SegmentOptions& options = {}) {
         std::lock_guard lock(managerMutex);
-        auto it = segments.find(name);
-        if(it != segments.end()) {
-            std::lock_guard segLock(it->second.segmentMutex);
-            it->second.refCount++;
-            return it->second.address;
+        auto it = names.find(name);
+        if(it != names.end() && table.attach(it->second)) {
+            return it->second;
         }
 
-        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, 
-                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
-        if(addr == MAP_FAILED) {
-            return nullptr;
+        SharedSegment segment = mapSharedSegment(size, options);
+        if(!segment.address) {
+            return {};
         }
-
-        segments[name] = {addr, size, 1};
-        return addr;
+        SegmentHandle handle = table.insert(segment);
+        if(!handle.isValid()) {
+            unmapSharedSegment(segment);
+            return {};
+        }
+        names[name] = handle;
+        return handle;
     }
-    
-    bool deallocate(const std::string& name) {
+
+    // Resolves a name without taking a reference
+    SegmentHandle lookup(const std::string& name) const {
         std::lock_guard lock(managerMutex);
-        auto it = segments.find(name);
-        if(it == segments.end()) {
-            return false;
-        }
+        auto it = names.find(name);
+        return it != names.end() ? it->second : SegmentHandle{};
+    }
 
-        std::lock_guard segLock(it->second.segmentMutex);
-        if(--it->second.refCount <= 0) {
-            munmap(it->second.address, it->second.size);
-            segments.erase(it);
-        }
-        return true;
+    // Takes a reference; nullptr if the segment has been destroyed
+    void* attach(SegmentHandle handle) {
+        const SharedSegment* segment = table.attach(handle);
+        return segment ? segment->address : nullptr;
     }
 
-    ~SharedMemoryManager() {
+    // Drops a reference; the last one unmaps the segment
+    bool detach(SegmentHandle handle) {
+        auto result = table.detach(handle);
+        if(result != SharedSegmentTable::DetachResult::Destroyed) {
+            return result == SharedSegmentTable::DetachResult::Released;
+        }
         std::lock_guard lock(managerMutex);
-        for(auto& [name, segment] : segments) {
-            if(segment.address) {
-                munmap(segment.address, segment.size);
-                segment.address = nullptr;
+        for(auto it = names.begin(); it != names.end(); ++it) {
+            if(it->second.index == handle.index && it->second.generation == handle.generation) {
+                names.erase(it);
+                break;
             }
         }
-        segments.clear();
+        return true;
     }
 
-    std::vector> getSegments() const {
+    const SharedSegment* getSegment(SegmentHandle handle) const {
+        return table.get(handle);
+    }
+
+    void* allocate(const std::string& name, size_t size, const SegmentOptions& options = {}) {
+        SegmentHandle handle = create(name, size, options);
+        const SharedSegment* segment = table.get(handle);
+        return segment ? segment->address : nullptr;
+    }
+    
+    bool deallocate(const std::string& name) {
+        SegmentHandle handle = lookup(name);
+        return handle.isValid() && detach(handle);
+    }
+
+    std::vector<std::pair<std::string, SharedSegment>> getSegments() const {
         std::lock_guard lock(managerMutex);
-        std::vector> result;
-        result.reserve(segments.size());
-        for(const auto& [name, segment] : segments) {
-            result.emplace_back(name, segment);
+        std::vector<std::pair<std::string, SharedSegment>> result;
+        result.reserve(names.size());
+        for(const auto& [name, handle] : names) {
+            if(const SharedSegment* segment = table.get(handle)) {
+                result.emplace_back(name, *segment);
+            }
         }
         return result;
     }
 };
 
+// Handlers run outside any lock: the dispatch table is swapped on
+// registration and read without locking, so a slow handler holds up
+// neither other signals nor registration of unrelated ones. Each process
+// has an atomic pending mask; deliverPending() runs everything pending in
+// one pass.
 class SignalHandler {
 private:
-    using SignalCallback = std::function<void(int) w-tid="34">;
-    std::unordered_map handlers;
-    std::mutex handlerMutex;
+    using SignalCallback = std::function<void(int)>;
+    SignalDispatchTable handlers;
+    std::unordered_map<ProcessId, std::unique_ptr<PendingSignals>> pending;
+    std::shared_mutex pendingMutex;
+
+    PendingSignals& pendingFor(ProcessId pid) {
+        {
+            std::shared_lock lock(pendingMutex);
+            auto it = pending.find(pid);
+            if (it != pending.end()) return *it->second;
+        }
+        std::unique_lock lock(pendingMutex);
+        auto& signals = pending[pid];
+        if (!signals) signals = std::make_unique<PendingSignals>();
+        return *signals;
+    }
     
 public:
+    // Does not wait for running handlers; see SignalDispatchTable::synchronize
     void registerHandler(int signal, SignalCallback callback) {
-        std::lock_guard lock(handlerMutex);
-        handlers[signal] = std::move(callback);
+        handlers.set(signal, std::move(callback));
     }
     
+    // Synchronous delivery, bypassing the pending masks
     void process(int signal) {
-        std::lock_guard lock(handlerMutex);
-        if(auto it = handlers.find(signal); it != handlers.end()) {
-            it->second(signal);
-        }
+        handlers.dispatch(signal);
     }
 
-    void clearAllHandlers() {
-        std::lock_guard lock(handlerMutex);
-        handlers.clear();
+    // Marks signal pending for pid. Returns false if it already was.
+    bool raise(ProcessId pid, int signal) {
+        return pendingFor(pid).raise(signal);
     }
 
-    ~SignalHandler() {
-        clearAllHandlers();
+    // Runs the handlers of everything pending for pid, lowest signal first
+    size_t deliverPending(ProcessId pid) {
+        return handlers.dispatchAll(pendingFor(pid).take());
+    }
+
+    // Sleeps until a signal is pending for pid; false on timeout
+    bool waitPending(ProcessId pid, std::chrono::nanoseconds timeout) {
+        return pendingFor(pid).wait(timeout);
+    }
+
+    void clearAllHandlers() {
+        handlers.clearAll();
     }
 };
 
@@ -181,8 +274,26 @@ private:
     MessageQueue messageQueue;
     SharedMemoryManager sharedMem;
     SignalHandler signalHandler;
+    // Zero-copy payload arenas by segment id, each in a named shared
+    // segment. Lookups hand out a shared_ptr, so teardown can tell which
+    // arenas are still in use.
+    struct PayloadArenaEntry {
+        std::shared_ptr<SharedPayloadArena> arena;
+        SegmentHandle segment; // The reference openPayloadArena took
+        std::string name;
+    };
+    std::unordered_map<uint32_t, PayloadArenaEntry> payloadArenas;
+    std::unordered_map<std::string, uint32_t> payloadArenaIds;
+    std::shared_mutex payloadArenasMutex;
+    uint32_t nextPayloadSegment = 1;
     
     IPCManager() = default;
+
+    std::shared_ptr<SharedPayloadArena> findPayloadArena(uint32_t segment) {
+        std::shared_lock lock(payloadArenasMutex);
+        auto it = payloadArenas.find(segment);
+        return it != payloadArenas.end() ? it->second.arena : nullptr;
+    }
     
 public:
     static IPCManager& getInstance() {
@@ -193,29 +304,138 @@ public:
         return *instance;
     }
     
-    void sendMessage(ProcessId dest, const Message& msg) {
-        messageQueue.optimizedSend(dest, msg);
+    // A process is reachable by messages from registration until it is
+    // unregistered, e.g. on exit
+    void registerProcess(ProcessId pid) {
+        messageQueue.openChannel(pid);
+    }
+
+    void unregisterProcess(ProcessId pid) {
+        messageQueue.closeChannel(pid);
+    }
+
+    // False if dest is not registered or its inbox stayed full
+    bool sendMessage(ProcessId dest, const Message& msg) {
+        return messageQueue.optimizedSend(dest, msg);
+    }
+
+    bool sendMessage(ProcessId dest, Message&& msg) {
+        return messageQueue.optimizedSend(dest, std::move(msg));
     }
     
     Message receiveMessage(ProcessId receiver) {
         return messageQueue.receive(receiver);
     }
+
+    bool receiveMessage(ProcessId receiver, Message& msg, std::chrono::nanoseconds timeout) {
+        return messageQueue.receive(receiver, msg, timeout);
+    }
     
-    void* createSharedMemory(const std::string& name, size_t size) {
-        return sharedMem.allocate(name, size);
+    void* createSharedMemory(const std::string& name, size_t size, const SegmentOptions& options = {}) {
+        return sharedMem.allocate(name, size, options);
+    }
+
+    // Handle-based path: resolve the name once, then attach and detach
+    // without the name lookup
+    SegmentHandle openSharedSegment(const std::string& name, size_t size, const SegmentOptions& options = {}) {
+        return sharedMem.create(name, size, options);
+    }
+
+    SegmentHandle lookupSharedSegment(const std::string& name) const {
+        return sharedMem.lookup(name);
+    }
+
+    void* attachSharedSegment(SegmentHandle handle) {
+        return sharedMem.attach(handle);
+    }
+
+    bool detachSharedSegment(SegmentHandle handle) {
+        return sharedMem.detach(handle);
     }
     
     bool removeSharedMemory(const std::string& name) {
         return sharedMem.deallocate(name);
     }
     
-    void registerSignalHandler(int signal, std::function<void(int) w-tid="40"> handler) {
+    // A shared segment that senders allocate payloads in directly.
+    // Opening an existing name attaches to its arena. Returns the segment
+    // id, or 0 if the segment cannot hold an arena of payloadBytes.
+    uint32_t openPayloadArena(const std::string& name, size_t payloadBytes) {
+        std::unique_lock lock(payloadArenasMutex);
+        auto it = payloadArenaIds.find(name);
+        if (it != payloadArenaIds.end()) return it->second;
+
+        // create() attaches to an existing segment of that name, whatever
+        // its size, so size the arena by the segment actually mapped and
+        // format it only if nobody has yet
+        size_t size = SharedPayloadArena::segmentSizeFor(payloadBytes);
+        SegmentHandle handle = sharedMem.create(name, size);
+        const SharedSegment* segment = sharedMem.getSegment(handle);
+        if (!segment) return 0;
+        bool formatted = SharedPayloadArena::isFormatted(segment->address, segment->size);
+        if (!formatted && segment->size < size) {
+            sharedMem.detach(handle);
+            return 0;
+        }
+        uint32_t id = nextPayloadSegment;
+        auto arena = std::make_shared<SharedPayloadArena>(id, segment->address, segment->size, !formatted);
+        if (!arena->isValid()) {
+            sharedMem.detach(handle);
+            return 0;
+        }
+        nextPayloadSegment++;
+        payloadArenas[id] = {std::move(arena), handle, name};
+        payloadArenaIds[name] = id;
+        return id;
+    }
+
+    std::optional<PayloadDescriptor> allocatePayload(uint32_t segment, size_t length) {
+        auto arena = findPayloadArena(segment);
+        return arena ? arena->allocate(length) : std::nullopt;
+    }
+
+    // Valid until the arena is torn down; teardown skips arenas that a
+    // call is using at that moment
+    uint8_t* resolvePayload(const PayloadDescriptor& payload) {
+        auto arena = findPayloadArena(payload.segment);
+        return arena ? arena->data(payload) : nullptr;
+    }
+
+    // Sends only the descriptor; the sender's reference passes to dest,
+    // which calls releasePayload once done with the data. If the send
+    // fails the sender still holds the reference.
+    bool sendPayload(ProcessId dest, ProcessId sender, const PayloadDescriptor& payload, size_t priority = 1) {
+        Message msg{};
+        msg.sender = sender;
+        msg.priority = priority;
+        msg.payload = payload;
+        return messageQueue.optimizedSend(dest, std::move(msg));
+    }
+
+    bool releasePayload(const PayloadDescriptor& payload) {
+        auto arena = findPayloadArena(payload.segment);
+        return arena && arena->release(payload);
+    }
+
+    void registerSignalHandler(int signal, std::function<void(int)> handler) {
         signalHandler.registerHandler(signal, std::move(handler));
     }
     
     void handleSignal(int signal) {
         signalHandler.process(signal);
     }
+
+    bool raiseSignal(ProcessId pid, int signal) {
+        return signalHandler.raise(pid, signal);
+    }
+
+    size_t deliverPendingSignals(ProcessId pid) {
+        return signalHandler.deliverPending(pid);
+    }
+
+    bool waitForSignal(ProcessId pid, std::chrono::nanoseconds timeout) {
+        return signalHandler.waitPending(pid, timeout);
+    }
     
     ~IPCManager() {
         // Clean up message queues
@@ -223,10 +443,30 @@ public:
             messageQueue.clear();
         }
 
-        // Clean up shared memory segments
+        // Payload arenas go first, under their lock. One that a thread
+        // still holds keeps its arena and its segment mapped.
+        std::unordered_set<std::string> arenasInUse;
+        {
+            std::unique_lock lock(payloadArenasMutex);
+            for(auto it = payloadArenas.begin(); it != payloadArenas.end();) {
+                if(it->second.arena.use_count() > 1) {
+                    arenasInUse.insert(it->second.name);
+                    ++it;
+                    continue;
+                }
+                it->second.arena.reset();
+                sharedMem.detach(it->second.segment);
+                payloadArenaIds.erase(it->second.name);
+                it = payloadArenas.erase(it);
+            }
+        }
+
+        // Clean up the remaining shared memory segments
         auto segments = sharedMem.getSegments();
         for(const auto& segment : segments) {
-            removeSharedMemory(segment.first);
+            if(!arenasInUse.count(segment.first)) {
+                removeSharedMemory(segment.first);
+            }
         }
 
         // Clean up signal handlers
@@ -0,0 +1,449 @@
+#ifndef COMPRESSED_PAGE_POOL_HPP
+#define COMPRESSED_PAGE_POOL_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "../include/lz_codec.hpp"
+
+namespace Memory {
+
+// Size-classed store for compressed pages (zsmalloc-style). Objects are
+// rounded up to a 32-byte class and packed into zspages of 1-4 pages,
+// sized per class to minimize the tail left over; a 1.3 KB object does
+// not waste the rest of a page. Zspages that empty out are released.
+class ZsPool {
+public:
+    using Handle = uint64_t;
+
+    static constexpr size_t PAGE_SIZE = 4096;
+    static constexpr size_t CLASS_STEP = 32;
+    static constexpr size_t CLASS_COUNT = PAGE_SIZE / CLASS_STEP;
+    static constexpr size_t MAX_ZSPAGE_PAGES = 4;
+
+    ZsPool() {
+        for (size_t i = 0; i < CLASS_COUNT; i++) {
+            SizeClass& sizeClass = classes[i];
+            sizeClass.objectSize = (i + 1) * CLASS_STEP;
+            size_t bestWaste = SIZE_MAX;
+            for (size_t pages = 1; pages <= MAX_ZSPAGE_PAGES; pages++) {
+                size_t bytes = pages * PAGE_SIZE;
+                size_t waste = (bytes % sizeClass.objectSize) * MAX_ZSPAGE_PAGES / pages;
+                if (waste < bestWaste) {
+                    bestWaste = waste;
+                    sizeClass.zspageBytes = bytes;
+                }
+            }
+            sizeClass.objectsPerZspage = sizeClass.zspageBytes / sizeClass.objectSize;
+        }
+    }
+
+    ZsPool(const ZsPool&) = delete;
+    ZsPool& operator=(const ZsPool&) = delete;
+
+    // size must be 1..PAGE_SIZE
+    Handle allocate(size_t size) {
+        size_t classIndex = (size - 1) / CLASS_STEP;
+        SizeClass& sizeClass = classes[classIndex];
+        std::lock_guard lock(sizeClass.mutex);
+
+        if (sizeClass.partial.empty()) {
+            uint32_t index;
+            if (!sizeClass.released.empty()) {
+                index = sizeClass.released.back();
+                sizeClass.released.pop_back();
+            } else {
+                index = static_cast<uint32_t>(sizeClass.zspages.size());
+                sizeClass.zspages.emplace_back();
+            }
+            Zspage& zspage = sizeClass.zspages[index];
+            zspage.memory.reset(new uint8_t[sizeClass.zspageBytes]);
+            zspage.freeSlots.resize(sizeClass.objectsPerZspage);
+            for (size_t slot = 0; slot < sizeClass.objectsPerZspage; slot++) {
+                zspage.freeSlots[slot] = static_cast<uint16_t>(sizeClass.objectsPerZspage - 1 - slot);
+            }
+            sizeClass.partial.push_back(index);
+            poolBytes.fetch_add(sizeClass.zspageBytes, std::memory_order_relaxed);
+        }
+
+        uint32_t index = sizeClass.partial.back();
+        Zspage& zspage = sizeClass.zspages[index];
+        uint16_t slot = zspage.freeSlots.back();
+        zspage.freeSlots.pop_back();
+        zspage.used++;
+        if (zspage.freeSlots.empty()) sizeClass.partial.pop_back();
+        return makeHandle(classIndex, index, slot);
+    }
+
+    // Valid until the handle is freed
+    uint8_t* map(Handle handle) {
+        SizeClass& sizeClass = classes[classOf(handle)];
+        std::lock_guard lock(sizeClass.mutex);
+        return sizeClass.zspages[zspageOf(handle)].memory.get() + slotOf(handle) * sizeClass.objectSize;
+    }
+
+    void free(Handle handle) {
+        SizeClass& sizeClass = classes[classOf(handle)];
+        std::lock_guard lock(sizeClass.mutex);
+        uint32_t index = zspageOf(handle);
+        Zspage& zspage = sizeClass.zspages[index];
+        zspage.freeSlots.push_back(slotOf(handle));
+        if (zspage.freeSlots.size() == 1) sizeClass.partial.push_back(index);
+
+        if (--zspage.used == 0) {
+            zspage.memory.reset();
+            zspage.freeSlots.clear();
+            sizeClass.partial.erase(std::find(sizeClass.partial.begin(), sizeClass.partial.end(), index));
+            sizeClass.released.push_back(index);
+            poolBytes.fetch_sub(sizeClass.zspageBytes, std::memory_order_relaxed);
+        }
+    }
+
+    // Memory held by zspages, including free slots
+    size_t getPoolBytes() const { return poolBytes.load(std::memory_order_relaxed); }
+
+private:
+    struct Zspage {
+        std::unique_ptr<uint8_t[]> memory; // Null once released
+        std::vector<uint16_t> freeSlots;
+        uint32_t used = 0;
+    };
+
+    struct SizeClass {
+        size_t objectSize = 0;
+        size_t zspageBytes = 0;
+        size_t objectsPerZspage = 0;
+        std::vector<Zspage> zspages;
+        std::vector<uint32_t> partial;  // Zspages with free slots
+        std::vector<uint32_t> released; // Indices free for reuse
+        std::mutex mutex;
+    };
+
+    static Handle makeHandle(size_t classIndex, uint32_t zspage, uint16_t slot) {
+        return (Handle(classIndex) << 48) | (Handle(zspage) << 16) | slot;
+    }
+    static size_t classOf(Handle handle) { return handle >> 48; }
+    static uint32_t zspageOf(Handle handle) { return static_cast<uint32_t>(handle >> 16); }
+    static uint16_t slotOf(Handle handle) { return static_cast<uint16_t>(handle); }
+
+    std::array<SizeClass, CLASS_COUNT> classes;
+    std::atomic<size_t> poolBytes{0};
+};
+
+// Compressed cache for inactive pages (zswap-style). Tracked pages sit on
+// an LRU; reclaim() compresses the coldest ones into a ZsPool and hands
+// each page back through releasePage. A page filled with one repeated
+// 64-bit word (most often zero) is stored as that word alone. Pages that
+// do not compress below MAX_COMPRESSED_SIZE stay resident.
+//
+// Call access() before touching a tracked page: it decompresses a page
+// that was reclaimed (the fault path) and marks it recently used. A page
+// accessed while it is being compressed is left resident. When a released
+// page has to be backed again before it is written, restorePage does it.
+//
+// protectPage(page, false) write-protects a page, TLB flush included, for
+// as long as it is being compressed, so a store cannot land between the
+// compression and releasePage; the write faults into access() instead.
+// protectPage(page, true) hands write access back when the page stays.
+// Returning false from protectPage(page, false) keeps the page resident
+// and out of this pass, e.g. when it sits inside a 2 MB leaf that
+// protecting or releasing one 4 KB page would split.
+//
+// The hooks run under the cache lock; they may take locks of their own
+// as long as those are never held while calling into the cache.
+class CompressedPageCache {
+public:
+    static constexpr size_t PAGE_SIZE = ZsPool::PAGE_SIZE;
+    static constexpr size_t MAX_COMPRESSED_SIZE = PAGE_SIZE * 3 / 4;
+
+    struct Stats {
+        uint64_t storedPages = 0;      // Currently compressed in the pool
+        uint64_t sameFilledPages = 0;  // Currently stored as a single word
+        uint64_t compressedBytes = 0;  // Payload bytes in the pool
+        uint64_t rejectedPages = 0;    // Poorly compressible, left resident
+        uint64_t faults = 0;           // Pages decompressed on access
+        uint64_t corruptPages = 0;     // Restores that failed to decompress
+        uint64_t skippedPages = 0;     // Refused by protectPage, left resident
+        size_t poolBytes = 0;
+    };
+
+    explicit CompressedPageCache(std::function<void(void*)> releasePage = {},
+                                 std::function<bool(void*)> restorePage = {},
+                                 std::function<bool(void*, bool)> protectPage = {})
+        : releasePage(std::move(releasePage)), restorePage(std::move(restorePage)),
+          protectPage(std::move(protectPage)) {}
+
+    ~CompressedPageCache() {
+        stopBackground();
+        for (auto& [page, entry] : entries) {
+            if (entry.state == State::Compressed && !entry.sameFilled) pool.free(entry.handle);
+        }
+    }
+
+    CompressedPageCache(const CompressedPageCache&) = delete;
+    CompressedPageCache& operator=(const CompressedPageCache&) = delete;
+
+    // page must be PAGE_SIZE aligned and stay valid until untrack()
+    void track(void* page) {
+        std::lock_guard lock(mutex);
+        if (entries.count(page)) return;
+        lru.push_front(page);
+        entries[page] = {lru.begin(), std::chrono::steady_clock::now()};
+    }
+
+    // Decompresses the page if needed, then stops tracking it. Waits for
+    // an in-flight compression so the page can be unmapped afterwards.
+    void untrack(void* page) {
+        std::unique_lock lock(mutex);
+        auto it = entries.find(page);
+        if (it == entries.end()) return;
+        compressionDone.wait(lock, [&] { return it->second.state != State::Compressing; });
+        if (it->second.state == State::Compressed) {
+            // Not on the LRU while compressed. With nowhere to restore it
+            // the contents go; the caller is unmapping the page anyway.
+            if (!restore(page, it->second)) discard(it->second);
+        } else {
+            lru.erase(it->second.position);
+        }
+        entries.erase(it);
+    }
+
+    // Fault path. Returns true if the page had to be decompressed; a page
+    // restorePage could not back, or whose copy is corrupt, stays
+    // compressed and returns false.
+    bool access(void* page) {
+        std::lock_guard lock(mutex);
+        auto it = entries.find(page);
+        if (it == entries.end()) return false;
+        Entry& entry = it->second;
+        entry.lastAccess = std::chrono::steady_clock::now();
+        entry.generation++;
+
+        bool faulted = entry.state == State::Compressed;
+        if (faulted) {
+            if (!restore(page, entry)) return false;
+            stats.faults++;
+            lru.push_front(page);
+            entry.position = lru.begin();
+        } else if (entry.state == State::Resident) {
+            lru.splice(lru.begin(), lru, entry.position);
+        } else if (protectPage) {
+            protectPage(page, true); // Reclaim sees the new generation and keeps the page
+        }
+        return faulted;
+    }
+
+    bool isCompressed(void* page) {
+        std::lock_guard lock(mutex);
+        auto it = entries.find(page);
+        return it != entries.end() && it->second.state == State::Compressed;
+    }
+
+    // Compresses up to maxPages pages from the cold end of the LRU that
+    // have not been accessed for minIdle. Returns pages compressed.
+    size_t reclaim(size_t maxPages, std::chrono::milliseconds minIdle) {
+        size_t compressed = 0;
+        std::vector<uint8_t> buffer(Kernel::Compression::LZCodec::compressBound(PAGE_SIZE));
+        auto now = std::chrono::steady_clock::now();
+
+        for (size_t attempts = 0; compressed < maxPages; attempts++) {
+            void* page;
+            uint64_t generation;
+            {
+                std::lock_guard lock(mutex);
+                if (lru.empty() || attempts >= entries.size()) break;
+                page = lru.back();
+                Entry& entry = entries[page];
+                if (now - entry.lastAccess < minIdle) break; // The rest are warmer
+                lru.pop_back();
+                if (protectPage && !protectPage(page, false)) {
+                    stats.skippedPages++;
+                    lru.push_front(page);
+                    entry.position = lru.begin();
+                    continue;
+                }
+                entry.state = State::Compressing;
+                generation = entry.generation;
+            }
+
+            // Compress outside the lock; a write faults into access(),
+            // which bumps the generation
+            uint64_t fill = 0;
+            bool sameFilled = isSameFilled(page, fill);
+            size_t size = sameFilled ? 0
+                : Kernel::Compression::LZCodec::compress(static_cast<const uint8_t*>(page), PAGE_SIZE,
+                                                         buffer.data(), buffer.size());
+            bool keep = sameFilled || (size > 0 && size <= MAX_COMPRESSED_SIZE);
+            ZsPool::Handle handle = 0;
+            if (keep && !sameFilled) {
+                handle = pool.allocate(size);
+                std::memcpy(pool.map(handle), buffer.data(), size);
+            }
+
+            std::lock_guard lock(mutex);
+            compressionDone.notify_all();
+            Entry& entry = entries[page];
+            if (!keep || entry.generation != generation) {
+                if (keep && !sameFilled) pool.free(handle);
+                if (!keep) stats.rejectedPages++;
+                if (protectPage) protectPage(page, true);
+                entry.state = State::Resident;
+                // Rejected pages go to the warm end so the next pass moves on
+                lru.push_front(page);
+                entry.position = lru.begin();
+                continue;
+            }
+
+            entry.state = State::Compressed;
+            entry.sameFilled = sameFilled;
+            entry.fill = fill;
+            entry.handle = handle;
+            entry.compressedSize = static_cast<uint32_t>(size);
+            stats.storedPages++;
+            if (sameFilled) stats.sameFilledPages++;
+            stats.compressedBytes += size;
+            if (releasePage) releasePage(page);
+            compressed++;
+        }
+        return compressed;
+    }
+
+    // Background reclaim: every interval, compress up to batch pages idle
+    // for minIdle. Keeps compression off the allocation path. afterPass,
+    // if set, runs on the worker after each reclaim pass.
+    void startBackground(std::chrono::milliseconds interval, size_t batch, std::chrono::milliseconds minIdle,
+                         std::function<void()> afterPass = {}) {
+        stopBackground();
+        running = true;
+        worker = std::thread([this, interval, batch, minIdle, afterPass = std::move(afterPass)] {
+            std::unique_lock lock(workerMutex);
+            while (running) {
+                lock.unlock();
+                reclaim(batch, minIdle);
+                if (afterPass) afterPass();
+                lock.lock();
+                workerSignal.wait_for(lock, interval, [this] { return !running; });
+            }
+        });
+    }
+
+    void stopBackground() {
+        {
+            std::lock_guard lock(workerMutex);
+            running = false;
+        }
+        workerSignal.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    Stats getStats() {
+        std::lock_guard lock(mutex);
+        Stats snapshot = stats;
+        snapshot.poolBytes = pool.getPoolBytes();
+        return snapshot;
+    }
+
+    // A page of one repeated word. SSE2 compares 64 bytes per iteration.
+    static bool isSameFilled(const void* page, uint64_t& fill) {
+        const auto* words = static_cast<const uint64_t*>(page);
+        fill = words[0];
+#ifdef __SSE2__
+        const __m128i pattern = _mm_set1_epi64x(static_cast<long long>(fill));
+        const auto* vectors = static_cast<const __m128i*>(page);
+        for (size_t i = 0; i < PAGE_SIZE / sizeof(__m128i); i += 4) {
+            __m128i a = _mm_and_si128(_mm_cmpeq_epi8(_mm_load_si128(vectors + i), pattern),
+                                      _mm_cmpeq_epi8(_mm_load_si128(vectors + i + 1), pattern));
+            __m128i b = _mm_and_si128(_mm_cmpeq_epi8(_mm_load_si128(vectors + i + 2), pattern),
+                                      _mm_cmpeq_epi8(_mm_load_si128(vectors + i + 3), pattern));
+            if (_mm_movemask_epi8(_mm_and_si128(a, b)) != 0xffff) return false;
+        }
+        return true;
+#else
+        for (size_t i = 1; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+            if (words[i] != fill) return false;
+        }
+        return true;
+#endif
+    }
+
+private:
+    enum class State : uint8_t { Resident, Compressing, Compressed };
+
+    struct Entry {
+        std::list<void*>::iterator position; // Valid while Resident
+        std::chrono::steady_clock::time_point lastAccess;
+        uint64_t generation = 0;
+        State state = State::Resident;
+        bool sameFilled = false;
+        uint64_t fill = 0;
+        ZsPool::Handle handle = 0;
+        uint32_t compressedSize = 0;
+    };
+
+    // Caller holds mutex. Returns false, leaving the page compressed, if
+    // restorePage cannot back it or the copy does not decompress to a
+    // whole page; a frame already backed for it is released again rather
+    // than left mapped with garbage.
+    bool restore(void* page, Entry& entry) {
+        if (restorePage && !restorePage(page)) return false;
+        if (entry.sameFilled) {
+            std::fill_n(static_cast<uint64_t*>(page), PAGE_SIZE / sizeof(uint64_t), entry.fill);
+        } else {
+            long size = Kernel::Compression::LZCodec::decompress(pool.map(entry.handle), entry.compressedSize,
+                                                                 static_cast<uint8_t*>(page), PAGE_SIZE);
+            if (size != static_cast<long>(PAGE_SIZE)) {
+                stats.corruptPages++;
+                if (releasePage) releasePage(page);
+                return false;
+            }
+        }
+        discard(entry);
+        return true;
+    }
+
+    // Caller holds mutex. Drops the compressed copy.
+    void discard(Entry& entry) {
+        if (entry.sameFilled) {
+            stats.sameFilledPages--;
+        } else {
+            pool.free(entry.handle);
+        }
+        stats.storedPages--;
+        stats.compressedBytes -= entry.compressedSize;
+        entry.state = State::Resident;
+    }
+
+    ZsPool pool;
+    std::function<void(void*)> releasePage;
+    std::function<bool(void*)> restorePage;
+    std::function<bool(void*, bool)> protectPage;
+    std::list<void*> lru; // Front is most recently used
+    std::unordered_map<void*, Entry> entries;
+    Stats stats;
+    std::mutex mutex;
+    std::condition_variable compressionDone;
+
+    std::thread worker;
+    std::mutex workerMutex;
+    std::condition_variable workerSignal;
+    bool running = false;
+};
+
+} // namespace Memory
+
+#endif
@@ -2,6 +2,10 @@
 #include "kernel/loggin/EventLogger.hpp"
 #include "kernel/memory/PageAllocator.hpp" 
 #include "kernel/memory/vmm.hpp"
+#include "kernel/memory/SlabAllocator.hpp"
+#include "kernel/memory/MovableHeap.hpp"
+#include "kernel/memory/TLB.hpp"
+#include "kernel/memory/PageTable.hpp"
 #include 
 #include 
 #include 
@@ -16,55 +20,26 @@ class OptimizedUnifiedMemoryManager : public MemoryManager {
 private:
     static constexpr size_t PAGE_SIZE = 4096;
     static constexpr size_t CACHE_LINE_SIZE = 64;
-    static constexpr size_t TLB_SIZE = 256;
+    static constexpr uint32_t KERNEL_ADDRESS_SPACE = 0;
+    static constexpr size_t MOVABLE_HEAP_SIZE = 64 * 1024 * 1024;
+    static constexpr std::chrono::microseconds DEFAULT_COMPACTION_BUDGET{500};
     
-    struct TLBEntry {
-        uint64_t virtualAddress;
-        uint64_t physicalAddress;
-        bool valid;
-    };
-    
-    struct MemoryPool {
-        void* start;
-        size_t size;
-        std::atomic used{0};
-        WorkloadType optimizedFor;
-        FragmentationMetrics fragmentationMetrics;
-    };
-
-    struct PoolAllocationInfo {
-      size_t poolIndex;
-      size_t size;
-    };
-
     struct PageAllocationInfo {
       size_t numPages;
     };
 
-    struct FragmentationMetrics {
-      std::atomic totalAllocations{0};
-      std::atomic totalDeallocations{0};
-      std::atomic fragmentedSpace{0};
-      
-      void recordDeallocation(size_t size) {
-        totalDeallocations++;
-        fragmentedSpace += size;
-      }
-      
-      bool shouldDefragment() const {
-        return fragmentedSpace > 1024 * 1024; // 1MB
-      }
-    };
-
-    std::array tlbCache;
-    std::array pools;
+    // Tagged per address space; kernel heap pages are global entries
+    ::Memory::SoftwareTLB tlb;
+    // Small objects: per-thread size-class caches, no shared lock or map
+    ::Memory::SlabAllocator slabAllocator;
+    // Long-lived relocatable blocks, compacted a slice at a time between frames
+    ::Memory::MovableHeap movableHeap{MOVABLE_HEAP_SIZE};
     std::unique_ptr pageAllocator;
     std::unique_ptr compression;
     std::unique_ptr profiler;
     VirtualMemoryManager& vmm;
     std::mutex mutex;
-    std::unordered_map pageTable;
-    std::unordered_map poolAllocations;
+    ::Memory::PageTable pageTable;
     std::unordered_map pageAllocations;
     PhysicalPagePool physicalPagePool;
     
@@ -86,7 +61,6 @@ public:
             setupMemorySubsystems();
             setupPaging();
             setupGameProfiles();
-            configureMemoryPools();
             initializeTLB();
             
             totalMemory = pageAllocator->getTotalPages() * PAGE_SIZE;
@@ -104,39 +78,40 @@ public:
     void* allocateMemory(size_t size) {
         if (size == 0) return nullptr;
         
-        std::lock_guard lock(mutex);
-        
-        // Cache-line alignment
+        // Cache-line alignment; a cache-line multiple always lands in a slab
+        // class whose objects are cache-line aligned
         size = (size + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
         
-        // Workload detection
-        auto workloadType = profiler->detectWorkloadType();
-        
-        // Try optimized pool first
-        for (auto& pool : pools) {
-            if (pool.optimizedFor == workloadType && pool.size >= size) {
-                size_t offset = pool.used.fetch_add(size);
-                if (offset + size <= pool.size) {
-                    void* ptr = static_cast(pool.start) + offset;
-                    poolAllocations[ptr] = {&pool - &pools[0], size};
-                    return ptr;
-                }
-                pool.used.fetch_sub(size);
-            }
+        if (size <= ::Memory::SlabAllocator::MAX_SMALL_SIZE) {
+            if (void* ptr = slabAllocator.allocate(size)) return ptr;
         }
+        
+        std::lock_guard lock(mutex);
 
-        // Fallback to page allocation
+        // Large allocations and slab arena exhaustion fall back to pages
         size_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
         void* virtualAddr = pageAllocator->allocatePages(pages);
         
         if (!virtualAddr) return nullptr;
 
+        // Physically contiguous runs are mapped with one call
+        uint64_t runVirt = reinterpret_cast(virtualAddr);
+        uint64_t runPhys = 0;
+        size_t runPages = 0;
         for (size_t i = 0; i < pages; i++) {
             uint64_t vAddr = reinterpret_cast(virtualAddr) + i * PAGE_SIZE;
             uint64_t pAddr = allocatePhysicalPage();
-            pageTable[vAddr] = pAddr;
             updateTLB(vAddr, pAddr);
+            if (runPages > 0 && pAddr == runPhys + runPages * PAGE_SIZE) {
+                runPages++;
+                continue;
+            }
+            if (runPages > 0) pageTable.mapRange(runVirt, runPhys, runPages * PAGE_SIZE);
+            runVirt = vAddr;
+            runPhys = pAddr;
+            runPages = 1;
         }
+        pageTable.mapRange(runVirt, runPhys, runPages * PAGE_SIZE);
 
         pageAllocations[reinterpret_cast(virtualAddr)] = {pages};
         
@@ -144,34 +119,14 @@ public:
     }
 
     bool freeMemory(void* ptr) {
-        std::lock_guard lock(mutex);
-
-        // Start by checking if this is a pool allocation
-        auto poolIt = poolAllocations.find(ptr); 
-        if (poolIt != poolAllocations.end()) {
-            MemoryPool& pool = pools[poolIt->second.poolIndex];
-            
-            // Track pool statistics
-            pool.used.fetch_sub(poolIt->second.size);
-            pool.fragmentationMetrics.recordDeallocation(poolIt->second.size);
-            
-            // Clear pool allocation tracking
-            poolAllocations.erase(poolIt);
-            
-            // Trigger pool defragmentation if needed
-            if (pool.fragmentationMetrics.shouldDefragment()) {
-                defragmentPool(pool);
-            }
-            
-            EventLogger::log("Pool memory freed", {
-              {"pool_index", poolIt->second.poolIndex},
-              {"size", poolIt->second.size},
-              {"address", fmt::ptr(ptr)}
-            });
-            
+        // Slab objects carry their metadata in the slab header
+        if (slabAllocator.owns(ptr)) {
+            slabAllocator.free(ptr);
             return true;
         }
 
+        std::lock_guard lock(mutex);
+
         // Handle page-based allocations
         uint64_t vAddr = reinterpret_cast(ptr);
         auto pageRange = pageAllocations.find(vAddr);
@@ -183,19 +138,18 @@ public:
             return false;
         }
 
-        // Clear TLB entries for all pages
+        // One range invalidation for the whole block, not one per page
         const size_t numPages = pageRange->second.numPages;
-        for (size_t i = 0; i < numPages; i++) {
-            uint64_t pageAddr = vAddr + (i * PAGE_SIZE);
-            invalidateTLBEntry(pageAddr);
-            
-            // Free physical pages
-            auto physPage = pageTable.find(pageAddr);
-            if (physPage != pageTable.end()) {
-                physicalPagePool.freePage(physPage->second);
-                pageTable.erase(physPage);
+        tlb.invalidateRange(KERNEL_ADDRESS_SPACE, vAddr, numPages);
+
+        // Free physical pages run by run, then drop the mappings in one pass
+        pageTable.forEachRange(vAddr, numPages * PAGE_SIZE,
+                               [&](uint64_t, uint64_t phys, uint64_t length, const auto&) {
+            for (uint64_t offset = 0; offset < length; offset += PAGE_SIZE) {
+                physicalPagePool.freePage(phys + offset);
             }
-        }
+        });
+        pageTable.unmapRange(vAddr, numPages * PAGE_SIZE);
 
         // Return pages to page allocator
         pageAllocator->freePages(ptr, numPages);
@@ -213,6 +167,59 @@ public:
         return true;
     }
 
+    // Handle-based allocation for data that can tolerate relocation.
+    // Resolve the handle for each access, or pin it to keep a pointer.
+    // A null handle under fragmentation may succeed a frame or two later.
+    ::Memory::MovableHeap::Handle allocateMovable(size_t size) {
+        auto handle = movableHeap.allocate(size);
+        if (!handle && movableHeap.getFragmentation() > 0.0f) {
+            // Full but fragmented: spend one frame's budget compacting and
+            // retry; if that is not enough, fail and let the per-frame
+            // steps free the space instead of stalling here for a full pass
+            movableHeap.compactStep(DEFAULT_COMPACTION_BUDGET);
+            handle = movableHeap.allocate(size);
+        }
+        return handle;
+    }
+
+    bool freeMovable(::Memory::MovableHeap::Handle handle) {
+        return movableHeap.free(handle);
+    }
+
+    void* resolveMovable(::Memory::MovableHeap::Handle handle) {
+        return movableHeap.resolve(handle);
+    }
+
+    void* pinMovable(::Memory::MovableHeap::Handle handle) {
+        return movableHeap.pin(handle);
+    }
+
+    void unpinMovable(::Memory::MovableHeap::Handle handle) {
+        movableHeap.unpin(handle);
+    }
+
+    // Keeps the outgoing address space's TLB entries under its tag
+    void switchAddressSpace(uint32_t addressSpace) {
+        std::lock_guard lock(mutex);
+        tlb.switchTo(addressSpace);
+    }
+
+    ::Memory::SoftwareTLB::Stats getTLBStats() {
+        std::lock_guard lock(mutex);
+        return tlb.getStats();
+    }
+
+    // Call once per frame; relocates live movable blocks within the budget
+    void compactBetweenFrames(std::chrono::microseconds budget = DEFAULT_COMPACTION_BUDGET) {
+        auto stats = movableHeap.compactStep(budget);
+        if (stats.passComplete && stats.bytesMoved > 0) {
+            EventLogger::log("Movable heap compacted", {
+              {"used", movableHeap.getUsedBytes()},
+              {"live", movableHeap.getLiveBytes()}
+            });
+        }
+    }
+
 private:
     void setupMemorySubsystems() {
         compression = std::make_unique();
@@ -224,22 +231,6 @@ private:
         pageAllocator->enableDynamicHugePages();
     }
 
-    void configureMemoryPools() {
-        const size_t sizes[] = {64, 256, 1024, 4096};
-        const WorkloadType types[] = {
-            WorkloadType::GAMING,
-            WorkloadType::CREATIVE,
-            WorkloadType::GENERAL,
-            WorkloadType::HIGH_PERFORMANCE
-        };
-        
-        for(size_t i = 0; i < pools.size(); ++i) {
-            pools[i].size = sizes[i] * 1024;
-            pools[i].start = pageAllocator->allocatePages(pools[i].size / PAGE_SIZE);
-            pools[i].optimizedFor = types[i];
-        }
-    }
-
     void setupGameProfiles() {
         std::vector profiles = {
             {"ModernGames", 2048_MB, true, Priority::HIGH},
@@ -252,55 +243,12 @@ private:
         }
     }
 
-    void updateTLB(uint64_t virtualAddr, uint64_t physicalAddr) {
-        size_t index = virtualAddr % TLB_SIZE;
-        tlbCache[index] = {virtualAddr, physicalAddr, true};
-    }
-
-    void invalidateTLBEntry(uint64_t virtualAddr) {
-        size_t index = virtualAddr % TLB_SIZE;
-        tlbCache[index].valid = false;
+    void initializeTLB() {
+        tlb.switchTo(KERNEL_ADDRESS_SPACE);
     }
 
-    void defragmentPool(MemoryPool& pool) {
-        std::lock_guard defragLock(pool.defragMutex);
-        
-        // Only defrag if still needed after acquiring lock
-        if (!pool.fragmentationMetrics.shouldDefragment()) {
-            return;
-        }
-
-        // Copy live allocations
-        std::vector> liveAllocations;
-        for (const auto& [ptr, info] : poolAllocations) {
-            if (info.poolIndex == &pool - &pools[0]) {
-                liveAllocations.emplace_back(ptr, info.size); 
-            }
-        }
-
-        // Sort by address
-        std::sort(liveAllocations.begin(), liveAllocations.end());
-
-        // Compact allocations
-        char* dest = static_cast(pool.start);
-        for (const auto& [ptr, size] : liveAllocations) {
-            if (ptr != dest) {
-                std::memcpy(dest, ptr, size);
-                // Update allocation tracking
-                poolAllocations[dest] = {&pool - &pools[0], size};
-                poolAllocations.erase(ptr);
-            }
-            dest += size;
-        }
-
-        // Reset fragmentation metrics
-        pool.fragmentationMetrics = FragmentationMetrics{};
-        pool.used.store(dest - static_cast(pool.start));
-
-        EventLogger::log("Pool defragmented", {
-          {"pool_index", &pool - &pools[0]},
-          {"compacted_size", pool.used.load()}
-        });
+    void updateTLB(uint64_t virtualAddr, uint64_t physicalAddr) {
+        tlb.insert(virtualAddr, physicalAddr, true);
     }
 };
 
@@ -8,87 +8,41 @@
 #include 
 #include 
 
-namespace Memory {
+#include "kernel/memory/PageAllocator.hpp"
 
-struct PageBitmap {
-    uint8_t* buffer;
-    size_t size;
-    
-    PageBitmap() : buffer(nullptr), size(0) {}
-};
+namespace Memory {
 
+// Huge-page aware front end over the buddy allocator. Huge pages are
+// 2 MB aligned runs; the bitmap indexes 4 KB pages either way.
 class EnhancedPageAllocator {
 private:
-    PageBitmap bitmap;
-    void* memoryStart;
-    size_t totalPages;
-    size_t freePages;
-    std::mutex allocationMutex;
-    std::vector<void* w-tid="16"> freePageList;
-    
-    size_t getPageIndex(void* address) {
-        return ((uintptr_t)address - (uintptr_t)memoryStart) / PAGE_SIZE;
-    }
-    
-    void setBit(size_t index, bool value) {
-        size_t byteIndex = index / 8;
-        size_t bitIndex = index % 8;
-        uint8_t bitMask = 1 << bitIndex;
-        
-        if (value) {
-            bitmap.buffer[byteIndex] |= bitMask;
-        } else {
-            bitmap.buffer[byteIndex] &= ~bitMask;
-        }
-    }
-    
-    bool getBit(size_t index) {
-        size_t byteIndex = index / 8;
-        size_t bitIndex = index % 8;
-        uint8_t bitMask = 1 << bitIndex;
-        return (bitmap.buffer[byteIndex] & bitMask) != 0;
-    }
+    PageAllocator allocator;
 
 public:
-    static const size_t PAGE_SIZE = 4096;
+    static const size_t PAGE_SIZE = PageAllocator::PAGE_SIZE;
     static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
     
     void initialize(void* start, size_t memorySize) {
-        std::lock_guard lock(allocationMutex);
-        memoryStart = start;
-        totalPages = memorySize / PAGE_SIZE;
-        freePages = totalPages;
-        
-        bitmap.size = (totalPages + 7) / 8;
-        bitmap.buffer = new uint8_t[bitmap.size]();
+        allocator.initialize(start, memorySize);
     }
     
     void* allocate(size_t size, bool useHugePages = false) {
-        std::lock_guard lock(allocationMutex);
-        size_t pageSize = useHugePages ? HUGE_PAGE_SIZE : PAGE_SIZE;
-        size_t pageCount = (size + pageSize - 1) / pageSize;
-        
-        size_t consecutivePages = 0;
-        size_t startPage = 0;
-        
-        for (size_t i = 0; i < totalPages; i++) {
-            if (!getBit(i)) {
-                if (consecutivePages == 0) startPage = i;
-                consecutivePages++;
-                
-                if (consecutivePages == pageCount) {
-                    for (size_t j = 0; j < pageCount; j++) {
-                        setBit(startPage + j, true);
-                    }
-                    freePages -= pageCount;
-                    return (void*)((uintptr_t)memoryStart + startPage * pageSize);
-                }
-            } else {
-                consecutivePages = 0;
-            }
+        if (useHugePages) {
+            size_t hugeSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+            return allocator.allocateAligned(hugeSize, HUGE_PAGE_SIZE);
         }
-        return nullptr;
+        return allocator.allocate(size);
     }
+    
+    void free(void* address, size_t size, bool useHugePages = false) {
+        if (useHugePages) {
+            size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        }
+        allocator.free(address, size);
+    }
+    
+    size_t getFreePageCount() const { return allocator.getFreePageCount(); }
+    float getFragmentationRatio() { return allocator.getFragmentationRatio(); }
 };
 
 class EnhancedMemoryManager {
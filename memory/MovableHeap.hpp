@@ -0,0 +1,253 @@
+#ifndef MOVABLE_HEAP_HPP
+#define MOVABLE_HEAP_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Memory {
+
+// Compactable heap for long-lived, relocatable blocks (asset metadata,
+// scripting objects, UI state). Callers hold a Handle instead of a
+// pointer; the handle table records each block's current offset, so the
+// compactor can slide live blocks down over freed space. Blocks are
+// bump-allocated and every block starts with a header, which lets the
+// compactor walk the heap in address order and resume where it stopped.
+//
+// A pointer from resolve() is valid until the next compactStep(). Code
+// that must hold a pointer across steps pins the block; pinned blocks are
+// never moved and compaction continues past them.
+class MovableHeap {
+public:
+    struct Handle {
+        uint32_t index = 0;
+        uint32_t generation = 0;
+        explicit operator bool() const { return generation != 0; }
+    };
+
+    struct CompactionStats {
+        size_t bytesMoved = 0;
+        size_t blocksMoved = 0;
+        bool passComplete = false;
+    };
+
+    static constexpr size_t ALIGNMENT = 16;
+
+    explicit MovableHeap(size_t capacity)
+        : region(new char[capacity]), capacity(capacity / ALIGNMENT * ALIGNMENT) {}
+
+    MovableHeap(const MovableHeap&) = delete;
+    MovableHeap& operator=(const MovableHeap&) = delete;
+
+    // Empty handle when the heap is full; compaction may make room
+    Handle allocate(size_t size) {
+        std::lock_guard lock(mutex);
+        size_t total = blockSize(size);
+        if (size == 0 || total > capacity - top) return {};
+
+        uint32_t index;
+        if (!freeHandles.empty()) {
+            index = freeHandles.back();
+            freeHandles.pop_back();
+        } else {
+            index = static_cast<uint32_t>(handles.size());
+            handles.push_back({});
+        }
+
+        HandleEntry& entry = handles[index];
+        entry.offset = top + sizeof(BlockHeader);
+        entry.size = size;
+        entry.generation++; // Odd: live
+        entry.pins = 0;
+
+        writeHeader(top, total, index);
+        top += total;
+        liveBytes += total;
+        return {index, entry.generation};
+    }
+
+    bool free(Handle handle) {
+        std::lock_guard lock(mutex);
+        HandleEntry* entry = find(handle);
+        if (!entry || entry->pins > 0) return false;
+
+        size_t headerOffset = entry->offset - sizeof(BlockHeader);
+        BlockHeader* header = headerAt(headerOffset);
+        header->handle = FREE_BLOCK;
+        liveBytes -= header->size;
+
+        entry->generation++; // Even: stale handles stop resolving
+        freeHandles.push_back(handle.index);
+        return true;
+    }
+
+    // Current address; stable only until the next compaction step
+    void* resolve(Handle handle) {
+        std::lock_guard lock(mutex);
+        HandleEntry* entry = find(handle);
+        return entry ? region.get() + entry->offset : nullptr;
+    }
+
+    size_t sizeOf(Handle handle) {
+        std::lock_guard lock(mutex);
+        HandleEntry* entry = find(handle);
+        return entry ? entry->size : 0;
+    }
+
+    // Pinned blocks stay put until every pin is released
+    void* pin(Handle handle) {
+        std::lock_guard lock(mutex);
+        HandleEntry* entry = find(handle);
+        if (!entry) return nullptr;
+        entry->pins++;
+        return region.get() + entry->offset;
+    }
+
+    void unpin(Handle handle) {
+        std::lock_guard lock(mutex);
+        HandleEntry* entry = find(handle);
+        if (entry && entry->pins > 0) entry->pins--;
+    }
+
+    // Slides live blocks toward the bottom of the heap until the time or
+    // byte budget runs out; call once per frame. A pass resumes where the
+    // previous call stopped and completes when it reaches the top.
+    CompactionStats compactStep(std::chrono::microseconds timeBudget,
+                                size_t byteBudget = SIZE_MAX) {
+        std::lock_guard lock(mutex);
+        CompactionStats stats;
+        auto deadline = std::chrono::steady_clock::now() + timeBudget;
+
+        // Nothing to reclaim: skip the walk entirely
+        if (scan == 0 && liveBytes == top) {
+            stats.passComplete = true;
+            return stats;
+        }
+
+        size_t steps = 0;
+        size_t movedSinceCheck = 0;
+        while (scan < top) {
+            BlockHeader* header = headerAt(scan);
+            size_t size = header->size;
+
+            if (header->handle != FREE_BLOCK) {
+                HandleEntry& entry = handles[header->handle];
+                if (entry.pins > 0) {
+                    // Barrier: leave a free block over the gap below it
+                    if (destination < scan) writeHeader(destination, scan - destination, FREE_BLOCK);
+                    destination = scan + size;
+                } else {
+                    if (destination < scan) {
+                        std::memmove(region.get() + destination, region.get() + scan, size);
+                        entry.offset = destination + sizeof(BlockHeader);
+                        stats.bytesMoved += size;
+                        stats.blocksMoved++;
+                        movedSinceCheck += size;
+                    }
+                    destination += size;
+                }
+            }
+            scan += size;
+
+            // Checking the clock every block would dominate small moves, so
+            // check every few blocks or after a large copy
+            if (stats.bytesMoved >= byteBudget) break;
+            if (++steps % 16 == 0 || movedSinceCheck >= CLOCK_CHECK_BYTES) {
+                movedSinceCheck = 0;
+                if (std::chrono::steady_clock::now() >= deadline) break;
+            }
+        }
+
+        if (scan >= top) {
+            top = destination;
+            scan = 0;
+            destination = 0;
+            stats.passComplete = true;
+            passes++;
+        }
+        return stats;
+    }
+
+    size_t getCapacity() const { return capacity; }
+
+    size_t getUsedBytes() {
+        std::lock_guard lock(mutex);
+        return top;
+    }
+
+    size_t getLiveBytes() {
+        std::lock_guard lock(mutex);
+        return liveBytes;
+    }
+
+    // Share of the allocated span occupied by freed blocks
+    float getFragmentation() {
+        std::lock_guard lock(mutex);
+        return top ? static_cast<float>(top - liveBytes) / static_cast<float>(top) : 0.0f;
+    }
+
+    uint64_t getCompletedPasses() {
+        std::lock_guard lock(mutex);
+        return passes;
+    }
+
+private:
+    static constexpr uint32_t FREE_BLOCK = UINT32_MAX;
+    static constexpr size_t CLOCK_CHECK_BYTES = 64 * 1024;
+
+    struct alignas(ALIGNMENT) BlockHeader {
+        uint32_t size;   // Header included
+        uint32_t handle; // FREE_BLOCK once freed
+    };
+
+    struct HandleEntry {
+        size_t offset = 0; // Payload offset in the region
+        size_t size = 0;
+        uint32_t generation = 0; // Odd while live, so never 0 for a live block
+        uint32_t pins = 0;
+    };
+
+    static size_t blockSize(size_t size) {
+        return (sizeof(BlockHeader) + size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    HandleEntry* find(Handle handle) {
+        if (handle.index >= handles.size()) return nullptr;
+        HandleEntry& entry = handles[handle.index];
+        if (entry.generation != handle.generation || !(entry.generation & 1)) return nullptr;
+        return &entry;
+    }
+
+    BlockHeader* headerAt(size_t offset) {
+        return reinterpret_cast<BlockHeader*>(region.get() + offset);
+    }
+
+    void writeHeader(size_t offset, size_t size, uint32_t handle) {
+        BlockHeader* header = headerAt(offset);
+        header->size = static_cast<uint32_t>(size);
+        header->handle = handle;
+    }
+
+    std::unique_ptr<char[]> region;
+    size_t capacity;
+    size_t top = 0;
+    size_t liveBytes = 0;
+
+    // Resumable compaction cursor: blocks below destination are packed
+    size_t scan = 0;
+    size_t destination = 0;
+    uint64_t passes = 0;
+
+    std::vector<HandleEntry> handles;
+    std::vector<uint32_t> freeHandles;
+    std::mutex mutex;
+};
+
+} // namespace Memory
+
+#endif
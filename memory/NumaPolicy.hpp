@@ -0,0 +1,491 @@
+#ifndef NUMA_POLICY_HPP
+#define NUMA_POLICY_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "PageAllocator.hpp"
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace Memory {
+
+// Nodes, the CPUs on each and the SLIT distance matrix (10 = local).
+// Built from sysfs on Linux, or synthesized to simulate a topology.
+class NumaTopology {
+public:
+    static constexpr size_t MAX_NODES = 64;
+    static constexpr uint8_t LOCAL_DISTANCE = 10;
+
+    NumaTopology() : NumaTopology(1, std::max(1u, std::thread::hardware_concurrency())) {}
+
+    // Simulated machine: nodes of cpusPerNode CPUs each (CPUs numbered
+    // node by node), every pair of nodes remoteDistance apart
+    NumaTopology(size_t nodes, size_t cpusPerNode, uint8_t remoteDistance = 20) {
+        nodes = std::clamp<size_t>(nodes, 1, MAX_NODES);
+        count = nodes;
+        for (size_t cpu = 0; cpu < nodes * cpusPerNode; cpu++) {
+            cpuNode.push_back(static_cast<uint8_t>(cpu / cpusPerNode));
+        }
+        distances.assign(nodes * nodes, remoteDistance);
+        for (size_t node = 0; node < nodes; node++) distances[node * nodes + node] = LOCAL_DISTANCE;
+        buildFallbackOrder();
+    }
+
+    // Reads /sys/devices/system/node; a single node when that is missing
+    static NumaTopology detect() {
+        std::vector<std::vector<size_t>> nodeCpus;
+        std::vector<std::vector<uint8_t>> rows;
+        for (size_t node = 0; node < MAX_NODES; node++) {
+            std::string base = "/sys/devices/system/node/node" + std::to_string(node);
+            std::ifstream cpulist(base + "/cpulist");
+            std::ifstream distance(base + "/distance");
+            if (!cpulist || !distance) continue;
+
+            std::string list;
+            std::getline(cpulist, list);
+            nodeCpus.push_back(parseCpuList(list));
+            std::vector<uint8_t> row;
+            for (unsigned value; distance >> value;) row.push_back(static_cast<uint8_t>(value));
+            rows.push_back(std::move(row));
+        }
+        // Rows list distances to online nodes in order, so sparse node ids compact cleanly
+        for (const auto& row : rows) {
+            if (row.size() != rows.size()) return NumaTopology();
+        }
+        if (rows.empty()) return NumaTopology();
+
+        NumaTopology topology(rows.size(), 0);
+        for (size_t node = 0; node < nodeCpus.size(); node++) {
+            for (size_t cpu : nodeCpus[node]) {
+                if (cpu >= topology.cpuNode.size()) topology.cpuNode.resize(cpu + 1, 0);
+                topology.cpuNode[cpu] = static_cast<uint8_t>(node);
+            }
+            for (size_t other = 0; other < rows.size(); other++) {
+                topology.distances[node * rows.size() + other] = rows[node][other];
+            }
+        }
+        topology.buildFallbackOrder();
+        return topology;
+    }
+
+    size_t nodeCount() const { return count; }
+    size_t cpuCount() const { return cpuNode.size(); }
+
+    size_t nodeOfCpu(size_t cpu) const {
+        return cpu < cpuNode.size() ? cpuNode[cpu] : 0;
+    }
+
+    uint8_t distance(size_t from, size_t to) const {
+        return distances[from * nodeCount() + to];
+    }
+
+    void setDistance(size_t from, size_t to, uint8_t value) {
+        distances[from * nodeCount() + to] = value;
+        distances[to * nodeCount() + from] = value;
+        buildFallbackOrder();
+    }
+
+    // Every node ordered by distance from node, node itself first
+    const std::vector<uint8_t>& fallbackOrder(size_t node) const { return fallback[node]; }
+
+    // Node of the CPU the caller is running on
+    size_t currentNode() const {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        if (cpu >= 0) return nodeOfCpu(static_cast<size_t>(cpu));
+#endif
+        return 0;
+    }
+
+private:
+    static std::vector<size_t> parseCpuList(const std::string& list) {
+        // "0-3,8-11"
+        std::vector<size_t> cpus;
+        std::stringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            if (range.empty()) continue;
+            size_t dash = range.find('-');
+            size_t first = std::stoul(range.substr(0, dash));
+            size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            for (size_t cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    void buildFallbackOrder() {
+        size_t nodes = count;
+        fallback.assign(nodes, {});
+        for (size_t node = 0; node < nodes; node++) {
+            auto& order = fallback[node];
+            for (size_t other = 0; other < nodes; other++) order.push_back(static_cast<uint8_t>(other));
+            std::stable_sort(order.begin(), order.end(), [&](uint8_t a, uint8_t b) {
+                if (a == node || b == node) return a == node && b != node;
+                return distances[node * nodes + a] < distances[node * nodes + b];
+            });
+        }
+    }
+
+    size_t count = 1;
+    std::vector<uint8_t> cpuNode;
+    std::vector<uint8_t> distances; // nodes x nodes, row-major
+    std::vector<std::vector<uint8_t>> fallback;
+};
+
+// Where new pages of a process or region come from
+struct NumaPolicy {
+    enum class Mode : uint8_t {
+        FirstTouch, // The node of the CPU that faults the page in
+        Preferred,  // preferredNode, then the nearest node with free memory
+        Interleave  // Round-robin over nodeMask by page offset
+    };
+
+    Mode mode = Mode::FirstTouch;
+    uint8_t preferredNode = 0;
+    uint64_t nodeMask = ~0ULL;
+
+    static NumaPolicy firstTouch() { return {}; }
+
+    static NumaPolicy preferred(size_t node) {
+        NumaPolicy policy;
+        policy.mode = Mode::Preferred;
+        policy.preferredNode = static_cast<uint8_t>(node);
+        return policy;
+    }
+
+    static NumaPolicy interleave(uint64_t nodeMask = ~0ULL) {
+        NumaPolicy policy;
+        policy.mode = Mode::Interleave;
+        policy.nodeMask = nodeMask;
+        return policy;
+    }
+};
+
+// Per-process policies, overridden by per-region policies (mbind-style).
+// Processes without one use first touch.
+class NumaPolicyTable {
+public:
+    void setProcessPolicy(int pid, const NumaPolicy& policy) {
+        std::lock_guard lock(mutex);
+        processes[pid] = policy;
+    }
+
+    // Replaces whatever parts of earlier regions [start, start + length) overlaps
+    void setRegionPolicy(int pid, uint64_t start, uint64_t length, const NumaPolicy& policy) {
+        if (length == 0) return;
+        std::lock_guard lock(mutex);
+        clearLocked(pid, start, start + length);
+        regions[{pid, start}] = {start + length, policy};
+    }
+
+    void clearRegionPolicy(int pid, uint64_t start, uint64_t length) {
+        std::lock_guard lock(mutex);
+        clearLocked(pid, start, start + length);
+    }
+
+    void removeProcess(int pid) {
+        std::lock_guard lock(mutex);
+        processes.erase(pid);
+        regions.erase(regions.lower_bound({pid, 0}), regions.lower_bound({pid + 1, 0}));
+    }
+
+    NumaPolicy lookup(int pid, uint64_t virt) const {
+        std::lock_guard lock(mutex);
+        auto it = regions.upper_bound({pid, virt});
+        if (it != regions.begin()) {
+            --it;
+            if (it->first.first == pid && virt < it->second.end) return it->second.policy;
+        }
+        auto process = processes.find(pid);
+        return process != processes.end() ? process->second : NumaPolicy::firstTouch();
+    }
+
+private:
+    struct Region {
+        uint64_t end;
+        NumaPolicy policy;
+    };
+
+    // Caller holds mutex. Trims regions overlapping [start, end).
+    void clearLocked(int pid, uint64_t start, uint64_t end) {
+        auto it = regions.lower_bound({pid, start});
+        if (it != regions.begin()) {
+            auto previous = std::prev(it);
+            if (previous->first.first == pid && previous->second.end > start) it = previous;
+        }
+        while (it != regions.end() && it->first.first == pid && it->first.second < end) {
+            uint64_t regionStart = it->first.second;
+            Region region = it->second;
+            it = regions.erase(it);
+            if (regionStart < start) regions[{pid, regionStart}] = {start, region.policy};
+            if (region.end > end) regions[{pid, end}] = {region.end, region.policy};
+        }
+    }
+
+    mutable std::mutex mutex;
+    std::unordered_map<int, NumaPolicy> processes;
+    std::map<std::pair<int, uint64_t>, Region> regions; // (pid, start)
+};
+
+// One buddy allocator, with its own free lists, per node. Allocations go
+// to the node the policy picks and fall back to the nearest node with
+// free memory.
+class NumaPageAllocator {
+public:
+    static constexpr size_t PAGE_SIZE = PageAllocator::PAGE_SIZE;
+    static constexpr size_t NO_NODE = SIZE_MAX;
+
+    struct Allocation {
+        void* address = nullptr;
+        size_t node = NO_NODE;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;        // Placed on the node the policy picked
+        uint64_t misses = 0;      // Placed on a fallback node
+        uint64_t interleaved = 0;
+        uint64_t failures = 0;
+    };
+
+    explicit NumaPageAllocator(const NumaTopology& topology)
+        : topology(topology), nodes(topology.nodeCount()) {}
+
+    NumaPageAllocator(const NumaPageAllocator&) = delete;
+    NumaPageAllocator& operator=(const NumaPageAllocator&) = delete;
+
+    // Hands node the memory [start, start + size). Call before allocating.
+    void addNode(size_t node, void* start, size_t size) {
+        if (node >= nodes.size()) return;
+        nodes[node].start = reinterpret_cast<uintptr_t>(start);
+        nodes[node].end = nodes[node].start + size;
+        nodes[node].pages = std::make_unique<PageAllocator>();
+        nodes[node].pages->initialize(start, size);
+    }
+
+    // virt positions interleaved pages; 0 falls back to a rotating counter.
+    // alignment, as in PageAllocator::allocateAligned, is relative to the
+    // node's range (huge frames).
+    Allocation allocate(size_t size, const NumaPolicy& policy, size_t currentNode, uint64_t virt = 0,
+                        size_t alignment = PAGE_SIZE) {
+        size_t target = targetNode(policy, currentNode, virt);
+        if (policy.mode == NumaPolicy::Mode::Interleave) interleaved++;
+        for (uint8_t node : topology.fallbackOrder(target)) {
+            if (void* address = allocateOnNode(size, node, alignment)) {
+                (node == target ? hits : misses)++;
+                return {address, node};
+            }
+        }
+        failures++;
+        return {};
+    }
+
+    // No fallback: migration wants exactly this node
+    void* allocateOnNode(size_t size, size_t node, size_t alignment = PAGE_SIZE) {
+        if (node >= nodes.size() || !nodes[node].pages) return nullptr;
+        if (alignment > PAGE_SIZE) return nodes[node].pages->allocateAligned(size, alignment);
+        return nodes[node].pages->allocate(size);
+    }
+
+    void free(void* address, size_t size) {
+        size_t node = nodeOf(address);
+        if (node != NO_NODE) nodes[node].pages->free(address, size);
+    }
+
+    size_t nodeOf(const void* address) const {
+        uintptr_t value = reinterpret_cast<uintptr_t>(address);
+        for (size_t node = 0; node < nodes.size(); node++) {
+            if (value >= nodes[node].start && value < nodes[node].end) return node;
+        }
+        return NO_NODE;
+    }
+
+    size_t getFreePageCount(size_t node) const {
+        return node < nodes.size() && nodes[node].pages ? nodes[node].pages->getFreePageCount() : 0;
+    }
+
+    const NumaTopology& getTopology() const { return topology; }
+
+    Stats getStats() const {
+        return {hits.load(), misses.load(), interleaved.load(), failures.load()};
+    }
+
+private:
+    struct Node {
+        uintptr_t start = 0;
+        uintptr_t end = 0;
+        std::unique_ptr<PageAllocator> pages;
+    };
+
+    size_t targetNode(const NumaPolicy& policy, size_t currentNode, uint64_t virt) {
+        size_t count = nodes.size();
+        switch (policy.mode) {
+        case NumaPolicy::Mode::Preferred:
+            if (policy.preferredNode < count) return policy.preferredNode;
+            break;
+        case NumaPolicy::Mode::Interleave: {
+            uint64_t mask = policy.nodeMask & (count >= 64 ? ~0ULL : (1ULL << count) - 1);
+            size_t eligible = __builtin_popcountll(mask);
+            if (eligible == 0) break;
+            size_t index = (virt ? virt / PAGE_SIZE : interleaveCursor++) % eligible;
+            while (index--) mask &= mask - 1; // Drop the lowest set bits
+            return __builtin_ctzll(mask);
+        }
+        case NumaPolicy::Mode::FirstTouch:
+            break;
+        }
+        return std::min(currentNode, count - 1);
+    }
+
+    const NumaTopology& topology;
+    std::vector<Node> nodes;
+    std::atomic<uint64_t> interleaveCursor{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> interleaved{0};
+    std::atomic<uint64_t> failures{0};
+};
+
+// Access-sampling page migration (AutoNUMA-style). The caller reports a
+// sample of page accesses, e.g. hinting faults from periodically
+// unmapped PTEs, together with the node of the accessing CPU. A page is
+// queued once MIGRATE_STREAK consecutive samples come from the same
+// remote node, which keeps pages shared across nodes from ping-ponging,
+// and migrate() moves a bounded batch of queued pages per pass.
+//
+// migrate() write-protects each page through the backend before copying
+// it, so a store during the copy faults and waits instead of landing in
+// the old frame; the new frame gets write access back once installed.
+class NumaBalancer {
+public:
+    static constexpr size_t PAGE_SIZE = NumaPageAllocator::PAGE_SIZE;
+    static constexpr uint8_t MIGRATE_STREAK = 2;
+
+    struct Backend {
+        std::function<void*(uint64_t virt)> frameOf; // 4 KB frame behind virt; nullptr if none
+        std::function<void(void* dst, const void* src)> copyPage;
+        std::function<void(uint64_t virt, void* frame)> remap; // Also flushes the TLB entry
+        // Sets write access on virt, flushing the TLB entry when it is
+        // taken away; returns whether the page was writable before
+        std::function<bool(uint64_t virt, bool writable)> setWritable;
+    };
+
+    struct Stats {
+        uint64_t samples = 0;
+        uint64_t remoteSamples = 0;
+        uint64_t migrations = 0;
+        uint64_t migrationFailures = 0; // Target node out of memory
+    };
+
+    NumaBalancer(NumaPageAllocator& allocator, Backend backend)
+        : allocator(allocator), backend(std::move(backend)) {}
+
+    // One sampled access to virt from a CPU on node
+    void recordAccess(uint64_t virt, size_t node) {
+        uint64_t page = virt & ~(PAGE_SIZE - 1);
+        void* frame = backend.frameOf(page);
+        if (!frame) return;
+        size_t current = allocator.nodeOf(frame);
+
+        std::lock_guard lock(mutex);
+        stats.samples++;
+        if (current == node || current == NumaPageAllocator::NO_NODE) {
+            samples.erase(page); // A local access breaks the streak
+            return;
+        }
+        stats.remoteSamples++;
+        Sample& sample = samples[page];
+        if (sample.streak > 0 && sample.node == node) {
+            sample.streak++;
+        } else {
+            sample.node = static_cast<uint8_t>(node);
+            sample.streak = 1;
+        }
+        if (sample.streak >= MIGRATE_STREAK && !sample.queued) {
+            sample.queued = true;
+            queue.push_back(page);
+        }
+    }
+
+    // Moves up to maxPages queued pages to the node that keeps touching
+    // them. Returns the number migrated.
+    size_t migrate(size_t maxPages) {
+        std::vector<std::pair<uint64_t, size_t>> batch;
+        {
+            std::lock_guard lock(mutex);
+            while (batch.size() < maxPages && !queue.empty()) {
+                uint64_t page = queue.front();
+                queue.pop_front();
+                // Entries reset by a local access since being queued are dropped
+                auto it = samples.find(page);
+                if (it == samples.end() || !it->second.queued) continue;
+                if (it->second.streak >= MIGRATE_STREAK) batch.push_back({page, it->second.node});
+                samples.erase(it);
+            }
+        }
+
+        size_t migrated = 0, failed = 0;
+        for (auto [page, target] : batch) {
+            void* frame = backend.frameOf(page);
+            if (!frame || allocator.nodeOf(frame) == target) continue;
+            void* destination = allocator.allocateOnNode(PAGE_SIZE, target);
+            if (!destination) {
+                failed++;
+                continue;
+            }
+            bool writable = backend.setWritable(page, false);
+            backend.copyPage(destination, frame);
+            backend.remap(page, destination);
+            if (writable) backend.setWritable(page, true);
+            allocator.free(frame, PAGE_SIZE); // Unreachable once remapped
+            migrated++;
+        }
+
+        std::lock_guard lock(mutex);
+        stats.migrations += migrated;
+        stats.migrationFailures += failed;
+        return migrated;
+    }
+
+    size_t getPendingCount() {
+        std::lock_guard lock(mutex);
+        return queue.size();
+    }
+
+    Stats getStats() {
+        std::lock_guard lock(mutex);
+        return stats;
+    }
+
+private:
+    struct Sample {
+        uint8_t node = 0; // Remote node of the current streak
+        uint8_t streak = 0;
+        bool queued = false;
+    };
+
+    NumaPageAllocator& allocator;
+    Backend backend;
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Sample> samples; // Remotely sampled pages
+    std::deque<uint64_t> queue;
+    Stats stats;
+};
+
+} // namespace Memory
+
+#endif
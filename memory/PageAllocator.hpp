@@ -1,133 +1,420 @@
 #ifndef PAGE_ALLOCATOR_HPP
 #define PAGE_ALLOCATOR_HPP
 
-#include 
-#include 
-#include 
-#include 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 namespace Memory {
 
+// One bit per page, set while the page is allocated or parked in a CPU
+// cache. Searches and counts work a word at a time (tzcnt/popcnt).
 struct PageBitmap {
-    uint8_t* buffer;
-    size_t size;
-    
-    PageBitmap() : buffer(nullptr), size(0) {}
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    std::vector<uint64_t> words;
+    size_t size = 0; // Pages covered
+
+    void resize(size_t pages) {
+        size = pages;
+        words.assign((pages + 63) / 64, 0);
+        // Bits past the last page read as allocated so searches never return them
+        if (pages % 64) words.back() = ~0ULL << (pages % 64);
+    }
+
+    bool test(size_t index) const {
+        return (words[index / 64] >> (index % 64)) & 1;
+    }
+
+    void setRange(size_t first, size_t count, bool value) {
+        while (count > 0) {
+            size_t bit = first % 64;
+            size_t span = std::min<size_t>(64 - bit, count);
+            uint64_t mask = (span == 64 ? ~0ULL : ((1ULL << span) - 1)) << bit;
+            if (value) {
+                words[first / 64] |= mask;
+            } else {
+                words[first / 64] &= ~mask;
+            }
+            first += span;
+            count -= span;
+        }
+    }
+
+    size_t countSet() const {
+        size_t set = 0;
+        for (uint64_t word : words) set += __builtin_popcountll(word);
+        return set - (words.size() * 64 - size); // Minus the padding bits
+    }
+
+    // First run of count clear bits starting at a multiple of align
+    size_t findClearRun(size_t count, size_t align) const {
+        size_t position = 0;
+        while (position + count <= size) {
+            size_t start = nextClear(position);
+            if (start == NOT_FOUND) return NOT_FOUND;
+            start = (start + align - 1) / align * align;
+            if (start + count > size) return NOT_FOUND;
+
+            size_t end = nextSet(start, start + count);
+            if (end == start + count) return start;
+            position = end + 1;
+        }
+        return NOT_FOUND;
+    }
+
+private:
+    size_t nextClear(size_t from) const {
+        size_t word = from / 64;
+        if (word >= words.size()) return NOT_FOUND;
+        uint64_t bits = ~words[word] & (~0ULL << (from % 64));
+        while (!bits) {
+            if (++word >= words.size()) return NOT_FOUND;
+            bits = ~words[word];
+        }
+        return word * 64 + __builtin_ctzll(bits);
+    }
+
+    // First set bit in [from, to), or to
+    size_t nextSet(size_t from, size_t to) const {
+        size_t word = from / 64;
+        uint64_t bits = words[word] & (~0ULL << (from % 64));
+        while (!bits) {
+            if (++word * 64 >= to) return to;
+            bits = words[word];
+        }
+        return std::min(to, word * 64 + __builtin_ctzll(bits));
+    }
 };
 
+// Binary buddy allocator with per-order free lists and per-CPU caches for
+// single pages. Free-list links live in side arrays indexed by page, so
+// the managed range itself is never touched. Requests above MAX_ORDER, or
+// ones the buddy lists cannot align, fall back to a bitmap search.
 class PageAllocator {
+public:
+    static const size_t PAGE_SIZE = 4096;
+    static constexpr unsigned MAX_ORDER = 10; // Largest buddy block: 4 MB
+    static constexpr size_t CPU_CACHES = 64;
+    static constexpr size_t CACHE_BATCH = 32;
+    static constexpr size_t CACHE_HIGH = 4 * CACHE_BATCH;
+
 private:
-    PageBitmap bitmap;
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint8_t NOT_FREE = 0xFF;
+
+    struct FreeArea {
+        uint32_t head = NONE;
+        size_t count = 0;
+    };
+
+    struct alignas(64) CpuCache {
+        std::mutex mutex;
+        std::vector<uint32_t> pages;
+    };
+
     void* memoryStart;
     size_t totalPages;
-    size_t freePages;
+    std::atomic<size_t> freePages;
     std::mutex allocationMutex;
-    std::vector freePageList;
-    
+    PageBitmap bitmap;
+    std::array<FreeArea, MAX_ORDER + 1> freeAreas;
+    std::vector<uint8_t> freeOrder; // Block order if the page heads a free block
+    std::vector<uint32_t> nextFree;
+    std::vector<uint32_t> prevFree;
+    std::array<CpuCache, CPU_CACHES> cpuCaches;
+
     size_t getPageIndex(void* address) {
         return ((uintptr_t)address - (uintptr_t)memoryStart) / PAGE_SIZE;
     }
-    
-    void setBit(size_t index, bool value) {
-        size_t byteIndex = index / 8;
-        size_t bitIndex = index % 8;
-        uint8_t bitMask = 1 << bitIndex;
-        
-        if (value) {
-            bitmap.buffer[byteIndex] |= bitMask;
+
+    void* pageAddress(size_t index) {
+        return (void*)((uintptr_t)memoryStart + index * PAGE_SIZE);
+    }
+
+    static unsigned orderFor(size_t pages) {
+        unsigned order = 0;
+        while ((size_t(1) << order) < pages) order++;
+        return order;
+    }
+
+    void pushBlock(uint32_t index, unsigned order) {
+        FreeArea& area = freeAreas[order];
+        nextFree[index] = area.head;
+        prevFree[index] = NONE;
+        if (area.head != NONE) prevFree[area.head] = index;
+        area.head = index;
+        area.count++;
+        freeOrder[index] = static_cast<uint8_t>(order);
+    }
+
+    void removeBlock(uint32_t index, unsigned order) {
+        FreeArea& area = freeAreas[order];
+        if (prevFree[index] != NONE) {
+            nextFree[prevFree[index]] = nextFree[index];
         } else {
-            bitmap.buffer[byteIndex] &= ~bitMask;
+            area.head = nextFree[index];
+        }
+        if (nextFree[index] != NONE) prevFree[nextFree[index]] = prevFree[index];
+        area.count--;
+        freeOrder[index] = NOT_FREE;
+    }
+
+    // Pops the smallest block of at least order, splitting it down
+    uint32_t takeBlock(unsigned order) {
+        unsigned current = order;
+        while (current <= MAX_ORDER && freeAreas[current].head == NONE) current++;
+        if (current > MAX_ORDER) return NONE;
+
+        uint32_t index = freeAreas[current].head;
+        removeBlock(index, current);
+        while (current > order) {
+            current--;
+            pushBlock(index + (uint32_t(1) << current), current);
+        }
+        return index;
+    }
+
+    // Returns a block to its list, coalescing with free buddies
+    void freeBlock(uint32_t index, unsigned order) {
+        while (order < MAX_ORDER) {
+            uint32_t buddy = index ^ (uint32_t(1) << order);
+            if (buddy + (size_t(1) << order) > totalPages || freeOrder[buddy] != order) break;
+            removeBlock(buddy, order);
+            index = std::min(index, buddy);
+            order++;
+        }
+        pushBlock(index, order);
+    }
+
+    // Splits [first, first + count) into maximal aligned blocks
+    void insertRange(size_t first, size_t count) {
+        while (count > 0) {
+            unsigned order = 0;
+            while (order < MAX_ORDER && first % (size_t(2) << order) == 0 &&
+                   (size_t(2) << order) <= count) {
+                order++;
+            }
+            freeBlock(static_cast<uint32_t>(first), order);
+            first += size_t(1) << order;
+            count -= size_t(1) << order;
+        }
+    }
+
+    // Removes an arbitrary free run from the buddy lists; the bitmap
+    // guarantees every page in it belongs to some free block
+    void carveRange(size_t first, size_t count) {
+        size_t position = first;
+        const size_t end = first + count;
+        while (position < end) {
+            unsigned order = 0;
+            size_t head = position;
+            for (; order <= MAX_ORDER; order++) {
+                head = position & ~((size_t(1) << order) - 1);
+                if (freeOrder[head] == order) break;
+            }
+            removeBlock(static_cast<uint32_t>(head), order);
+
+            size_t blockEnd = head + (size_t(1) << order);
+            if (head < position) insertRange(head, position - head);
+            if (blockEnd > end) insertRange(end, blockEnd - end);
+            position = std::min(blockEnd, end);
         }
     }
-    
-    bool getBit(size_t index) {
-        size_t byteIndex = index / 8;
-        size_t bitIndex = index % 8;
-        uint8_t bitMask = 1 << bitIndex;
-        return (bitmap.buffer[byteIndex] & bitMask) != 0;
+
+    // Caller holds allocationMutex
+    size_t allocateLocked(size_t pageCount, size_t alignPages) {
+        unsigned order = orderFor(std::max(pageCount, alignPages));
+        if (order <= MAX_ORDER) {
+            uint32_t index = takeBlock(order);
+            if (index != NONE) {
+                // Give back the tail a power-of-two block would waste
+                size_t blockPages = size_t(1) << order;
+                if (blockPages > pageCount) insertRange(index + pageCount, blockPages - pageCount);
+                bitmap.setRange(index, pageCount, true);
+                return index;
+            }
+        }
+
+        size_t start = bitmap.findClearRun(pageCount, alignPages);
+        if (start == PageBitmap::NOT_FOUND) return PageBitmap::NOT_FOUND;
+        carveRange(start, pageCount);
+        bitmap.setRange(start, pageCount, true);
+        return start;
+    }
+
+    static size_t currentCpu() {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        if (cpu >= 0) return static_cast<size_t>(cpu) % CPU_CACHES;
+#endif
+        return std::hash<std::thread::id>{}(std::this_thread::get_id()) % CPU_CACHES;
+    }
+
+    void* allocateCached() {
+        CpuCache& cache = cpuCaches[currentCpu()];
+        std::lock_guard cacheLock(cache.mutex);
+        if (cache.pages.empty()) {
+            std::lock_guard lock(allocationMutex);
+            for (size_t i = 0; i < CACHE_BATCH; i++) {
+                uint32_t index = takeBlock(0);
+                if (index == NONE) break;
+                bitmap.setRange(index, 1, true);
+                cache.pages.push_back(index);
+            }
+        }
+        if (cache.pages.empty()) return nullptr;
+
+        uint32_t index = cache.pages.back();
+        cache.pages.pop_back();
+        freePages--;
+        return pageAddress(index);
+    }
+
+    void freeCached(size_t index) {
+        CpuCache& cache = cpuCaches[currentCpu()];
+        std::lock_guard cacheLock(cache.mutex);
+        cache.pages.push_back(static_cast<uint32_t>(index));
+        freePages++;
+        if (cache.pages.size() > CACHE_HIGH) {
+            // Return the coldest pages so they can coalesce again
+            std::lock_guard lock(allocationMutex);
+            for (size_t i = 0; i < CACHE_BATCH; i++) {
+                bitmap.setRange(cache.pages[i], 1, false);
+                freeBlock(cache.pages[i], 0);
+            }
+            cache.pages.erase(cache.pages.begin(), cache.pages.begin() + CACHE_BATCH);
+        }
     }
 
 public:
-    static const size_t PAGE_SIZE = 4096;
-    
     PageAllocator() : memoryStart(nullptr), totalPages(0), freePages(0) {}
-    
+
+    PageAllocator(const PageAllocator&) = delete;
+    PageAllocator& operator=(const PageAllocator&) = delete;
+
     void initialize(void* start, size_t memorySize) {
+        for (auto& cache : cpuCaches) {
+            std::lock_guard cacheLock(cache.mutex);
+            cache.pages.clear();
+            cache.pages.reserve(CACHE_HIGH + 1);
+        }
+
         std::lock_guard lock(allocationMutex);
         memoryStart = start;
-        totalPages = memorySize / PAGE_SIZE;
+        totalPages = std::min<size_t>(memorySize / PAGE_SIZE, NONE);
         freePages = totalPages;
-        
-        // Initialize bitmap
-        bitmap.size = (totalPages + 7) / 8;
-        bitmap.buffer = new uint8_t[bitmap.size]();
+
+        bitmap.resize(totalPages);
+        freeOrder.assign(totalPages, NOT_FREE);
+        nextFree.assign(totalPages, NONE);
+        prevFree.assign(totalPages, NONE);
+        freeAreas = {};
+        insertRange(0, totalPages);
     }
-    
+
     void* allocate(size_t size, bool isKernel = false) {
-        std::lock_guard lock(allocationMutex);
+        (void)isKernel;
+        return allocateAligned(size, PAGE_SIZE);
+    }
+
+    // alignment is relative to the managed range and a multiple of PAGE_SIZE
+    void* allocateAligned(size_t size, size_t alignment) {
         size_t pageCount = (size + PAGE_SIZE - 1) / PAGE_SIZE;
-        
-        // Find continuous free pages
-        size_t consecutivePages = 0;
-        size_t startPage = 0;
-        
-        for (size_t i = 0; i < totalPages; i++) {
-            if (!getBit(i)) {
-                if (consecutivePages == 0) startPage = i;
-                consecutivePages++;
-                
-                if (consecutivePages == pageCount) {
-                    // Mark pages as used
-                    for (size_t j = 0; j < pageCount; j++) {
-                        setBit(startPage + j, true);
-                    }
+        size_t alignPages = std::max<size_t>(alignment / PAGE_SIZE, 1);
+        if (pageCount == 0 || pageCount > totalPages) return nullptr;
+        if (pageCount == 1 && alignPages == 1) {
+            if (void* page = allocateCached()) return page;
+        }
+
+        for (int attempt = 0; attempt < 2; attempt++) {
+            {
+                std::lock_guard lock(allocationMutex);
+                size_t index = allocateLocked(pageCount, alignPages);
+                if (index != PageBitmap::NOT_FOUND) {
                     freePages -= pageCount;
-                    
-                    return (void*)((uintptr_t)memoryStart + startPage * PAGE_SIZE);
+                    return pageAddress(index);
                 }
-            } else {
-                consecutivePages = 0;
             }
+            // Pages parked in CPU caches may be what blocks a contiguous run
+            drainCpuCaches();
         }
-        
         return nullptr; // No sufficient continuous pages found
     }
-    
+
     void free(void* address, size_t size) {
-        std::lock_guard lock(allocationMutex);
         size_t pageCount = (size + PAGE_SIZE - 1) / PAGE_SIZE;
         size_t startPage = getPageIndex(address);
-        
-        for (size_t i = 0; i < pageCount; i++) {
-            setBit(startPage + i, false);
+        if (pageCount == 0 || startPage + pageCount > totalPages) return;
+
+        if (pageCount == 1) {
+            freeCached(startPage);
+            return;
         }
+
+        std::lock_guard lock(allocationMutex);
+        bitmap.setRange(startPage, pageCount, false);
+        insertRange(startPage, pageCount);
         freePages += pageCount;
     }
-    
+
+    // Returns every cached page to the buddy lists
+    void drainCpuCaches() {
+        for (auto& cache : cpuCaches) {
+            std::lock_guard cacheLock(cache.mutex);
+            if (cache.pages.empty()) continue;
+            std::lock_guard lock(allocationMutex);
+            for (uint32_t index : cache.pages) {
+                bitmap.setRange(index, 1, false);
+                freeBlock(index, 0);
+            }
+            cache.pages.clear();
+        }
+    }
+
     size_t getFreePageCount() const { return freePages; }
     size_t getTotalPageCount() const { return totalPages; }
-    
-    float getFragmentationRatio() {
-        size_t fragments = 0;
-        bool inFragment = false;
-        
-        for (size_t i = 0; i < totalPages; i++) {
-            if (!getBit(i) && !inFragment) {
-                fragments++;
-                inFragment = true;
-            } else if (getBit(i)) {
-                inFragment = false;
-            }
+
+    size_t getFreeBlockCount(unsigned order) {
+        std::lock_guard lock(allocationMutex);
+        return order <= MAX_ORDER ? freeAreas[order].count : 0;
+    }
+
+    // Unusable free space index: the fraction of free memory that cannot
+    // satisfy an allocation of the given order. 0 means no fragmentation.
+    float getFragmentationIndex(unsigned order) {
+        std::lock_guard lock(allocationMutex);
+        size_t free = freePages;
+        if (free == 0) return 0.0f;
+
+        size_t usable = 0;
+        for (unsigned i = std::min(order, MAX_ORDER); i <= MAX_ORDER; i++) {
+            usable += freeAreas[i].count << i;
         }
-        
-        return static_cast<float w-tid="18">(fragments) / static_cast<float w-tid="19">(freePages);
+        if (order == 0) return 0.0f; // Any free page serves order 0
+        return static_cast<float>(free - std::min(usable, free)) / static_cast<float>(free);
+    }
+
+    float getFragmentationRatio() {
+        return getFragmentationIndex(MAX_ORDER);
     }
-    
-    ~PageAllocator() {
-        delete[] bitmap.buffer;
+
+    // Pages currently marked in the bitmap (allocated or cached)
+    size_t getMarkedPageCount() {
+        std::lock_guard lock(allocationMutex);
+        return bitmap.countSet();
     }
 };
 
 } // namespace Memory
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,371 @@
+#ifndef PAGE_TABLE_HPP
+#define PAGE_TABLE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+
+namespace Memory {
+
+struct PageTableEntry {
+    uint64_t present : 1;
+    uint64_t writable : 1;
+    uint64_t userAccess : 1;
+    uint64_t writeThrough : 1;
+    uint64_t cacheDisable : 1;
+    uint64_t accessed : 1;
+    uint64_t dirty : 1;
+    uint64_t pageSize : 1;
+    uint64_t global : 1;
+    uint64_t available : 3;
+    uint64_t address : 40;
+    uint64_t reserved : 11;
+    uint64_t noExecute : 1;
+};
+
+static_assert(sizeof(PageTableEntry) == 8, "PageTableEntry must match the hardware layout");
+
+// x86-64 4-level radix page table (PML4 -> PDPT -> PD -> PT). Ranges are
+// mapped with the largest leaf that fits: 1 GB at the PDPT level, 2 MB at
+// the PD level, 4 KB otherwise. Lookups cost one entry per level, and
+// mapping a 2 MB-aligned pool writes one entry per 2 MB instead of 512.
+//
+// Entries hold frame numbers. Table pages are addressed through the
+// kernel's identity-mapped window, so a table entry's frame << 12 is the
+// address of the next-level table.
+//
+// Not thread-safe; the owning address space serializes changes.
+class PageTable {
+public:
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t ENTRIES = 512;
+    static constexpr uint64_t PAGE_SIZE = 4096;
+    static constexpr uint64_t LARGE_PAGE_SIZE = 2ULL * 1024 * 1024;
+    static constexpr uint64_t HUGE_PAGE_SIZE = 1ULL * 1024 * 1024 * 1024;
+
+    struct Protection {
+        bool writable = true;
+        bool user = false;
+        bool global = false;
+        bool noExecute = true;
+    };
+
+    struct Translation {
+        uint64_t physicalAddr;
+        uint64_t pageSize; // Size of the leaf that maps the address
+        Protection protection;
+    };
+
+    struct Stats {
+        size_t tables = 0;        // Table pages currently allocated
+        uint64_t entryWrites = 0; // Leaf entries set or cleared
+        uint64_t splits = 0;      // Large leaves broken up by partial changes
+    };
+
+    PageTable() : root(newTable()) {}
+
+    ~PageTable() { freeTable(root, LEVELS - 1); }
+
+    PageTable(const PageTable&) = delete;
+    PageTable& operator=(const PageTable&) = delete;
+
+    // Maps [virt, virt + length) to [phys, phys + length). Fails without
+    // changing anything if an address is not 4 KB aligned or part of the
+    // range is already mapped.
+    bool mapRange(uint64_t virt, uint64_t phys, uint64_t length) {
+        return mapRange(virt, phys, length, Protection());
+    }
+
+    bool mapRange(uint64_t virt, uint64_t phys, uint64_t length, const Protection& protection) {
+        if (length == 0 || (virt | phys | length) % PAGE_SIZE != 0) return false;
+        uint64_t last = virt + length - 1;
+        if (last < virt) return false;
+
+        bool mapped = false;
+        walkLeaves(root, LEVELS - 1, virt, last, [&](uint64_t, uint64_t, uint64_t, const PageTableEntry&) {
+            mapped = true;
+            return false;
+        });
+        if (mapped) return false;
+
+        mapIn(root, LEVELS - 1, virt, last, phys - virt, protection);
+        return true;
+    }
+
+    // Unmaps every page the range touches; large leaves that straddle an
+    // edge are split first. Empty tables are freed. Returns bytes unmapped.
+    uint64_t unmapRange(uint64_t virt, uint64_t length) {
+        if (length == 0) return 0;
+        uint64_t last = virt + length - 1;
+        if (last < virt) last = UINT64_MAX;
+        virt &= ~(PAGE_SIZE - 1);
+        last |= PAGE_SIZE - 1; // Splits never go below a whole page
+        return unmapIn(root, LEVELS - 1, virt, last);
+    }
+
+    // Sets or clears write access on every mapped page the range touches,
+    // splitting large leaves that straddle an edge. Returns bytes changed;
+    // the caller flushes the TLB when access is taken away.
+    uint64_t setWritable(uint64_t virt, uint64_t length, bool writable) {
+        if (length == 0) return 0;
+        uint64_t last = virt + length - 1;
+        if (last < virt) last = UINT64_MAX;
+        virt &= ~(PAGE_SIZE - 1);
+        last |= PAGE_SIZE - 1;
+        return setWritableIn(root, LEVELS - 1, virt, last, writable);
+    }
+
+    std::optional<Translation> translate(uint64_t virt) const {
+        const Table* table = root;
+        for (size_t level = LEVELS - 1;; level--) {
+            const PageTableEntry& entry = table->entries[indexOf(virt, level)];
+            if (!entry.present) return std::nullopt;
+            if (isLeaf(entry, level)) {
+                uint64_t span = spanOf(level);
+                return Translation{frameAddress(entry) + (virt & (span - 1)), span, protectionOf(entry)};
+            }
+            table = childOf(entry);
+        }
+    }
+
+    // Calls visit(virt, phys, length, protection) for each maximal run of
+    // mappings in [virt, virt + length) that is contiguous in both address
+    // spaces and shares one protection, in address order
+    template<typename Visit>
+    void forEachRange(uint64_t virt, uint64_t length, Visit&& visit) const {
+        if (length == 0) return;
+        uint64_t last = virt + length - 1;
+        if (last < virt) last = UINT64_MAX;
+
+        bool pending = false;
+        uint64_t runVirt = 0, runPhys = 0, runLength = 0;
+        Protection runProtection;
+        walkLeaves(root, LEVELS - 1, virt, last,
+                   [&](uint64_t leafVirt, uint64_t leafPhys, uint64_t leafLength, const PageTableEntry& entry) {
+            Protection protection = protectionOf(entry);
+            if (pending && runVirt + runLength == leafVirt && runPhys + runLength == leafPhys &&
+                sameProtection(runProtection, protection)) {
+                runLength += leafLength;
+                return true;
+            }
+            if (pending) visit(runVirt, runPhys, runLength, runProtection);
+            pending = true;
+            runVirt = leafVirt;
+            runPhys = leafPhys;
+            runLength = leafLength;
+            runProtection = protection;
+            return true;
+        });
+        if (pending) visit(runVirt, runPhys, runLength, runProtection);
+    }
+
+    // Physical address of the PML4, for CR3
+    uint64_t rootAddress() const { return reinterpret_cast<uintptr_t>(root); }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct alignas(PAGE_SIZE) Table {
+        PageTableEntry entries[ENTRIES];
+    };
+
+    static constexpr size_t shiftOf(size_t level) { return 12 + 9 * level; }
+    static constexpr uint64_t spanOf(size_t level) { return uint64_t(1) << shiftOf(level); }
+
+    static size_t indexOf(uint64_t virt, size_t level) {
+        return (virt >> shiftOf(level)) & (ENTRIES - 1);
+    }
+
+    // PT entries are always leaves; PD and PDPT entries are when PS is set
+    static bool isLeaf(const PageTableEntry& entry, size_t level) {
+        return level == 0 || entry.pageSize;
+    }
+
+    static uint64_t frameAddress(const PageTableEntry& entry) {
+        return static_cast<uint64_t>(entry.address) << 12;
+    }
+
+    static Table* childOf(const PageTableEntry& entry) {
+        return reinterpret_cast<Table*>(frameAddress(entry));
+    }
+
+    static Protection protectionOf(const PageTableEntry& entry) {
+        return {bool(entry.writable), bool(entry.userAccess), bool(entry.global), bool(entry.noExecute)};
+    }
+
+    static bool sameProtection(const Protection& a, const Protection& b) {
+        return a.writable == b.writable && a.user == b.user &&
+               a.global == b.global && a.noExecute == b.noExecute;
+    }
+
+    void setLeaf(PageTableEntry& entry, size_t level, uint64_t phys, const Protection& protection) {
+        entry = {};
+        entry.present = 1;
+        entry.writable = protection.writable;
+        entry.userAccess = protection.user;
+        entry.global = protection.global;
+        entry.noExecute = protection.noExecute;
+        entry.pageSize = level > 0;
+        entry.address = phys >> 12;
+        stats.entryWrites++;
+    }
+
+    // Intermediate entries grant everything; the leaf decides
+    static void setTable(PageTableEntry& entry, Table* table) {
+        entry = {};
+        entry.present = 1;
+        entry.writable = 1;
+        entry.userAccess = 1;
+        entry.address = reinterpret_cast<uintptr_t>(table) >> 12;
+    }
+
+    Table* newTable() {
+        stats.tables++;
+        return new Table{};
+    }
+
+    void freeTable(Table* table, size_t level) {
+        if (level > 0) {
+            for (const PageTableEntry& entry : table->entries) {
+                if (entry.present && !isLeaf(entry, level)) freeTable(childOf(entry), level - 1);
+            }
+        }
+        delete table;
+        stats.tables--;
+    }
+
+    static bool isEmpty(const Table* table) {
+        return std::none_of(std::begin(table->entries), std::end(table->entries),
+                            [](const PageTableEntry& entry) { return entry.present; });
+    }
+
+    // offset is phys - virt for the whole range
+    void mapIn(Table* table, size_t level, uint64_t virt, uint64_t last, uint64_t offset,
+               const Protection& protection) {
+        uint64_t span = spanOf(level);
+        for (;;) {
+            uint64_t entryStart = virt & ~(span - 1);
+            uint64_t entryLast = entryStart + (span - 1);
+            uint64_t chunkLast = std::min(last, entryLast);
+            PageTableEntry& entry = table->entries[indexOf(virt, level)];
+
+            // A whole, physically aligned entry becomes a leaf at this level
+            bool whole = virt == entryStart && chunkLast == entryLast;
+            if (level == 0 || (level <= 2 && whole && (virt + offset) % span == 0)) {
+                setLeaf(entry, level, virt + offset, protection);
+            } else {
+                if (!entry.present) setTable(entry, newTable());
+                mapIn(childOf(entry), level - 1, virt, chunkLast, offset, protection);
+            }
+
+            if (chunkLast == last) return;
+            virt = chunkLast + 1;
+        }
+    }
+
+    uint64_t unmapIn(Table* table, size_t level, uint64_t virt, uint64_t last) {
+        uint64_t span = spanOf(level);
+        uint64_t unmapped = 0;
+        for (;;) {
+            uint64_t entryStart = virt & ~(span - 1);
+            uint64_t entryLast = entryStart + (span - 1);
+            uint64_t chunkLast = std::min(last, entryLast);
+            PageTableEntry& entry = table->entries[indexOf(virt, level)];
+
+            if (entry.present) {
+                bool whole = virt == entryStart && chunkLast == entryLast;
+                if (isLeaf(entry, level) && whole) {
+                    entry = {};
+                    stats.entryWrites++;
+                    unmapped += span;
+                } else {
+                    if (isLeaf(entry, level)) split(entry, level);
+                    Table* child = childOf(entry);
+                    unmapped += unmapIn(child, level - 1, virt, chunkLast);
+                    if (isEmpty(child)) {
+                        freeTable(child, level - 1);
+                        entry = {};
+                    }
+                }
+            }
+
+            if (chunkLast == last) return unmapped;
+            virt = chunkLast + 1;
+        }
+    }
+
+    uint64_t setWritableIn(Table* table, size_t level, uint64_t virt, uint64_t last, bool writable) {
+        uint64_t span = spanOf(level);
+        uint64_t changed = 0;
+        for (;;) {
+            uint64_t entryStart = virt & ~(span - 1);
+            uint64_t entryLast = entryStart + (span - 1);
+            uint64_t chunkLast = std::min(last, entryLast);
+            PageTableEntry& entry = table->entries[indexOf(virt, level)];
+
+            if (entry.present) {
+                bool whole = virt == entryStart && chunkLast == entryLast;
+                if (isLeaf(entry, level) && (whole || bool(entry.writable) == writable)) {
+                    if (bool(entry.writable) != writable) {
+                        entry.writable = writable;
+                        stats.entryWrites++;
+                    }
+                    changed += chunkLast - virt + 1;
+                } else {
+                    if (isLeaf(entry, level)) split(entry, level);
+                    changed += setWritableIn(childOf(entry), level - 1, virt, chunkLast, writable);
+                }
+            }
+
+            if (chunkLast == last) return changed;
+            virt = chunkLast + 1;
+        }
+    }
+
+    // Replaces a large leaf with a table of next-size leaves mapping the same memory
+    void split(PageTableEntry& entry, size_t level) {
+        uint64_t phys = frameAddress(entry);
+        Protection protection = protectionOf(entry);
+        Table* child = newTable();
+        uint64_t childSpan = spanOf(level - 1);
+        for (size_t i = 0; i < ENTRIES; i++) {
+            setLeaf(child->entries[i], level - 1, phys + i * childSpan, protection);
+        }
+        setTable(entry, child);
+        stats.splits++;
+    }
+
+    // Calls visit(virt, phys, length, entry) for each present leaf,
+    // clipped to [virt, last); stops early when visit returns false
+    template<typename Visit>
+    static bool walkLeaves(const Table* table, size_t level, uint64_t virt, uint64_t last, Visit&& visit) {
+        uint64_t span = spanOf(level);
+        for (;;) {
+            uint64_t entryStart = virt & ~(span - 1);
+            uint64_t entryLast = entryStart + (span - 1);
+            uint64_t chunkLast = std::min(last, entryLast);
+            const PageTableEntry& entry = table->entries[indexOf(virt, level)];
+
+            if (entry.present) {
+                if (isLeaf(entry, level)) {
+                    uint64_t phys = frameAddress(entry) + (virt - entryStart);
+                    if (!visit(virt, phys, chunkLast - virt + 1, entry)) return false;
+                } else if (!walkLeaves(childOf(entry), level - 1, virt, chunkLast, visit)) {
+                    return false;
+                }
+            }
+
+            if (chunkLast == last) return true;
+            virt = chunkLast + 1;
+        }
+    }
+
+    Stats stats;
+    Table* root;
+};
+
+} // namespace Memory
+
+#endif
@@ -0,0 +1,393 @@
+#ifndef SLAB_ALLOCATOR_HPP
+#define SLAB_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace Memory {
+
+// Size-class slab allocator for small objects (16 B - 32 KB).
+//
+// Every thread allocates from its own heap: a magazine of ready objects
+// per size class in front of slabs the heap owns. Slabs are SLAB_SIZE
+// aligned, so the slab header (size class, owning heap, free lists) is
+// found by masking the pointer; there is no per-allocation map. A free
+// from a thread that does not own the slab is pushed onto the owner's
+// lock-free remote queue and reclaimed when the owner next refills.
+// Only slab-level events (new slab, empty slab, thread start/exit) take
+// the allocator-wide lock.
+class SlabAllocator {
+public:
+    static constexpr size_t MIN_SIZE = 16;
+    static constexpr size_t MAX_SMALL_SIZE = 32 * 1024;
+    static constexpr size_t SIZE_CLASSES = 40;
+    static constexpr size_t SLAB_SIZE = 256 * 1024;
+    static constexpr size_t MAX_MAGAZINE = 128;
+    static constexpr size_t DEFAULT_ARENA_SIZE = 1ULL << 30;
+
+    explicit SlabAllocator(size_t arenaSize = DEFAULT_ARENA_SIZE)
+        : state(std::make_shared<State>(arenaSize)) {}
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    // nullptr for size 0, sizes above MAX_SMALL_SIZE, or an exhausted arena
+    void* allocate(size_t size) {
+        if (size == 0 || size > MAX_SMALL_SIZE) return nullptr;
+        ThreadHeap* heap = localHeap();
+        size_t sizeClass = classIndex(size);
+        Magazine& magazine = heap->magazines[sizeClass];
+        if (magazine.count == 0 && !refill(*heap, sizeClass)) return nullptr;
+        return magazine.objects[--magazine.count];
+    }
+
+    // ptr must come from allocate() on this allocator
+    void free(void* ptr) {
+        if (!ptr) return;
+        Slab* slab = slabOf(ptr);
+        ThreadHeap* heap = localHeap();
+        if (slab->owner != heap) {
+            slab->owner->pushRemote(static_cast<FreeObject*>(ptr));
+            return;
+        }
+
+        Magazine& magazine = heap->magazines[slab->sizeClass];
+        if (magazine.count == magazine.capacity) {
+            flush(*heap, slab->sizeClass, magazine.capacity / 2);
+        }
+        magazine.objects[magazine.count++] = ptr;
+    }
+
+    bool owns(const void* ptr) const {
+        auto address = reinterpret_cast<uintptr_t>(ptr);
+        return address >= state->arenaBase && address < state->arenaBase + state->arenaSize;
+    }
+
+    // Usable size of the object's class
+    size_t sizeOf(const void* ptr) const { return slabOf(ptr)->objectSize; }
+
+    size_t getSlabCount() const {
+        std::lock_guard lock(state->mutex);
+        return state->slabsInUse;
+    }
+
+    static size_t classIndex(size_t size) {
+        if (size <= 128) return (std::max(size, MIN_SIZE) + 15) / 16 - 1;
+        // Four classes per power of two above 128 bytes
+        unsigned log = 63 - __builtin_clzll(size - 1);
+        size_t step = ((size - 1) >> (log - 2)) & 3;
+        return 8 + (log - 7) * 4 + step;
+    }
+
+    static size_t classSize(size_t index) {
+        if (index < 8) return (index + 1) * 16;
+        size_t log = 7 + (index - 8) / 4;
+        size_t step = (index - 8) % 4;
+        return (size_t(1) << log) + (step + 1) * (size_t(1) << (log - 2));
+    }
+
+private:
+    struct FreeObject {
+        FreeObject* next;
+    };
+
+    struct ThreadHeap;
+
+    // Lives in the first bytes of every slab
+    struct alignas(64) Slab {
+        ThreadHeap* owner;
+        uint32_t sizeClass;
+        uint32_t objectSize;
+        uint32_t used; // Objects outside the slab's own free lists
+        char* bump;    // Never-used tail, carved lazily
+        char* end;
+        FreeObject* freeList;
+        Slab* prev;
+        Slab* next;
+        bool partial; // Linked in the owner's partial list
+    };
+
+    struct Magazine {
+        void* objects[MAX_MAGAZINE];
+        uint32_t count = 0;
+        uint32_t capacity = 0;
+    };
+
+    struct SlabList {
+        Slab* head = nullptr;
+    };
+
+    struct ThreadHeap {
+        std::array<Magazine, SIZE_CLASSES> magazines;
+        std::array<Slab*, SIZE_CLASSES> current{};
+        std::array<SlabList, SIZE_CLASSES> partial;
+        alignas(64) std::atomic<FreeObject*> remoteFrees{nullptr};
+
+        ThreadHeap() {
+            for (size_t i = 0; i < SIZE_CLASSES; i++) {
+                magazines[i].capacity = static_cast<uint32_t>(
+                    std::clamp<size_t>(64 * 1024 / classSize(i), 4, MAX_MAGAZINE));
+            }
+        }
+
+        // Multi-producer push; the owner takes the whole list at once, so no ABA
+        void pushRemote(FreeObject* object) {
+            FreeObject* head = remoteFrees.load(std::memory_order_relaxed);
+            do {
+                object->next = head;
+            } while (!remoteFrees.compare_exchange_weak(head, object, std::memory_order_release,
+                                                        std::memory_order_relaxed));
+        }
+    };
+
+    // Shared by the allocator and every thread that used it, so threads
+    // exiting after the allocator is destroyed do not touch freed memory
+    struct State {
+        uintptr_t arenaBase = 0;
+        size_t arenaSize = 0;
+        void* mapping = nullptr;
+        size_t mappingSize = 0;
+
+        mutable std::mutex mutex;
+        size_t arenaUsed = 0;
+        size_t slabsInUse = 0;
+        std::vector<char*> freeSlabs;
+        std::vector<std::unique_ptr<ThreadHeap>> heaps;
+        std::vector<ThreadHeap*> abandonedHeaps;
+
+        explicit State(size_t size) {
+            arenaSize = size / SLAB_SIZE * SLAB_SIZE;
+            mappingSize = arenaSize + SLAB_SIZE;
+#ifdef __linux__
+            void* region = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            mapping = region == MAP_FAILED ? nullptr : region;
+#else
+            mapping = ::operator new(mappingSize, std::nothrow);
+#endif
+            if (!mapping) {
+                arenaSize = 0;
+                return;
+            }
+            arenaBase = (reinterpret_cast<uintptr_t>(mapping) + SLAB_SIZE - 1) & ~(SLAB_SIZE - 1);
+        }
+
+        ~State() {
+            if (!mapping) return;
+#ifdef __linux__
+            munmap(mapping, mappingSize);
+#else
+            ::operator delete(mapping);
+#endif
+        }
+    };
+
+    // Per-thread binding of this allocator to a heap
+    struct HeapBinding {
+        std::weak_ptr<State> state;
+        ThreadHeap* heap;
+        SlabAllocator* allocator;
+    };
+
+    struct ThreadBindings {
+        std::vector<HeapBinding> bindings;
+
+        ~ThreadBindings() {
+            for (auto& binding : bindings) {
+                if (auto state = binding.state.lock()) {
+                    abandon(*state, *binding.heap);
+                }
+            }
+        }
+    };
+
+    std::shared_ptr<State> state;
+
+    static Slab* slabOf(const void* ptr) {
+        return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(ptr) & ~(SLAB_SIZE - 1));
+    }
+
+    ThreadHeap* localHeap() {
+        thread_local ThreadBindings local;
+        for (auto& binding : local.bindings) {
+            if (binding.allocator == this && !binding.state.expired()) return binding.heap;
+        }
+
+        // First use on this thread: adopt an abandoned heap or create one
+        ThreadHeap* heap;
+        {
+            std::lock_guard lock(state->mutex);
+            if (!state->abandonedHeaps.empty()) {
+                heap = state->abandonedHeaps.back();
+                state->abandonedHeaps.pop_back();
+            } else {
+                state->heaps.push_back(std::make_unique<ThreadHeap>());
+                heap = state->heaps.back().get();
+            }
+        }
+        local.bindings.erase(std::remove_if(local.bindings.begin(), local.bindings.end(),
+            [](const HeapBinding& binding) { return binding.state.expired(); }),
+            local.bindings.end());
+        local.bindings.push_back({state, heap, this});
+        return heap;
+    }
+
+    // Thread exit: return cached objects so empty slabs go back to the
+    // arena; the heap and its slabs wait for the next thread to adopt them
+    static void abandon(State& state, ThreadHeap& heap) {
+        collectRemote(state, heap);
+        for (size_t i = 0; i < SIZE_CLASSES; i++) {
+            flush(state, heap, i, heap.magazines[i].count);
+        }
+        std::lock_guard lock(state.mutex);
+        state.abandonedHeaps.push_back(&heap);
+    }
+
+    bool refill(ThreadHeap& heap, size_t sizeClass) {
+        Magazine& magazine = heap.magazines[sizeClass];
+        const uint32_t target = std::max<uint32_t>(magazine.capacity / 2, 1);
+
+        while (magazine.count < target) {
+            Slab* slab = heap.current[sizeClass];
+            if (!slab || !takeObjects(*slab, magazine, target)) {
+                slab = nextSlab(heap, sizeClass);
+                if (!slab) break;
+                heap.current[sizeClass] = slab;
+            }
+        }
+        return magazine.count > 0;
+    }
+
+    // Moves objects from the slab into the magazine; false if the slab is exhausted
+    static bool takeObjects(Slab& slab, Magazine& magazine, uint32_t target) {
+        uint32_t before = magazine.count;
+        while (magazine.count < target && slab.freeList) {
+            magazine.objects[magazine.count++] = slab.freeList;
+            slab.freeList = slab.freeList->next;
+        }
+        while (magazine.count < target && slab.bump + slab.objectSize <= slab.end) {
+            magazine.objects[magazine.count++] = slab.bump;
+            slab.bump += slab.objectSize;
+        }
+        slab.used += magazine.count - before;
+        return magazine.count > before;
+    }
+
+    // Partial slab first; objects other threads handed back are reclaimed
+    // before the arena is asked for a fresh slab
+    Slab* nextSlab(ThreadHeap& heap, size_t sizeClass) {
+        SlabList& list = heap.partial[sizeClass];
+        if (!list.head && heap.remoteFrees.load(std::memory_order_relaxed)) {
+            collectRemote(*state, heap);
+        }
+        if (list.head) {
+            Slab* slab = list.head;
+            unlink(list, *slab);
+            return slab;
+        }
+        return createSlab(heap, sizeClass);
+    }
+
+    Slab* createSlab(ThreadHeap& heap, size_t sizeClass) {
+        char* memory = nullptr;
+        {
+            std::lock_guard lock(state->mutex);
+            if (!state->freeSlabs.empty()) {
+                memory = state->freeSlabs.back();
+                state->freeSlabs.pop_back();
+            } else if (state->arenaUsed + SLAB_SIZE <= state->arenaSize) {
+                memory = reinterpret_cast<char*>(state->arenaBase + state->arenaUsed);
+                state->arenaUsed += SLAB_SIZE;
+            } else {
+                return nullptr;
+            }
+            state->slabsInUse++;
+        }
+
+        Slab* slab = new (memory) Slab();
+        slab->owner = &heap;
+        slab->sizeClass = static_cast<uint32_t>(sizeClass);
+        slab->objectSize = static_cast<uint32_t>(classSize(sizeClass));
+        slab->used = 0;
+        slab->bump = memory + sizeof(Slab);
+        slab->end = memory + SLAB_SIZE;
+        slab->freeList = nullptr;
+        slab->prev = slab->next = nullptr;
+        slab->partial = false;
+        return slab;
+    }
+
+    void flush(ThreadHeap& heap, size_t sizeClass, uint32_t count) {
+        flush(*state, heap, sizeClass, count);
+    }
+
+    // Returns the oldest count magazine entries to their slabs
+    static void flush(State& state, ThreadHeap& heap, size_t sizeClass, uint32_t count) {
+        Magazine& magazine = heap.magazines[sizeClass];
+        count = std::min(count, magazine.count);
+        for (uint32_t i = 0; i < count; i++) {
+            release(state, heap, magazine.objects[i]);
+        }
+        std::move(magazine.objects + count, magazine.objects + magazine.count, magazine.objects);
+        magazine.count -= count;
+    }
+
+    static void collectRemote(State& state, ThreadHeap& heap) {
+        FreeObject* object = heap.remoteFrees.exchange(nullptr, std::memory_order_acquire);
+        while (object) {
+            FreeObject* next = object->next;
+            release(state, heap, object);
+            object = next;
+        }
+    }
+
+    // Puts one object back on its slab's free list; empty slabs other than
+    // the class's current one go back to the arena
+    static void release(State& state, ThreadHeap& heap, void* ptr) {
+        Slab* slab = slabOf(ptr);
+        auto* object = static_cast<FreeObject*>(ptr);
+        object->next = slab->freeList;
+        slab->freeList = object;
+        slab->used--;
+
+        SlabList& list = heap.partial[slab->sizeClass];
+        bool isCurrent = heap.current[slab->sizeClass] == slab;
+        if (slab->used == 0 && !isCurrent) {
+            if (slab->partial) unlink(list, *slab);
+            std::lock_guard lock(state.mutex);
+            state.freeSlabs.push_back(reinterpret_cast<char*>(slab));
+            state.slabsInUse--;
+        } else if (!slab->partial && !isCurrent) {
+            link(list, *slab);
+        }
+    }
+
+    static void link(SlabList& list, Slab& slab) {
+        slab.prev = nullptr;
+        slab.next = list.head;
+        if (list.head) list.head->prev = &slab;
+        list.head = &slab;
+        slab.partial = true;
+    }
+
+    static void unlink(SlabList& list, Slab& slab) {
+        if (slab.prev) slab.prev->next = slab.next; else list.head = slab.next;
+        if (slab.next) slab.next->prev = slab.prev;
+        slab.prev = slab.next = nullptr;
+        slab.partial = false;
+    }
+};
+
+} // namespace Memory
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef TLB_HPP
+#define TLB_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Memory {
+
+// Model of one CPU's TLB: set-associative, with entries tagged by a
+// hardware address-space tag (PCID). A CPU keeps a few tags live at once,
+// so switching between recently used address spaces does not flush them;
+// a tag is only flushed when it is recycled for another address space.
+// Global entries (kernel mappings) match every tag and survive switches.
+// 2 MB pages live in a separate small fully associative array, as in the
+// hardware L1 DTLB, so one entry covers 512 small pages.
+//
+// Not thread-safe: each CPU owns its model, and shootdowns are delivered
+// by the caller under its own lock.
+class SoftwareTLB {
+public:
+    static constexpr size_t PAGE_SHIFT = 12;
+    static constexpr size_t SETS = 64;
+    static constexpr size_t WAYS = 4;
+    static constexpr size_t LARGE_PAGE_SHIFT = 21;
+    static constexpr size_t LARGE_ENTRIES = 32;
+    // Live tags per CPU; more only lengthens the search on a switch
+    static constexpr size_t HW_TAGS = 6;
+    // Above this many pages one flush of the tag beats per-page invlpg
+    static constexpr size_t FULL_FLUSH_THRESHOLD = 33;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t pageInvalidations = 0;
+        uint64_t fullFlushes = 0;
+        uint64_t contextSwitches = 0;
+        uint64_t switchFlushes = 0; // Switches that had to drop a tag's entries
+        uint64_t shootdowns = 0;    // Remote invalidation requests received
+    };
+
+    explicit SoftwareTLB(bool pcidEnabled = true)
+        : tagCount(pcidEnabled ? HW_TAGS : 1) {}
+
+    // Makes addressSpace current. Without PCID, or when its tag was
+    // recycled, the CPU starts with none of its entries.
+    void switchTo(uint32_t addressSpace) {
+        stats.contextSwitches++;
+        size_t tag = tagOf(addressSpace);
+        if (tag != NO_TAG) {
+            currentTag = tag;
+            tags[tag].lastUse = ++clock;
+            return;
+        }
+
+        // Recycle a free tag, else the least recently used one
+        size_t victim = 0;
+        for (size_t i = 0; i < tagCount; i++) {
+            if (!tags[i].valid) {
+                victim = i;
+                break;
+            }
+            if (tags[i].lastUse < tags[victim].lastUse) victim = i;
+        }
+
+        // Also clears anything cached before the first switch
+        if (tags[victim].valid) stats.switchFlushes++;
+        dropTag(victim);
+        tags[victim] = {addressSpace, ++clock, true};
+        currentTag = victim;
+    }
+
+    // Translation for the current address space
+    bool lookup(uint64_t virtualAddr, uint64_t& physicalAddr) {
+        uint64_t page = virtualAddr >> PAGE_SHIFT;
+        for (Entry& entry : sets[page % SETS]) {
+            if (entry.valid && entry.page == page && (entry.global || entry.tag == currentTag)) {
+                entry.lastUse = ++clock;
+                physicalAddr = entry.frame << PAGE_SHIFT | (virtualAddr & PAGE_MASK);
+                stats.hits++;
+                return true;
+            }
+        }
+        uint64_t largePage = virtualAddr >> LARGE_PAGE_SHIFT;
+        for (Entry& entry : largeEntries) {
+            if (entry.valid && entry.page == largePage && (entry.global || entry.tag == currentTag)) {
+                entry.lastUse = ++clock;
+                physicalAddr = entry.frame << LARGE_PAGE_SHIFT | (virtualAddr & LARGE_PAGE_MASK);
+                stats.hits++;
+                return true;
+            }
+        }
+        stats.misses++;
+        return false;
+    }
+
+    // Caches a translation for the current address space, evicting the
+    // least recently used way of the set
+    void insert(uint64_t virtualAddr, uint64_t physicalAddr, bool global = false) {
+        uint64_t page = virtualAddr >> PAGE_SHIFT;
+        auto& set = sets[page % SETS];
+        Entry* slot = &set[0];
+        for (Entry& entry : set) {
+            if (entry.valid && entry.page == page && (entry.global || entry.tag == currentTag)) {
+                slot = &entry;
+                break;
+            }
+            if (!entry.valid || (slot->valid && entry.lastUse < slot->lastUse)) slot = &entry;
+        }
+        *slot = {page, physicalAddr >> PAGE_SHIFT, ++clock, static_cast<uint8_t>(currentTag), true, global};
+    }
+
+    // Caches a 2 MB translation; both addresses must be 2 MB aligned
+    void insertLarge(uint64_t virtualAddr, uint64_t physicalAddr, bool global = false) {
+        uint64_t page = virtualAddr >> LARGE_PAGE_SHIFT;
+        Entry* slot = &largeEntries[0];
+        for (Entry& entry : largeEntries) {
+            if (entry.valid && entry.page == page && (entry.global || entry.tag == currentTag)) {
+                slot = &entry;
+                break;
+            }
+            if (!entry.valid || (slot->valid && entry.lastUse < slot->lastUse)) slot = &entry;
+        }
+        *slot = {page, physicalAddr >> LARGE_PAGE_SHIFT, ++clock, static_cast<uint8_t>(currentTag), true, global};
+    }
+
+    // Drops pages of addressSpace starting at virtualAddr; large ranges
+    // flush the whole tag instead of walking page by page
+    void invalidateRange(uint32_t addressSpace, uint64_t virtualAddr, size_t pages) {
+        if (pages == 0) return;
+        if (pages > FULL_FLUSH_THRESHOLD) {
+            flushAddressSpace(addressSpace);
+            invalidateGlobalRange(virtualAddr, pages);
+            return;
+        }
+
+        size_t tag = tagOf(addressSpace);
+        uint64_t first = virtualAddr >> PAGE_SHIFT;
+        for (uint64_t page = first; page < first + pages; page++) {
+            stats.pageInvalidations++;
+            for (Entry& entry : sets[page % SETS]) {
+                if (entry.valid && entry.page == page && (entry.global || entry.tag == tag)) {
+                    entry.valid = false;
+                }
+            }
+        }
+        for (Entry& entry : largeEntries) {
+            if (entry.valid && (entry.global || entry.tag == tag) && overlapsLarge(entry, first, pages)) {
+                entry.valid = false;
+            }
+        }
+    }
+
+    void invalidatePage(uint32_t addressSpace, uint64_t virtualAddr) {
+        invalidateRange(addressSpace, virtualAddr, 1);
+    }
+
+    // Drops every non-global entry of addressSpace, keeping its tag
+    void flushAddressSpace(uint32_t addressSpace) {
+        size_t tag = tagOf(addressSpace);
+        if (tag == NO_TAG) return; // Nothing cached under it
+        stats.fullFlushes++;
+        dropTag(tag);
+    }
+
+    // A tag flush leaves global entries alone, like INVPCID single-context
+    void invalidateGlobalRange(uint64_t virtualAddr, size_t pages) {
+        uint64_t first = virtualAddr >> PAGE_SHIFT;
+        for (auto& set : sets) {
+            for (Entry& entry : set) {
+                if (entry.valid && entry.global && entry.page >= first && entry.page - first < pages) {
+                    entry.valid = false;
+                }
+            }
+        }
+        for (Entry& entry : largeEntries) {
+            if (entry.valid && entry.global && overlapsLarge(entry, first, pages)) entry.valid = false;
+        }
+    }
+
+    void flushAll() {
+        stats.fullFlushes++;
+        for (auto& set : sets) {
+            for (Entry& entry : set) entry.valid = false;
+        }
+        for (Entry& entry : largeEntries) entry.valid = false;
+    }
+
+    // True if entries of addressSpace may be cached on this CPU; remote
+    // CPUs that return false can skip a shootdown
+    bool mayCache(uint32_t addressSpace) const {
+        return tagOf(addressSpace) != NO_TAG;
+    }
+
+    void recordShootdown() { stats.shootdowns++; }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    static constexpr uint64_t PAGE_MASK = (uint64_t(1) << PAGE_SHIFT) - 1;
+    static constexpr uint64_t LARGE_PAGE_MASK = (uint64_t(1) << LARGE_PAGE_SHIFT) - 1;
+    static constexpr size_t PAGES_PER_LARGE = size_t(1) << (LARGE_PAGE_SHIFT - PAGE_SHIFT);
+    static constexpr size_t NO_TAG = SIZE_MAX;
+
+    struct Entry {
+        uint64_t page = 0;
+        uint64_t frame = 0;
+        uint64_t lastUse = 0;
+        uint8_t tag = 0;
+        bool valid = false;
+        bool global = false;
+    };
+
+    struct Tag {
+        uint32_t addressSpace = 0;
+        uint64_t lastUse = 0;
+        bool valid = false;
+    };
+
+    size_t tagOf(uint32_t addressSpace) const {
+        for (size_t i = 0; i < tagCount; i++) {
+            if (tags[i].valid && tags[i].addressSpace == addressSpace) return i;
+        }
+        return NO_TAG;
+    }
+
+    void dropTag(size_t tag) {
+        for (auto& set : sets) {
+            for (Entry& entry : set) {
+                if (entry.valid && !entry.global && entry.tag == tag) entry.valid = false;
+            }
+        }
+        for (Entry& entry : largeEntries) {
+            if (entry.valid && !entry.global && entry.tag == tag) entry.valid = false;
+        }
+    }
+
+    // Whether a 2 MB entry covers any of the small pages [first, first + pages)
+    static bool overlapsLarge(const Entry& entry, uint64_t first, size_t pages) {
+        uint64_t start = entry.page * PAGES_PER_LARGE;
+        return start < first + pages && first < start + PAGES_PER_LARGE;
+    }
+
+    std::array<std::array<Entry, WAYS>, SETS> sets{};
+    std::array<Entry, LARGE_ENTRIES> largeEntries{};
+    std::array<Tag, HW_TAGS> tags{};
+    size_t tagCount;
+    size_t currentTag = 0;
+    uint64_t clock = 0;
+    Stats stats;
+};
+
+// Collects the invalidations of one unmap or free and delivers them as a
+// single shootdown per CPU that may cache the address space, instead of
+// one interrupt per page per CPU.
+class TLBShootdownBatch {
+public:
+    TLBShootdownBatch(std::vector<SoftwareTLB*> cpus, uint32_t addressSpace)
+        : cpus(std::move(cpus)), addressSpace(addressSpace) {}
+
+    ~TLBShootdownBatch() { flush(); }
+
+    TLBShootdownBatch(const TLBShootdownBatch&) = delete;
+    TLBShootdownBatch& operator=(const TLBShootdownBatch&) = delete;
+
+    // Adjacent ranges merge, so freeing page by page still costs one range
+    void add(uint64_t virtualAddr, size_t pages) {
+        uint64_t first = virtualAddr >> SoftwareTLB::PAGE_SHIFT;
+        if (!ranges.empty() && ranges.back().first + ranges.back().pages == first) {
+            ranges.back().pages += pages;
+        } else {
+            ranges.push_back({first, pages});
+        }
+        totalPages += pages;
+    }
+
+    // Returns the number of CPUs interrupted
+    size_t flush() {
+        if (ranges.empty()) return 0;
+        size_t interrupted = 0;
+        for (SoftwareTLB* cpu : cpus) {
+            if (!cpu->mayCache(addressSpace)) continue;
+            cpu->recordShootdown();
+            interrupted++;
+            bool fullFlush = totalPages > SoftwareTLB::FULL_FLUSH_THRESHOLD;
+            if (fullFlush) cpu->flushAddressSpace(addressSpace);
+            for (const Range& range : ranges) {
+                uint64_t address = range.first << SoftwareTLB::PAGE_SHIFT;
+                if (fullFlush) {
+                    cpu->invalidateGlobalRange(address, range.pages);
+                } else {
+                    cpu->invalidateRange(addressSpace, address, range.pages);
+                }
+            }
+        }
+        ranges.clear();
+        totalPages = 0;
+        return interrupted;
+    }
+
+private:
+    struct Range {
+        uint64_t first;
+        size_t pages;
+    };
+
+    std::vector<SoftwareTLB*> cpus;
+    uint32_t addressSpace;
+    std::vector<Range> ranges;
+    size_t totalPages = 0;
+};
+
+} // namespace Memory
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef TRANSPARENT_HUGE_PAGES_HPP
+#define TRANSPARENT_HUGE_PAGES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <utility>
+#include <vector>
+#include "PageTable.hpp"
+
+namespace Memory {
+
+// Background promotion of 2 MB regions that are fully mapped with 4 KB
+// pages (khugepaged), and demotion when part of a huge page is unmapped.
+//
+// Mapping code reports new small mappings with noteMapped(); scan() then
+// visits a bounded number of those candidate regions per call. A region
+// whose pages are already physically contiguous and aligned is promoted
+// by rewriting its entries; otherwise its pages are copied into a fresh
+// 2 MB frame. Unmapping part of a huge page splits it back into 4 KB
+// entries through PageTable::unmapRange.
+//
+// Not thread-safe; call under the lock that guards the page table.
+class TransparentHugePages {
+public:
+    static constexpr uint64_t PAGE_SIZE = PageTable::PAGE_SIZE;
+    static constexpr uint64_t LARGE_PAGE_SIZE = PageTable::LARGE_PAGE_SIZE;
+
+    // Physical memory hooks; all addresses are physical except flushRange
+    struct Backend {
+        std::function<uint64_t(uint64_t region)> allocateLargeFrame; // 2 MB aligned, for virtual region; 0 when none is free
+        std::function<void(uint64_t phys, uint64_t length)> freeFrames;
+        std::function<void(uint64_t dst, uint64_t src, uint64_t length)> copy;
+        std::function<void(uint64_t virt, uint64_t length)> flushRange; // TLB, may be empty
+    };
+
+    struct Stats {
+        uint64_t promotions = 0;
+        uint64_t inPlacePromotions = 0; // Already contiguous: no copy needed
+        uint64_t demotions = 0;
+        uint64_t regionsScanned = 0;
+        uint64_t allocationFailures = 0;
+    };
+
+    TransparentHugePages(PageTable& pageTable, Backend backend)
+        : pageTable(pageTable), backend(std::move(backend)) {}
+
+    // Makes the 2 MB regions overlapping a new small mapping candidates
+    void noteMapped(uint64_t virt, uint64_t length) {
+        if (length == 0) return;
+        for (uint64_t region = regionOf(virt); region <= regionOf(virt + length - 1); region += LARGE_PAGE_SIZE) {
+            candidates.insert(region);
+        }
+    }
+
+    // Frees and unmaps [virt, virt + length); huge pages it only partly
+    // covers are demoted to 4 KB pages and become candidates again
+    void unmap(uint64_t virt, uint64_t length) {
+        if (length == 0) return;
+        uint64_t last = virt + length - 1;
+        for (uint64_t region = regionOf(virt); region <= regionOf(last); region += LARGE_PAGE_SIZE) {
+            bool partial = region < virt || region + LARGE_PAGE_SIZE - 1 > last;
+            auto translation = pageTable.translate(region);
+            if (partial && translation && translation->pageSize == LARGE_PAGE_SIZE) {
+                stats.demotions++;
+                candidates.insert(region);
+            }
+        }
+
+        std::vector<Run> runs;
+        pageTable.forEachRange(virt, length, [&](uint64_t runVirt, uint64_t phys, uint64_t runLength,
+                                                 const PageTable::Protection&) {
+            runs.push_back({runVirt, phys, runLength});
+        });
+        pageTable.unmapRange(virt, length);
+        if (backend.flushRange) backend.flushRange(virt, length);
+        for (const Run& run : runs) backend.freeFrames(run.phys, run.length);
+    }
+
+    // One background pass over at most maxRegions candidates, resuming
+    // after the last region visited. Returns the number promoted.
+    size_t scan(size_t maxRegions) {
+        std::vector<uint64_t> batch;
+        auto it = candidates.lower_bound(cursor);
+        while (batch.size() < maxRegions && batch.size() < candidates.size()) {
+            if (it == candidates.end()) it = candidates.begin();
+            batch.push_back(*it++);
+        }
+        cursor = it == candidates.end() ? 0 : *it;
+
+        size_t promoted = 0;
+        for (uint64_t region : batch) {
+            stats.regionsScanned++;
+            if (promote(region)) promoted++;
+        }
+        return promoted;
+    }
+
+    bool isPromoted(uint64_t virt) const {
+        auto translation = pageTable.translate(virt);
+        return translation && translation->pageSize >= LARGE_PAGE_SIZE;
+    }
+
+    size_t getCandidateCount() const { return candidates.size(); }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Run {
+        uint64_t virt;
+        uint64_t phys;
+        uint64_t length;
+    };
+
+    static uint64_t regionOf(uint64_t virt) { return virt & ~(LARGE_PAGE_SIZE - 1); }
+
+    bool promote(uint64_t region) {
+        if (isPromoted(region)) {
+            candidates.erase(region);
+            return false;
+        }
+
+        // Every page present with one protection, or the region waits
+        std::vector<Run> runs;
+        uint64_t mapped = 0;
+        bool uniform = true;
+        PageTable::Protection protection;
+        pageTable.forEachRange(region, LARGE_PAGE_SIZE, [&](uint64_t virt, uint64_t phys, uint64_t length,
+                                                            const PageTable::Protection& runProtection) {
+            if (runs.empty()) {
+                protection = runProtection;
+            } else if (runProtection.writable != protection.writable ||
+                       runProtection.user != protection.user ||
+                       runProtection.global != protection.global ||
+                       runProtection.noExecute != protection.noExecute) {
+                uniform = false;
+            }
+            runs.push_back({virt, phys, length});
+            mapped += length;
+        });
+        if (mapped != LARGE_PAGE_SIZE || !uniform) return false;
+
+        bool inPlace = runs.size() == 1 && runs[0].phys % LARGE_PAGE_SIZE == 0;
+        uint64_t frame = inPlace ? runs[0].phys : backend.allocateLargeFrame(region);
+        if (!inPlace && frame == 0) {
+            stats.allocationFailures++;
+            return false;
+        }
+        if (!inPlace) {
+            for (const Run& run : runs) backend.copy(frame + (run.virt - region), run.phys, run.length);
+        }
+
+        pageTable.unmapRange(region, LARGE_PAGE_SIZE);
+        pageTable.mapRange(region, frame, LARGE_PAGE_SIZE, protection);
+        if (backend.flushRange) backend.flushRange(region, LARGE_PAGE_SIZE);
+
+        // Old frames go back only once no translation can reach them
+        if (inPlace) {
+            stats.inPlacePromotions++;
+        } else {
+            for (const Run& run : runs) backend.freeFrames(run.phys, run.length);
+        }
+        candidates.erase(region);
+        stats.promotions++;
+        return true;
+    }
+
+    PageTable& pageTable;
+    Backend backend;
+    std::set<uint64_t> candidates; // 2 MB region bases
+    uint64_t cursor = 0;
+    Stats stats;
+};
+
+} // namespace Memory
+
+#endif
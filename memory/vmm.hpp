@@ -2,74 +2,101 @@
 #define VMM_HPP
 
 #include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 #include "../include/types.hpp"
+#include "CompressedPagePool.hpp"
+#include "NumaPolicy.hpp"
+#include "PageAllocator.hpp"
+#include "PageTable.hpp"
+#include "TLB.hpp"
+#include "TransparentHugePages.hpp"
 
 namespace Memory {
 
 class CompressionEngine {
 private:
     std::array<TLBEntry, 1024> tlb_entries;
-    std::vector<NumaNode> nodes;
-    std::vector<CompressedPage> compressed_pages;
+    CompressedPageCache pageCache;
 
 public:
-    void compressPage(void* page) {
-        // Advanced compression using LZ4
-        uint8_t* data = static_cast<uint8_t*>(page);
-        auto compressed = lz4_compress(data);
-        compressed_pages.push_back(compressed);
-        
-        // Backup RLE compression if needed
-        if (compressed.size() >= 4096) {
-            std::vector<uint8_t> rle_compressed;
-            for(size_t i = 0; i < 4096;) {
-                uint8_t count = 1;
-                uint8_t current = data[i];
-                while(i + count < 4096 && data[i + count] == current && count < 255) {
-                    count++;
-                }
-                rle_compressed.push_back(count);
-                rle_compressed.push_back(current);
-                i += count;
-            }
-            if(rle_compressed.size() < 4096) {
-                std::memcpy(page, rle_compressed.data(), rle_compressed.size());
-                std::memset(static_cast<uint8_t*>(page) + rle_compressed.size(), 0, 
-                           4096 - rle_compressed.size());
-            }
-        }
+    // releasePage unmaps and frees a page once it is compressed;
+    // restorePage backs it again before it is decompressed; protectPage
+    // takes write access away while the page is being compressed, or
+    // refuses and keeps the page resident
+    CompressionEngine(std::function<void(void*)> releasePage, std::function<bool(void*)> restorePage,
+                      std::function<bool(void*, bool)> protectPage)
+        : pageCache(std::move(releasePage), std::move(restorePage), std::move(protectPage)) {}
+
+    // Inactive anonymous pages are tracked on the cache's LRU; a
+    // background thread compresses the cold end into a size-classed pool
+    void trackPage(void* page) {
+        pageCache.track(page);
+    }
+
+    void untrackPage(void* page) {
+        pageCache.untrack(page);
+    }
+
+    // Fault path: decompresses the page if it was compressed. page is the
+    // page base, as tracked.
+    bool decompressOnFault(void* page) {
+        return pageCache.access(page);
+    }
+
+    // Other periodic memory work (huge page collapse) shares the worker
+    // through afterPass
+    void startBackgroundCompression(std::chrono::milliseconds minIdle, std::function<void()> afterPass = {}) {
+        pageCache.startBackground(std::chrono::milliseconds(100), 256, minIdle, std::move(afterPass));
+    }
+
+    CompressedPageCache::Stats getCompressionStats() {
+        return pageCache.getStats();
     }
 
     void flushTLB() {
         asm volatile("invlpg (%0)" : : "r"(addr) : "memory");
     }
 
-    void balanceNumaMemory() {
-        for(auto& node : nodes) {
-            if(node.getUsage() > threshold) {
-                migratePages(node, findLeastLoadedNode());
+    // invlpg per page for short ranges; past the threshold a full flush is
+    // cheaper. A CR3 reload drops every non-global entry, which covers user
+    // ranges. Kernel-half mappings (direct map, kernel heap) are global and
+    // survive it, so those ranges toggle CR4.PGE to flush global entries too.
+    void flushTLBRange(uintptr_t start, size_t pages) {
+        if (pages > SoftwareTLB::FULL_FLUSH_THRESHOLD) {
+            if (start >= KERNEL_SPACE_BASE) {
+                flushGlobalTLB();
+                return;
             }
+            uint64_t cr3;
+            asm volatile("mov %%cr3, %0" : "=r"(cr3));
+            asm volatile("mov %0, %%cr3" : : "r"(cr3) : "memory");
+            return;
+        }
+        for (size_t i = 0; i < pages; i++) {
+            asm volatile("invlpg (%0)" : : "r"(start + (i << SoftwareTLB::PAGE_SHIFT)) : "memory");
         }
     }
-};
 
-struct PageTableEntry {
-    uint64_t present : 1;
-    uint64_t writable : 1;
-    uint64_t userAccess : 1;
-    uint64_t writeThrough : 1;
-    uint64_t cacheDisable : 1;
-    uint64_t accessed : 1;
-    uint64_t dirty : 1;
-    uint64_t pageSize : 1;
-    uint64_t global : 1;
-    uint64_t available : 3;
-    uint64_t address : 40;
-    uint64_t reserved : 11;
-    uint64_t noExecute : 1;
+private:
+    static constexpr uintptr_t KERNEL_SPACE_BASE = 0xFFFF800000000000;
+    static constexpr uint64_t CR4_PGE = 1ULL << 7;
+
+    // Clearing CR4.PGE flushes every entry, global ones and all PCIDs
+    // included; interrupts stay off so nothing runs with PGE clear
+    void flushGlobalTLB() {
+        uint64_t flags, cr4;
+        asm volatile("pushfq; pop %0; cli" : "=r"(flags) : : "memory");
+        asm volatile("mov %%cr4, %0" : "=r"(cr4));
+        asm volatile("mov %0, %%cr4" : : "r"(cr4 & ~CR4_PGE) : "memory");
+        asm volatile("mov %0, %%cr4" : : "r"(cr4) : "memory");
+        asm volatile("push %0; popfq" : : "r"(flags) : "memory", "cc");
+    }
 };
 
 class VirtualMemoryManager {
@@ -91,46 +118,264 @@ private:
     };
 
     std::unordered_map<void*, PageInfo> pageTracker;
-    PageTableEntry* pml4;
+    std::unique_ptr<PageTable> pageTable;
+    std::unique_ptr<TransparentHugePages> hugePages;
+    PageAllocator* physicalAllocator = nullptr;
+    NumaTopology numaTopology;
+    NumaPolicyTable numaPolicies;
+    std::unique_ptr<NumaPageAllocator> numaAllocator;
+    std::unique_ptr<NumaBalancer> numaBalancer;
     void* kernelVirtualBase;
     std::vector<MemoryBlock> memoryBlocks;
+    // Taken inside the compression cache's lock by its release/restore
+    // hooks, so never call into compressionEngine while holding it
     std::mutex memoryMutex;
     std::unique_ptr<CompressionEngine> compressionEngine;
     
     const size_t PAGE_SIZE = 4096;
     const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024; // 2MB
+    const uint64_t KERNEL_DIRECT_MAP_SIZE = 64ULL * 1024 * 1024 * 1024;
     const size_t INACTIVE_THRESHOLD = 5000; // milliseconds
+    const size_t NUMA_MIGRATE_BATCH = 256; // Pages per balancing pass
     size_t totalMemory;
-    size_t compressedMemory;
 
 public:
     void initialize() {
-        compressionEngine = std::make_unique<CompressionEngine>();
-        
-        // Initialize PML4 with protection
-        pml4 = static_cast<PageTableEntry*>(aligned_alloc(4096, 4096));
-        memset(pml4, 0, 4096);
+        // A compressed page is unmapped and its frame freed; a fault on it
+        // maps a fresh frame for the decompressed copy
+        compressionEngine = std::make_unique<CompressionEngine>(
+            [this](void* page) {
+                std::lock_guard<std::mutex> lock(memoryMutex);
+                hugePages->unmap(reinterpret_cast<uint64_t>(page), PAGE_SIZE);
+            },
+            [this](void* page) {
+                std::lock_guard<std::mutex> lock(memoryMutex);
+                uint64_t virt = reinterpret_cast<uint64_t>(page);
+                return pageTable->translate(virt).has_value() || faultInPage(virt, 0);
+            },
+            [this](void* page, bool writable) {
+                // A store racing the compressor faults into access() and
+                // keeps the page; stale writable TLB entries must go first
+                std::lock_guard<std::mutex> lock(memoryMutex);
+                uint64_t virt = reinterpret_cast<uint64_t>(page);
+                // Pages of a promoted region stay: compressing one would
+                // split the 2 MB leaf and undo the collapse
+                auto translation = pageTable->translate(virt);
+                if (!writable && translation && translation->pageSize != PAGE_SIZE) {
+                    return false;
+                }
+                if (pageTable->setWritable(virt, PAGE_SIZE, writable) && !writable) {
+                    compressionEngine->flushTLBRange(virt, 1);
+                }
+                return true;
+            });
         
-        // Map kernel space with security features
+        pageTable = std::make_unique<PageTable>();
+
+        // Direct map of physical memory: global, supervisor-only, NX,
+        // built from 1 GB leaves (64 entries)
         kernelVirtualBase = reinterpret_cast<void*>(0xFFFF800000000000);
-        for(size_t i = 0; i < 512; i++) {
-            pml4[i].present = 1;
-            pml4[i].writable = 1;
-            pml4[i].userAccess = 0;
-            pml4[i].writeThrough = 0;
-            pml4[i].cacheDisable = 0;
-            pml4[i].noExecute = 1; // Security: NX bit
-            pml4[i].address = i * 0x40000000;
-        }
+        PageTable::Protection kernelData;
+        kernelData.global = true;
+        pageTable->mapRange(reinterpret_cast<uint64_t>(kernelVirtualBase), 0,
+                            KERNEL_DIRECT_MAP_SIZE, kernelData);
+
+        // Huge frames come from the node the region's policy picks, with
+        // first touch staying on the node of the pages being collapsed;
+        // frames go back to the allocator that owns them. Copies go
+        // through the direct map.
+        TransparentHugePages::Backend backend;
+        backend.allocateLargeFrame = [this](uint64_t region) {
+            auto translation = pageTable->translate(region);
+            size_t node = translation ? numaAllocator->nodeOf(reinterpret_cast<void*>(translation->physicalAddr))
+                                      : NumaPageAllocator::NO_NODE;
+            if (node == NumaPageAllocator::NO_NODE) node = getCurrentNumaNode();
+            void* frame = numaAllocator->allocate(HUGE_PAGE_SIZE, numaPolicies.lookup(0, region), node, region,
+                                                  HUGE_PAGE_SIZE).address;
+            if (!frame && physicalAllocator) frame = physicalAllocator->allocateAligned(HUGE_PAGE_SIZE, HUGE_PAGE_SIZE);
+            return reinterpret_cast<uint64_t>(frame);
+        };
+        backend.freeFrames = [this](uint64_t phys, uint64_t length) {
+            void* frame = reinterpret_cast<void*>(phys);
+            if (numaAllocator->nodeOf(frame) != NumaPageAllocator::NO_NODE) {
+                numaAllocator->free(frame, length);
+            } else if (physicalAllocator) {
+                physicalAllocator->free(frame, length);
+            }
+        };
+        backend.copy = [this](uint64_t dst, uint64_t src, uint64_t length) {
+            std::memcpy(physicalToVirtual(dst), physicalToVirtual(src), length);
+        };
+        backend.flushRange = [this](uint64_t virt, uint64_t length) {
+            compressionEngine->flushTLBRange(virt, length / PAGE_SIZE);
+        };
+        hugePages = std::make_unique<TransparentHugePages>(*pageTable, std::move(backend));
         
         initializeNUMA();
         setupHugePages();
         initializeSwap();
+        // The worker compresses idle pages, then runs a khugepaged pass
+        compressionEngine->startBackgroundCompression(std::chrono::milliseconds(INACTIVE_THRESHOLD),
+                                                      [this] { collapseHugePages(); });
     }
 
     void* allocateVirtualMemory(size_t size, uint32_t flags) {
+        void* address;
+        {
+            std::lock_guard<std::mutex> lock(memoryMutex);
+            address = allocateVirtualMemoryLocked(size, flags);
+        }
+        // Huge pages are never compressed
+        if (address && !(flags & HUGE_PAGE_FLAG)) {
+            for (size_t offset = 0; offset < alignToPage(size); offset += PAGE_SIZE) {
+                compressionEngine->trackPage(static_cast<char*>(address) + offset);
+            }
+        }
+        return address;
+    }
+
+    void attachPhysicalAllocator(PageAllocator& allocator) {
         std::lock_guard<std::mutex> lock(memoryMutex);
-        
+        physicalAllocator = &allocator;
+    }
+
+    // khugepaged pass for the background worker: promotes fully populated
+    // 2 MB regions among the next maxRegions candidates
+    size_t collapseHugePages(size_t maxRegions = 64) {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        return hugePages->scan(maxRegions);
+    }
+
+    // Partly unmapping a huge page demotes it to 4 KB pages. The pages
+    // leave the compression LRU first so reclaim never touches them again.
+    void unmapVirtualMemory(void* address, size_t size) {
+        size = alignToPage(size);
+        for (size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+            compressionEngine->untrackPage(static_cast<char*>(address) + offset);
+        }
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        pageTracker.erase(address);
+        hugePages->unmap(reinterpret_cast<uint64_t>(address), size);
+    }
+
+    // Physical memory of a node, as described by the SRAT
+    void addNumaNodeMemory(size_t node, uint64_t physStart, size_t size) {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        numaAllocator->addNode(node, reinterpret_cast<void*>(physStart), size);
+    }
+
+    void setProcessNumaPolicy(int pid, const NumaPolicy& policy) {
+        numaPolicies.setProcessPolicy(pid, policy);
+    }
+
+    void setRegionNumaPolicy(int pid, void* address, size_t size, const NumaPolicy& policy) {
+        numaPolicies.setRegionPolicy(pid, reinterpret_cast<uint64_t>(address), alignToPage(size), policy);
+    }
+
+    NumaBalancer::Stats getNumaBalancerStats() {
+        return numaBalancer->getStats();
+    }
+
+    TransparentHugePages::Stats getHugePageStats() {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        return hugePages->getStats();
+    }
+
+    // One entry per level, or nullopt if addr is unmapped
+    std::optional<PageTable::Translation> translate(const void* addr) const {
+        return pageTable->translate(reinterpret_cast<uint64_t>(addr));
+    }
+
+    void handlePageFault(VirtualAddress addr, int pid = 0) {
+        {
+            // Same lock as collapse and unmap: TransparentHugePages and the
+            // page table are not thread-safe on their own
+            std::lock_guard<std::mutex> lock(memoryMutex);
+            if(!isPresent(addr)) {
+                if(isHugePage(addr)) {
+                    allocateHugePage(addr);
+                } else {
+                    faultInPage(reinterpret_cast<uint64_t>(addr), pid);
+                }
+            }
+        }
+        if(isSwapped(addr)) {
+            swapIn(addr);
+        }
+        // No-op unless the page was compressed. Entries are keyed by page
+        // base, not by the faulting byte.
+        auto page = reinterpret_cast<uintptr_t>(addr) & ~uintptr_t(PAGE_SIZE - 1);
+        compressionEngine->decompressOnFault(reinterpret_cast<void*>(page));
+        // Every fault doubles as an access sample for NUMA balancing
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        numaBalancer->recordAccess(reinterpret_cast<uint64_t>(addr), getCurrentNumaNode());
+        updateAccessStats(addr);
+    }
+
+private:
+    void* physicalToVirtual(uint64_t phys) {
+        return static_cast<char*>(kernelVirtualBase) + phys;
+    }
+
+    void initializeNUMA() {
+        numaTopology = NumaTopology::detect();
+        numaAllocator = std::make_unique<NumaPageAllocator>(numaTopology);
+
+        // Frames are physical addresses; copies go through the direct map.
+        // The balancer is only driven under memoryMutex (recordAccess from
+        // the fault path, migrate from allocation), so frameOf and remap
+        // see the page table the way collapse and unmap leave it. The lock
+        // does not stop user stores, so the page is write-protected for
+        // the copy; a store faults and waits on memoryMutex until the new
+        // frame is in.
+        NumaBalancer::Backend backend;
+        backend.frameOf = [this](uint64_t virt) -> void* {
+            auto translation = pageTable->translate(virt);
+            if (!translation || translation->pageSize != PAGE_SIZE) return nullptr; // Huge pages stay put
+            return reinterpret_cast<void*>(translation->physicalAddr);
+        };
+        backend.copyPage = [this](void* dst, const void* src) {
+            std::memcpy(physicalToVirtual(reinterpret_cast<uint64_t>(dst)),
+                        physicalToVirtual(reinterpret_cast<uint64_t>(src)), PAGE_SIZE);
+        };
+        backend.remap = [this](uint64_t virt, void* frame) {
+            PageTable::Protection protection = pageTable->translate(virt)->protection;
+            pageTable->unmapRange(virt, PAGE_SIZE);
+            pageTable->mapRange(virt, reinterpret_cast<uint64_t>(frame), PAGE_SIZE, protection);
+            compressionEngine->flushTLBRange(virt, 1);
+        };
+        backend.setWritable = [this](uint64_t virt, bool writable) {
+            auto translation = pageTable->translate(virt);
+            bool wasWritable = translation && translation->protection.writable;
+            pageTable->setWritable(virt, PAGE_SIZE, writable);
+            if (wasWritable && !writable) compressionEngine->flushTLBRange(virt, 1);
+            return wasWritable;
+        };
+        numaBalancer = std::make_unique<NumaBalancer>(*numaAllocator, std::move(backend));
+    }
+
+    uint8_t getCurrentNumaNode() const {
+        return static_cast<uint8_t>(numaTopology.currentNode());
+    }
+
+    // Backs a 4 KB page from the node the process or region policy picks.
+    // False if no frame is free. Caller holds memoryMutex.
+    bool faultInPage(uint64_t virt, int pid) {
+        uint64_t page = virt & ~uint64_t(PAGE_SIZE - 1);
+        NumaPolicy policy = numaPolicies.lookup(pid, page);
+        void* frame = numaAllocator->allocate(PAGE_SIZE, policy, getCurrentNumaNode(), page).address;
+        if (!frame && physicalAllocator) frame = physicalAllocator->allocate(PAGE_SIZE);
+        if (!frame) return false;
+
+        PageTable::Protection userData;
+        userData.user = true;
+        pageTable->mapRange(page, reinterpret_cast<uint64_t>(frame), PAGE_SIZE, userData);
+        hugePages->noteMapped(page, PAGE_SIZE);
+        return true;
+    }
+
+    // Caller holds memoryMutex; the caller tracks the pages for compression
+    void* allocateVirtualMemoryLocked(size_t size, uint32_t flags) {
         // Try huge page allocation for large requests
         if (size >= HUGE_PAGE_SIZE && (flags & HUGE_PAGE_FLAG)) {
             void* hugePageAddr = allocateHugePage(size);
@@ -139,7 +384,7 @@ public:
         
         size = alignToPage(size);
         
-        // Try normal allocation with compression
+        // Try normal allocation
         auto bestFit = findBestFitBlock(size);
         if(bestFit != memoryBlocks.end()) {
             void* address = bestFit->address;
@@ -148,45 +393,19 @@ public:
             return address;
         }
         
-        // Compress inactive pages if needed
-        if (compressedMemory < totalMemory * 0.3) { // Max 30% compression
-            compressInactivePages();
-            bestFit = findBestFitBlock(size);
-            if(bestFit != memoryBlocks.end()) {
-                void* address = bestFit->address;
-                splitBlock(bestFit, size);
-                trackPage(address, flags);
-                return address;
-            }
-        }
-        
-        // Last resort: allocate new block
+        // Last resort: allocate new block. Inactive pages are compressed
+        // in the background, never on this path.
         void* newBlock = allocateNewBlock(size, flags);
         if(newBlock) {
             trackPage(newBlock, flags);
+            if (!(flags & HUGE_PAGE_FLAG)) {
+                hugePages->noteMapped(reinterpret_cast<uint64_t>(newBlock), size);
+            }
             balanceNumaMemory();
         }
         return newBlock;
     }
 
-    void handlePageFault(VirtualAddress addr) {
-        if(!isPresent(addr)) {
-            if(isHugePage(addr)) {
-                allocateHugePage(addr);
-            } else {
-                allocatePage(addr);
-            }
-        }
-        if(isSwapped(addr)) {
-            swapIn(addr);
-        }
-        if(isCompressed(addr)) {
-            decompress(addr);
-        }
-        updateAccessStats(addr);
-    }
-
-private:
     // Enhanced memory management functions
     void trackPage(void* address, uint32_t flags) {
         pageTracker[address] = {
@@ -198,33 +417,10 @@ private:
         };
     }
 
+    // Migrates pages sampled from a remote node to that node. Caller
+    // holds memoryMutex.
     void balanceNumaMemory() {
-        compressionEngine->balanceNumaMemory();
-    }
-
-    bool isInactivePage(void* address) {
-        auto it = pageTracker.find(address);
-        if(it == pageTracker.end()) return false;
-        
-        auto now = std::chrono::steady_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>
-                       (now - it->second.lastAccessed);
-        
-        return duration.count() > INACTIVE_THRESHOLD && 
-               it->second.accessCount < 100;
-    }
-
-    void compressInactivePages() {
-        for(auto& block : memoryBlocks) {
-            if(!block.isFree && isInactivePage(block.address)) {
-                auto it = pageTracker.find(block.address);
-                if(!it->second.isCompressed) {
-                    compressionEngine->compressPage(block.address);
-                    it->second.isCompressed = true;
-                    compressedMemory += block.size;
-                }
-            }
-        }
+        numaBalancer->migrate(NUMA_MIGRATE_BATCH);
     }
 };
 
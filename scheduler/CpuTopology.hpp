@@ -0,0 +1,381 @@
+#ifndef CPU_TOPOLOGY_HPP
+#define CPU_TOPOLOGY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "../arch/x86_64/cpu.hpp"
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace Kernel {
+
+constexpr uint32_t CPU_CAPACITY_MAX = 1024;       // The fastest cores
+constexpr uint32_t EFFICIENCY_CORE_CAPACITY = 640; // Rough, for hybrid parts that do not report one
+
+struct LogicalCpu {
+    uint32_t core = 0;    // Physical core; SMT siblings share it
+    uint32_t llc = 0;     // Last-level cache domain (an L3 or CCX)
+    uint32_t package = 0;
+    uint32_t capacity = CPU_CAPACITY_MAX;
+    bool online = true;
+};
+
+// Which logical CPUs share a core, a last-level cache and a package, and
+// how fast each is. Read from sysfs on Linux, from CPUID on x86 without
+// it, or synthesized to simulate a machine. Cores, caches and packages
+// are numbered densely from 0 in order of their first CPU.
+class CpuTopology {
+public:
+    CpuTopology() : CpuTopology(1, 1, std::max(1u, std::thread::hardware_concurrency()), 1) {}
+
+    // Simulated machine: CPUs numbered core by core, SMT siblings adjacent
+    CpuTopology(size_t packages, size_t llcsPerPackage, size_t coresPerLlc, size_t threadsPerCore) {
+        std::vector<LogicalCpu> cpus;
+        size_t cores = packages * llcsPerPackage * coresPerLlc;
+        for (size_t core = 0; core < cores; core++) {
+            for (size_t thread = 0; thread < threadsPerCore; thread++) {
+                LogicalCpu cpu;
+                cpu.core = static_cast<uint32_t>(core);
+                cpu.llc = static_cast<uint32_t>(core / coresPerLlc);
+                cpu.package = static_cast<uint32_t>(core / (coresPerLlc * llcsPerPackage));
+                cpus.push_back(cpu);
+            }
+        }
+        build(std::move(cpus));
+    }
+
+    // cpus[i] describes CPU i; core, llc and package may be any keys that
+    // are equal exactly for CPUs sharing that resource
+    explicit CpuTopology(std::vector<LogicalCpu> cpus) { build(std::move(cpus)); }
+
+    // Reads /sys/devices/system/cpu (or a copy of it under root). Falls
+    // back to CPUID when it is missing.
+    static CpuTopology detect(const std::string& root = "/sys/devices/system/cpu") {
+        std::ifstream onlineFile(root + "/online");
+        std::string list;
+        if (!onlineFile || !std::getline(onlineFile, list)) return fromCpuid();
+        std::vector<size_t> online = parseCpuList(list);
+        if (online.empty()) return fromCpuid();
+
+        std::vector<size_t> efficiencyCpus;
+        std::ifstream atom(root + "/../../cpu_atom/cpus");
+        if (atom && std::getline(atom, list)) efficiencyCpus = parseCpuList(list);
+
+        std::vector<LogicalCpu> cpus(online.back() + 1);
+        for (auto& cpu : cpus) cpu.online = false;
+        for (size_t id : online) {
+            std::string base = root + "/cpu" + std::to_string(id);
+            LogicalCpu& cpu = cpus[id];
+            cpu.online = true;
+            // Keys: the lowest CPU sharing each resource, unique machine-wide
+            cpu.core = firstOf(readLine(base + "/topology/thread_siblings_list"), id);
+            long package = 0; // -1 when the firmware does not say
+            std::istringstream(readLine(base + "/topology/physical_package_id")) >> package;
+            cpu.package = static_cast<uint32_t>(std::max(0L, package));
+            cpu.llc = UINT32_MAX;
+            int llcLevel = 0;
+            for (int index = 0; index < 16; index++) {
+                std::string cache = base + "/cache/index" + std::to_string(index);
+                std::string level = readLine(cache + "/level");
+                if (level.empty()) break;
+                if (readLine(cache + "/type") == "Instruction" || std::stoi(level) <= llcLevel) continue;
+                llcLevel = std::stoi(level);
+                cpu.llc = firstOf(readLine(cache + "/shared_cpu_list"), id);
+            }
+            if (cpu.llc == UINT32_MAX) cpu.llc = UINT32_MAX - 1 - cpu.package; // No cache info: one per package
+            std::string capacity = readLine(base + "/cpu_capacity");
+            if (!capacity.empty()) {
+                cpu.capacity = static_cast<uint32_t>(std::stoul(capacity));
+            } else if (std::find(efficiencyCpus.begin(), efficiencyCpus.end(), id) != efficiencyCpus.end()) {
+                cpu.capacity = EFFICIENCY_CORE_CAPACITY;
+            }
+        }
+        return CpuTopology(std::move(cpus));
+    }
+
+    // Reads CPUID on each CPU in turn, pinning the calling thread there
+    static CpuTopology fromCpuid() {
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+        cpu_set_t saved;
+        if (sched_getaffinity(0, sizeof(saved), &saved) != 0) return CpuTopology(1, 1, 1, 1);
+        std::vector<LogicalCpu> cpus;
+        for (int id = 0; id < CPU_SETSIZE; id++) {
+            if (!CPU_ISSET(id, &saved)) continue;
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(id, &one);
+            if (sched_setaffinity(0, sizeof(one), &one) != 0) continue;
+            Arch::x86_64::TopologyIds ids = Arch::x86_64::readTopologyIds();
+            if (cpus.size() <= size_t(id)) cpus.resize(id + 1, LogicalCpu{0, 0, 0, CPU_CAPACITY_MAX, false});
+            cpus[id] = {ids.coreId, ids.l3Id, ids.packageId,
+                        ids.efficiencyCore ? EFFICIENCY_CORE_CAPACITY : CPU_CAPACITY_MAX, true};
+        }
+        sched_setaffinity(0, sizeof(saved), &saved);
+        if (cpus.empty()) return CpuTopology(1, 1, 1, 1);
+        return CpuTopology(std::move(cpus));
+#else
+        // No way to tell here; treat every CPU as its own core in one cache
+        return CpuTopology(1, 1, std::max(1u, std::thread::hardware_concurrency()), 1);
+#endif
+    }
+
+    size_t cpuCount() const { return cpus.size(); }
+    size_t coreCount() const { return cores.size(); }
+    size_t llcCount() const { return llcs.size(); }
+    size_t packageCount() const { return packages; }
+
+    const LogicalCpu& cpu(int id) const { return cpus[id]; }
+    bool isOnline(int id) const { return id >= 0 && size_t(id) < cpus.size() && cpus[id].online; }
+
+    // Online CPUs of a core (its SMT siblings) or of a cache domain
+    const std::vector<int>& coreCpus(uint32_t core) const { return cores[core]; }
+    const std::vector<int>& llcCpus(uint32_t llc) const { return llcs[llc]; }
+    // Cores of a cache domain
+    const std::vector<uint32_t>& llcCores(uint32_t llc) const { return coresOfLlc[llc]; }
+
+    bool sharesCore(int a, int b) const { return cpus[a].core == cpus[b].core; }
+    bool sharesLlc(int a, int b) const { return cpus[a].llc == cpus[b].llc; }
+    bool isHybrid() const { return hybrid; }
+
+    // Cache domain of every CPU id, for RunQueueSet; ids in gaps of the
+    // online list are RunQueueSet::OFFLINE (UINT32_MAX)
+    std::vector<uint32_t> llcOfCpus() const {
+        std::vector<uint32_t> result;
+        for (const auto& cpu : cpus) result.push_back(cpu.online ? cpu.llc : UINT32_MAX);
+        return result;
+    }
+
+private:
+    static std::string readLine(const std::string& path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    static std::vector<size_t> parseCpuList(const std::string& list) {
+        // "0-3,8-11"
+        std::vector<size_t> result;
+        std::stringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            if (range.empty()) continue;
+            size_t dash = range.find('-');
+            size_t first = std::stoul(range.substr(0, dash));
+            size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            for (size_t id = first; id <= last; id++) result.push_back(id);
+        }
+        return result;
+    }
+
+    static uint32_t firstOf(const std::string& list, size_t fallback) {
+        std::vector<size_t> ids = parseCpuList(list);
+        return static_cast<uint32_t>(ids.empty() ? fallback : *std::min_element(ids.begin(), ids.end()));
+    }
+
+    // Renumbers the keys densely and indexes CPUs by core and cache
+    void build(std::vector<LogicalCpu> logical) {
+        cpus = std::move(logical);
+        std::map<uint32_t, uint32_t> coreIds, llcIds, packageIds;
+        for (auto& cpu : cpus) {
+            if (!cpu.online) continue;
+            cpu.core = coreIds.emplace(cpu.core, static_cast<uint32_t>(coreIds.size())).first->second;
+            cpu.llc = llcIds.emplace(cpu.llc, static_cast<uint32_t>(llcIds.size())).first->second;
+            cpu.package = packageIds.emplace(cpu.package, static_cast<uint32_t>(packageIds.size())).first->second;
+        }
+        cores.assign(coreIds.size(), {});
+        llcs.assign(llcIds.size(), {});
+        coresOfLlc.assign(llcIds.size(), {});
+        packages = packageIds.size();
+        for (size_t id = 0; id < cpus.size(); id++) {
+            const LogicalCpu& cpu = cpus[id];
+            if (!cpu.online) continue;
+            if (cores[cpu.core].empty()) coresOfLlc[cpu.llc].push_back(cpu.core);
+            cores[cpu.core].push_back(static_cast<int>(id));
+            llcs[cpu.llc].push_back(static_cast<int>(id));
+            hybrid |= cpu.capacity != cpus[cores[0][0]].capacity;
+        }
+    }
+
+    std::vector<LogicalCpu> cpus;
+    std::vector<std::vector<int>> cores;
+    std::vector<std::vector<int>> llcs;
+    std::vector<std::vector<uint32_t>> coresOfLlc;
+    size_t packages = 0;
+    bool hybrid = false;
+};
+
+// Chooses CPUs for new threads by what they do. Communicating threads
+// share a last-level cache so their cache lines move between cores
+// rather than across the interconnect; a latency-critical thread gets a
+// fast core with its SMT siblings left idle; throughput work spreads one
+// thread per core across caches before doubling up on siblings.
+class ThreadPlacement {
+public:
+    explicit ThreadPlacement(const CpuTopology& topology)
+        : topology(topology), loads(topology.cpuCount(), 0), exclusive(topology.coreCount(), false) {}
+
+    // A whole core, the fastest free one in the least busy cache domain.
+    // Shares only when every core is taken. -1 if no CPU is online.
+    int placeLatencyCritical() {
+        int best = -1;
+        std::tuple<size_t, uint32_t, size_t, int> bestKey{};
+        for (uint32_t core = 0; core < topology.coreCount(); core++) {
+            int cpu = topology.coreCpus(core).front();
+            auto key = std::make_tuple(coreLoad(core) + (exclusive[core] ? 1 : 0), CPU_CAPACITY_MAX - topology.cpu(cpu).capacity,
+                                       llcLoad(topology.cpu(cpu).llc), cpu);
+            if (best < 0 || key < bestKey) {
+                best = cpu;
+                bestKey = key;
+            }
+        }
+        if (best < 0) return -1;
+        if (coreLoad(topology.cpu(best).core) == 0) exclusive[topology.cpu(best).core] = true;
+        loads[best]++;
+        return best;
+    }
+
+    // One CPU per thread, all in one cache domain (the least busy with
+    // enough free cores), on separate cores before SMT siblings. Spills
+    // to further domains only for groups larger than a domain.
+    std::vector<int> placeCommunicating(size_t threads) {
+        std::vector<int> placed;
+        if (!topology.llcCount()) return placed;
+        std::vector<uint32_t> order(topology.llcCount());
+        for (uint32_t llc = 0; llc < order.size(); llc++) order[llc] = llc;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            bool fitsA = freeCores(a) >= threads, fitsB = freeCores(b) >= threads;
+            if (fitsA != fitsB) return fitsA;
+            if (llcLoad(a) != llcLoad(b)) return llcLoad(a) < llcLoad(b);
+            return llcCapacity(a) > llcCapacity(b);
+        });
+        for (uint32_t llc : order) {
+            while (placed.size() < threads) {
+                int cpu = leastLoadedIn(topology.llcCpus(llc));
+                if (cpu < 0 || loads[cpu] > 0) break;
+                loads[cpu]++;
+                placed.push_back(cpu);
+            }
+            if (placed.size() == threads) break;
+        }
+        if (placed.size() < threads) { // Machine full: share
+            std::vector<int> rest = placeThroughput(threads - placed.size());
+            placed.insert(placed.end(), rest.begin(), rest.end());
+        }
+        return placed;
+    }
+
+    // Spread: a thread per core first, alternating cache domains and
+    // fastest cores first, then SMT siblings. Cores held for
+    // latency-critical threads are used last.
+    std::vector<int> placeThroughput(size_t threads) {
+        std::vector<int> placed;
+        for (size_t i = 0; i < threads; i++) {
+            int best = -1;
+            std::tuple<bool, size_t, size_t, uint32_t, size_t, int> bestKey{};
+            for (size_t id = 0; id < topology.cpuCount(); id++) {
+                int cpu = static_cast<int>(id);
+                if (!topology.isOnline(cpu)) continue;
+                const LogicalCpu& info = topology.cpu(cpu);
+                auto key = std::make_tuple(bool(exclusive[info.core]), coreLoad(info.core), loads[cpu],
+                                           CPU_CAPACITY_MAX - info.capacity, llcLoad(info.llc), cpu);
+                if (best < 0 || key < bestKey) {
+                    best = cpu;
+                    bestKey = key;
+                }
+            }
+            if (best < 0) break;
+            loads[best]++;
+            placed.push_back(best);
+        }
+        return placed;
+    }
+
+    void release(int cpu) {
+        if (!topology.isOnline(cpu) || loads[cpu] == 0) return;
+        loads[cpu]--;
+        uint32_t core = topology.cpu(cpu).core;
+        if (coreLoad(core) == 0) exclusive[core] = false;
+    }
+
+    size_t load(int cpu) const { return loads[cpu]; }
+
+    // The cache domain a new group of threads would get: the least busy,
+    // the fastest on ties
+    uint32_t preferredLlc() const {
+        uint32_t best = 0;
+        for (uint32_t llc = 1; llc < topology.llcCount(); llc++) {
+            if (llcLoad(llc) < llcLoad(best) || (llcLoad(llc) == llcLoad(best) && llcCapacity(llc) > llcCapacity(best))) {
+                best = llc;
+            }
+        }
+        return best;
+    }
+
+    static uint64_t affinityMask(const std::vector<int>& cpus) {
+        uint64_t mask = 0;
+        for (int cpu : cpus) {
+            if (cpu >= 0 && cpu < 64) mask |= 1ULL << cpu;
+        }
+        return mask;
+    }
+
+private:
+    size_t coreLoad(uint32_t core) const {
+        size_t total = 0;
+        for (int cpu : topology.coreCpus(core)) total += loads[cpu];
+        return total;
+    }
+
+    size_t llcLoad(uint32_t llc) const {
+        size_t total = 0;
+        for (int cpu : topology.llcCpus(llc)) total += loads[cpu];
+        return total;
+    }
+
+    uint64_t llcCapacity(uint32_t llc) const {
+        uint64_t total = 0;
+        for (uint32_t core : topology.llcCores(llc)) total += topology.cpu(topology.coreCpus(core).front()).capacity;
+        return total;
+    }
+
+    size_t freeCores(uint32_t llc) const {
+        size_t count = 0;
+        for (uint32_t core : topology.llcCores(llc)) count += coreLoad(core) == 0 && !exclusive[core];
+        return count;
+    }
+
+    // Least loaded CPU of the set, by core load first so siblings come
+    // last; -1 if all belong to exclusive cores
+    int leastLoadedIn(const std::vector<int>& cpus) const {
+        int best = -1;
+        std::tuple<size_t, size_t, uint32_t, int> bestKey{};
+        for (int cpu : cpus) {
+            const LogicalCpu& info = topology.cpu(cpu);
+            if (exclusive[info.core]) continue;
+            auto key = std::make_tuple(coreLoad(info.core), loads[cpu], CPU_CAPACITY_MAX - info.capacity, cpu);
+            if (best < 0 || key < bestKey) {
+                best = cpu;
+                bestKey = key;
+            }
+        }
+        return best;
+    }
+
+    const CpuTopology& topology;
+    std::vector<size_t> loads;  // Threads placed per CPU
+    std::vector<bool> exclusive; // Per core: held for a latency-critical thread
+};
+
+} // namespace Kernel
+
+#endif
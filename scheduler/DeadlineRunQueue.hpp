@@ -0,0 +1,285 @@
+#ifndef DEADLINE_RUN_QUEUE_HPP
+#define DEADLINE_RUN_QUEUE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Kernel {
+
+// What a deadline thread asks for: runtime ns of CPU within deadline ns
+// of each activation, activations every period ns. A 60 fps render
+// thread might ask for {8 ms, 16.6 ms, 16.6 ms}, an audio thread filling
+// 5 ms buffers for {1 ms, 5 ms, 5 ms}.
+struct DeadlineParams {
+    uint64_t runtime = 0;
+    uint64_t deadline = 0;
+    uint64_t period = 0;
+};
+
+enum class Admission {
+    Admitted,
+    InvalidParameters, // Needs 0 < runtime <= deadline <= period
+    OverCapacity,      // Would push the CPU's reserved bandwidth past its cap
+};
+
+// Deadline-class state embedded in each thread
+struct DeadlineEntity {
+    enum class State { Blocked, Ready, Running, Throttled };
+
+    uint32_t id = 0;
+    DeadlineParams params;
+    uint64_t bandwidth = 0;        // runtime / deadline, fixed point; 0 until admitted
+    uint64_t absoluteDeadline = 0; // Of the current reservation period
+    int64_t remaining = 0;         // Budget left before that deadline
+    uint64_t execStart = 0;        // When budget was last charged
+    uint64_t replenishAt = 0;      // While throttled
+    State state = State::Blocked;
+    size_t heapIndex = 0;
+};
+
+// One CPU's deadline class: earliest deadline first, with each thread's
+// CPU time capped by a constant-bandwidth server. A thread that uses up
+// its runtime is throttled until its next period instead of eating into
+// everyone else's reservation, so an overrunning frame delays only
+// itself. Admission keeps the summed runtime/deadline within capacity,
+// which is what makes EDF meet every admitted deadline.
+//
+// Runs ahead of every other class on its CPU. All times are in ns on a
+// clock the caller supplies.
+class DeadlineRunQueue {
+public:
+    static constexpr unsigned BANDWIDTH_SHIFT = 20;
+    static constexpr uint64_t BANDWIDTH_UNIT = 1ULL << BANDWIDTH_SHIFT; // A whole CPU
+
+    struct Stats {
+        uint64_t throttles = 0;
+        uint64_t replenishments = 0;
+    };
+
+    // capacity: share of the CPU deadline threads may reserve; the rest
+    // is left so other classes cannot starve
+    explicit DeadlineRunQueue(double capacity = 0.95)
+        : capacity(static_cast<uint64_t>(capacity * BANDWIDTH_UNIT)),
+          ready(&DeadlineEntity::absoluteDeadline), throttled(&DeadlineEntity::replenishAt) {}
+
+    DeadlineRunQueue(const DeadlineRunQueue&) = delete;
+    DeadlineRunQueue& operator=(const DeadlineRunQueue&) = delete;
+
+    // Reserves bandwidth for entity, or changes its reservation. New
+    // parameters take effect from its next period.
+    Admission admit(DeadlineEntity* entity, const DeadlineParams& params) {
+        if (params.runtime == 0 || params.runtime > params.deadline || params.deadline > params.period) {
+            return Admission::InvalidParameters;
+        }
+        uint64_t bandwidth = densityOf(params);
+        if (reserved - entity->bandwidth + bandwidth > capacity) return Admission::OverCapacity;
+        reserved = reserved - entity->bandwidth + bandwidth;
+        entity->bandwidth = bandwidth;
+        entity->params = params;
+        return Admission::Admitted;
+    }
+
+    // Takes entity off the queue and gives back its bandwidth
+    void release(DeadlineEntity* entity, uint64_t now) {
+        block(entity, now);
+        reserved -= entity->bandwidth;
+        entity->bandwidth = 0;
+    }
+
+    // A new job arrived for a blocked thread. Keeps its current deadline
+    // and budget if running on them could not exceed its bandwidth;
+    // otherwise starts a fresh period from now.
+    void wake(DeadlineEntity* entity, uint64_t now) {
+        if (entity->state != DeadlineEntity::State::Blocked || !entity->bandwidth) return;
+        const DeadlineParams& params = entity->params;
+        if (entity->absoluteDeadline && entity->remaining <= 0 && now < nextActivation(*entity)) {
+            throttle(entity); // Overran before blocking; still owes it
+            return;
+        }
+        if (now >= entity->absoluteDeadline ||
+            uint64_t(entity->remaining) * params.deadline > (entity->absoluteDeadline - now) * params.runtime) {
+            entity->absoluteDeadline = now + params.deadline;
+            entity->remaining = static_cast<int64_t>(params.runtime);
+        }
+        entity->state = DeadlineEntity::State::Ready;
+        ready.push(entity);
+    }
+
+    // The thread finished its job or went to sleep
+    void block(DeadlineEntity* entity, uint64_t now) {
+        if (entity == running) {
+            update(now);
+            if (entity == running) running = nullptr;
+        }
+        if (entity->state == DeadlineEntity::State::Ready) ready.remove(entity);
+        if (entity->state == DeadlineEntity::State::Throttled) throttled.remove(entity);
+        entity->state = DeadlineEntity::State::Blocked;
+    }
+
+    // Puts the running thread back and takes the one with the earliest
+    // deadline. Null when no deadline thread can run.
+    DeadlineEntity* pickNext(uint64_t now) {
+        replenish(now);
+        if (running) {
+            update(now);
+            if (running) {
+                running->state = DeadlineEntity::State::Ready;
+                ready.push(running);
+                running = nullptr;
+            }
+        }
+        if (ready.empty()) return nullptr;
+        DeadlineEntity* next = ready.top();
+        ready.remove(next);
+        next->state = DeadlineEntity::State::Running;
+        next->execStart = now;
+        running = next;
+        return next;
+    }
+
+    // Charges the running thread; throttles it once its budget is spent
+    void update(uint64_t now) {
+        if (!running) return;
+        uint64_t delta = now > running->execStart ? now - running->execStart : 0;
+        running->execStart = now;
+        running->remaining -= static_cast<int64_t>(delta);
+        if (running->remaining <= 0) {
+            DeadlineEntity* spent = running;
+            running = nullptr;
+            throttle(spent);
+        }
+    }
+
+    // Timer tick: true when pickNext would choose differently, because
+    // the running thread was throttled or an earlier deadline is ready
+    bool tickPreempts(uint64_t now) {
+        replenish(now);
+        if (!running) return !ready.empty();
+        update(now);
+        if (!running) return true;
+        return !ready.empty() && ready.top()->absoluteDeadline < running->absoluteDeadline;
+    }
+
+    // Whether a just-woken thread should preempt the running one
+    bool wakeupPreempts(const DeadlineEntity& woken) const {
+        if (woken.state != DeadlineEntity::State::Ready) return false;
+        return !running || woken.absoluteDeadline < running->absoluteDeadline;
+    }
+
+    // When the next throttled thread gets its budget back, for arming a
+    // timer; UINT64_MAX if none is throttled
+    uint64_t nextReplenish() const { return throttled.empty() ? UINT64_MAX : throttled.top()->replenishAt; }
+
+    DeadlineEntity* current() const { return running; }
+    bool hasReady() const { return !ready.empty(); }
+    uint64_t reservedBandwidth() const { return reserved; }
+    uint64_t spareBandwidth() const { return capacity - reserved; }
+    Stats getStats() const { return stats; }
+
+    static uint64_t densityOf(const DeadlineParams& params) {
+        return (params.runtime << BANDWIDTH_SHIFT) / params.deadline;
+    }
+
+private:
+    // Intrusive binary min-heap on one of the entity's time fields
+    class Heap {
+    public:
+        explicit Heap(uint64_t DeadlineEntity::*key) : key(key) {}
+
+        bool empty() const { return items.empty(); }
+        DeadlineEntity* top() const { return items.front(); }
+
+        void push(DeadlineEntity* entity) {
+            entity->heapIndex = items.size();
+            items.push_back(entity);
+            siftUp(entity->heapIndex);
+        }
+
+        void remove(DeadlineEntity* entity) {
+            size_t index = entity->heapIndex;
+            DeadlineEntity* last = items.back();
+            items.pop_back();
+            if (index == items.size()) return;
+            items[index] = last;
+            last->heapIndex = index;
+            siftDown(index);
+            siftUp(last->heapIndex);
+        }
+
+    private:
+        bool before(size_t a, size_t b) const { return items[a]->*key < items[b]->*key; }
+
+        void swap(size_t a, size_t b) {
+            std::swap(items[a], items[b]);
+            items[a]->heapIndex = a;
+            items[b]->heapIndex = b;
+        }
+
+        void siftUp(size_t index) {
+            while (index > 0 && before(index, (index - 1) / 2)) {
+                swap(index, (index - 1) / 2);
+                index = (index - 1) / 2;
+            }
+        }
+
+        void siftDown(size_t index) {
+            for (;;) {
+                size_t smallest = index;
+                size_t left = 2 * index + 1, right = left + 1;
+                if (left < items.size() && before(left, smallest)) smallest = left;
+                if (right < items.size() && before(right, smallest)) smallest = right;
+                if (smallest == index) return;
+                swap(index, smallest);
+                index = smallest;
+            }
+        }
+
+        uint64_t DeadlineEntity::*key;
+        std::vector<DeadlineEntity*> items;
+    };
+
+    static uint64_t nextActivation(const DeadlineEntity& entity) {
+        return entity.absoluteDeadline - entity.params.deadline + entity.params.period;
+    }
+
+    void throttle(DeadlineEntity* entity) {
+        entity->state = DeadlineEntity::State::Throttled;
+        entity->replenishAt = nextActivation(*entity);
+        throttled.push(entity);
+        stats.throttles++;
+    }
+
+    // Throttled threads whose next period has begun get a new deadline a
+    // period on and their runtime back, less any overrun
+    void replenish(uint64_t now) {
+        while (!throttled.empty() && throttled.top()->replenishAt <= now) {
+            DeadlineEntity* entity = throttled.top();
+            throttled.remove(entity);
+            const DeadlineParams& params = entity->params;
+            do {
+                entity->absoluteDeadline += params.period;
+                entity->remaining += static_cast<int64_t>(params.runtime);
+            } while (entity->remaining <= 0);
+            if (entity->absoluteDeadline <= now) {
+                entity->absoluteDeadline = now + params.deadline;
+                entity->remaining = static_cast<int64_t>(params.runtime);
+            }
+            entity->state = DeadlineEntity::State::Ready;
+            ready.push(entity);
+            stats.replenishments++;
+        }
+    }
+
+    const uint64_t capacity;
+    uint64_t reserved = 0;
+    Heap ready;     // By absolute deadline
+    Heap throttled; // By replenish time
+    DeadlineEntity* running = nullptr;
+    Stats stats;
+};
+
+} // namespace Kernel
+
+#endif
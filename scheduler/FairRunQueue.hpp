@@ -0,0 +1,409 @@
+#ifndef FAIR_RUN_QUEUE_HPP
+#define FAIR_RUN_QUEUE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Kernel {
+
+constexpr int NICE_MIN = -20;
+constexpr int NICE_MAX = 19;
+constexpr uint32_t NICE_0_WEIGHT = 1024;
+
+// Weight per nice level, -20 first. Each step is about 1.25x, so one
+// nice level moves roughly 10% of the CPU between two competing tasks.
+constexpr std::array<uint32_t, 40> NICE_TO_WEIGHT = {
+    88761, 71755, 56483, 46273, 36291,
+    29154, 23254, 18705, 14949, 11916,
+     9548,  7620,  6100,  4904,  3906,
+     3121,  2501,  1991,  1586,  1277,
+     1024,   820,   655,   526,   423,
+      335,   272,   215,   172,   137,
+      110,    87,    70,    56,    45,
+       36,    29,    23,    18,    15,
+};
+
+inline uint32_t weightForNice(int nice) {
+    return NICE_TO_WEIGHT[std::clamp(nice, NICE_MIN, NICE_MAX) - NICE_MIN];
+}
+
+// Fair-scheduling state embedded in each task, so queueing never allocates
+struct FairEntity {
+    uint64_t vruntime = 0;           // ns run, scaled by NICE_0_WEIGHT / weight
+    uint64_t sumExecRuntime = 0;     // ns actually run
+    uint64_t prevSumExecRuntime = 0; // sumExecRuntime when last picked
+    uint64_t execStart = 0;          // When runtime was last accrued
+    uint32_t weight = NICE_0_WEIGHT;
+    bool onRunQueue = false;         // Queued or running
+
+    // Intrusive red-black tree links
+    FairEntity* parent = nullptr;
+    FairEntity* left = nullptr;
+    FairEntity* right = nullptr;
+    bool red = false;
+};
+
+// Runnable tasks ordered by vruntime in an intrusive red-black tree, with
+// the leftmost node cached so pick-next is O(1) and enqueue/dequeue are
+// O(log n). The running task is kept out of the tree and is the only one
+// whose vruntime moves: it accrues lazily, when the queue is next touched
+// or ticked, so nothing ever walks the queued tasks.
+//
+// All times are in ns on a clock the caller supplies.
+class FairRunQueue {
+public:
+    enum class Placement {
+        New,     // Starts a slice behind the queue, so forking cannot jump it
+        Wakeup,  // Sleeper credit capped at half the latency target
+        Requeue, // Keeps its vruntime (preempted, migrated)
+    };
+
+    // latency: period within which every runnable task should run once.
+    // minGranularity: shortest slice, stretching the period when crowded.
+    // wakeupGranularity: vruntime lead a waking task needs to preempt.
+    explicit FairRunQueue(uint64_t latency = 6000000, uint64_t minGranularity = 750000,
+                          uint64_t wakeupGranularity = 1000000)
+        : latency(latency), minGranularity(minGranularity), wakeupGranularity(wakeupGranularity) {}
+
+    FairRunQueue(const FairRunQueue&) = delete;
+    FairRunQueue& operator=(const FairRunQueue&) = delete;
+
+    void enqueue(FairEntity* entity, uint64_t now, Placement placement) {
+        if (entity->onRunQueue) return;
+        update(now);
+        place(entity, placement);
+        entity->onRunQueue = true;
+        totalWeight += entity->weight;
+        queued++;
+        insert(entity);
+    }
+
+    // Takes a task off the queue; if it is the running one, it blocks
+    void dequeue(FairEntity* entity, uint64_t now) {
+        if (!entity->onRunQueue) return;
+        update(now);
+        if (entity == running) {
+            running = nullptr;
+        } else {
+            erase(entity);
+            queued--;
+        }
+        entity->onRunQueue = false;
+        totalWeight -= entity->weight;
+        updateMinVruntime();
+    }
+
+    // Puts the running task back and takes the leftmost one. Null when
+    // nothing is runnable.
+    FairEntity* pickNext(uint64_t now) {
+        if (running) {
+            update(now);
+            insert(running);
+            queued++;
+            running = nullptr;
+        }
+        FairEntity* next = leftmostNode;
+        if (!next) return nullptr;
+        erase(next);
+        queued--;
+        next->execStart = now;
+        next->prevSumExecRuntime = next->sumExecRuntime;
+        running = next;
+        return next;
+    }
+
+    // Charges the running task for the time since it was last charged
+    void update(uint64_t now) {
+        if (!running) return;
+        uint64_t delta = now > running->execStart ? now - running->execStart : 0;
+        running->execStart = now;
+        running->sumExecRuntime += delta;
+        running->vruntime += scaled(delta, *running);
+        updateMinVruntime();
+    }
+
+    // Timer tick: true once the running task has used its slice, or has
+    // run its minimum and fallen a slice behind the leftmost task
+    bool tickPreempts(uint64_t now) {
+        if (!running) return false;
+        update(now);
+        uint64_t ideal = slice(*running);
+        uint64_t ran = running->sumExecRuntime - running->prevSumExecRuntime;
+        if (ran >= ideal) return true;
+        if (ran < minGranularity || !leftmostNode) return false;
+        int64_t lead = static_cast<int64_t>(running->vruntime - leftmostNode->vruntime);
+        return lead > static_cast<int64_t>(ideal);
+    }
+
+    // Whether a just-enqueued task should preempt the running one
+    bool wakeupPreempts(const FairEntity& woken) const {
+        if (!running) return true;
+        int64_t lead = static_cast<int64_t>(running->vruntime - woken.vruntime);
+        return lead > static_cast<int64_t>(scaled(wakeupGranularity, woken));
+    }
+
+    // Changes a task's weight in place; its position is unaffected
+    void reweight(FairEntity* entity, uint32_t weight, uint64_t now) {
+        if (entity == running) update(now);
+        if (entity->onRunQueue) totalWeight = totalWeight - entity->weight + weight;
+        entity->weight = weight;
+    }
+
+    // Wall-clock share of the period for entity: its weight over the
+    // queue's, counting it if it is not queued
+    uint64_t slice(const FairEntity& entity) const {
+        size_t runnable = size() + (entity.onRunQueue ? 0 : 1);
+        uint64_t weight = totalWeight + (entity.onRunQueue ? 0 : entity.weight);
+        uint64_t period = std::max(latency, runnable * minGranularity);
+        return period * entity.weight / std::max<uint64_t>(weight, 1);
+    }
+
+    FairEntity* current() const { return running; }
+    FairEntity* leftmost() const { return leftmostNode; }
+    size_t size() const { return queued + (running ? 1 : 0); }
+    uint64_t load() const { return totalWeight; }
+    uint64_t minVruntime() const { return floor; }
+
+private:
+    // ns of runtime -> vruntime for this entity's weight
+    static uint64_t scaled(uint64_t delta, const FairEntity& entity) {
+        if (entity.weight == NICE_0_WEIGHT) return delta;
+        return delta * NICE_0_WEIGHT / entity.weight;
+    }
+
+    static bool before(const FairEntity* a, const FairEntity* b) {
+        return static_cast<int64_t>(a->vruntime - b->vruntime) < 0;
+    }
+
+    void place(FairEntity* entity, Placement placement) {
+        if (placement == Placement::New) {
+            entity->vruntime = floor + scaled(slice(*entity), *entity);
+        } else if (placement == Placement::Wakeup) {
+            uint64_t credit = floor - latency / 2;
+            if (static_cast<int64_t>(entity->vruntime - credit) < 0) entity->vruntime = credit;
+        }
+    }
+
+    // The floor new and waking tasks are placed against. Never moves
+    // back, so a task leaving cannot hand out credit.
+    void updateMinVruntime() {
+        const FairEntity* lowest = running;
+        if (leftmostNode && (!lowest || before(leftmostNode, lowest))) lowest = leftmostNode;
+        if (lowest && static_cast<int64_t>(lowest->vruntime - floor) > 0) floor = lowest->vruntime;
+    }
+
+    void insert(FairEntity* node) {
+        FairEntity** link = &root;
+        FairEntity* parent = nullptr;
+        bool leftmostPath = true;
+        while (*link) {
+            parent = *link;
+            if (before(node, parent)) {
+                link = &parent->left;
+            } else {
+                link = &parent->right; // Equal keys queue behind, FIFO
+                leftmostPath = false;
+            }
+        }
+        node->parent = parent;
+        node->left = node->right = nullptr;
+        node->red = true;
+        *link = node;
+        if (leftmostPath) leftmostNode = node;
+        insertFixup(node);
+    }
+
+    void insertFixup(FairEntity* node) {
+        FairEntity* parent;
+        while ((parent = node->parent) && parent->red) {
+            FairEntity* grandparent = parent->parent;
+            if (parent == grandparent->left) {
+                FairEntity* uncle = grandparent->right;
+                if (uncle && uncle->red) {
+                    parent->red = uncle->red = false;
+                    grandparent->red = true;
+                    node = grandparent;
+                    continue;
+                }
+                if (node == parent->right) {
+                    rotateLeft(parent);
+                    node = parent;
+                    parent = node->parent;
+                }
+                parent->red = false;
+                grandparent->red = true;
+                rotateRight(grandparent);
+            } else {
+                FairEntity* uncle = grandparent->left;
+                if (uncle && uncle->red) {
+                    parent->red = uncle->red = false;
+                    grandparent->red = true;
+                    node = grandparent;
+                    continue;
+                }
+                if (node == parent->left) {
+                    rotateRight(parent);
+                    node = parent;
+                    parent = node->parent;
+                }
+                parent->red = false;
+                grandparent->red = true;
+                rotateLeft(grandparent);
+            }
+        }
+        root->red = false;
+    }
+
+    void erase(FairEntity* node) {
+        if (node == leftmostNode) leftmostNode = successor(node);
+        FairEntity* child;
+        FairEntity* childParent;
+        bool removedRed;
+        if (!node->left || !node->right) {
+            child = node->left ? node->left : node->right;
+            childParent = node->parent;
+            removedRed = node->red;
+            transplant(node, child);
+        } else {
+            FairEntity* next = node->right;
+            while (next->left) next = next->left;
+            removedRed = next->red;
+            child = next->right;
+            if (next->parent == node) {
+                childParent = next;
+            } else {
+                childParent = next->parent;
+                transplant(next, next->right);
+                next->right = node->right;
+                next->right->parent = next;
+            }
+            transplant(node, next);
+            next->left = node->left;
+            next->left->parent = next;
+            next->red = node->red;
+        }
+        if (!removedRed) eraseFixup(child, childParent);
+        node->parent = node->left = node->right = nullptr;
+    }
+
+    // node is null or black and one black short; parent is its parent
+    void eraseFixup(FairEntity* node, FairEntity* parent) {
+        while (node != root && (!node || !node->red)) {
+            if (node == parent->left) {
+                FairEntity* sibling = parent->right;
+                if (sibling->red) {
+                    sibling->red = false;
+                    parent->red = true;
+                    rotateLeft(parent);
+                    sibling = parent->right;
+                }
+                if (isBlack(sibling->left) && isBlack(sibling->right)) {
+                    sibling->red = true;
+                    node = parent;
+                    parent = node->parent;
+                    continue;
+                }
+                if (isBlack(sibling->right)) {
+                    sibling->left->red = false;
+                    sibling->red = true;
+                    rotateRight(sibling);
+                    sibling = parent->right;
+                }
+                sibling->red = parent->red;
+                parent->red = false;
+                sibling->right->red = false;
+                rotateLeft(parent);
+            } else {
+                FairEntity* sibling = parent->left;
+                if (sibling->red) {
+                    sibling->red = false;
+                    parent->red = true;
+                    rotateRight(parent);
+                    sibling = parent->left;
+                }
+                if (isBlack(sibling->left) && isBlack(sibling->right)) {
+                    sibling->red = true;
+                    node = parent;
+                    parent = node->parent;
+                    continue;
+                }
+                if (isBlack(sibling->left)) {
+                    sibling->right->red = false;
+                    sibling->red = true;
+                    rotateLeft(sibling);
+                    sibling = parent->left;
+                }
+                sibling->red = parent->red;
+                parent->red = false;
+                sibling->left->red = false;
+                rotateRight(parent);
+            }
+            node = root;
+        }
+        if (node) node->red = false;
+    }
+
+    static bool isBlack(const FairEntity* node) { return !node || !node->red; }
+
+    static FairEntity* successor(FairEntity* node) {
+        if (node->right) {
+            node = node->right;
+            while (node->left) node = node->left;
+            return node;
+        }
+        while (node->parent && node == node->parent->right) node = node->parent;
+        return node->parent;
+    }
+
+    void replaceChild(FairEntity* parent, FairEntity* old, FairEntity* replacement) {
+        if (!parent) {
+            root = replacement;
+        } else if (parent->left == old) {
+            parent->left = replacement;
+        } else {
+            parent->right = replacement;
+        }
+    }
+
+    void transplant(FairEntity* old, FairEntity* replacement) {
+        replaceChild(old->parent, old, replacement);
+        if (replacement) replacement->parent = old->parent;
+    }
+
+    void rotateLeft(FairEntity* node) {
+        FairEntity* pivot = node->right;
+        node->right = pivot->left;
+        if (pivot->left) pivot->left->parent = node;
+        pivot->parent = node->parent;
+        replaceChild(node->parent, node, pivot);
+        pivot->left = node;
+        node->parent = pivot;
+    }
+
+    void rotateRight(FairEntity* node) {
+        FairEntity* pivot = node->left;
+        node->left = pivot->right;
+        if (pivot->right) pivot->right->parent = node;
+        pivot->parent = node->parent;
+        replaceChild(node->parent, node, pivot);
+        pivot->right = node;
+        node->parent = pivot;
+    }
+
+    const uint64_t latency;
+    const uint64_t minGranularity;
+    const uint64_t wakeupGranularity;
+
+    FairEntity* root = nullptr;
+    FairEntity* leftmostNode = nullptr;
+    FairEntity* running = nullptr;
+    size_t queued = 0;        // In the tree, not counting running
+    uint64_t totalWeight = 0; // Queued and running
+    uint64_t floor = 0;       // min vruntime
+};
+
+} // namespace Kernel
+
+#endif
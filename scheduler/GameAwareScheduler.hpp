@@ -1,3 +1,5 @@
+#include "DeadlineRunQueue.hpp"
+#include "CpuTopology.hpp"
 
             class GameProcess {
             public:
@@ -29,6 +31,8 @@
                 std::string gameThreadPriority;
                 int ioLatencyTarget;
                 std::vector memoryPool;
+                Kernel::CpuTopology topology;
+                Kernel::ThreadPlacement placement;
 
                 struct GameProfile {
                     std::string gameName;
@@ -37,6 +41,11 @@
                     bool useGPUBoost;
                     float cpuAllocation;
                     std::vector requiredServices;
+                    // Deadline-class reservations for the game's frame-paced
+                    // threads, registered per thread by reserveFramePacing
+                    // instead of boosting their priority
+                    Kernel::DeadlineParams renderFrame;
+                    Kernel::DeadlineParams audioBuffer;
                 };
 
                 bool isGameProcess(const std::string& processName) {
@@ -44,7 +53,9 @@
                 }
 
             public:
-                GameAwareScheduler() : gameThreadPriority("HIGH"), ioLatencyTarget(1) {
+                GameAwareScheduler()
+                    : gameThreadPriority("HIGH"), ioLatencyTarget(1),
+                      topology(Kernel::CpuTopology::detect()), placement(topology) {
                     knownGameExecutables.insert("TS4_x64.exe");
                     knownGameExecutables.insert("Sims4.exe");
                     knownGameExecutables.insert("GTA5.exe");
@@ -96,13 +107,9 @@
                                     if (threadHandle) {
                                         SetThreadPriority(threadHandle, THREAD_PRIORITY_HIGHEST);
                                         
-                                        SYSTEM_INFO sysInfo;
-                                        GetSystemInfo(&sysInfo);
-                                        
-                                        DWORD_PTR affinityMask = 0;
-                                        for(DWORD i = 0; i < sysInfo.dwNumberOfProcessors/2; i++) {
-                                            affinityMask |= (1ULL << i);
-                                        }
+                                        // Keep the game's threads in one last-level cache
+                                        DWORD_PTR affinityMask = static_cast<DWORD_PTR>(Kernel::ThreadPlacement::affinityMask(
+                                            topology.llcCpus(placement.preferredLlc())));
                                         
                                         SetThreadAffinityMask(threadHandle, affinityMask);
                                         
@@ -234,6 +241,29 @@
                     latencyOpt.optimize();
                 }
 
+                // Gives a game's render and audio threads their own deadline
+                // reservations from its profile. reserve(threadId, params) is
+                // EnhancedScheduler::setThreadDeadline; the ids come from its
+                // createThread. Both must be admitted: a render reservation
+                // without the audio one is released again.
+                template<typename Reserve, typename Release>
+                bool reserveFramePacing(const std::string& gameName, uint32_t renderThread,
+                                        uint32_t audioThread, Reserve&& reserve, Release&& release) {
+                    auto it = gameProfiles.find(gameName);
+                    if (it == gameProfiles.end()) {
+                        it = gameProfiles.emplace(gameName, createDefaultProfile(gameName)).first;
+                    }
+                    const GameProfile& profile = it->second;
+                    if (reserve(renderThread, profile.renderFrame) != Kernel::Admission::Admitted) {
+                        return false;
+                    }
+                    if (reserve(audioThread, profile.audioBuffer) != Kernel::Admission::Admitted) {
+                        release(renderThread);
+                        return false;
+                    }
+                    return true;
+                }
+
             private:
                 GameProfile createDefaultProfile(const std::string& gameName) {
                     GameProfile profile;
@@ -242,6 +272,8 @@
                     profile.reservedMemory = 4ULL * 1024 * 1024 * 1024; // 4GB default reservation
                     profile.useGPUBoost = true;
                     profile.cpuAllocation = 0.75f; // 75% CPU allocation
+                    profile.renderFrame = {10000000, 16666667, 16666667}; // 10 ms of each 60 fps frame
+                    profile.audioBuffer = {1000000, 5000000, 5000000};    // 1 ms per 5 ms buffer
                     
                     // Add required services
                     profile.requiredServices = {
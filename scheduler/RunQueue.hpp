@@ -0,0 +1,281 @@
+#ifndef RUN_QUEUE_HPP
+#define RUN_QUEUE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Kernel {
+
+constexpr size_t RUNQUEUE_LEVELS = 64;
+
+// Scheduling state embedded in each thread, so queueing never allocates
+struct SchedEntity {
+    uint32_t id = 0;
+    uint8_t level = 0;   // 0..RUNQUEUE_LEVELS-1, higher runs first
+    int queuedOn = -1;   // CPU whose queue holds it, -1 when not queued
+    int lastCpu = -1;    // Where it last ran, for cache affinity
+    SchedEntity* next = nullptr;
+    SchedEntity* prev = nullptr;
+};
+
+// One CPU's runnable threads: a FIFO per priority level and a bitmap of
+// non-empty levels, so enqueue, dequeue and pick-next are all O(1).
+class CpuRunQueue {
+public:
+    void enqueue(SchedEntity* entity, int cpu) {
+        Level& level = levels[entity->level];
+        entity->next = nullptr;
+        entity->prev = level.tail;
+        if (level.tail) {
+            level.tail->next = entity;
+        } else {
+            level.head = entity;
+            occupied |= 1ULL << entity->level;
+        }
+        level.tail = entity;
+        entity->queuedOn = cpu;
+        queued.store(queued.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void remove(SchedEntity* entity) {
+        Level& level = levels[entity->level];
+        (entity->prev ? entity->prev->next : level.head) = entity->next;
+        (entity->next ? entity->next->prev : level.tail) = entity->prev;
+        if (!level.head) occupied &= ~(1ULL << entity->level);
+        entity->next = entity->prev = nullptr;
+        entity->queuedOn = -1;
+        queued.store(queued.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+
+    // Longest-waiting thread of the highest non-empty level
+    SchedEntity* peek() const {
+        if (!occupied) return nullptr;
+        return levels[63 - __builtin_clzll(occupied)].head;
+    }
+
+    SchedEntity* pickNext() {
+        SchedEntity* entity = peek();
+        if (entity) remove(entity);
+        return entity;
+    }
+
+    int highestLevel() const { return occupied ? 63 - __builtin_clzll(occupied) : -1; }
+
+    // Racy snapshot for load balancing; exact under lock()
+    size_t size() const { return queued.load(std::memory_order_relaxed); }
+
+    void lock() {
+        while (locked.exchange(true, std::memory_order_acquire)) {
+            while (locked.load(std::memory_order_relaxed)) std::this_thread::yield();
+        }
+    }
+
+    bool tryLock() { return !locked.exchange(true, std::memory_order_acquire); }
+
+    void unlock() { locked.store(false, std::memory_order_release); }
+
+private:
+    struct Level {
+        SchedEntity* head = nullptr;
+        SchedEntity* tail = nullptr;
+    };
+
+    std::array<Level, RUNQUEUE_LEVELS> levels{};
+    uint64_t occupied = 0;
+    std::atomic<size_t> queued{0};
+    std::atomic<bool> locked{false};
+};
+
+// Per-CPU run queues with wake-up placement and idle-time work stealing.
+// CPUs sharing a last-level cache form a domain: a waking thread goes
+// back to its previous CPU, or to an idle CPU in the same domain, and an
+// idle CPU steals from the busiest queue in its own domain before
+// looking further away.
+class RunQueueSet {
+public:
+    struct Stats {
+        uint64_t localPicks = 0;
+        uint64_t steals = 0;       // Within the last-level cache domain
+        uint64_t remoteSteals = 0; // Across domains
+        uint64_t failedSteals = 0;
+    };
+
+    // llcOfCpu entry of a CPU id that is not online: it keeps its slot so
+    // ids still index the set, but is in no domain and never chosen
+    static constexpr uint32_t OFFLINE = UINT32_MAX;
+
+    // llcOfCpu[cpu] names each CPU's last-level cache domain, or OFFLINE
+    explicit RunQueueSet(std::vector<uint32_t> llcOfCpu)
+        : llcOfCpu(std::move(llcOfCpu)), queues(new Cpu[this->llcOfCpu.size()]) {
+        uint32_t domains = 0;
+        for (uint32_t llc : this->llcOfCpu) {
+            if (llc != OFFLINE) domains = std::max(domains, llc + 1);
+        }
+        domainCpus.resize(domains);
+        for (size_t cpu = 0; cpu < this->llcOfCpu.size(); cpu++) {
+            if (this->llcOfCpu[cpu] == OFFLINE) continue;
+            if (firstOnline < 0) firstOnline = static_cast<int>(cpu);
+            domainCpus[this->llcOfCpu[cpu]].push_back(static_cast<int>(cpu));
+        }
+    }
+
+    // Uniform domains of cpusPerLlc consecutive CPUs
+    RunQueueSet(size_t cpus, size_t cpusPerLlc) : RunQueueSet(uniformDomains(cpus, cpusPerLlc)) {}
+
+    RunQueueSet(const RunQueueSet&) = delete;
+    RunQueueSet& operator=(const RunQueueSet&) = delete;
+
+    size_t cpuCount() const { return llcOfCpu.size(); }
+    uint32_t llcOf(int cpu) const { return llcOfCpu[cpu]; }
+    bool isOnline(int cpu) const { return cpu >= 0 && size_t(cpu) < cpuCount() && llcOfCpu[cpu] != OFFLINE; }
+
+    // Wake-up placement: the previous CPU if idle, else an idle CPU
+    // sharing its cache, else the least loaded CPU sharing its cache.
+    // Never crosses a cache domain; stealing evens out the domains.
+    int selectCpu(const SchedEntity& entity) const {
+        int previous = isOnline(entity.lastCpu) ? entity.lastCpu : std::max(firstOnline, 0);
+        if (isIdle(previous)) return previous;
+        int best = previous;
+        size_t bestLoad = load(previous);
+        for (int cpu : domainCpus[llcOfCpu[previous]]) {
+            if (isIdle(cpu)) return cpu;
+            size_t cpuLoad = load(cpu);
+            if (cpuLoad < bestLoad) {
+                best = cpu;
+                bestLoad = cpuLoad;
+            }
+        }
+        return best;
+    }
+
+    void enqueue(SchedEntity* entity, int cpu) {
+        CpuRunQueue& queue = queues[cpu].queue;
+        queue.lock();
+        queue.enqueue(entity, cpu);
+        queue.unlock();
+    }
+
+    // Takes a queued thread off whichever queue holds it. Returns false
+    // if it was not queued (already picked).
+    bool dequeue(SchedEntity* entity) {
+        for (;;) {
+            int cpu = entity->queuedOn;
+            if (cpu < 0) return false;
+            CpuRunQueue& queue = queues[cpu].queue;
+            queue.lock();
+            if (entity->queuedOn == cpu) {
+                queue.remove(entity);
+                queue.unlock();
+                return true;
+            }
+            queue.unlock(); // Stolen meanwhile; follow it
+        }
+    }
+
+    // The next thread for cpu, stealing when its own queue is empty. A
+    // null result marks the CPU idle until something is picked again.
+    SchedEntity* pickNext(int cpu) {
+        Cpu& self = queues[cpu];
+        self.queue.lock();
+        SchedEntity* entity = self.queue.pickNext();
+        self.queue.unlock();
+        if (entity) {
+            self.stats.localPicks++;
+        } else {
+            entity = steal(cpu);
+        }
+        self.idle.store(entity == nullptr, std::memory_order_relaxed);
+        if (entity) entity->lastCpu = cpu;
+        return entity;
+    }
+
+    // Highest level waiting on cpu's queue, -1 if none; for preemption
+    int highestWaitingLevel(int cpu) {
+        CpuRunQueue& queue = queues[cpu].queue;
+        queue.lock();
+        int level = queue.highestLevel();
+        queue.unlock();
+        return level;
+    }
+
+    void setIdle(int cpu, bool idle) { queues[cpu].idle.store(idle, std::memory_order_relaxed); }
+    bool isIdle(int cpu) const { return queues[cpu].idle.load(std::memory_order_relaxed) && load(cpu) == 0; }
+    size_t load(int cpu) const { return queues[cpu].queue.size(); }
+
+    Stats getStats() const {
+        Stats total;
+        for (size_t cpu = 0; cpu < cpuCount(); cpu++) {
+            const Stats& stats = queues[cpu].stats;
+            total.localPicks += stats.localPicks;
+            total.steals += stats.steals;
+            total.remoteSteals += stats.remoteSteals;
+            total.failedSteals += stats.failedSteals;
+        }
+        return total;
+    }
+
+private:
+    struct Cpu {
+        CpuRunQueue queue;
+        std::atomic<bool> idle{true};
+        Stats stats; // Written only by the owning CPU
+    };
+
+    static std::vector<uint32_t> uniformDomains(size_t cpus, size_t cpusPerLlc) {
+        std::vector<uint32_t> llcs(cpus);
+        for (size_t cpu = 0; cpu < cpus; cpu++) llcs[cpu] = static_cast<uint32_t>(cpu / std::max<size_t>(cpusPerLlc, 1));
+        return llcs;
+    }
+
+    // Busiest queue in the thief's domain first, then in the others
+    SchedEntity* steal(int thief) {
+        Stats& stats = queues[thief].stats;
+        uint32_t home = llcOfCpu[thief];
+        if (SchedEntity* entity = stealFrom(domainCpus[home], thief)) {
+            stats.steals++;
+            return entity;
+        }
+        for (uint32_t offset = 1; offset < domainCpus.size(); offset++) {
+            uint32_t domain = (home + offset) % domainCpus.size();
+            if (SchedEntity* entity = stealFrom(domainCpus[domain], thief)) {
+                stats.remoteSteals++;
+                return entity;
+            }
+        }
+        stats.failedSteals++;
+        return nullptr;
+    }
+
+    SchedEntity* stealFrom(const std::vector<int>& cpus, int thief) {
+        int victim = -1;
+        size_t victimLoad = 0;
+        for (int cpu : cpus) {
+            size_t cpuLoad = load(cpu);
+            if (cpu != thief && cpuLoad > victimLoad) {
+                victim = cpu;
+                victimLoad = cpuLoad;
+            }
+        }
+        if (victim < 0) return nullptr;
+        CpuRunQueue& queue = queues[victim].queue;
+        if (!queue.tryLock()) return nullptr; // Contended: the owner is busy with it
+        SchedEntity* entity = queue.pickNext();
+        queue.unlock();
+        return entity;
+    }
+
+    const std::vector<uint32_t> llcOfCpu;
+    std::vector<std::vector<int>> domainCpus; // Online CPUs only
+    int firstOnline = -1;
+    std::unique_ptr<Cpu[]> queues;
+};
+
+} // namespace Kernel
+
+#endif
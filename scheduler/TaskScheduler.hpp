@@ -5,6 +5,7 @@
 #include 
 #include 
 #include 
+#include "CpuTopology.hpp"
 
 namespace Kernel {
 
@@ -63,7 +64,8 @@ public:
         m_priorityManager.setBackgroundProcessPriority(LOW);
         
         // Optimize render threads
-        m_renderThreadPool.setThreadCount(8);
+        // One render thread per physical core; SMT siblings add little
+        m_renderThreadPool.setThreadCount(static_cast<int>(CpuTopology::detect().coreCount()));
         m_renderThreadPool.setThreadPriority(HIGH);
         
         // IO optimization
@@ -1,4 +1,7 @@
 #include "kernel/scheduler/scheduler.hpp"
+#include "kernel/scheduler/RunQueue.hpp"
+#include "kernel/scheduler/DeadlineRunQueue.hpp"
+#include "kernel/scheduler/CpuTopology.hpp"
 #include "kernel/loggin/EventLogger.hpp"
 #include "kernel/process/process.hpp"
 #include "kernel/interrupt/InterruptManager.hpp"
@@ -10,25 +13,36 @@ private:
     static constexpr size_t MAX_PROCESSES = 1024;
     static constexpr size_t MAX_THREADS = 256;
     static constexpr size_t TIME_SLICE = 1; // ms
+    static constexpr size_t MAX_CPUS = 128;
     
     struct ThreadContext {
         uint64_t priority;
         uint64_t cpuTime;
-        bool isGameThread;
         std::atomic isActive;
         ProcessContext* processContext;
+        Process* process;   // Owner, so dispatch needs no search
+        SchedEntity entity; // entity.id indexes threads
+        DeadlineEntity deadline;
+        int deadlineCpu;    // CPU whose deadline class holds it, -1 if none
+    };
+
+    struct DeadlineCpu {
+        DeadlineRunQueue queue;
+        std::mutex lock;
     };
 
     std::array threads;
     std::atomic activeThreadCount{0};
-    std::vector> processes;
-    std::queue readyQueue;
-    Process* currentProcess;
-    ThreadContext* currentThread;
+    std::vector> processes; // processes[pid - 1]
+    std::unique_ptr<RunQueueSet> runQueues;
+    std::unique_ptr<DeadlineCpu[]> deadlineQueues;         // One per CPU, ahead of runQueues
+    std::array<ThreadContext*, MAX_CPUS> currentThreads{}; // Running thread per CPU
     State state;
 
 public:
-    EnhancedScheduler() : currentProcess(nullptr), state(State::STOPPED) {}
+    static constexpr uint32_t INVALID_THREAD = UINT32_MAX;
+
+    EnhancedScheduler() : state(State::STOPPED) {}
     
     ~EnhancedScheduler() {
         stop();
@@ -43,7 +57,13 @@ public:
         EventLogger::log("Initializing enhanced scheduler...");
         processes.reserve(MAX_PROCESSES);
         setupTimerInterrupt();
-        readyQueue = std::queue();
+        // Steal domains follow the real last-level caches
+        std::vector<uint32_t> llcOfCpu = CpuTopology::detect().llcOfCpus();
+        if (llcOfCpu.empty()) llcOfCpu.push_back(0);
+        if (llcOfCpu.size() > MAX_CPUS) llcOfCpu.resize(MAX_CPUS);
+        size_t cpus = llcOfCpu.size();
+        runQueues = std::make_unique<RunQueueSet>(std::move(llcOfCpu));
+        deadlineQueues.reset(new DeadlineCpu[cpus]);
         setupPriorities();
         state = State::STOPPED;
         EventLogger::log("Enhanced scheduler initialized successfully");
@@ -69,91 +89,226 @@ public:
             return 0;
         }
         
+        if(activeThreadCount >= MAX_THREADS) {
+            EventLogger::log("Error: Maximum thread limit reached");
+            return 0;
+        }
+        
         ProcessID pid = processes.size() + 1;
         auto process = std::make_unique(pid, entryPoint, priority);
         process->setState(Process::State::READY);
         
         // Create main thread for process
-        ThreadContext& thread = threads[activeThreadCount++];
-        thread.priority = priority;
-        thread.cpuTime = 0;
-        thread.isGameThread = (priority > 10); // Assume high priority = game thread
-        thread.isActive = true;
-        thread.processContext = process->getContext();
-        
-        readyQueue.push(process.get());
+        Process* owner = process.get();
         processes.push_back(std::move(process));
+        addThread(owner, priority);
         
         return pid;
     }
 
+    // Adds a thread to a process; returns its id for setThreadDeadline,
+    // or INVALID_THREAD. A game's render and audio threads each get one,
+    // so each can hold its own deadline reservation.
+    uint32_t createThread(ProcessID pid, uint32_t priority) {
+        if(pid == 0 || pid > processes.size() || activeThreadCount >= MAX_THREADS) {
+            return INVALID_THREAD;
+        }
+        return addThread(processes[pid - 1].get(), priority).entity.id;
+    }
+
     void terminateProcess(ProcessID pid) {
-        for(auto& process : processes) {
-            if(process->getID() == pid) {
-                process->setState(Process::State::TERMINATED);
-                // Clean up associated threads
-                for(size_t i = 0; i < activeThreadCount; i++) {
-                    if(threads[i].processContext == process->getContext()) {
-                        threads[i].isActive = false;
-                    }
+        if(pid == 0 || pid > processes.size()) return;
+        Process* process = processes[pid - 1].get();
+        process->setState(Process::State::TERMINATED);
+        // Clean up associated threads; a running one leaves at its next tick
+        for(size_t i = 0; i < activeThreadCount; i++) {
+            if(threads[i].process == process) {
+                threads[i].isActive = false;
+                runQueues->dequeue(&threads[i].entity);
+                if(threads[i].deadlineCpu >= 0) {
+                    DeadlineCpu& deadlines = deadlineQueues[threads[i].deadlineCpu];
+                    std::lock_guard<std::mutex> lock(deadlines.lock);
+                    deadlines.queue.release(&threads[i].deadline, clockNs());
                 }
-                break;
             }
         }
     }
 
+    // Moves a process's main thread into the deadline class: it gets
+    // params.runtime of CPU within params.deadline of every period, ahead
+    // of all level-queued threads, for frame or audio-buffer pacing.
+    // Calling again changes the reservation. Placed on the CPU with the
+    // most unreserved bandwidth; fails if even that one cannot fit it.
+    Admission setDeadline(ProcessID pid, const DeadlineParams& params) {
+        return reserve(mainThread(pid), params);
+    }
+
+    // The same for any thread from createThread, e.g. a game's render
+    // thread with a frame reservation and its audio thread with a buffer one
+    Admission setThreadDeadline(uint32_t threadId, const DeadlineParams& params) {
+        return reserve(threadById(threadId), params);
+    }
+
+    // Returns a process's main thread to its priority level
+    void clearDeadline(ProcessID pid) {
+        release(mainThread(pid));
+    }
+
+    void clearThreadDeadline(uint32_t threadId) {
+        release(threadById(threadId));
+    }
+
+    // Runs on each CPU's timer tick. Deadline threads come first, earliest
+    // deadline first while they have budget; otherwise picks from the
+    // CPU's own queue in O(1), stealing from a busy CPU only when the
+    // queue is empty.
     void schedule() {
         if(state != State::RUNNING) return;
 
-        // Game-aware scheduling
-        ThreadContext* nextThread = nullptr;
-        uint64_t maxPriority = 0;
+        int cpu = currentCpu();
+        uint64_t now = clockNs();
+        ThreadContext* current = currentThreads[cpu];
 
-        #pragma omp parallel for reduction(max:maxPriority)
-        for(size_t i = 0; i < activeThreadCount; i++) {
-            if(threads[i].isActive) {
-                uint64_t dynamicPriority = calculateDynamicPriority(threads[i]);
-                if(dynamicPriority > maxPriority) {
-                    maxPriority = dynamicPriority;
-                    nextThread = &threads[i];
-                }
-            }
+        if(current && current->isActive && current->deadlineCpu >= 0 &&
+           current->deadline.state == DeadlineEntity::State::Blocked) {
+            // Moved into the deadline class while it ran
+            DeadlineCpu& home = deadlineQueues[current->deadlineCpu];
+            std::lock_guard<std::mutex> homeLock(home.lock);
+            home.queue.wake(&current->deadline, now);
         }
 
-        if(nextThread && nextThread != currentThread) {
-            Process* nextProcess = nullptr;
-            // Find process associated with thread
-            for(auto& process : processes) {
-                if(process->getContext() == nextThread->processContext) {
-                    nextProcess = process.get();
-                    break;
-                }
+        DeadlineCpu& deadlines = deadlineQueues[cpu];
+        std::unique_lock<std::mutex> deadlineLock(deadlines.lock);
+        bool currentOnLevels = current && current->isActive && current->deadlineCpu < 0;
+
+        if(!deadlines.queue.tickPreempts(now)) {
+            if(deadlines.queue.current()) return; // Keeps its CPU until its budget or a nearer deadline
+        } else if(DeadlineEntity* next = deadlines.queue.pickNext(now)) {
+            deadlineLock.unlock();
+            if(currentOnLevels) runQueues->enqueue(&current->entity, cpu);
+            switchTo(cpu, current, &threads[next->id]);
+            return;
+        }
+        deadlineLock.unlock();
+
+        // Keep running unless a thread of at least equal level waits here
+        if(currentOnLevels && runQueues->highestWaitingLevel(cpu) < current->entity.level) return;
+
+        SchedEntity* next = runQueues->pickNext(cpu);
+        if(!next) {
+            if(!currentOnLevels) currentThreads[cpu] = nullptr;
+            return;
+        }
+        if(currentOnLevels) {
+            runQueues->enqueue(&current->entity, cpu); // Round robin within its level
+        }
+        switchTo(cpu, current, &threads[next->id]);
+    }
+
+private:
+    // Run queue level. Frame-paced threads register with setDeadline
+    // rather than being guessed from their priority and boosted. Round
+    // robin within a level replaces the old cpuTime fairness term.
+    static uint8_t levelFor(const ThreadContext& thread) {
+        return static_cast<uint8_t>(std::min<uint64_t>(thread.priority, RUNQUEUE_LEVELS - 1));
+    }
+
+    void switchTo(int cpu, ThreadContext* current, ThreadContext* nextThread) {
+        bool currentRunnable = current && current->isActive;
+        Process* currentProcess = current ? current->process : nullptr;
+        Process* nextProcess = nextThread->process;
+        currentThreads[cpu] = nextThread;
+
+        if(nextProcess != currentProcess) {
+            if(currentProcess && currentRunnable) {
+                saveProcess(currentProcess);
+                currentProcess->setState(Process::State::READY);
             }
+            loadProcess(nextProcess);
+            nextProcess->setState(Process::State::RUNNING);
+        }
+    }
 
-            if(nextProcess && nextProcess != currentProcess) {
-                if(currentProcess) {
-                    saveProcess(currentProcess);
-                    currentProcess->setState(Process::State::READY);
-                    readyQueue.push(currentProcess);
-                }
-                
-                loadProcess(nextProcess);
-                currentProcess = nextProcess;
-                currentThread = nextThread;
-                currentProcess->setState(Process::State::RUNNING);
+    ThreadContext& addThread(Process* process, uint32_t priority) {
+        size_t index = activeThreadCount++;
+        ThreadContext& thread = threads[index];
+        thread.priority = priority;
+        thread.cpuTime = 0;
+        thread.isActive = true;
+        thread.processContext = process->getContext();
+        thread.process = process;
+        thread.entity = SchedEntity{};
+        thread.entity.id = static_cast<uint32_t>(index);
+        thread.entity.level = levelFor(thread);
+        thread.deadline = DeadlineEntity{};
+        thread.deadline.id = static_cast<uint32_t>(index);
+        thread.deadlineCpu = -1;
+        runQueues->enqueue(&thread.entity, runQueues->selectCpu(thread.entity));
+        return thread;
+    }
+
+    Admission reserve(ThreadContext* thread, const DeadlineParams& params) {
+        if(!thread) return Admission::InvalidParameters;
+
+        int cpu = thread->deadlineCpu;
+        if(cpu < 0) {
+            // Offline CPUs have all their bandwidth spare but never run it
+            for(size_t i = 0; i < runQueues->cpuCount(); i++) {
+                if(!runQueues->isOnline(static_cast<int>(i))) continue;
+                if(cpu < 0 || deadlineQueues[i].queue.spareBandwidth() > deadlineQueues[cpu].queue.spareBandwidth()) cpu = static_cast<int>(i);
             }
+            if(cpu < 0) return Admission::OverCapacity; // No CPU online to hold it
         }
+        DeadlineCpu& deadlines = deadlineQueues[cpu];
+        std::lock_guard<std::mutex> lock(deadlines.lock);
+        Admission admission = deadlines.queue.admit(&thread->deadline, params);
+        if(admission != Admission::Admitted || thread->deadlineCpu >= 0) return admission;
+
+        thread->deadlineCpu = cpu;
+        // A running thread moves over when its CPU next schedules
+        if(runQueues->dequeue(&thread->entity)) deadlines.queue.wake(&thread->deadline, clockNs());
+        return admission;
     }
 
-private:
-    uint64_t calculateDynamicPriority(const ThreadContext& thread) {
-        uint64_t priority = thread.priority;
-        if(thread.isGameThread) {
-            priority *= 2;  // Boost game threads
+    void release(ThreadContext* thread) {
+        if(!thread || thread->deadlineCpu < 0) return;
+        DeadlineCpu& deadlines = deadlineQueues[thread->deadlineCpu];
+        bool wasQueued;
+        {
+            std::lock_guard<std::mutex> lock(deadlines.lock);
+            wasQueued = thread->deadline.state != DeadlineEntity::State::Blocked &&
+                        deadlines.queue.current() != &thread->deadline;
+            deadlines.queue.release(&thread->deadline, clockNs());
         }
-        // Add CPU fairness factor
-        priority += (1000000 / (thread.cpuTime + 1));
-        return priority;
+        thread->deadlineCpu = -1;
+        if(wasQueued) runQueues->enqueue(&thread->entity, runQueues->selectCpu(thread->entity));
+    }
+
+    ThreadContext* threadById(uint32_t threadId) {
+        if(threadId >= activeThreadCount || !threads[threadId].isActive) return nullptr;
+        return &threads[threadId];
+    }
+
+    ThreadContext* mainThread(ProcessID pid) {
+        if(pid == 0 || pid > processes.size()) return nullptr;
+        Process* process = processes[pid - 1].get();
+        for(size_t i = 0; i < activeThreadCount; i++) {
+            if(threads[i].process == process && threads[i].isActive) return &threads[i];
+        }
+        return nullptr;
+    }
+
+    static uint64_t clockNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int currentCpu() const {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        if(cpu >= 0) return cpu % static_cast<int>(runQueues->cpuCount());
+#endif
+        return 0;
     }
 
     void setupTimerInterrupt() {
@@ -1,9 +1,11 @@
+#include "FairRunQueue.hpp"
+
 class ProcessScheduler {
 private:
-    struct Process {
+    // vruntime, weight and run queue links live in the FairEntity base
+    struct Process : Kernel::FairEntity {
         pid_t pid;
-        uint32_t priority;
-        std::chrono::nanoseconds vruntime;
+        uint32_t priority; // nice + 20, as in the kernel's static priorities
         ProcessState state;
         List<Task*> tasks;
     };
@@ -11,8 +13,14 @@ private:
     // Enhanced CFS++ Implementation
     class CFSPlusPlus {
     private:
-        RedBlackTree<Process> runqueue;
+        Kernel::FairRunQueue runqueue;
         Timer* scheduler_timer;
+        bool need_resched = false;
+        
+        static uint64_t now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
         
     public:
         void initialize() {
@@ -20,20 +28,34 @@ private:
             scheduler_timer->set_callback([this]() { this->updateStats(); });
         }
         
+        // Puts the running process back and takes the leftmost, O(log n)
         Process* pickNext() {
-            return runqueue.leftmost(); // Most deserving process
+            need_resched = false;
+            return static_cast<Process*>(runqueue.pickNext(now()));
         }
         
+        // Only the running process accrues vruntime; queued ones are untouched
         void updateStats() {
-            for(auto& proc : runqueue) {
-                proc.vruntime += calculateDelta(proc);
-            }
+            if(runqueue.tickPreempts(now())) need_resched = true;
+        }
+        
+        bool needsReschedule() const { return need_resched; }
+        
+        void enqueue(Process* proc, Kernel::FairRunQueue::Placement placement) {
+            runqueue.enqueue(proc, now(), placement);
+            if(runqueue.wakeupPreempts(*proc)) need_resched = true;
+        }
+        
+        // Blocks the running process or pulls a queued one
+        void dequeue(Process* proc) {
+            runqueue.dequeue(proc, now());
         }
         
         void addTask(Process* proc, void (*entry_point)(), uint32_t priority) {
             Task* task = new Task(entry_point, priority);
             proc->tasks.push_back(task);
             updateProcessPriority(proc);
+            runqueue.reweight(proc, Kernel::weightForNice(static_cast<int>(proc->priority) + Kernel::NICE_MIN), now());
         }
     };
 
@@ -72,7 +94,6 @@ private:
     CFSPlusPlus cfs;
     IPCManager ipc;
     Process* current_process;
-    List ready_queue;
 
 public:
     void initialize() {
@@ -81,15 +102,16 @@ public:
 
     void schedule() {
         auto* next = cfs.pickNext();
-        if(next) {
+        if(next && next != current_process) {
             contextSwitch(current_process, next);
+            current_process = next;
         }
     }
     
+    // Gives up the CPU but stays runnable: the tree decides whether it runs on
     void yield() {
         auto* current = getCurrentProcess();
         current->state = READY;
-        ready_queue.push_back(current);
         schedule();
     }
     
@@ -98,13 +120,16 @@ public:
         cfs.addTask(current, entry_point, priority);
     }
     
+    // Leaves the run queue; on waking it gets bounded sleeper credit, and
+    // preempts if that puts it far enough ahead of the running process
     void sleep(std::chrono::milliseconds duration) {
         auto* current = getCurrentProcess();
         current->state = SLEEPING;
+        cfs.dequeue(current);
         setTimer(duration, [this, current]() {
             current->state = READY;
-            ready_queue.push_back(current);
+            cfs.enqueue(current, Kernel::FairRunQueue::Placement::Wakeup);
         });
-        yield();
+        schedule();
     }
 };
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "../../gtest/gtest.h"
+#include "../../filesystem/CompressionManager.hpp"
+#include <cstddef>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace Kernel {
+namespace FileSystem {
+namespace Test {
+
+// Framed format checks: frames are compressed on a private pool so the
+// parallel path runs even on a single-CPU machine
+class CompressionManagerTest : public ::testing::Test {
+protected:
+    using Codec = CompressionManager::Codec;
+    static constexpr size_t FRAME = CompressionManager::FRAME_SIZE;
+
+    // Text-like runs with random bytes mixed in, so every codec has work
+    static std::vector<char> asset(size_t size, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<char> data(size);
+        for (size_t i = 0; i < size; i++) {
+            data[i] = rng() % 4 == 0 ? static_cast<char>(rng()) : "vertex normal uv "[i % 17];
+        }
+        return data;
+    }
+
+    CompressionManager::FrameIndex indexOf(const std::vector<char>& framed) {
+        CompressionManager::FrameIndex index;
+        EXPECT_TRUE(CompressionManager::parseIndex(framed.data(), framed.size(), framed.size(), index));
+        return index;
+    }
+
+    template<typename T>
+    static void poke(std::vector<char>& framed, size_t offset, T value) {
+        std::memcpy(framed.data() + offset, &value, sizeof(value));
+    }
+
+    WorkerPool pool{3};
+    CompressionManager manager{100.0, 4, pool};
+};
+
+TEST_F(CompressionManagerTest, RoundTripsAcrossFrameBoundaries) {
+    for (Codec codec : {Codec::Stored, Codec::Fast, Codec::Zlib}) {
+        for (size_t size : {size_t(0), size_t(1), FRAME - 1, FRAME, FRAME + 1, 3 * FRAME + 17}) {
+            SCOPED_TRACE(testing::Message() << "codec " << int(codec) << " size " << size);
+            auto data = asset(size, static_cast<uint32_t>(size));
+            auto framed = manager.compress(data, codec, 1);
+            ASSERT_TRUE(CompressionManager::isFramed(framed));
+            EXPECT_EQ(indexOf(framed).frames.size(), (size + FRAME - 1) / FRAME);
+
+            std::vector<char> restored;
+            ASSERT_TRUE(manager.decompressFramed(framed, restored));
+            EXPECT_EQ(restored, data);
+            EXPECT_EQ(manager.decompress(framed), data);
+
+            // Ranges straddling each frame boundary
+            for (size_t boundary = FRAME; boundary < size; boundary += FRAME) {
+                auto range = manager.decompressRange(framed, boundary - 10, 20);
+                EXPECT_EQ(range, std::vector<char>(data.begin() + (boundary - 10),
+                                                   data.begin() + std::min(size, boundary + 10)));
+            }
+        }
+    }
+}
+
+TEST_F(CompressionManagerTest, RangeReadsOnlyTouchOverlappingFrames) {
+    auto data = asset(4 * FRAME, 7);
+    auto framed = manager.compress(data, Codec::Zlib, 6);
+
+    uint64_t before = manager.getFramesDecompressed();
+    auto range = manager.decompressRange(framed, 2 * FRAME - 100, 200);
+    EXPECT_EQ(manager.getFramesDecompressed() - before, 2u);
+    EXPECT_EQ(range, std::vector<char>(data.begin() + 2 * FRAME - 100, data.begin() + 2 * FRAME + 100));
+
+    // Past the end is clipped; at the end is empty
+    EXPECT_EQ(manager.decompressRange(framed, 4 * FRAME - 5, 100).size(), 5u);
+    EXPECT_TRUE(manager.decompressRange(framed, 4 * FRAME, 100).empty());
+}
+
+TEST_F(CompressionManagerTest, TruncatedFramesAreRejected) {
+    auto data = asset(3 * FRAME + 17, 11);
+    auto framed = manager.compress(data, Codec::Fast, 0);
+    const size_t payloadOffset = indexOf(framed).payloadOffset;
+
+    for (size_t cut : {sizeof(CompressionManager::Header) - 1, sizeof(CompressionManager::Header),
+                       payloadOffset - 1, payloadOffset, payloadOffset + 1, framed.size() / 2,
+                       framed.size() - 1}) {
+        SCOPED_TRACE(testing::Message() << "cut at " << cut);
+        std::vector<char> truncated(framed.begin(), framed.begin() + cut);
+        CompressionManager::FrameIndex index;
+        EXPECT_FALSE(CompressionManager::parseIndex(truncated.data(), truncated.size(),
+                                                    truncated.size(), index));
+        std::vector<char> restored;
+        EXPECT_FALSE(manager.decompressFramed(truncated, restored));
+    }
+}
+
+TEST_F(CompressionManagerTest, CorruptFrameHeadersAreRejected) {
+    using Header = CompressionManager::Header;
+    using FrameEntry = CompressionManager::FrameEntry;
+    auto data = asset(3 * FRAME + 17, 13);
+    const auto framed = manager.compress(data, Codec::Zlib, 6);
+    const size_t secondEntry = sizeof(Header) + sizeof(FrameEntry);
+
+    auto rejected = [&](auto&& corrupt) {
+        auto copy = framed;
+        corrupt(copy);
+        CompressionManager::FrameIndex index;
+        std::vector<char> restored;
+        return !CompressionManager::parseIndex(copy.data(), copy.size(), copy.size(), index) &&
+               !manager.decompressFramed(copy, restored);
+    };
+    EXPECT_TRUE(rejected([&](auto& f) { poke<uint32_t>(f, offsetof(Header, magic), 0x12345678); }));
+    EXPECT_TRUE(rejected([&](auto& f) { poke<uint16_t>(f, offsetof(Header, version), 2); }));
+    EXPECT_TRUE(rejected([&](auto& f) { poke<uint32_t>(f, offsetof(Header, frameSize), 0); }));
+    EXPECT_TRUE(rejected([&](auto& f) {
+        poke<uint32_t>(f, offsetof(Header, frameSize), CompressionManager::MAX_FRAME_SIZE + 1);
+    }));
+    EXPECT_TRUE(rejected([&](auto& f) { poke<uint32_t>(f, offsetof(Header, frameCount), 1000000); }));
+    EXPECT_TRUE(rejected([&](auto& f) { poke<uint64_t>(f, offsetof(Header, originalSize), 1ULL << 40); }));
+    EXPECT_TRUE(rejected([&](auto& f) {
+        poke<uint64_t>(f, secondEntry + offsetof(FrameEntry, offset), framed.size());
+    }));
+    EXPECT_TRUE(rejected([&](auto& f) {
+        poke<uint32_t>(f, secondEntry + offsetof(FrameEntry, compressedSize), 0xFFFFFFFF);
+    }));
+    EXPECT_TRUE(rejected([&](auto& f) {
+        poke<uint32_t>(f, secondEntry + offsetof(FrameEntry, originalSize), FRAME - 1);
+    }));
+
+    // A damaged payload passes the index checks but fails to decode
+    auto damaged = framed;
+    damaged[indexOf(damaged).payloadOffset + 40] ^= 0x5A;
+    std::vector<char> restored;
+    EXPECT_FALSE(manager.decompressFramed(damaged, restored));
+}
+
+} // namespace Test
+} // namespace FileSystem
+} // namespace Kernel
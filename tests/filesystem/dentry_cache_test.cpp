@@ -0,0 +1,41 @@
+#include "../../gtest/gtest.h"
+#include "../../filesystem/DentryCache.hpp"
+#include <string>
+
+namespace Kernel {
+namespace FileSystem {
+namespace Test {
+
+TEST(PathNameCacheTest, RemembersNormalizedAndRejectedSpellings) {
+    PathNameCache names;
+    EXPECT_FALSE(names.lookup("/assets//./level1.pak", 0));
+
+    names.insert("/assets//./level1.pak", "/assets/level1.pak", 0);
+    names.insert("/assets/a|b", "", 0);
+    EXPECT_EQ(names.lookup("/assets//./level1.pak", 0), "/assets/level1.pak");
+    EXPECT_EQ(names.lookup("/assets/a|b", 0), ""); // Known invalid
+
+    // A mount change moves the generation on and retires every entry
+    EXPECT_FALSE(names.lookup("/assets//./level1.pak", 1));
+    names.insert("/assets//./level1.pak", "/assets/level1.pak", 1);
+    EXPECT_EQ(names.lookup("/assets//./level1.pak", 1), "/assets/level1.pak");
+}
+
+TEST(PathNameCacheTest, StaysBoundedPerShard) {
+    PathNameCache names;
+    const size_t total = PathNameCache::SHARD_COUNT * PathNameCache::MAX_ENTRIES_PER_SHARD * 2;
+    for (size_t i = 0; i < total; i++) {
+        std::string raw = "/file" + std::to_string(i);
+        names.insert(raw, raw, 0);
+    }
+    size_t hits = 0;
+    for (size_t i = 0; i < total; i++) {
+        hits += names.lookup("/file" + std::to_string(i), 0).has_value();
+    }
+    EXPECT_LE(hits, PathNameCache::SHARD_COUNT * PathNameCache::MAX_ENTRIES_PER_SHARD);
+    EXPECT_TRUE(names.lookup("/file" + std::to_string(total - 1), 0)); // Latest insert kept
+}
+
+} // namespace Test
+} // namespace FileSystem
+} // namespace Kernel
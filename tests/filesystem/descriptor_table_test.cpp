@@ -0,0 +1,69 @@
+#include "../../gtest/gtest.h"
+#include "../../filesystem/DescriptorTable.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Kernel {
+namespace FileSystem {
+namespace Test {
+
+struct Entry {
+    std::string path;
+    int closes = 0;
+};
+
+TEST(DescriptorTableTest, TakeHandsBackTheValueOnce) {
+    DescriptorTable<Entry> table;
+    auto [id, slot] = table.allocate({"/assets/level1.pak", 0});
+    ASSERT_NE(slot, nullptr);
+
+    auto taken = table.take(id);
+    ASSERT_TRUE(taken);
+    EXPECT_EQ(taken->path, "/assets/level1.pak");
+    EXPECT_EQ(table.lookup(id), nullptr);
+    EXPECT_FALSE(table.take(id));
+    EXPECT_FALSE(table.release(id));
+    EXPECT_EQ(table.size(), 0u);
+
+    // The slot comes back under a new generation; the old id stays dead
+    auto [reused, reusedSlot] = table.allocate({"/assets/level2.pak", 0});
+    ASSERT_NE(reusedSlot, nullptr);
+    EXPECT_NE(reused, id);
+    EXPECT_FALSE(table.take(id));
+    EXPECT_EQ(table.lookup(reused)->path, "/assets/level2.pak");
+}
+
+// Every id is closed by several threads at once; exactly one of them
+// must get the value, so per-close accounting runs exactly once
+TEST(DescriptorTableTest, RacingClosesTakeEachSlotOnce) {
+    constexpr size_t DESCRIPTORS = 4096;
+    constexpr size_t CLOSERS = 4;
+    DescriptorTable<Entry> table;
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < DESCRIPTORS; i++) {
+        ids.push_back(table.allocate({"/file" + std::to_string(i), 0}).first);
+    }
+
+    std::vector<std::atomic<int>> wins(DESCRIPTORS);
+    std::vector<std::thread> closers;
+    for (size_t t = 0; t < CLOSERS; t++) {
+        closers.emplace_back([&] {
+            for (size_t i = 0; i < DESCRIPTORS; i++) {
+                if (auto entry = table.take(ids[i])) {
+                    EXPECT_EQ(entry->path, "/file" + std::to_string(i));
+                    wins[i]++;
+                }
+            }
+        });
+    }
+    for (auto& closer : closers) closer.join();
+
+    for (size_t i = 0; i < DESCRIPTORS; i++) EXPECT_EQ(wins[i].load(), 1) << "descriptor " << i;
+    EXPECT_EQ(table.size(), 0u);
+}
+
+} // namespace Test
+} // namespace FileSystem
+} // namespace Kernel
@@ -0,0 +1,38 @@
+#include "../../gtest/gtest.h"
+#include "../../filesystem/EvictionPolicy.hpp"
+#include <string>
+#include <unordered_map>
+
+namespace Kernel {
+namespace FileSystem {
+namespace Test {
+
+TEST(EvictionPolicyTest, RespectsByteBudget) {
+    for (auto type : {EvictionPolicyType::LRU, EvictionPolicyType::ARC,
+                      EvictionPolicyType::WTinyLFU}) {
+        auto policy = createEvictionPolicy(type, 1024 * 1024);
+        std::unordered_map<std::string, size_t> resident;
+        size_t usedBytes = 0;
+
+        for (size_t i = 0; i < 10000; i++) {
+            std::string key = "block/" + std::to_string(i % 700);
+            if (resident.count(key)) {
+                policy->onAccess(key);
+                continue;
+            }
+            resident.emplace(key, 4096);
+            usedBytes += 4096;
+            policy->onInsert(key, 4096);
+            std::string victim;
+            while (usedBytes > 1024 * 1024 && policy->victim(victim)) {
+                usedBytes -= resident[victim];
+                resident.erase(victim);
+            }
+            EXPECT_LE(usedBytes, 1024u * 1024u);
+        }
+    }
+}
+
+} // namespace Test
+} // namespace FileSystem
+} // namespace Kernel
@@ -0,0 +1,68 @@
+#include "../../gtest/gtest.h"
+#include "../../filesystem/PageCache.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Kernel {
+namespace FileSystem {
+namespace Test {
+
+// Switching a directory to encrypted storage drops the cached blocks of
+// every file under it and leaves other files alone
+TEST(PageCacheTest, InvalidatePrefixDropsOnlyFilesUnderRoot) {
+    PageCache cache(64 * PageCache::SMALL_BLOCK_SIZE, PageCache::SMALL_BLOCK_SIZE);
+    uint64_t secret = cache.fileId("/saves/slot1.dat");
+    uint64_t nested = cache.fileId("/saves/cloud/slot2.dat");
+    uint64_t asset = cache.fileId("/assets/level1.pak");
+    for (uint64_t file : {secret, nested, asset}) {
+        for (uint64_t block = 0; block < 4; block++) {
+            cache.insert(file, block, std::vector<char>(PageCache::SMALL_BLOCK_SIZE, 'x'));
+        }
+    }
+
+    cache.invalidatePrefix("/saves/");
+    for (uint64_t block = 0; block < 4; block++) {
+        EXPECT_FALSE(cache.contains(secret, block));
+        EXPECT_FALSE(cache.contains(nested, block));
+        EXPECT_TRUE(cache.contains(asset, block));
+    }
+    EXPECT_EQ(cache.getStats().bytesCached, 4 * PageCache::SMALL_BLOCK_SIZE);
+
+    // Ids stay interned, so reopened files keep their id
+    EXPECT_EQ(cache.fileId("/saves/slot1.dat"), secret);
+    cache.invalidatePrefix("/nothing/");
+    EXPECT_EQ(cache.getStats().bytesCached, 4 * PageCache::SMALL_BLOCK_SIZE);
+}
+
+// Blocks evicted for space reach the handler with their contents, so a
+// lower tier can keep them; invalidated blocks do not
+TEST(PageCacheTest, EvictedBlocksReachTheHandler) {
+    PageCache cache(PageCache::SHARD_COUNT * PageCache::SMALL_BLOCK_SIZE,
+                    PageCache::SMALL_BLOCK_SIZE);
+    std::map<uint64_t, char> evicted;
+    cache.setEvictionHandler([&](uint64_t file, uint64_t block, PageCache::BlockRef ref) {
+        EXPECT_EQ(file, 1u);
+        EXPECT_EQ(ref->size(), PageCache::SMALL_BLOCK_SIZE);
+        evicted[block] = ref->bytes()[0];
+    });
+
+    constexpr uint64_t BLOCKS = 4 * PageCache::SHARD_COUNT;
+    for (uint64_t block = 0; block < BLOCKS; block++) {
+        cache.insert(1, block, std::vector<char>(PageCache::SMALL_BLOCK_SIZE, char('a' + block % 26)));
+    }
+    ASSERT_FALSE(evicted.empty());
+    for (auto [block, first] : evicted) {
+        EXPECT_FALSE(cache.contains(1, block));
+        EXPECT_EQ(first, char('a' + block % 26));
+    }
+    EXPECT_EQ(evicted.size() + cache.getStats().bytesCached / PageCache::SMALL_BLOCK_SIZE, BLOCKS);
+
+    size_t before = evicted.size();
+    cache.invalidate(1);
+    EXPECT_EQ(evicted.size(), before);
+}
+
+} // namespace Test
+} // namespace FileSystem
+} // namespace Kernel
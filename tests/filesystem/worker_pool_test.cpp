@@ -0,0 +1,53 @@
+#include "../../gtest/gtest.h"
+#include "../../filesystem/WorkerPool.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Kernel {
+namespace FileSystem {
+namespace Test {
+
+TEST(WorkerPoolTest, RunsEveryIndexOnce) {
+    WorkerPool pool(3);
+    for (size_t count : {0u, 1u, 7u, 1000u}) {
+        std::vector<std::atomic<int>> runs(count);
+        pool.parallelFor(count, 4, [&](size_t i) { runs[i]++; });
+        for (size_t i = 0; i < count; i++) EXPECT_EQ(runs[i].load(), 1) << "index " << i;
+    }
+}
+
+// Without helpers, or capped at one worker, the caller does all the work
+TEST(WorkerPoolTest, SingleWorkerStaysOnTheCaller) {
+    WorkerPool empty(0);
+    WorkerPool pool(2);
+    for (WorkerPool* target : {&empty, &pool}) {
+        std::atomic<size_t> elsewhere{0};
+        auto caller = std::this_thread::get_id();
+        target->parallelFor(100, target == &pool ? 1 : 8, [&](size_t) {
+            if (std::this_thread::get_id() != caller) elsewhere++;
+        });
+        EXPECT_EQ(elsewhere.load(), 0u);
+    }
+}
+
+// Calls from inside a job, and from several threads at once, finish even
+// when every helper is busy
+TEST(WorkerPoolTest, NestedAndConcurrentCallsComplete) {
+    WorkerPool pool(2);
+    std::atomic<size_t> total{0};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; t++) {
+        callers.emplace_back([&] {
+            pool.parallelFor(8, 3, [&](size_t) {
+                pool.parallelFor(16, 3, [&](size_t) { total++; });
+            });
+        });
+    }
+    for (auto& caller : callers) caller.join();
+    EXPECT_EQ(total.load(), 4u * 8 * 16);
+}
+
+} // namespace Test
+} // namespace FileSystem
+} // namespace Kernel
@@ -0,0 +1,171 @@
+#include "../../gtest/gtest.h"
+#include "../../ipc/MessageChannel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+// The old MessageQueue: one priority_queue behind one mutex for every
+// receiver, copying each message in and out. receive() only returns the
+// top message, and only when it is addressed to the caller.
+class LegacyMessageQueue {
+public:
+    void optimizedSend(ProcessId dest, const Message& msg) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        Message msgCopy = msg;
+        msgCopy.receiver = dest;
+        messages.push(msgCopy);
+    }
+
+    bool receive(ProcessId receiver, Message& out) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (messages.empty() || messages.top().receiver != receiver) return false;
+        out = messages.top();
+        messages.pop();
+        return true;
+    }
+
+private:
+    struct ByPriority {
+        bool operator()(const Message& a, const Message& b) const { return a.priority < b.priority; }
+    };
+
+    std::priority_queue<Message, std::vector<Message>, ByPriority> messages;
+    std::mutex queueMutex;
+};
+
+class MessageChannelPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr size_t PRODUCERS = 4;
+    static constexpr size_t MESSAGES_PER_PRODUCER = 50000;
+
+    // Payloads past the small-string buffer, so copies allocate
+    static Message makeMessage(ProcessId sender, size_t sequence, size_t priority = 1) {
+        Message msg{};
+        msg.sender = sender;
+        msg.priority = priority;
+        msg.timestamp = sequence;
+        msg.data.assign(64, static_cast<char>('a' + sequence % 26));
+        return msg;
+    }
+
+    template<typename F>
+    static double elapsedMs(F&& f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// Four senders, one receiver. Each sender's messages must arrive in order.
+TEST_F(MessageChannelPerformanceTest, FanInThroughput) {
+    constexpr size_t TOTAL = PRODUCERS * MESSAGES_PER_PRODUCER;
+
+    LegacyMessageQueue legacy;
+    double legacyMs = elapsedMs([&] {
+        std::vector<std::thread> producers;
+        for (size_t p = 0; p < PRODUCERS; p++) {
+            producers.emplace_back([&, p] {
+                for (size_t i = 0; i < MESSAGES_PER_PRODUCER; i++) {
+                    legacy.optimizedSend(0, makeMessage(static_cast<ProcessId>(p), i));
+                }
+            });
+        }
+        Message msg;
+        for (size_t received = 0; received < TOTAL;) {
+            if (legacy.receive(0, msg)) {
+                received++;
+            } else {
+                std::this_thread::yield(); // Polling, as the old receive forced
+            }
+        }
+        for (auto& producer : producers) producer.join();
+    });
+
+    MpscChannel channel(1024);
+    std::vector<size_t> nextSequence(PRODUCERS, 0);
+    bool inOrder = true;
+    double channelMs = elapsedMs([&] {
+        std::vector<std::thread> producers;
+        for (size_t p = 0; p < PRODUCERS; p++) {
+            producers.emplace_back([&, p] {
+                for (size_t i = 0; i < MESSAGES_PER_PRODUCER; i++) {
+                    channel.send(makeMessage(static_cast<ProcessId>(p), i));
+                }
+            });
+        }
+        std::vector<Message> batch;
+        for (size_t received = 0; received < TOTAL;) {
+            batch.clear();
+            received += channel.receiveBatch(batch, 64, std::chrono::milliseconds(100));
+            for (const Message& msg : batch) {
+                inOrder &= msg.timestamp == nextSequence[msg.sender]++;
+            }
+        }
+        for (auto& producer : producers) producer.join();
+    });
+
+    std::cout << "Fan-in of " << TOTAL << " messages: legacy queue " << legacyMs << " ms ("
+              << TOTAL / legacyMs / 1000 << " M/s), MPSC channel " << channelMs << " ms ("
+              << TOTAL / channelMs / 1000 << " M/s)" << std::endl;
+
+    EXPECT_TRUE(inOrder);
+    EXPECT_TRUE(channel.empty());
+    EXPECT_LT(channelMs, legacyMs);
+}
+
+// Round trips over a pair of SPSC channels; both sides sleep in futex
+// waits while idle
+TEST_F(MessageChannelPerformanceTest, PingPongLatency) {
+    constexpr size_t ROUND_TRIPS = 20000;
+    SpscChannel ping(64), pong(64);
+
+    std::thread echo([&] {
+        Message msg;
+        for (size_t i = 0; i < ROUND_TRIPS; i++) {
+            ping.receive(msg);
+            pong.send(std::move(msg));
+        }
+    });
+
+    std::vector<double> roundTripUs;
+    roundTripUs.reserve(ROUND_TRIPS);
+    Message reply;
+    for (size_t i = 0; i < ROUND_TRIPS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        ping.send(makeMessage(1, i));
+        ASSERT_TRUE(pong.receive(reply, std::chrono::seconds(5)));
+        roundTripUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        ASSERT_EQ(reply.timestamp, i);
+    }
+    echo.join();
+
+    std::sort(roundTripUs.begin(), roundTripUs.end());
+    std::cout << "Ping-pong round trip: p50 " << roundTripUs[ROUND_TRIPS / 2] << " us, p99 "
+              << roundTripUs[ROUND_TRIPS * 99 / 100] << " us" << std::endl;
+}
+
+// With one shared queue, a message for receiver 2 at the top hides
+// everything queued for receiver 1
+TEST_F(MessageChannelPerformanceTest, ReceiversDoNotStarveEachOther) {
+    LegacyMessageQueue legacy;
+    legacy.optimizedSend(1, makeMessage(0, 0, 1));
+    legacy.optimizedSend(2, makeMessage(0, 1, 3));
+    Message msg;
+    EXPECT_FALSE(legacy.receive(1, msg)); // Starved until 2 drains its message
+
+    MpscChannel inbox1, inbox2;
+    inbox1.send(makeMessage(0, 0, 1));
+    inbox2.send(makeMessage(0, 1, 3));
+    EXPECT_TRUE(inbox1.tryReceive(msg));
+    EXPECT_EQ(msg.timestamp, 0u);
+}
+
+} // namespace Test
+} // namespace Kernel
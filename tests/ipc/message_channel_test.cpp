@@ -0,0 +1,60 @@
+#include "../../gtest/gtest.h"
+#include "../../ipc/MessageChannel.hpp"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+class MessageChannelTest : public ::testing::Test {
+protected:
+    static Message makeMessage(ProcessId sender, size_t sequence, size_t priority = 1) {
+        Message msg{};
+        msg.sender = sender;
+        msg.priority = priority;
+        msg.timestamp = sequence;
+        msg.data.assign(64, static_cast<char>('a' + sequence % 26));
+        return msg;
+    }
+};
+
+TEST_F(MessageChannelTest, PriorityLanesAndBatches) {
+    MpscChannel channel(8);
+    std::vector<Message> batch;
+    for (size_t i = 0; i < 8; i++) batch.push_back(makeMessage(0, i, 0));
+    batch.push_back(makeMessage(0, 8, 0)); // Lane holds 8
+    EXPECT_EQ(channel.sendBatch(batch), 8u);
+    EXPECT_EQ(batch.size(), 1u);
+    EXPECT_FALSE(channel.trySend(std::move(batch[0])));
+    EXPECT_EQ(batch[0].data.size(), 64u); // A failed send leaves the message intact
+
+    EXPECT_TRUE(channel.trySend(makeMessage(0, 100, 7))); // Top lane
+    EXPECT_TRUE(channel.trySend(makeMessage(0, 101, 2)));
+
+    std::vector<Message> received;
+    EXPECT_EQ(channel.receiveBatch(received, 4), 4u);
+    EXPECT_EQ(received[0].timestamp, 100u);
+    EXPECT_EQ(received[1].timestamp, 101u);
+    EXPECT_EQ(received[2].timestamp, 0u);
+    EXPECT_EQ(received[3].timestamp, 1u);
+
+    // A sender blocked on the full lane wakes when the receiver drains it
+    for (size_t i = 2; i < 8; i++) channel.receiveBatch(received, 1);
+    for (size_t i = 0; i < 8; i++) ASSERT_TRUE(channel.trySend(makeMessage(0, i, 0)));
+    std::thread sender([&] { EXPECT_TRUE(channel.send(makeMessage(0, 8, 0), std::chrono::seconds(5))); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    received.clear();
+    while (received.size() < 9) channel.receiveBatch(received, 9, std::chrono::seconds(5));
+    sender.join();
+    EXPECT_EQ(received.back().timestamp, 8u);
+
+    // Timeouts on an empty channel and on a full lane
+    Message msg;
+    EXPECT_FALSE(channel.receive(msg, std::chrono::milliseconds(5)));
+    for (size_t i = 0; i < 8; i++) channel.trySend(makeMessage(0, i, 0));
+    EXPECT_FALSE(channel.send(makeMessage(0, 9, 0), std::chrono::milliseconds(5)));
+}
+
+} // namespace Test
+} // namespace Kernel
@@ -0,0 +1,125 @@
+#include "../../gtest/gtest.h"
+#include "../../ipc/SharedPayloadArena.hpp"
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Kernel {
+namespace Test {
+
+class SharedPayloadArenaTest : public ::testing::Test {
+protected:
+    static constexpr size_t FRAME_SIZE = 1024 * 1024;
+    static constexpr size_t ARENA_SIZE = 16 * FRAME_SIZE;
+
+    void SetUp() override {
+        segmentSize = SharedPayloadArena::segmentSizeFor(ARENA_SIZE);
+        segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        ASSERT_NE(segment, MAP_FAILED);
+        arena = std::make_unique<SharedPayloadArena>(7, segment, segmentSize, true);
+        ASSERT_TRUE(arena->isValid());
+    }
+
+    void TearDown() override {
+        arena.reset();
+        munmap(segment, segmentSize);
+    }
+
+    static void renderFrame(uint8_t* frame, size_t index) {
+        std::memset(frame, static_cast<int>(index & 0xff), FRAME_SIZE);
+    }
+
+    static uint64_t checksum(const uint8_t* frame) {
+        return std::accumulate(frame, frame + FRAME_SIZE, uint64_t(0));
+    }
+
+    void* segment = nullptr;
+    size_t segmentSize = 0;
+    std::unique_ptr<SharedPayloadArena> arena;
+};
+
+TEST_F(SharedPayloadArenaTest, ReferenceCountsAndValidation) {
+    auto frame = arena->allocate(FRAME_SIZE);
+    ASSERT_TRUE(frame);
+    size_t frameBlocks = FRAME_SIZE / SharedPayloadArena::BLOCK_SIZE;
+    EXPECT_EQ(arena->getFreeBlockCount(), arena->getBlockCount() - frameBlocks);
+
+    // Fan-out to two receivers; the sender drops its own reference
+    EXPECT_TRUE(arena->retain(*frame, 2));
+    EXPECT_FALSE(arena->release(*frame));
+    EXPECT_FALSE(arena->release(*frame));
+    EXPECT_TRUE(arena->release(*frame));
+    EXPECT_EQ(arena->getFreeBlockCount(), arena->getBlockCount());
+
+    // Released, then reused: the old descriptor no longer resolves
+    EXPECT_EQ(arena->data(*frame), nullptr);
+    EXPECT_FALSE(arena->release(*frame));
+    std::vector<PayloadDescriptor> frames;
+    while (auto next = arena->allocate(FRAME_SIZE)) frames.push_back(*next);
+    EXPECT_EQ(frames.size(), 16u);
+    EXPECT_EQ(arena->data(*frame), nullptr);
+
+    PayloadDescriptor forged = frames[0];
+    forged.length = FRAME_SIZE + 1;
+    EXPECT_EQ(arena->data(forged), nullptr);
+    forged = frames[0];
+    forged.offset += 64;
+    EXPECT_EQ(arena->data(forged), nullptr);
+    forged = frames[0];
+    forged.segment = 8;
+    EXPECT_EQ(arena->data(forged), nullptr);
+
+    EXPECT_TRUE(arena->release(frames[3]));
+    auto refill = arena->allocate(FRAME_SIZE);
+    ASSERT_TRUE(refill);
+    EXPECT_EQ(refill->offset, frames[3].offset);
+}
+
+// Another process attaches to the segment, reads the frame and frees it
+TEST_F(SharedPayloadArenaTest, ReleasedByAnotherProcess) {
+    auto frame = arena->allocate(FRAME_SIZE);
+    ASSERT_TRUE(frame);
+    renderFrame(arena->data(*frame), 42);
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        SharedPayloadArena attached(7, segment, segmentSize, false);
+        const uint8_t* data = attached.isValid() ? attached.data(*frame) : nullptr;
+        bool ok = data && checksum(data) == 42ULL * FRAME_SIZE && attached.release(*frame);
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT_EQ(arena->getFreeBlockCount(), arena->getBlockCount());
+    EXPECT_EQ(arena->data(*frame), nullptr);
+}
+
+// A second opener must attach to the formatted segment, not wipe it
+TEST_F(SharedPayloadArenaTest, AttachKeepsExistingPayloads) {
+    EXPECT_TRUE(SharedPayloadArena::isFormatted(segment, segmentSize));
+    EXPECT_FALSE(SharedPayloadArena::isFormatted(segment, 8)); // Smaller than a header
+    auto frame = arena->allocate(FRAME_SIZE);
+    ASSERT_TRUE(frame);
+    renderFrame(arena->data(*frame), 9);
+
+    SharedPayloadArena attached(7, segment, segmentSize, !SharedPayloadArena::isFormatted(segment, segmentSize));
+    ASSERT_TRUE(attached.isValid());
+    ASSERT_NE(attached.data(*frame), nullptr);
+    EXPECT_EQ(checksum(attached.data(*frame)), 9ULL * FRAME_SIZE);
+    EXPECT_EQ(attached.getFreeBlockCount(), arena->getFreeBlockCount());
+
+    // A fresh, zeroed segment holds no arena yet
+    void* blank = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(blank, MAP_FAILED);
+    EXPECT_FALSE(SharedPayloadArena::isFormatted(blank, segmentSize));
+    munmap(blank, segmentSize);
+}
+
+} // namespace Test
+} // namespace Kernel
@@ -0,0 +1,46 @@
+#include "../../gtest/gtest.h"
+#include "../../ipc/SharedSegment.hpp"
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+TEST(SharedSegmentTableTest, StaleHandlesAndConcurrentAttach) {
+    SharedSegmentTable table;
+    SegmentHandle first = table.insert(mapSharedSegment(SEGMENT_PAGE_SIZE));
+    ASSERT_TRUE(first.isValid());
+    EXPECT_EQ(table.detach(first), SharedSegmentTable::DetachResult::Destroyed);
+    EXPECT_EQ(table.attach(first), nullptr);
+    EXPECT_EQ(table.detach(first), SharedSegmentTable::DetachResult::Stale);
+
+    // The freed slot is reused under a new generation
+    SegmentHandle second = table.insert(mapSharedSegment(SEGMENT_PAGE_SIZE));
+    EXPECT_EQ(second.index, first.index);
+    EXPECT_NE(second.generation, first.generation);
+    EXPECT_EQ(table.attach(first), nullptr);
+    EXPECT_EQ(table.detach(first), SharedSegmentTable::DetachResult::Stale);
+    EXPECT_NE(table.get(second), nullptr);
+    EXPECT_EQ(table.attach(SegmentHandle{}), nullptr);
+
+    constexpr size_t THREADS = 4;
+    constexpr size_t ROUNDS = 100000;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t] {
+            for (size_t i = 0; i < ROUNDS; i++) {
+                const SharedSegment* segment = table.attach(second);
+                if (!segment) continue;
+                static_cast<volatile uint8_t*>(segment->address)[t] = 1;
+                table.detach(second);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(table.detach(second), SharedSegmentTable::DetachResult::Destroyed);
+    EXPECT_EQ(table.get(second), nullptr);
+}
+
+} // namespace Test
+} // namespace Kernel
@@ -0,0 +1,75 @@
+#include "../../gtest/gtest.h"
+#include "../../ipc/SignalDispatch.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+class SignalDispatchTest : public ::testing::Test {
+protected:
+    static constexpr int PING = 10;
+    static constexpr int PONG = 12;
+    static constexpr int SLOW = 17;
+    static constexpr size_t CONTENDERS = 3;
+};
+
+TEST_F(SignalDispatchTest, PendingSignalsCoalesce) {
+    SignalDispatchTable handlers;
+    std::vector<int> order;
+    for (int signal : {PING, PONG, SLOW}) handlers.set(signal, [&](int s) { order.push_back(s); });
+
+    PendingSignals pending;
+    EXPECT_TRUE(pending.raise(SLOW));
+    for (int i = 0; i < 1000; i++) pending.raise(PING);
+    EXPECT_FALSE(pending.raise(SLOW));
+    EXPECT_TRUE(pending.raise(PONG));
+    EXPECT_TRUE(pending.raise(3)); // No handler: taken but not counted
+    EXPECT_FALSE(pending.raise(MAX_SIGNALS));
+
+    EXPECT_EQ(handlers.dispatchAll(pending.take()), 3u);
+    EXPECT_EQ(order, (std::vector<int>{PING, PONG, SLOW}));
+    EXPECT_EQ(pending.peek(), 0u);
+    EXPECT_FALSE(pending.wait(std::chrono::milliseconds(5)));
+
+    handlers.clear(PING);
+    EXPECT_FALSE(handlers.dispatch(PING));
+    handlers.clearAll();
+    EXPECT_FALSE(handlers.dispatch(PONG));
+}
+
+// Registration churn while other threads dispatch: every dispatch sees
+// either the old or the new handler, never a freed one
+TEST_F(SignalDispatchTest, RegistrationDuringDispatch) {
+    SignalDispatchTable handlers;
+    std::atomic<uint64_t> calls{0};
+    handlers.set(PING, [&](int) { calls++; });
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> dispatchers;
+    for (size_t i = 0; i < CONTENDERS; i++) {
+        dispatchers.emplace_back([&] {
+            while (running) {
+                PendingSignals pending;
+                pending.raise(PING);
+                pending.raise(PONG);
+                handlers.dispatchAll(pending.take());
+            }
+        });
+    }
+    for (int i = 0; i < 2000; i++) {
+        handlers.set(PONG, [&, i](int) { calls += i % 2; });
+        if (i % 100 == 0) std::this_thread::yield();
+    }
+    running = false;
+    for (auto& dispatcher : dispatchers) dispatcher.join();
+    EXPECT_GT(calls.load(), 0u);
+    handlers.synchronize();
+    EXPECT_EQ(handlers.getRetiredCount(), 0u);
+}
+
+} // namespace Test
+} // namespace Kernel
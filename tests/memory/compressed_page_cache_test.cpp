@@ -0,0 +1,174 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/CompressedPagePool.hpp"
+#include "../../memory/PageTable.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <sys/mman.h>
+
+namespace Memory {
+namespace Test {
+
+// A small anonymous mapping of compressible pages, each with its own
+// contents so a page restored into the wrong frame is caught
+class CompressedPageCacheTest : public ::testing::Test {
+protected:
+    static constexpr size_t PAGE = CompressedPageCache::PAGE_SIZE;
+    static constexpr size_t PAGES = 64;
+
+    void SetUp() override {
+        void* mapping = mmap(nullptr, PAGES * PAGE, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        ASSERT_NE(mapping, MAP_FAILED);
+        memory = static_cast<uint8_t*>(mapping);
+        for (size_t i = 0; i < PAGES; i++) {
+            char* page = reinterpret_cast<char*>(memory + i * PAGE);
+            for (size_t offset = 0; offset + 32 <= PAGE; offset += 32) {
+                std::snprintf(page + offset, 32, "page %04zu row %04zu vertex    ", i, offset / 32);
+            }
+        }
+        original.assign(memory, memory + PAGES * PAGE);
+    }
+
+    void TearDown() override { munmap(memory, PAGES * PAGE); }
+
+    bool intact(size_t i) const {
+        return std::memcmp(memory + i * PAGE, original.data() + i * PAGE, PAGE) == 0;
+    }
+
+    uint8_t* memory = nullptr;
+    std::vector<uint8_t> original;
+};
+
+// Compressed pages are handed back unmapped, so nothing can write to the
+// stale frame; they are backed again before the pool copy is restored
+TEST_F(CompressedPageCacheTest, ReleasedPagesStayUnmappedUntilRestored) {
+    constexpr size_t COUNT = 64;
+    bool backingAvailable = true;
+    CompressedPageCache cache(
+        [](void* page) {
+            mprotect(page, PAGE, PROT_NONE);
+            madvise(page, PAGE, MADV_DONTNEED);
+        },
+        [&backingAvailable](void* page) {
+            return backingAvailable && mprotect(page, PAGE, PROT_READ | PROT_WRITE) == 0;
+        });
+    for (size_t i = 0; i < COUNT; i++) cache.track(memory + i * PAGE);
+    size_t compressed = cache.reclaim(COUNT, std::chrono::milliseconds(0));
+    ASSERT_GT(compressed, 0u);
+
+    std::vector<unsigned char> residency(COUNT);
+    ASSERT_EQ(mincore(memory, COUNT * PAGE, residency.data()), 0);
+    for (size_t i = 0; i < COUNT; i++) {
+        EXPECT_EQ(residency[i] & 1, cache.isCompressed(memory + i * PAGE) ? 0 : 1) << "page " << i;
+    }
+
+    // No backing: the fault leaves the page compressed
+    backingAvailable = false;
+    EXPECT_FALSE(cache.access(memory));
+    EXPECT_TRUE(cache.isCompressed(memory));
+    backingAvailable = true;
+
+    for (size_t i = 0; i < COUNT; i++) {
+        cache.access(memory + i * PAGE);
+        ASSERT_TRUE(intact(i)) << "page " << i;
+        memory[i * PAGE] ^= 0xff; // Written after the fault, kept by the next one
+        EXPECT_FALSE(cache.access(memory + i * PAGE));
+        EXPECT_EQ(memory[i * PAGE], static_cast<uint8_t>(original[i * PAGE] ^ 0xff));
+    }
+    EXPECT_EQ(cache.getStats().storedPages, 0u);
+}
+
+// Pages are read-only from the moment reclaim picks them until they are
+// released, so no store can slip in after the compressed copy was taken.
+// A page that stays resident gets its write access back.
+TEST_F(CompressedPageCacheTest, PagesAreWriteProtectedWhileCompressing) {
+    std::mt19937 rng(3);
+    uint8_t* noise = memory + 7 * PAGE; // Does not compress: reclaim rejects it
+    for (size_t b = 0; b < PAGE; b++) noise[b] = static_cast<uint8_t>(rng());
+    std::memcpy(original.data() + 7 * PAGE, noise, PAGE);
+
+    std::vector<bool> writable(PAGES, true);
+    auto indexOf = [this](void* page) { return (static_cast<uint8_t*>(page) - memory) / PAGE; };
+    size_t releasedWritable = 0;
+    CompressedPageCache cache(
+        [&](void* page) {
+            if (writable[indexOf(page)]) releasedWritable++;
+            mprotect(page, PAGE, PROT_NONE);
+            madvise(page, PAGE, MADV_DONTNEED);
+        },
+        [&](void* page) {
+            writable[indexOf(page)] = true;
+            return mprotect(page, PAGE, PROT_READ | PROT_WRITE) == 0;
+        },
+        [&](void* page, bool allowWrite) {
+            writable[indexOf(page)] = allowWrite;
+            return mprotect(page, PAGE, allowWrite ? PROT_READ | PROT_WRITE : PROT_READ) == 0;
+        });
+    for (size_t i = 0; i < PAGES; i++) cache.track(memory + i * PAGE);
+    EXPECT_EQ(cache.reclaim(PAGES, std::chrono::milliseconds(0)), PAGES - 1);
+    EXPECT_EQ(releasedWritable, 0u);
+    EXPECT_EQ(cache.getStats().rejectedPages, 1u);
+
+    // The rejected page is writable again; a store would fault otherwise
+    EXPECT_FALSE(cache.isCompressed(noise));
+    EXPECT_TRUE(writable[7]);
+    noise[0] ^= 0xff;
+    original[7 * PAGE] ^= 0xff;
+
+    for (size_t i = 0; i < PAGES; i++) {
+        EXPECT_EQ(cache.access(memory + i * PAGE), i != 7);
+        ASSERT_TRUE(intact(i)) << "page " << i;
+    }
+    EXPECT_EQ(cache.getStats().corruptPages, 0u);
+}
+
+// Pages inside a promoted 2 MB region stay resident: compressing one
+// would split the leaf and undo the promotion. The protect hook refuses
+// them as the VMM's does, and reclaim moves on.
+TEST_F(CompressedPageCacheTest, PagesInsideHugeLeavesAreSkipped) {
+    PageTable pageTable;
+    uint64_t base = reinterpret_cast<uint64_t>(memory) & ~(PageTable::LARGE_PAGE_SIZE - 1);
+    uint64_t end = reinterpret_cast<uint64_t>(memory) + PAGES * PAGE;
+    uint64_t length = (end - base + PageTable::LARGE_PAGE_SIZE - 1) & ~(PageTable::LARGE_PAGE_SIZE - 1);
+    ASSERT_TRUE(pageTable.mapRange(base, 0x40000000, length));
+    uint64_t writes = pageTable.getStats().entryWrites;
+
+    size_t released = 0;
+    CompressedPageCache cache(
+        [&](void* page) {
+            released++;
+            pageTable.unmapRange(reinterpret_cast<uint64_t>(page), PAGE);
+        },
+        [](void*) { return true; },
+        [&](void* page, bool allowWrite) {
+            uint64_t virt = reinterpret_cast<uint64_t>(page);
+            auto translation = pageTable.translate(virt);
+            if (!allowWrite && translation && translation->pageSize != PAGE) return false;
+            pageTable.setWritable(virt, PAGE, allowWrite);
+            return true;
+        });
+    for (size_t i = 0; i < PAGES; i++) cache.track(memory + i * PAGE);
+
+    EXPECT_EQ(cache.reclaim(PAGES, std::chrono::milliseconds(0)), 0u);
+    EXPECT_EQ(released, 0u);
+    EXPECT_EQ(cache.getStats().skippedPages, PAGES);
+    EXPECT_EQ(pageTable.getStats().entryWrites, writes); // Nothing split
+    for (size_t i = 0; i < PAGES; i++) {
+        EXPECT_FALSE(cache.isCompressed(memory + i * PAGE));
+        EXPECT_EQ(pageTable.translate(reinterpret_cast<uint64_t>(memory + i * PAGE))->pageSize,
+                  PageTable::LARGE_PAGE_SIZE);
+    }
+
+    // Mapped with 4 KB leaves (unaligned frames), the same pages compress
+    pageTable.unmapRange(base, length);
+    ASSERT_TRUE(pageTable.mapRange(base, 0x40000000 + PAGE, length));
+    EXPECT_EQ(cache.reclaim(PAGES, std::chrono::milliseconds(0)), PAGES);
+    EXPECT_EQ(released, PAGES);
+}
+
+} // namespace Test
+} // namespace Memory
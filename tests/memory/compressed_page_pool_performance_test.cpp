@@ -0,0 +1,159 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/CompressedPagePool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+
+namespace Memory {
+namespace Test {
+
+// 16 MB of anonymous memory with a typical mix: 25% zero pages, 10%
+// pages of one repeated word, 50% compressible data, 15% random bytes.
+// Released pages are dropped with MADV_DONTNEED, so a fault really has
+// to rebuild the page from the pool.
+class CompressedPagePoolPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr size_t PAGE = CompressedPageCache::PAGE_SIZE;
+    static constexpr size_t PAGES = 4096;
+
+    void SetUp() override {
+        void* mapping = mmap(nullptr, PAGES * PAGE, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        ASSERT_NE(mapping, MAP_FAILED);
+        memory = static_cast<uint8_t*>(mapping);
+
+        std::mt19937 rng(11);
+        const char* words[] = {"texture", "mesh", "shader", "frame", "buffer", "vertex",
+                               "index", "sampler", "pipeline", "descriptor"};
+        for (size_t i = 0; i < PAGES; i++) {
+            uint8_t* page = memory + i * PAGE;
+            size_t kind = i % 20;
+            if (kind < 5) {
+                std::memset(page, 0, PAGE);
+            } else if (kind < 7) {
+                uint64_t word = 0x3f8000003f800000ULL + i;
+                std::fill_n(reinterpret_cast<uint64_t*>(page), PAGE / 8, word);
+            } else if (kind < 17) {
+                std::string text;
+                while (text.size() < PAGE) {
+                    text += words[rng() % 10];
+                    text += ' ';
+                    text += std::to_string(rng() % 64);
+                    text += '\n';
+                }
+                std::memcpy(page, text.data(), PAGE);
+            } else {
+                for (size_t b = 0; b < PAGE; b++) page[b] = static_cast<uint8_t>(rng());
+            }
+        }
+        original.assign(memory, memory + PAGES * PAGE);
+    }
+
+    void TearDown() override { munmap(memory, PAGES * PAGE); }
+
+    static void release(void* page) { madvise(page, PAGE, MADV_DONTNEED); }
+
+    bool intact(size_t i) const {
+        return std::memcmp(memory + i * PAGE, original.data() + i * PAGE, PAGE) == 0;
+    }
+
+    uint8_t* memory = nullptr;
+    std::vector<uint8_t> original;
+};
+
+TEST_F(CompressedPagePoolPerformanceTest, FaultLatencyAndPoolDensity) {
+    CompressedPageCache cache(release);
+    for (size_t i = 0; i < PAGES; i++) cache.track(memory + i * PAGE);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t compressed = cache.reclaim(PAGES, std::chrono::milliseconds(0));
+    double reclaimMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t sameFilledPages = 0, randomPages = 0;
+    for (size_t i = 0; i < PAGES; i++) {
+        if (i % 20 < 7) sameFilledPages++;
+        if (i % 20 >= 17) randomPages++;
+    }
+
+    auto stats = cache.getStats();
+    size_t storedBytes = (stats.storedPages - stats.sameFilledPages) * PAGE;
+    std::cout << "Reclaimed " << compressed << " pages in " << reclaimMs << " ms: "
+              << stats.sameFilledPages << " same-filled, " << stats.rejectedPages << " rejected, "
+              << storedBytes / 1024 << " KB into a " << stats.poolBytes / 1024 << " KB pool" << std::endl;
+
+    EXPECT_EQ(stats.sameFilledPages, sameFilledPages);
+    EXPECT_EQ(stats.rejectedPages, randomPages);
+    EXPECT_EQ(compressed, PAGES - randomPages);
+    // Size classes keep the pool close to the compressed payload
+    EXPECT_LT(stats.poolBytes, stats.compressedBytes * 11 / 10 + 64 * 1024);
+    EXPECT_LT(stats.poolBytes * 2, storedBytes);
+
+    // Fault every page back in, in random order
+    std::vector<size_t> order(PAGES);
+    for (size_t i = 0; i < PAGES; i++) order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(5));
+    std::vector<double> sameFilledUs, compressedUs;
+    for (size_t i : order) {
+        bool sameFilled = i % 20 < 7;
+        bool stored = i % 20 < 17;
+        auto faultStart = std::chrono::steady_clock::now();
+        EXPECT_EQ(cache.access(memory + i * PAGE), stored);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - faultStart).count();
+        if (stored) (sameFilled ? sameFilledUs : compressedUs).push_back(us);
+        ASSERT_TRUE(intact(i)) << "page " << i;
+    }
+
+    auto percentile = [](std::vector<double>& v, size_t p) {
+        std::sort(v.begin(), v.end());
+        return v[v.size() * p / 100];
+    };
+    double compressedP99 = percentile(compressedUs, 99);
+    std::cout << "Fault latency: same-filled p50 " << percentile(sameFilledUs, 50) << " us, p99 "
+              << percentile(sameFilledUs, 99) << " us; compressed p50 " << percentile(compressedUs, 50)
+              << " us, p99 " << compressedP99 << " us" << std::endl;
+
+    EXPECT_LT(compressedP99, 200.0);
+    stats = cache.getStats();
+    EXPECT_EQ(stats.storedPages, 0u);
+    EXPECT_EQ(stats.faults, compressed);
+    EXPECT_EQ(stats.poolBytes, 0u); // Every zspage released
+}
+
+TEST_F(CompressedPagePoolPerformanceTest, BackgroundReclaimSparesRecentlyUsedPages) {
+    CompressedPageCache cache(release);
+    for (size_t i = 0; i < PAGES; i++) cache.track(memory + i * PAGE);
+
+    // Keep the first 64 pages hot while the background thread runs
+    constexpr auto MIN_IDLE = std::chrono::milliseconds(50);
+    std::atomic<size_t> passes{0}; // Other background work rides on each pass
+    cache.startBackground(std::chrono::milliseconds(1), 512, MIN_IDLE, [&passes] { passes++; });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline &&
+           cache.getStats().storedPages < PAGES / 2) {
+        for (size_t i = 0; i < 64; i++) {
+            cache.access(memory + i * PAGE);
+            ASSERT_TRUE(intact(i));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    cache.stopBackground();
+
+    for (size_t i = 0; i < 64; i++) EXPECT_FALSE(cache.isCompressed(memory + i * PAGE));
+    EXPECT_GE(cache.getStats().storedPages, PAGES / 2);
+    EXPECT_GT(passes.load(), 0u);
+
+    for (size_t i = 0; i < PAGES; i++) {
+        cache.untrack(memory + i * PAGE);
+        ASSERT_TRUE(intact(i)) << "page " << i;
+    }
+}
+
+} // namespace Test
+} // namespace Memory
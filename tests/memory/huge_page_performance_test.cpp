@@ -0,0 +1,156 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/TLB.hpp"
+#include "../../memory/TransparentHugePages.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+// A 32 MB heap faulted in 4 KB at a time over a simulated physical
+// memory. Half the regions get contiguous frames (promoted in place), the
+// rest scattered frames (promoted by copying). Random accesses go through
+// the software TLB before and after the khugepaged pass.
+class HugePagePerformanceTest : public ::testing::Test {
+protected:
+    static constexpr uint64_t PAGE = PageTable::PAGE_SIZE;
+    static constexpr uint64_t LARGE = PageTable::LARGE_PAGE_SIZE;
+    static constexpr size_t REGIONS = 16;
+    static constexpr uint64_t HEAP_BASE = 0x40000000;
+    static constexpr uint64_t HEAP_SIZE = REGIONS * LARGE;
+    // Physical layout: small frames, then a pool of huge frames
+    static constexpr uint64_t SMALL_FRAMES_BASE = LARGE;
+    static constexpr uint64_t HUGE_FRAMES_BASE = SMALL_FRAMES_BASE + HEAP_SIZE + LARGE;
+    static constexpr uint64_t PHYSICAL_SIZE = HUGE_FRAMES_BASE + HEAP_SIZE;
+
+    void SetUp() override {
+        physical.assign(PHYSICAL_SIZE, 0);
+
+        TransparentHugePages::Backend backend;
+        backend.allocateLargeFrame = [this](uint64_t) -> uint64_t {
+            if (nextHugeFrame >= PHYSICAL_SIZE) return 0;
+            uint64_t frame = nextHugeFrame;
+            nextHugeFrame += LARGE;
+            return frame;
+        };
+        backend.freeFrames = [this](uint64_t, uint64_t length) { freedBytes += length; };
+        backend.copy = [this](uint64_t dst, uint64_t src, uint64_t length) {
+            std::memcpy(&physical[dst], &physical[src], length);
+        };
+        backend.flushRange = [this](uint64_t virt, uint64_t length) {
+            tlb.invalidateRange(0, virt, length / PAGE);
+        };
+        hugePages = std::make_unique<TransparentHugePages>(pageTable, std::move(backend));
+        tlb.switchTo(0);
+    }
+
+    // Maps every small page of the heap; odd regions get shuffled frames
+    void faultInHeap() {
+        std::vector<uint64_t> frames(HEAP_SIZE / PAGE);
+        for (size_t i = 0; i < frames.size(); i++) frames[i] = SMALL_FRAMES_BASE + i * PAGE;
+        std::mt19937 rng(3);
+        for (size_t region = 1; region < REGIONS; region += 2) {
+            auto first = frames.begin() + region * (LARGE / PAGE);
+            std::shuffle(first, first + LARGE / PAGE, rng);
+        }
+        for (size_t i = 0; i < frames.size(); i++) {
+            uint64_t virt = HEAP_BASE + i * PAGE;
+            ASSERT_TRUE(pageTable.mapRange(virt, frames[i], PAGE));
+            hugePages->noteMapped(virt, PAGE);
+            std::memset(&physical[frames[i]], static_cast<int>(i % 251), PAGE);
+        }
+    }
+
+    // Returns the byte at virt, translating through the TLB
+    uint8_t read(uint64_t virt) {
+        uint64_t phys;
+        if (!tlb.lookup(virt, phys)) {
+            auto translation = pageTable.translate(virt);
+            if (!translation) return 0xff;
+            phys = translation->physicalAddr;
+            uint64_t base = virt & ~(translation->pageSize - 1);
+            uint64_t frame = phys & ~(translation->pageSize - 1);
+            if (translation->pageSize == LARGE) {
+                tlb.insertLarge(base, frame);
+            } else {
+                tlb.insert(base, frame);
+            }
+        }
+        return physical[phys];
+    }
+
+    uint64_t randomAccessMisses(size_t accesses, uint32_t seed) {
+        std::mt19937_64 rng(seed);
+        uint64_t before = tlb.getStats().misses;
+        for (size_t i = 0; i < accesses; i++) {
+            uint64_t offset = rng() % HEAP_SIZE;
+            EXPECT_EQ(read(HEAP_BASE + offset), (offset / PAGE) % 251);
+        }
+        return tlb.getStats().misses - before;
+    }
+
+    std::vector<uint8_t> physical;
+    uint64_t nextHugeFrame = HUGE_FRAMES_BASE;
+    uint64_t freedBytes = 0;
+    PageTable pageTable;
+    SoftwareTLB tlb;
+    std::unique_ptr<TransparentHugePages> hugePages;
+};
+
+TEST_F(HugePagePerformanceTest, PromotionCutsTLBMisses) {
+    faultInHeap();
+    constexpr size_t ACCESSES = 1 << 19;
+    uint64_t smallMisses = randomAccessMisses(ACCESSES, 7);
+
+    // Background passes of 4 regions each, as khugepaged would run them
+    while (hugePages->getCandidateCount() > 0) hugePages->scan(4);
+    const auto& stats = hugePages->getStats();
+    EXPECT_EQ(stats.promotions, REGIONS);
+    EXPECT_EQ(stats.inPlacePromotions, REGIONS / 2);
+    EXPECT_EQ(freedBytes, REGIONS / 2 * LARGE); // Scattered frames returned after copying
+
+    uint64_t largeMisses = randomAccessMisses(ACCESSES, 7);
+    std::cout << "TLB misses over " << ACCESSES << " random reads: " << smallMisses
+              << " with 4 KB pages, " << largeMisses << " after promoting "
+              << stats.promotions << " regions (" << stats.inPlacePromotions << " in place)" << std::endl;
+
+    EXPECT_LT(largeMisses * 100, smallMisses);
+}
+
+TEST_F(HugePagePerformanceTest, PartialUnmapDemotesAndRefillRepromotes) {
+    faultInHeap();
+    while (hugePages->getCandidateCount() > 0) hugePages->scan(REGIONS);
+
+    uint64_t region = HEAP_BASE + 3 * LARGE;
+    uint64_t hole = region + 100 * PAGE;
+    ASSERT_TRUE(hugePages->isPromoted(hole));
+    EXPECT_EQ(read(hole + PAGE), (3 * LARGE / PAGE + 101) % 251);
+
+    hugePages->unmap(hole, PAGE);
+    EXPECT_EQ(hugePages->getStats().demotions, 1u);
+    EXPECT_FALSE(hugePages->isPromoted(region));
+    EXPECT_FALSE(pageTable.translate(hole));
+    EXPECT_EQ(read(hole), 0xff); // The cached 2 MB entry was flushed
+    EXPECT_EQ(read(hole + PAGE), (3 * LARGE / PAGE + 101) % 251);
+    EXPECT_EQ(pageTable.translate(hole + PAGE)->pageSize, PAGE);
+
+    // Not fully populated: the pass leaves it alone
+    hugePages->scan(REGIONS);
+    EXPECT_FALSE(hugePages->isPromoted(region));
+
+    uint64_t frame = SMALL_FRAMES_BASE + HEAP_SIZE; // Spare frame between the pools
+    std::memset(&physical[frame], 42, PAGE);
+    ASSERT_TRUE(pageTable.mapRange(hole, frame, PAGE));
+    hugePages->noteMapped(hole, PAGE);
+    hugePages->scan(REGIONS);
+    EXPECT_TRUE(hugePages->isPromoted(region));
+    EXPECT_EQ(read(hole), 42);
+    EXPECT_EQ(read(hole + PAGE), (3 * LARGE / PAGE + 101) % 251);
+}
+
+} // namespace Test
+} // namespace Memory
@@ -0,0 +1,99 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/MovableHeap.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+// Simulates a long session: every frame allocates and frees blocks, pins
+// a few across the frame, then gives the compactor a fixed time slice.
+class MovableHeapPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr size_t HEAP_SIZE = 32 * 1024 * 1024;
+    static constexpr size_t FRAMES = 600;
+    static constexpr std::chrono::microseconds BUDGET{500};
+
+    struct Block {
+        MovableHeap::Handle handle;
+        size_t size;
+        unsigned char tag;
+    };
+
+    static bool intact(MovableHeap& heap, const Block& block) {
+        auto* data = static_cast<unsigned char*>(heap.resolve(block.handle));
+        return data && std::all_of(data, data + block.size,
+                                   [&](unsigned char c) { return c == block.tag; });
+    }
+};
+
+TEST_F(MovableHeapPerformanceTest, IncrementalCompactionStaysWithinFrameBudget) {
+    MovableHeap heap(HEAP_SIZE);
+    std::mt19937 rng(21);
+    std::vector<Block> live;
+    std::vector<double> stepUs;
+    size_t failedAllocations = 0;
+
+    for (size_t frame = 0; frame < FRAMES; frame++) {
+        // Churn: allocate a burst and free almost as many random blocks
+        for (int i = 0; i < 100; i++) {
+            size_t size = 32 + rng() % (rng() % 50 == 0 ? 16 * 1024 : 2048);
+            auto handle = heap.allocate(size);
+            if (!handle) {
+                failedAllocations++;
+                continue;
+            }
+            unsigned char tag = static_cast<unsigned char>(rng());
+            std::memset(heap.resolve(handle), tag, size);
+            live.push_back({handle, size, tag});
+        }
+        for (int i = 0; i < 97 && !live.empty(); i++) {
+            size_t victim = rng() % live.size();
+            ASSERT_TRUE(intact(heap, live[victim]));
+            ASSERT_TRUE(heap.free(live[victim].handle));
+            live[victim] = live.back();
+            live.pop_back();
+        }
+
+        // A few blocks stay pinned through the compaction slice
+        std::vector<std::pair<Block, void*>> pinned;
+        for (int i = 0; i < 4 && !live.empty(); i++) {
+            const Block& block = live[rng() % live.size()];
+            pinned.push_back({block, heap.pin(block.handle)});
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        heap.compactStep(BUDGET);
+        stepUs.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count());
+
+        for (auto& [block, address] : pinned) {
+            EXPECT_EQ(heap.resolve(block.handle), address);
+            heap.unpin(block.handle);
+        }
+    }
+
+    for (const auto& block : live) {
+        ASSERT_TRUE(intact(heap, block));
+    }
+    std::sort(stepUs.begin(), stepUs.end());
+    double p99StepUs = stepUs[stepUs.size() * 99 / 100];
+    std::cout << "Compaction step p99: " << p99StepUs << " us, worst: " << stepUs.back()
+              << " us, passes: "
+              << heap.getCompletedPasses() << ", fragmentation: "
+              << heap.getFragmentation() * 100 << "%, failed allocations: "
+              << failedAllocations << std::endl;
+
+    // One block copy may overrun the slice; never a multi-millisecond pause.
+    // p99 rather than the maximum so a preempted test thread does not fail it
+    EXPECT_LT(p99StepUs, 2000.0);
+    EXPECT_GT(heap.getCompletedPasses(), 0u);
+    EXPECT_EQ(failedAllocations, 0u);
+}
+
+} // namespace Test
+} // namespace Memory
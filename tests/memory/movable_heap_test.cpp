@@ -0,0 +1,35 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/MovableHeap.hpp"
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+TEST(MovableHeapTest, CompactionReclaimsFreedSpace) {
+    MovableHeap heap(4 * 1024 * 1024);
+    std::vector<MovableHeap::Handle> handles;
+    for (int i = 0; i < 1000; i++) {
+        handles.push_back(heap.allocate(1000));
+        std::memset(heap.resolve(handles.back()), i % 251, 1000);
+    }
+    for (size_t i = 0; i < handles.size(); i += 2) {
+        EXPECT_TRUE(heap.free(handles[i]));
+        EXPECT_EQ(heap.resolve(handles[i]), nullptr); // Stale handle
+    }
+    EXPECT_GT(heap.getFragmentation(), 0.4f);
+
+    while (!heap.compactStep(std::chrono::microseconds(50)).passComplete) {}
+    EXPECT_EQ(heap.getFragmentation(), 0.0f);
+    EXPECT_EQ(heap.getUsedBytes(), heap.getLiveBytes());
+    for (size_t i = 1; i < handles.size(); i += 2) {
+        auto* data = static_cast<unsigned char*>(heap.resolve(handles[i]));
+        ASSERT_NE(data, nullptr);
+        EXPECT_EQ(data[0], i % 251);
+        EXPECT_EQ(data[999], i % 251);
+    }
+}
+
+} // namespace Test
+} // namespace Memory
@@ -0,0 +1,137 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/NumaPolicy.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+// A simulated four-node machine: 32 MB of real memory per node, a hash
+// map standing in for the page table, and the SLIT distance of each
+// access as its cost.
+class NumaPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr size_t NODES = 4;
+    static constexpr size_t PAGE = NumaPageAllocator::PAGE_SIZE;
+    static constexpr size_t NODE_SIZE = 32 * 1024 * 1024;
+
+    void SetUp() override {
+        // Node 0 is nearer to node 2 than to node 1
+        topology.setDistance(0, 1, 32);
+        topology.setDistance(0, 2, 16);
+        memory = static_cast<uint8_t*>(std::aligned_alloc(PAGE, NODES * NODE_SIZE));
+        allocator = std::make_unique<NumaPageAllocator>(topology);
+        for (size_t node = 0; node < NODES; node++) {
+            allocator->addNode(node, memory + node * NODE_SIZE, NODE_SIZE);
+        }
+
+        NumaBalancer::Backend backend;
+        backend.frameOf = [this](uint64_t virt) -> void* {
+            auto it = pageTable.find(virt);
+            return it == pageTable.end() ? nullptr : it->second;
+        };
+        backend.copyPage = [](void* dst, const void* src) { std::memcpy(dst, src, PAGE); };
+        backend.remap = [this](uint64_t virt, void* frame) { pageTable[virt] = frame; };
+        backend.setWritable = [](uint64_t, bool) { return true; }; // Nothing writes during a pass
+        balancer = std::make_unique<NumaBalancer>(*allocator, std::move(backend));
+    }
+
+    void TearDown() override {
+        balancer.reset();
+        allocator.reset();
+        std::free(memory);
+    }
+
+    // Faults in a page under policy from a CPU on node, stamping it with its address
+    size_t faultIn(uint64_t virt, const NumaPolicy& policy, size_t node) {
+        auto allocation = allocator->allocate(PAGE, policy, node, virt);
+        EXPECT_NE(allocation.address, nullptr);
+        pageTable[virt] = allocation.address;
+        std::memcpy(allocation.address, &virt, sizeof(virt));
+        return allocation.node;
+    }
+
+    NumaTopology topology{NODES, 2};
+    uint8_t* memory = nullptr;
+    std::unique_ptr<NumaPageAllocator> allocator;
+    std::unique_ptr<NumaBalancer> balancer;
+    std::unordered_map<uint64_t, void*> pageTable;
+};
+
+// A loader on node 0 first-touches every worker's buffer, so three of the
+// four workers start out running against remote memory. Each epoch the
+// workers read their own buffers and one read in 64, at random, is
+// sampled.
+TEST_F(NumaPerformanceTest, MigrationMovesHotPagesToTheirUsers) {
+    constexpr size_t PAGES_PER_WORKER = 1024;
+    constexpr size_t READS_PER_EPOCH = 1 << 18;
+    constexpr size_t SAMPLE_INTERVAL = 64;
+    constexpr size_t MIGRATE_BATCH = 512;
+    constexpr uint64_t BASE = 0x40000000;
+
+    for (size_t worker = 0; worker < NODES; worker++) {
+        for (size_t page = 0; page < PAGES_PER_WORKER; page++) {
+            faultIn(BASE + (worker * PAGES_PER_WORKER + page) * PAGE, NumaPolicy::firstTouch(), 0);
+        }
+    }
+
+    std::mt19937 rng(9);
+    std::vector<double> costPerEpoch;
+    for (size_t epoch = 0; epoch < 12; epoch++) {
+        uint64_t cost = 0;
+        for (size_t read = 0; read < READS_PER_EPOCH; read++) {
+            size_t worker = read % NODES;
+            uint64_t virt = BASE + (worker * PAGES_PER_WORKER + rng() % PAGES_PER_WORKER) * PAGE;
+            void* frame = pageTable.at(virt);
+            uint64_t stamp;
+            std::memcpy(&stamp, frame, sizeof(stamp));
+            ASSERT_EQ(stamp, virt);
+            cost += topology.distance(worker, allocator->nodeOf(frame));
+            if (rng() % SAMPLE_INTERVAL == 0) balancer->recordAccess(virt, worker);
+        }
+        costPerEpoch.push_back(double(cost) / READS_PER_EPOCH);
+        balancer->migrate(MIGRATE_BATCH);
+    }
+
+    size_t misplaced = 0;
+    for (size_t worker = 0; worker < NODES; worker++) {
+        for (size_t page = 0; page < PAGES_PER_WORKER; page++) {
+            void* frame = pageTable.at(BASE + (worker * PAGES_PER_WORKER + page) * PAGE);
+            if (allocator->nodeOf(frame) != worker) misplaced++;
+        }
+    }
+
+    auto stats = balancer->getStats();
+    std::cout << "Mean access distance: " << costPerEpoch.front() << " before, " << costPerEpoch.back()
+              << " after " << stats.migrations << " migrations from " << stats.samples
+              << " samples; " << misplaced << " of " << NODES * PAGES_PER_WORKER
+              << " pages still remote" << std::endl;
+
+    EXPECT_GT(costPerEpoch.front(), 18.0);
+    EXPECT_LT(costPerEpoch.back(), 12.0);
+    EXPECT_LT(misplaced, NODES * PAGES_PER_WORKER / 10);
+    EXPECT_LE(stats.migrations, 3 * PAGES_PER_WORKER); // Worker 0's pages never move
+    EXPECT_EQ(stats.migrationFailures, 0u);
+    EXPECT_EQ(allocator->getFreePageCount(0), NODE_SIZE / PAGE - PAGES_PER_WORKER - misplaced);
+}
+
+// Pages touched from two nodes in alternation never build a streak
+TEST_F(NumaPerformanceTest, SharedPagesDoNotPingPong) {
+    constexpr uint64_t BASE = 0x50000000;
+    for (size_t page = 0; page < 256; page++) faultIn(BASE + page * PAGE, NumaPolicy::firstTouch(), 0);
+
+    for (size_t round = 0; round < 8; round++) {
+        for (size_t page = 0; page < 256; page++) {
+            balancer->recordAccess(BASE + page * PAGE, 1 + round % 2);
+        }
+        balancer->migrate(256);
+    }
+    EXPECT_EQ(balancer->getStats().migrations, 0u);
+}
+
+} // namespace Test
+} // namespace Memory
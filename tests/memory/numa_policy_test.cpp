@@ -0,0 +1,153 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/NumaPolicy.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+// Four simulated nodes of 32 MB each; node 0 is nearer to node 2 than
+// to node 1
+class NumaPolicyTest : public ::testing::Test {
+protected:
+    static constexpr size_t NODES = 4;
+    static constexpr size_t PAGE = NumaPageAllocator::PAGE_SIZE;
+    static constexpr size_t NODE_SIZE = 32 * 1024 * 1024;
+
+    void SetUp() override {
+        topology.setDistance(0, 1, 32);
+        topology.setDistance(0, 2, 16);
+        memory = static_cast<uint8_t*>(std::aligned_alloc(PAGE, NODES * NODE_SIZE));
+        allocator = std::make_unique<NumaPageAllocator>(topology);
+        for (size_t node = 0; node < NODES; node++) {
+            allocator->addNode(node, memory + node * NODE_SIZE, NODE_SIZE);
+        }
+    }
+
+    void TearDown() override {
+        allocator.reset();
+        std::free(memory);
+    }
+
+    // Faults in a page under policy from a CPU on node, stamping it with its address
+    size_t faultIn(uint64_t virt, const NumaPolicy& policy, size_t node) {
+        auto allocation = allocator->allocate(PAGE, policy, node, virt);
+        EXPECT_NE(allocation.address, nullptr);
+        pageTable[virt] = allocation.address;
+        std::memcpy(allocation.address, &virt, sizeof(virt));
+        return allocation.node;
+    }
+
+    NumaTopology topology{NODES, 2};
+    uint8_t* memory = nullptr;
+    std::unique_ptr<NumaPageAllocator> allocator;
+    std::unordered_map<uint64_t, void*> pageTable;
+};
+
+TEST_F(NumaPolicyTest, PoliciesPlacePages) {
+    NumaPolicyTable policies;
+    policies.setProcessPolicy(1, NumaPolicy::interleave());
+    policies.setRegionPolicy(1, 0x100000, 0x100000, NumaPolicy::preferred(3));
+    policies.setRegionPolicy(1, 0x140000, 0x10000, NumaPolicy::firstTouch()); // Punches a hole
+
+    EXPECT_EQ(policies.lookup(1, 0x0).mode, NumaPolicy::Mode::Interleave);
+    EXPECT_EQ(policies.lookup(1, 0x100000).mode, NumaPolicy::Mode::Preferred);
+    EXPECT_EQ(policies.lookup(1, 0x140000).mode, NumaPolicy::Mode::FirstTouch);
+    EXPECT_EQ(policies.lookup(1, 0x150000).mode, NumaPolicy::Mode::Preferred);
+    EXPECT_EQ(policies.lookup(1, 0x200000).mode, NumaPolicy::Mode::Interleave);
+    EXPECT_EQ(policies.lookup(2, 0x100000).mode, NumaPolicy::Mode::FirstTouch);
+    policies.removeProcess(1);
+    EXPECT_EQ(policies.lookup(1, 0x100000).mode, NumaPolicy::Mode::FirstTouch);
+
+    // Interleave spreads a buffer evenly by page offset
+    std::vector<size_t> perNode(NODES);
+    for (uint64_t virt = 0x10000000; virt < 0x10000000 + 1024 * PAGE; virt += PAGE) {
+        perNode[faultIn(virt, NumaPolicy::interleave(), 1)]++;
+    }
+    for (size_t count : perNode) EXPECT_EQ(count, 256u);
+
+    // First touch follows the faulting CPU's node
+    EXPECT_EQ(faultIn(0x20000000, NumaPolicy::firstTouch(), topology.nodeOfCpu(5)), 2u);
+
+    // Huge frames follow the same policy, aligned within the node
+    constexpr size_t LARGE = 2 * 1024 * 1024;
+    auto huge = allocator->allocate(LARGE, NumaPolicy::preferred(3), 0, 0x40000000, LARGE);
+    ASSERT_NE(huge.address, nullptr);
+    EXPECT_EQ(huge.node, 3u);
+    EXPECT_EQ(allocator->nodeOf(huge.address), 3u);
+    EXPECT_EQ((static_cast<uint8_t*>(huge.address) - (memory + 3 * NODE_SIZE)) % LARGE, 0);
+    allocator->free(huge.address, LARGE);
+
+    // Preferred node 0 spills to node 2, its nearest neighbour, once full
+    uint64_t virt = 0x30000000;
+    while (allocator->getFreePageCount(0) > 0) faultIn(virt += PAGE, NumaPolicy::preferred(0), 3);
+    EXPECT_EQ(faultIn(virt += PAGE, NumaPolicy::preferred(0), 3), 2u);
+    EXPECT_GE(allocator->getStats().misses, 1u);
+}
+
+// The copy runs against a write-protected page, and write access comes
+// back only once the new frame is installed. A page that was read-only
+// before migrating stays read-only.
+TEST_F(NumaPolicyTest, MigrationCopiesWriteProtectedPages) {
+    constexpr uint64_t WRITABLE = 0x60000000;
+    constexpr uint64_t READ_ONLY = WRITABLE + PAGE;
+    faultIn(WRITABLE, NumaPolicy::firstTouch(), 0);
+    faultIn(READ_ONLY, NumaPolicy::firstTouch(), 0);
+
+    std::unordered_set<uint64_t> readOnly = {READ_ONLY};
+    std::vector<std::string> events;
+    NumaBalancer::Backend backend;
+    backend.frameOf = [this](uint64_t virt) -> void* {
+        auto it = pageTable.find(virt);
+        return it == pageTable.end() ? nullptr : it->second;
+    };
+    backend.copyPage = [&](void* dst, const void* src) {
+        for (auto& [virt, frame] : pageTable) {
+            if (frame == src) {
+                EXPECT_TRUE(readOnly.count(virt)) << "copied a writable page";
+            }
+        }
+        std::memcpy(dst, src, PAGE);
+        events.push_back("copy");
+    };
+    backend.remap = [&](uint64_t virt, void* frame) {
+        EXPECT_TRUE(readOnly.count(virt));
+        pageTable[virt] = frame;
+        events.push_back("remap");
+    };
+    backend.setWritable = [&](uint64_t virt, bool writable) {
+        bool was = !readOnly.count(virt);
+        if (writable) {
+            readOnly.erase(virt);
+        } else {
+            readOnly.insert(virt);
+        }
+        events.push_back(writable ? "unprotect" : "protect");
+        return was;
+    };
+    NumaBalancer balancer(*allocator, std::move(backend));
+
+    for (int sample = 0; sample < NumaBalancer::MIGRATE_STREAK; sample++) {
+        balancer.recordAccess(WRITABLE, 1);
+        balancer.recordAccess(READ_ONLY, 1);
+    }
+    EXPECT_EQ(balancer.migrate(2), 2u);
+    EXPECT_EQ(events, (std::vector<std::string>{"protect", "copy", "remap", "unprotect",
+                                                "protect", "copy", "remap"}));
+    EXPECT_FALSE(readOnly.count(WRITABLE));
+    EXPECT_TRUE(readOnly.count(READ_ONLY));
+    for (uint64_t virt : {WRITABLE, READ_ONLY}) {
+        EXPECT_EQ(allocator->nodeOf(pageTable.at(virt)), 1u);
+        uint64_t stamp;
+        std::memcpy(&stamp, pageTable.at(virt), sizeof(stamp));
+        EXPECT_EQ(stamp, virt);
+    }
+}
+
+} // namespace Test
+} // namespace Memory
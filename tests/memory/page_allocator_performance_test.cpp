@@ -0,0 +1,132 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/PageAllocator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+// The pre-buddy allocator: first-fit linear bitmap scan under one mutex.
+// Kept here only as the baseline for the comparison below.
+class LegacyBitmapAllocator {
+public:
+    void initialize(void* start, size_t memorySize) {
+        memoryStart = start;
+        totalPages = memorySize / PageAllocator::PAGE_SIZE;
+        bits.assign(totalPages, false);
+    }
+
+    void* allocate(size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t pageCount = (size + PageAllocator::PAGE_SIZE - 1) / PageAllocator::PAGE_SIZE;
+        size_t consecutivePages = 0;
+        size_t startPage = 0;
+        for (size_t i = 0; i < totalPages; i++) {
+            if (!bits[i]) {
+                if (consecutivePages == 0) startPage = i;
+                if (++consecutivePages == pageCount) {
+                    for (size_t j = 0; j < pageCount; j++) bits[startPage + j] = true;
+                    return (void*)((uintptr_t)memoryStart + startPage * PageAllocator::PAGE_SIZE);
+                }
+            } else {
+                consecutivePages = 0;
+            }
+        }
+        return nullptr;
+    }
+
+    void free(void* address, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t pageCount = (size + PageAllocator::PAGE_SIZE - 1) / PageAllocator::PAGE_SIZE;
+        size_t startPage = ((uintptr_t)address - (uintptr_t)memoryStart) / PageAllocator::PAGE_SIZE;
+        for (size_t i = 0; i < pageCount; i++) bits[startPage + i] = false;
+    }
+
+private:
+    void* memoryStart = nullptr;
+    size_t totalPages = 0;
+    std::vector<bool> bits;
+    std::mutex mutex;
+};
+
+// Each thread keeps a working set of mostly single pages with some
+// multi-page requests, freeing and reallocating at random, on top of a
+// long-lived 75% resident set. Reports mean alloc/free latency per
+// operation for 1-64 threads.
+class PageAllocatorPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr size_t MEMORY_SIZE = 256 * 1024 * 1024; // 64K pages
+    static constexpr size_t RESIDENT_CHUNK = 1024 * 1024;
+    static constexpr size_t OPERATIONS_PER_THREAD = 500;
+    static constexpr size_t WORKING_SET = 64;
+
+    void* const base = (void*)0x100000;
+
+    template<typename Allocator>
+    static void fillResident(Allocator& allocator) {
+        for (size_t i = 0; i < MEMORY_SIZE * 3 / 4 / RESIDENT_CHUNK; i++) {
+            allocator.allocate(RESIDENT_CHUNK);
+        }
+    }
+
+    template<typename Allocator>
+    double run(Allocator& allocator, size_t threadCount) {
+        std::vector<std::thread> threads;
+        std::vector<double> latencies(threadCount);
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&allocator, &latencies, t]() {
+                std::mt19937 rng(static_cast<uint32_t>(t));
+                std::vector<std::pair<void*, size_t>> live;
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < OPERATIONS_PER_THREAD; i++) {
+                    if (live.size() >= WORKING_SET || (!live.empty() && rng() % 2)) {
+                        size_t victim = rng() % live.size();
+                        allocator.free(live[victim].first, live[victim].second);
+                        live[victim] = live.back();
+                        live.pop_back();
+                    } else {
+                        size_t size = rng() % 8 == 0 ? (1 + rng() % 16) * PageAllocator::PAGE_SIZE
+                                                     : PageAllocator::PAGE_SIZE;
+                        if (void* page = allocator.allocate(size)) live.push_back({page, size});
+                    }
+                }
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                latencies[t] = std::chrono::duration<double, std::nano>(elapsed).count() /
+                               OPERATIONS_PER_THREAD;
+                for (auto& [page, size] : live) allocator.free(page, size);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        return *std::max_element(latencies.begin(), latencies.end());
+    }
+};
+
+TEST_F(PageAllocatorPerformanceTest, CompareAgainstLinearScan) {
+    for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+        LegacyBitmapAllocator legacy;
+        legacy.initialize(base, MEMORY_SIZE);
+        fillResident(legacy);
+        PageAllocator buddy;
+        buddy.initialize(base, MEMORY_SIZE);
+        fillResident(buddy);
+        size_t residentFree = buddy.getFreePageCount();
+
+        double legacyNs = run(legacy, threads);
+        double buddyNs = run(buddy, threads);
+        std::cout << threads << " threads: linear scan " << legacyNs << " ns/op, buddy "
+                  << buddyNs << " ns/op" << std::endl;
+
+        EXPECT_LT(buddyNs, legacyNs);
+        EXPECT_EQ(buddy.getFreePageCount(), residentFree);
+        buddy.drainCpuCaches();
+        EXPECT_EQ(buddy.getMarkedPageCount(), buddy.getTotalPageCount() - residentFree);
+    }
+}
+
+} // namespace Test
+} // namespace Memory
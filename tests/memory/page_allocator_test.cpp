@@ -0,0 +1,71 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/PageAllocator.hpp"
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+class PageAllocatorTest : public ::testing::Test {
+protected:
+    void* const base = (void*)0x100000;
+};
+
+TEST_F(PageAllocatorTest, AllocationsNeverOverlap) {
+    PageAllocator allocator;
+    allocator.initialize(base, 64 * 1024 * 1024);
+    std::mt19937 rng(7);
+    std::unordered_map<size_t, size_t> owner; // Page index -> allocation id
+    std::vector<std::pair<void*, size_t>> live;
+
+    for (size_t i = 0; i < 50000; i++) {
+        if (!live.empty() && rng() % 3 == 0) {
+            size_t victim = rng() % live.size();
+            size_t first = ((uintptr_t)live[victim].first - (uintptr_t)base) / PageAllocator::PAGE_SIZE;
+            size_t pages = (live[victim].second + PageAllocator::PAGE_SIZE - 1) / PageAllocator::PAGE_SIZE;
+            for (size_t p = 0; p < pages; p++) owner.erase(first + p);
+            allocator.free(live[victim].first, live[victim].second);
+            live[victim] = live.back();
+            live.pop_back();
+            continue;
+        }
+
+        // Mix of single pages, odd sizes, above-MAX_ORDER runs and huge pages
+        size_t size;
+        void* address;
+        switch (rng() % 4) {
+            case 0: size = PageAllocator::PAGE_SIZE; address = allocator.allocate(size); break;
+            case 1: size = (1 + rng() % 100) * PageAllocator::PAGE_SIZE; address = allocator.allocate(size); break;
+            case 2: size = (1 + rng() % 3) * 5 * 1024 * 1024; address = allocator.allocate(size); break;
+            default:
+                size = 2 * 1024 * 1024;
+                address = allocator.allocateAligned(size, size);
+                if (address) {
+                    EXPECT_EQ(((uintptr_t)address - (uintptr_t)base) % size, 0u);
+                }
+        }
+        if (!address) continue;
+
+        size_t first = ((uintptr_t)address - (uintptr_t)base) / PageAllocator::PAGE_SIZE;
+        size_t pages = (size + PageAllocator::PAGE_SIZE - 1) / PageAllocator::PAGE_SIZE;
+        ASSERT_LE(first + pages, allocator.getTotalPageCount());
+        for (size_t p = 0; p < pages; p++) {
+            ASSERT_TRUE(owner.emplace(first + p, i).second) << "page " << first + p << " handed out twice";
+        }
+        live.push_back({address, size});
+    }
+
+    EXPECT_GE(allocator.getFragmentationRatio(), 0.0f);
+    EXPECT_LE(allocator.getFragmentationRatio(), 1.0f);
+    for (auto& [address, size] : live) allocator.free(address, size);
+    allocator.drainCpuCaches();
+    EXPECT_EQ(allocator.getFreePageCount(), allocator.getTotalPageCount());
+    EXPECT_EQ(allocator.getFreeBlockCount(PageAllocator::MAX_ORDER),
+              allocator.getTotalPageCount() >> PageAllocator::MAX_ORDER);
+}
+
+} // namespace Test
+} // namespace Memory
@@ -0,0 +1,68 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/PageTable.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+class PageTablePerformanceTest : public ::testing::Test {
+protected:
+    static constexpr uint64_t POOL_BASE = 0x7f0000000000;
+    static constexpr uint64_t POOL_PHYS = 0x100000000;
+    static constexpr uint64_t POOL_SIZE = 512ULL * 1024 * 1024;
+    static constexpr uint64_t PAGE = PageTable::PAGE_SIZE;
+
+    template<typename F>
+    static double elapsedMs(F&& f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// A 512 MB texture pool: one hash insert per 4 KB page (the old
+// pageTable) against one 2 MB leaf per 512 pages
+TEST_F(PageTablePerformanceTest, MapsLargePoolWithLargeLeaves) {
+    std::unordered_map<uint64_t, uint64_t> hashTable;
+    double hashMapMs = elapsedMs([&] {
+        for (uint64_t offset = 0; offset < POOL_SIZE; offset += PAGE) {
+            hashTable[POOL_BASE + offset] = POOL_PHYS + offset;
+        }
+    });
+
+    PageTable pageTable;
+    bool mapped = false;
+    double radixMapMs = elapsedMs([&] { mapped = pageTable.mapRange(POOL_BASE, POOL_PHYS, POOL_SIZE); });
+    ASSERT_TRUE(mapped);
+
+    std::mt19937_64 rng(5);
+    std::vector<uint64_t> probes(1 << 20);
+    for (auto& probe : probes) probe = POOL_BASE + rng() % POOL_SIZE;
+
+    uint64_t hashSum = 0, radixSum = 0;
+    double hashLookupMs = elapsedMs([&] {
+        for (uint64_t virt : probes) {
+            hashSum += hashTable.find(virt & ~(PAGE - 1))->second + (virt & (PAGE - 1));
+        }
+    });
+    double radixLookupMs = elapsedMs([&] {
+        for (uint64_t virt : probes) radixSum += pageTable.translate(virt)->physicalAddr;
+    });
+
+    std::cout << "Map 512 MB: hash " << hashTable.size() << " inserts in " << hashMapMs
+              << " ms, radix " << pageTable.getStats().entryWrites << " entries in " << radixMapMs
+              << " ms" << std::endl;
+    std::cout << "1M lookups: hash " << hashLookupMs << " ms, radix " << radixLookupMs << " ms" << std::endl;
+
+    EXPECT_EQ(hashSum, radixSum);
+    EXPECT_EQ(pageTable.getStats().entryWrites, POOL_SIZE / PageTable::LARGE_PAGE_SIZE);
+    EXPECT_EQ(pageTable.translate(POOL_BASE + 12345)->pageSize, PageTable::LARGE_PAGE_SIZE);
+    EXPECT_LT(radixMapMs, hashMapMs);
+}
+
+} // namespace Test
+} // namespace Memory
@@ -0,0 +1,117 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/PageTable.hpp"
+#include <utility>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+class PageTableTest : public ::testing::Test {
+protected:
+    static constexpr uint64_t POOL_BASE = 0x7f0000000000;
+    static constexpr uint64_t POOL_PHYS = 0x100000000;
+    static constexpr uint64_t PAGE = PageTable::PAGE_SIZE;
+};
+
+TEST_F(PageTableTest, UsesGigabyteLeavesWhenAligned) {
+    PageTable pageTable;
+    uint64_t virt = 0xffff800000000000;
+    ASSERT_TRUE(pageTable.mapRange(virt, 0, 2 * PageTable::HUGE_PAGE_SIZE));
+    EXPECT_EQ(pageTable.getStats().entryWrites, 2u);
+
+    auto translation = pageTable.translate(virt + PageTable::HUGE_PAGE_SIZE + 0x1234);
+    ASSERT_TRUE(translation);
+    EXPECT_EQ(translation->physicalAddr, PageTable::HUGE_PAGE_SIZE + 0x1234);
+    EXPECT_EQ(translation->pageSize, PageTable::HUGE_PAGE_SIZE);
+
+    // Misaligned physical base falls back to 2 MB leaves
+    PageTable misaligned;
+    ASSERT_TRUE(misaligned.mapRange(0, PageTable::LARGE_PAGE_SIZE, PageTable::HUGE_PAGE_SIZE));
+    EXPECT_EQ(misaligned.getStats().entryWrites, 512u);
+}
+
+TEST_F(PageTableTest, PartialUnmapSplitsLargeLeaf) {
+    PageTable pageTable;
+    ASSERT_TRUE(pageTable.mapRange(POOL_BASE, POOL_PHYS, 2 * PageTable::LARGE_PAGE_SIZE));
+    EXPECT_FALSE(pageTable.mapRange(POOL_BASE + PAGE, 0, PAGE)); // Already mapped
+
+    uint64_t hole = POOL_BASE + PageTable::LARGE_PAGE_SIZE + 16 * PAGE;
+    EXPECT_EQ(pageTable.unmapRange(hole, PAGE), PAGE);
+    EXPECT_EQ(pageTable.getStats().splits, 1u);
+    EXPECT_FALSE(pageTable.translate(hole));
+
+    auto neighbour = pageTable.translate(hole + PAGE);
+    ASSERT_TRUE(neighbour);
+    EXPECT_EQ(neighbour->physicalAddr, POOL_PHYS + PageTable::LARGE_PAGE_SIZE + 17 * PAGE);
+    EXPECT_EQ(neighbour->pageSize, PAGE);
+    EXPECT_EQ(pageTable.translate(POOL_BASE)->pageSize, PageTable::LARGE_PAGE_SIZE);
+
+    // Leaves of different sizes still merge into contiguous runs
+    std::vector<std::pair<uint64_t, uint64_t>> runs;
+    pageTable.forEachRange(POOL_BASE, 2 * PageTable::LARGE_PAGE_SIZE,
+                           [&](uint64_t virt, uint64_t, uint64_t length, const PageTable::Protection&) {
+        runs.push_back({virt, length});
+    });
+    ASSERT_EQ(runs.size(), 2u);
+    EXPECT_EQ(runs[0].first, POOL_BASE);
+    EXPECT_EQ(runs[0].second, hole - POOL_BASE);
+    EXPECT_EQ(runs[1].first, hole + PAGE);
+    EXPECT_EQ(runs[1].second, POOL_BASE + 2 * PageTable::LARGE_PAGE_SIZE - hole - PAGE);
+
+    // Unmapping everything frees every table but the root
+    pageTable.unmapRange(POOL_BASE, 2 * PageTable::LARGE_PAGE_SIZE);
+    EXPECT_EQ(pageTable.getStats().tables, 1u);
+    EXPECT_FALSE(pageTable.translate(POOL_BASE));
+}
+
+// A sub-page range inside a large leaf unmaps the whole page it touches
+// instead of asking split() for a level below the smallest page
+TEST_F(PageTableTest, SubPageUnmapOfLargeLeaf) {
+    PageTable pageTable;
+    const uint64_t base = 0x200000;
+    ASSERT_TRUE(pageTable.mapRange(base, POOL_PHYS, PageTable::LARGE_PAGE_SIZE));
+
+    EXPECT_EQ(pageTable.unmapRange(base, 0x800), PAGE);
+    EXPECT_EQ(pageTable.getStats().splits, 1u);
+    EXPECT_FALSE(pageTable.translate(base));
+    EXPECT_FALSE(pageTable.translate(base + 0x800));
+
+    auto next = pageTable.translate(base + PAGE);
+    ASSERT_TRUE(next);
+    EXPECT_EQ(next->physicalAddr, POOL_PHYS + PAGE);
+    EXPECT_EQ(next->pageSize, PAGE);
+
+    // An unaligned range ending mid-page covers that last page too
+    EXPECT_EQ(pageTable.unmapRange(base + 3 * PAGE - 1, 2), 2 * PAGE);
+    EXPECT_FALSE(pageTable.translate(base + 3 * PAGE));
+    EXPECT_TRUE(pageTable.translate(base + 4 * PAGE));
+
+    EXPECT_EQ(pageTable.unmapRange(base, PageTable::LARGE_PAGE_SIZE), PageTable::LARGE_PAGE_SIZE - 3 * PAGE);
+    EXPECT_EQ(pageTable.getStats().tables, 1u);
+}
+
+// Write-protecting one page of a large leaf splits it; the rest of the
+// leaf keeps its access and a leaf already in the right state is left whole
+TEST_F(PageTableTest, SetWritableSplitsOnlyPartialLeaves) {
+    PageTable pageTable;
+    ASSERT_TRUE(pageTable.mapRange(POOL_BASE, POOL_PHYS, 2 * PageTable::LARGE_PAGE_SIZE));
+    uint64_t page = POOL_BASE + 5 * PAGE;
+
+    EXPECT_EQ(pageTable.setWritable(page, PAGE, false), PAGE);
+    EXPECT_EQ(pageTable.getStats().splits, 1u);
+    EXPECT_FALSE(pageTable.translate(page)->protection.writable);
+    EXPECT_EQ(pageTable.translate(page)->physicalAddr, POOL_PHYS + 5 * PAGE);
+    EXPECT_TRUE(pageTable.translate(page + PAGE)->protection.writable);
+    EXPECT_TRUE(pageTable.translate(POOL_BASE + PageTable::LARGE_PAGE_SIZE)->protection.writable);
+
+    EXPECT_EQ(pageTable.setWritable(POOL_BASE + PageTable::LARGE_PAGE_SIZE + PAGE, PAGE, true), PAGE);
+    EXPECT_EQ(pageTable.getStats().splits, 1u);
+    EXPECT_EQ(pageTable.translate(POOL_BASE + PageTable::LARGE_PAGE_SIZE)->pageSize, PageTable::LARGE_PAGE_SIZE);
+
+    EXPECT_EQ(pageTable.setWritable(page, PAGE, true), PAGE);
+    EXPECT_TRUE(pageTable.translate(page)->protection.writable);
+    EXPECT_EQ(pageTable.setWritable(POOL_BASE + 4 * PageTable::LARGE_PAGE_SIZE, PAGE, false), 0u);
+}
+
+} // namespace Test
+} // namespace Memory
@@ -0,0 +1,153 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/SlabAllocator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+// The pre-slab small-object path of OptimizedUnifiedMemoryManager: one
+// global mutex, cache-line rounding, a bump pointer that never reuses
+// freed space and a hash map entry per allocation. Kept only as the
+// baseline for the comparison below.
+class LegacyPoolAllocator {
+public:
+    explicit LegacyPoolAllocator(size_t size) : pool(new char[size]), poolSize(size) {}
+
+    void* allocate(size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size = (size + 63) & ~size_t(63);
+        if (used + size > poolSize) return nullptr;
+        void* ptr = pool.get() + used;
+        used += size;
+        allocations[ptr] = size;
+        return ptr;
+    }
+
+    void free(void* ptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        allocations.erase(ptr);
+    }
+
+private:
+    std::unique_ptr<char[]> pool;
+    size_t poolSize;
+    size_t used = 0;
+    std::mutex mutex;
+    std::unordered_map<void*, size_t> allocations;
+};
+
+class SlabAllocatorPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr size_t OPERATIONS_PER_THREAD = 100000;
+    static constexpr size_t WORKING_SET = 512;
+
+    // UI/audio-like churn: mostly tiny objects, occasionally a few KB
+    static size_t randomSize(std::mt19937& rng) {
+        return rng() % 16 == 0 ? 1024 + rng() % 8192 : 16 + rng() % 240;
+    }
+
+    template<typename Allocator>
+    static double churn(Allocator& allocator, size_t threadCount) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&allocator, t]() {
+                std::mt19937 rng(static_cast<uint32_t>(t + 1));
+                std::vector<void*> live(WORKING_SET, nullptr);
+                for (size_t i = 0; i < OPERATIONS_PER_THREAD; i++) {
+                    void*& slot = live[rng() % WORKING_SET];
+                    if (slot) {
+                        allocator.free(slot);
+                        slot = nullptr;
+                    } else {
+                        slot = allocator.allocate(randomSize(rng));
+                    }
+                }
+                for (void* ptr : live) {
+                    if (ptr) allocator.free(ptr);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() /
+               (OPERATIONS_PER_THREAD * threadCount);
+    }
+};
+
+TEST_F(SlabAllocatorPerformanceTest, CompareAgainstGlobalPool) {
+    for (size_t threads : {1, 2, 4, 8, 16}) {
+        // The bump pool is only reserved, never touched; if it runs dry the
+        // baseline just gets faster failed allocations
+        LegacyPoolAllocator legacy(1ULL << 30);
+        SlabAllocator slabs;
+
+        double legacyNs = churn(legacy, threads);
+        double slabNs = churn(slabs, threads);
+        std::cout << threads << " threads: global pool " << legacyNs << " ns/op, slab "
+                  << slabNs << " ns/op" << std::endl;
+        EXPECT_LT(slabNs, legacyNs);
+    }
+}
+
+// Producer allocates, consumer frees: every free is a remote free
+TEST_F(SlabAllocatorPerformanceTest, CrossThreadFreesAreReclaimed) {
+    SlabAllocator slabs;
+    constexpr size_t ROUNDS = 50;
+    constexpr size_t BATCH = 20000;
+
+    std::mutex handoffMutex;
+    std::vector<std::vector<void*>> handoff;
+    bool done = false;
+
+    std::thread consumer([&]() {
+        while (true) {
+            std::vector<void*> batch;
+            {
+                std::lock_guard<std::mutex> lock(handoffMutex);
+                if (!handoff.empty()) {
+                    batch = std::move(handoff.back());
+                    handoff.pop_back();
+                } else if (done) {
+                    break;
+                }
+            }
+            for (void* ptr : batch) slabs.free(ptr);
+            if (batch.empty()) std::this_thread::yield();
+        }
+    });
+
+    std::mt19937 rng(11);
+    size_t peakSlabs = 0;
+    for (size_t round = 0; round < ROUNDS; round++) {
+        std::vector<void*> batch;
+        for (size_t i = 0; i < BATCH; i++) {
+            void* ptr = slabs.allocate(16 + rng() % 112);
+            ASSERT_NE(ptr, nullptr);
+            batch.push_back(ptr);
+        }
+        std::lock_guard<std::mutex> lock(handoffMutex);
+        handoff.push_back(std::move(batch));
+        peakSlabs = std::max(peakSlabs, slabs.getSlabCount());
+    }
+    {
+        std::lock_guard<std::mutex> lock(handoffMutex);
+        done = true;
+    }
+    consumer.join();
+
+    // Remote frees must be recycled rather than growing the arena each round
+    std::cout << "Peak slabs: " << peakSlabs << std::endl;
+    EXPECT_LT(peakSlabs, ROUNDS * BATCH * 128 / SlabAllocator::SLAB_SIZE / 2);
+}
+
+} // namespace Test
+} // namespace Memory
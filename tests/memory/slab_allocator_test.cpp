@@ -0,0 +1,66 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/SlabAllocator.hpp"
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+TEST(SlabAllocatorTest, ObjectsAreDisjointAndSized) {
+    SlabAllocator slabs;
+    std::mt19937 rng(5);
+    std::vector<std::pair<unsigned char*, size_t>> live;
+
+    for (size_t i = 0; i < 100000; i++) {
+        if (!live.empty() && rng() % 2) {
+            size_t victim = rng() % live.size();
+            auto [ptr, size] = live[victim];
+            for (size_t b = 0; b < size; b++) {
+                ASSERT_EQ(ptr[b], static_cast<unsigned char>(reinterpret_cast<uintptr_t>(ptr) >> 4));
+            }
+            slabs.free(ptr);
+            live[victim] = live.back();
+            live.pop_back();
+            continue;
+        }
+        size_t size = 1 + rng() % SlabAllocator::MAX_SMALL_SIZE / (rng() % 64 + 1);
+        auto* ptr = static_cast<unsigned char*>(slabs.allocate(size));
+        ASSERT_NE(ptr, nullptr);
+        ASSERT_TRUE(slabs.owns(ptr));
+        ASSERT_GE(slabs.sizeOf(ptr), size);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % 16, 0u);
+        std::memset(ptr, static_cast<unsigned char>(reinterpret_cast<uintptr_t>(ptr) >> 4), size);
+        live.push_back({ptr, size});
+    }
+
+    EXPECT_EQ(slabs.allocate(0), nullptr);
+    EXPECT_EQ(slabs.allocate(SlabAllocator::MAX_SMALL_SIZE + 1), nullptr);
+    for (size_t i = 0; i < SlabAllocator::SIZE_CLASSES; i++) {
+        EXPECT_EQ(SlabAllocator::classIndex(SlabAllocator::classSize(i)), i);
+    }
+    for (auto& [ptr, size] : live) slabs.free(ptr);
+}
+
+// The memory manager rounds requests to cache lines before they reach the
+// slab, and relies on those landing in cache-line aligned objects
+TEST(SlabAllocatorTest, CacheLineMultiplesStayCacheLineAligned) {
+    constexpr size_t CACHE_LINE = 64;
+    SlabAllocator slabs;
+    std::vector<void*> live;
+    for (size_t size = CACHE_LINE; size <= SlabAllocator::MAX_SMALL_SIZE; size += CACHE_LINE) {
+        EXPECT_EQ(SlabAllocator::classSize(SlabAllocator::classIndex(size)) % CACHE_LINE, 0u) << size;
+        for (int i = 0; i < 3; i++) {
+            void* ptr = slabs.allocate(size);
+            ASSERT_NE(ptr, nullptr);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % CACHE_LINE, 0u) << size;
+            live.push_back(ptr);
+        }
+    }
+    for (void* ptr : live) slabs.free(ptr);
+}
+
+} // namespace Test
+} // namespace Memory
@@ -0,0 +1,187 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/TLB.hpp"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace Memory {
+namespace Test {
+
+// Replays one alloc/free trace on a simulated 4-CPU machine twice: once
+// the old way (no address-space tags, one shootdown per page to every
+// CPU) and once with PCID tags and batched range shootdowns.
+class TLBPerformanceTest : public ::testing::Test {
+protected:
+    static constexpr size_t CPUS = 4;
+    static constexpr uint32_t PROCESSES = 10;
+    static constexpr size_t STEPS = 40000;
+    static constexpr uint64_t PAGE = uint64_t(1) << SoftwareTLB::PAGE_SHIFT;
+
+    enum class Kind { Switch, Access, Remap };
+
+    struct Event {
+        Kind kind;
+        size_t cpu;
+        uint32_t process;
+        size_t region; // Region index for Access/Remap
+        size_t page;   // Page within the region for Access
+    };
+
+    struct Region {
+        uint64_t base;
+        size_t pages;
+    };
+
+    struct Result {
+        uint64_t shootdowns = 0;
+        uint64_t misses = 0;
+        uint64_t hits = 0;
+        uint64_t fullFlushes = 0;
+        uint64_t staleHits = 0;
+    };
+
+    // Each process owns a few regions, mostly small with some large
+    // buffers. Remapping frees a region and maps it again at the same
+    // address with new frames, so a missed invalidation shows up as a
+    // stale hit.
+    static std::vector<std::vector<Region>> makeRegions(std::mt19937& rng) {
+        std::vector<std::vector<Region>> regions(PROCESSES);
+        for (auto& process : regions) {
+            uint64_t base = 0x400000;
+            for (int i = 0; i < 8; i++) {
+                size_t pages = rng() % 4 == 0 ? 32 + rng() % 96 : 1 + rng() % 16;
+                process.push_back({base, pages});
+                base += (pages + 16) * PAGE;
+            }
+        }
+        return regions;
+    }
+
+    // Processes mostly stay on a home CPU, so a CPU cycles through a few
+    // address spaces; every 400 steps one migrates elsewhere
+    static std::vector<Event> makeTrace(const std::vector<std::vector<Region>>& regions,
+                                        std::mt19937& rng) {
+        std::vector<Event> trace;
+        std::vector<uint32_t> running(CPUS);
+        for (size_t cpu = 0; cpu < CPUS; cpu++) {
+            running[cpu] = static_cast<uint32_t>(cpu);
+            trace.push_back({Kind::Switch, cpu, running[cpu], 0, 0});
+        }
+        for (size_t step = 0; step < STEPS; step++) {
+            size_t cpu = step % CPUS;
+            if (rng() % 50 == 0) {
+                uint32_t process = static_cast<uint32_t>(rng() % 3) * CPUS + static_cast<uint32_t>(cpu);
+                if (step % 400 == 0 || process >= PROCESSES) process = rng() % PROCESSES;
+                running[cpu] = process;
+                trace.push_back({Kind::Switch, cpu, process, 0, 0});
+            }
+            uint32_t process = running[cpu];
+            size_t region = rng() % regions[process].size();
+            if (rng() % 200 == 0) {
+                trace.push_back({Kind::Remap, cpu, process, region, 0});
+                continue;
+            }
+            // Accesses cluster at the start of a region
+            size_t pages = regions[process][region].pages;
+            size_t page = rng() % std::min<size_t>(pages, 8);
+            trace.push_back({Kind::Access, cpu, process, region, page});
+        }
+        return trace;
+    }
+
+    static Result replay(const std::vector<Event>& trace,
+                         std::vector<std::vector<Region>> regions, bool optimized) {
+        std::vector<std::unique_ptr<SoftwareTLB>> tlbs;
+        std::vector<SoftwareTLB*> cpus;
+        for (size_t i = 0; i < CPUS; i++) {
+            tlbs.push_back(std::make_unique<SoftwareTLB>(optimized));
+            cpus.push_back(tlbs.back().get());
+        }
+
+        // Page table: (process, page) -> frame
+        std::vector<std::unordered_map<uint64_t, uint64_t>> pageTables(PROCESSES);
+        uint64_t nextFrame = 1;
+        auto map = [&](uint32_t process, const Region& region) {
+            for (size_t i = 0; i < region.pages; i++) {
+                pageTables[process][region.base / PAGE + i] = nextFrame++;
+            }
+        };
+        for (uint32_t process = 0; process < PROCESSES; process++) {
+            for (const Region& region : regions[process]) map(process, region);
+        }
+
+        Result result;
+        for (const Event& event : trace) {
+            SoftwareTLB& tlb = *cpus[event.cpu];
+            const Region& region = regions[event.process][event.region];
+            switch (event.kind) {
+            case Kind::Switch:
+                tlb.switchTo(event.process);
+                break;
+            case Kind::Access: {
+                uint64_t address = region.base + event.page * PAGE;
+                uint64_t frame = pageTables[event.process].at(address / PAGE);
+                uint64_t physical;
+                if (tlb.lookup(address, physical)) {
+                    if (physical / PAGE != frame) result.staleHits++;
+                } else {
+                    tlb.insert(address, frame * PAGE);
+                }
+                break;
+            }
+            case Kind::Remap:
+                if (optimized) {
+                    TLBShootdownBatch batch(cpus, event.process);
+                    batch.add(region.base, region.pages);
+                } else {
+                    for (size_t i = 0; i < region.pages; i++) {
+                        for (SoftwareTLB* cpu : cpus) {
+                            cpu->recordShootdown();
+                            cpu->invalidatePage(event.process, region.base + i * PAGE);
+                        }
+                    }
+                }
+                map(event.process, region);
+                break;
+            }
+        }
+
+        for (SoftwareTLB* cpu : cpus) {
+            const auto& stats = cpu->getStats();
+            result.shootdowns += stats.shootdowns;
+            result.misses += stats.misses;
+            result.hits += stats.hits;
+            result.fullFlushes += stats.fullFlushes;
+        }
+        return result;
+    }
+};
+
+TEST_F(TLBPerformanceTest, BatchedShootdownsAndTagsReduceFlushesAndMisses) {
+    std::mt19937 rng(13);
+    auto regions = makeRegions(rng);
+    auto trace = makeTrace(regions, rng);
+
+    Result legacy = replay(trace, regions, false);
+    Result tagged = replay(trace, regions, true);
+
+    auto missRate = [](const Result& r) {
+        return 100.0 * static_cast<double>(r.misses) / static_cast<double>(r.hits + r.misses);
+    };
+    std::cout << "Per-page shootdowns: " << legacy.shootdowns << " IPIs, "
+              << missRate(legacy) << "% misses" << std::endl;
+    std::cout << "Batched + PCID:      " << tagged.shootdowns << " IPIs, "
+              << missRate(tagged) << "% misses, " << tagged.fullFlushes
+              << " range flushes" << std::endl;
+
+    EXPECT_EQ(legacy.staleHits, 0u);
+    EXPECT_EQ(tagged.staleHits, 0u);
+    EXPECT_LT(tagged.shootdowns * 10, legacy.shootdowns);
+    EXPECT_LT(tagged.misses * 3, legacy.misses * 2);
+}
+
+} // namespace Test
+} // namespace Memory
@@ -0,0 +1,42 @@
+#include "../../gtest/gtest.h"
+#include "../../memory/TLB.hpp"
+#include <cstdint>
+
+namespace Memory {
+namespace Test {
+
+class TLBTest : public ::testing::Test {
+protected:
+    static constexpr uint64_t PAGE = uint64_t(1) << SoftwareTLB::PAGE_SHIFT;
+};
+
+TEST_F(TLBTest, RangeInvalidationIsScopedToAddressSpace) {
+    SoftwareTLB tlb;
+    uint64_t physical;
+
+    tlb.switchTo(1);
+    for (uint64_t i = 0; i < 8; i++) tlb.insert(i * PAGE, (100 + i) * PAGE);
+    tlb.switchTo(2);
+    for (uint64_t i = 0; i < 8; i++) tlb.insert(i * PAGE, (200 + i) * PAGE);
+    tlb.insert(0x100000, 0x900000, true); // Global
+
+    tlb.invalidateRange(1, 0, 4);
+    EXPECT_TRUE(tlb.lookup(0, physical)); // Address space 2 untouched
+    EXPECT_EQ(physical, 200 * PAGE);
+
+    tlb.switchTo(1);
+    EXPECT_FALSE(tlb.lookup(3 * PAGE, physical));
+    EXPECT_TRUE(tlb.lookup(4 * PAGE, physical)); // Survived the switch
+    EXPECT_EQ(physical, 104 * PAGE);
+    EXPECT_TRUE(tlb.lookup(0x100000, physical));
+
+    // Past the threshold the tag is flushed once; globals outside the range stay
+    uint64_t flushes = tlb.getStats().fullFlushes;
+    tlb.invalidateRange(1, 0, SoftwareTLB::FULL_FLUSH_THRESHOLD + 1);
+    EXPECT_EQ(tlb.getStats().fullFlushes, flushes + 1);
+    EXPECT_FALSE(tlb.lookup(5 * PAGE, physical));
+    EXPECT_TRUE(tlb.lookup(0x100000, physical));
+}
+
+} // namespace Test
+} // namespace Memory
@@ -0,0 +1,126 @@
+#include "../../gtest/gtest.h"
+#include "../../scheduler/CpuTopology.hpp"
+#include "../../scheduler/RunQueue.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace Kernel {
+namespace Test {
+
+class CpuTopologyTest : public ::testing::Test {
+protected:
+    // A sysfs cpu directory for a two-CCX part: 4 cores of 2 threads,
+    // Linux-numbered so CPU n's sibling is n + 4, each CCX with its own L3
+    static std::string writeFakeSysfs(const char* online = "0-7") {
+        namespace fs = std::filesystem;
+        fs::path root = fs::temp_directory_path() / ("cpu_topology_test_" + std::to_string(::getpid()));
+        fs::path cpuDir = root / "devices/system/cpu";
+        fs::create_directories(cpuDir);
+        std::ofstream(cpuDir / "online") << online << "\n";
+        for (int cpu = 0; cpu < 8; cpu++) {
+            int core = cpu % 4;
+            fs::path base = cpuDir / ("cpu" + std::to_string(cpu));
+            fs::create_directories(base / "topology");
+            std::ofstream(base / "topology/core_id") << core << "\n";
+            std::ofstream(base / "topology/physical_package_id") << 0 << "\n";
+            std::ofstream(base / "topology/thread_siblings_list") << core << "," << core + 4 << "\n";
+            const char* l3 = core < 2 ? "0-1,4-5" : "2-3,6-7";
+            struct Cache { int level; const char* type; std::string shared; };
+            std::string own = std::to_string(core) + "," + std::to_string(core + 4);
+            Cache caches[] = {{1, "Data", own}, {1, "Instruction", own}, {2, "Unified", own}, {3, "Unified", l3}};
+            for (int index = 0; index < 4; index++) {
+                fs::path cache = base / ("cache/index" + std::to_string(index));
+                fs::create_directories(cache);
+                std::ofstream(cache / "level") << caches[index].level << "\n";
+                std::ofstream(cache / "type") << caches[index].type << "\n";
+                std::ofstream(cache / "shared_cpu_list") << caches[index].shared << "\n";
+            }
+        }
+        return root.string();
+    }
+};
+
+TEST_F(CpuTopologyTest, DetectParsesSysfs) {
+    std::string root = writeFakeSysfs();
+    CpuTopology topology = CpuTopology::detect(root + "/devices/system/cpu");
+    std::filesystem::remove_all(root);
+
+    EXPECT_EQ(topology.cpuCount(), 8u);
+    EXPECT_EQ(topology.coreCount(), 4u);
+    EXPECT_EQ(topology.llcCount(), 2u);
+    EXPECT_EQ(topology.packageCount(), 1u);
+    EXPECT_TRUE(topology.sharesCore(1, 5));
+    EXPECT_FALSE(topology.sharesCore(1, 2));
+    EXPECT_TRUE(topology.sharesLlc(0, 5));
+    EXPECT_FALSE(topology.sharesLlc(1, 2));
+    EXPECT_EQ(topology.llcCpus(topology.cpu(6).llc), (std::vector<int>{2, 3, 6, 7}));
+    EXPECT_FALSE(topology.isHybrid());
+
+    // Communicating threads land in one CCX on separate cores
+    ThreadPlacement placement(topology);
+    std::vector<int> pair = placement.placeCommunicating(2);
+    ASSERT_EQ(pair.size(), 2u);
+    EXPECT_TRUE(topology.sharesLlc(pair[0], pair[1]));
+    EXPECT_FALSE(topology.sharesCore(pair[0], pair[1]));
+}
+
+// CPUs 4 and 5 offline: their ids keep a slot, but no run queue domain
+// or placement ever hands them a thread
+TEST_F(CpuTopologyTest, OfflineCpusAreNeverChosen) {
+    std::string root = writeFakeSysfs("0-3,6-7");
+    CpuTopology topology = CpuTopology::detect(root + "/devices/system/cpu");
+    std::filesystem::remove_all(root);
+
+    ASSERT_EQ(topology.cpuCount(), 8u);
+    EXPECT_FALSE(topology.isOnline(4));
+    EXPECT_FALSE(topology.isOnline(5));
+    EXPECT_EQ(topology.coreCount(), 4u);
+    EXPECT_EQ(topology.llcCpus(topology.cpu(0).llc), (std::vector<int>{0, 1}));
+
+    std::vector<uint32_t> llcOfCpu = topology.llcOfCpus();
+    ASSERT_EQ(llcOfCpu.size(), 8u);
+    EXPECT_EQ(llcOfCpu[4], RunQueueSet::OFFLINE);
+    EXPECT_EQ(llcOfCpu[5], RunQueueSet::OFFLINE);
+
+    // Offline queues look idle forever; wake-up placement must not use them
+    RunQueueSet runQueues(std::move(llcOfCpu));
+    std::vector<SchedEntity> entities(32);
+    for (size_t i = 0; i < entities.size(); i++) {
+        entities[i].id = static_cast<uint32_t>(i);
+        entities[i].lastCpu = static_cast<int>(i % 8);
+        int cpu = runQueues.selectCpu(entities[i]);
+        EXPECT_TRUE(runQueues.isOnline(cpu)) << "CPU " << cpu;
+        runQueues.enqueue(&entities[i], cpu);
+    }
+    EXPECT_EQ(runQueues.load(4), 0u);
+    EXPECT_EQ(runQueues.load(5), 0u);
+
+    ThreadPlacement placement(topology);
+    for (int cpu : placement.placeThroughput(12)) EXPECT_TRUE(topology.isOnline(cpu)) << "CPU " << cpu;
+    for (int cpu : placement.placeCommunicating(4)) EXPECT_TRUE(topology.isOnline(cpu)) << "CPU " << cpu;
+    EXPECT_TRUE(topology.isOnline(placement.placeLatencyCritical()));
+}
+
+TEST_F(CpuTopologyTest, DetectMatchesCpuid) {
+    CpuTopology sysfs = CpuTopology::detect();
+    CpuTopology cpuid = CpuTopology::fromCpuid();
+    std::cout << "This machine: " << sysfs.cpuCount() << " CPUs, " << sysfs.coreCount() << " cores, "
+              << sysfs.llcCount() << " last-level caches, " << sysfs.packageCount() << " packages"
+              << (sysfs.isHybrid() ? ", hybrid" : "") << std::endl;
+#if defined(__x86_64__) || defined(__i386__)
+    ASSERT_EQ(cpuid.coreCount(), sysfs.coreCount());
+    for (size_t a = 0; a < sysfs.cpuCount(); a++) {
+        for (size_t b = 0; b < sysfs.cpuCount(); b++) {
+            if (!sysfs.isOnline(int(a)) || !sysfs.isOnline(int(b)) || !cpuid.isOnline(int(a)) || !cpuid.isOnline(int(b))) continue;
+            EXPECT_EQ(cpuid.sharesCore(int(a), int(b)), sysfs.sharesCore(int(a), int(b))) << a << "," << b;
+        }
+    }
+#endif
+}
+
+} // namespace Test
+} // namespace Kernel
@@ -0,0 +1,344 @@
+#include "../../gtest/gtest.h"
+#include "../../scheduler/DeadlineRunQueue.hpp"
+#include "../../scheduler/RunQueue.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+// Simulation helpers are file-local: other test files have their own
+namespace {
+
+constexpr uint64_t US = 1000;
+constexpr uint64_t MS = 1000 * US;
+
+// A simulated thread: periodic jobs (frames, audio buffers) or a
+// background thread with work arriving in bursts
+struct SimThread {
+    const char* name;
+    uint32_t priority;       // What the old scheduler was given
+    DeadlineParams reserve;  // Deadline registration; runtime 0 for none
+    uint64_t period;         // Job release interval
+    uint64_t deadline;       // Relative, for counting misses
+    uint64_t workMin, workMax;
+    size_t spikeEvery;       // Every nth job takes spikeWork instead
+    uint64_t spikeWork;
+
+    struct Job {
+        uint64_t release;
+        uint64_t work;
+    };
+    std::deque<Job> jobs;
+    uint64_t nextRelease = 0;
+    size_t released = 0;
+    size_t completed = 0;
+    size_t missed = 0;
+    uint64_t cpuTime = 0;
+    std::vector<uint64_t> responseTimes; // Release to completion
+
+    SchedEntity entity;
+    DeadlineEntity deadlineEntity;
+
+    bool isDeadline() const { return reserve.runtime != 0; }
+};
+
+// What the simulator asks of a scheduling policy on one CPU
+class SimPolicy {
+public:
+    virtual ~SimPolicy() = default;
+    virtual void wake(SimThread* thread, uint64_t now) = 0;
+    virtual void block(SimThread* thread, uint64_t now) = 0;
+    virtual void tick(uint64_t now) = 0;
+    virtual SimThread* running() const = 0;
+};
+
+// The old EnhancedScheduler: static levels, doubled for anything above
+// priority 10 on the guess that it is a game thread, switched only on
+// the timer tick
+class PriorityBoostPolicy : public SimPolicy {
+public:
+    explicit PriorityBoostPolicy(std::vector<SimThread>& threads) : threads(threads) {
+        for (size_t i = 0; i < threads.size(); i++) {
+            uint64_t level = threads[i].priority > 10 ? threads[i].priority * 2 : threads[i].priority;
+            threads[i].entity.id = static_cast<uint32_t>(i);
+            threads[i].entity.level = static_cast<uint8_t>(std::min<uint64_t>(level, RUNQUEUE_LEVELS - 1));
+        }
+    }
+
+    void wake(SimThread* thread, uint64_t) override {
+        queue.enqueue(&thread->entity, 0);
+        if (!current) switchNext();
+    }
+
+    void block(SimThread* thread, uint64_t) override {
+        if (thread == current) {
+            current = nullptr;
+            switchNext();
+        }
+    }
+
+    void tick(uint64_t) override {
+        if (current && queue.highestLevel() < current->entity.level) return;
+        if (current) queue.enqueue(&current->entity, 0);
+        switchNext();
+    }
+
+    SimThread* running() const override { return current; }
+
+private:
+    void switchNext() {
+        SchedEntity* next = queue.pickNext();
+        current = next ? &threads[next->id] : nullptr;
+    }
+
+    std::vector<SimThread>& threads;
+    CpuRunQueue queue;
+    SimThread* current = nullptr;
+};
+
+// Registered threads in the deadline class, everything else below it on
+// plain levels without the boost
+class DeadlinePolicy : public SimPolicy {
+public:
+    explicit DeadlinePolicy(std::vector<SimThread>& threads) : threads(threads) {
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i].entity.id = static_cast<uint32_t>(i);
+            threads[i].entity.level = static_cast<uint8_t>(threads[i].priority);
+            threads[i].deadlineEntity.id = static_cast<uint32_t>(i);
+            if (threads[i].isDeadline()) {
+                EXPECT_EQ(deadlines.admit(&threads[i].deadlineEntity, threads[i].reserve), Admission::Admitted);
+            }
+        }
+    }
+
+    void wake(SimThread* thread, uint64_t now) override {
+        if (thread->isDeadline()) {
+            deadlines.wake(&thread->deadlineEntity, now);
+            if (deadlines.wakeupPreempts(thread->deadlineEntity)) switchNext(now);
+        } else {
+            levels.enqueue(&thread->entity, 0);
+            if (!current) switchNext(now);
+        }
+    }
+
+    void block(SimThread* thread, uint64_t now) override {
+        if (thread->isDeadline()) deadlines.block(&thread->deadlineEntity, now);
+        if (thread == current) {
+            current = nullptr;
+            switchNext(now);
+        }
+    }
+
+    void tick(uint64_t now) override {
+        bool onDeadline = current && current->isDeadline();
+        if (deadlines.tickPreempts(now)) {
+            switchNext(now);
+        } else if (!onDeadline && (!current || levels.highestLevel() >= current->entity.level)) {
+            switchNext(now);
+        }
+    }
+
+    SimThread* running() const override { return current; }
+
+    // A throttled thread's budget comes back at its next period; a real
+    // kernel arms a timer for it
+    uint64_t nextEvent() const { return deadlines.nextReplenish(); }
+
+    DeadlineRunQueue::Stats stats() const { return deadlines.getStats(); }
+
+private:
+    void switchNext(uint64_t now) {
+        if (current && !current->isDeadline()) levels.enqueue(&current->entity, 0);
+        if (DeadlineEntity* next = deadlines.pickNext(now)) {
+            current = &threads[next->id];
+            return;
+        }
+        SchedEntity* next = levels.pickNext();
+        current = next ? &threads[next->id] : nullptr;
+    }
+
+    std::vector<SimThread>& threads;
+    DeadlineRunQueue deadlines;
+    CpuRunQueue levels;
+    SimThread* current = nullptr;
+};
+
+struct ThreadResult {
+    double missRate;
+    uint64_t p50, p99, worst; // Response times, us
+    double cpuShare;
+};
+
+// Steps one CPU in 10 us increments with a 1 ms scheduler tick
+class FrameSimulator {
+public:
+    static constexpr uint64_t STEP = 10 * US;
+    static constexpr uint64_t TICK = 1 * MS;
+
+    FrameSimulator(std::vector<SimThread>& threads, uint32_t seed) : threads(threads), rng(seed) {}
+
+    std::vector<ThreadResult> run(SimPolicy& policy, uint64_t duration, const DeadlinePolicy* timers = nullptr) {
+        for (uint64_t now = 0; now < duration; now += STEP) {
+            for (auto& thread : threads) release(thread, now, policy);
+            if (now % TICK == 0 || (timers && timers->nextEvent() <= now)) policy.tick(now);
+            if (SimThread* thread = policy.running()) execute(*thread, now + STEP, policy);
+        }
+        std::vector<ThreadResult> results;
+        for (auto& thread : threads) {
+            ThreadResult result{};
+            for (auto& job : thread.jobs) {
+                if (duration - job.release > thread.deadline) thread.missed++; // Never finished
+            }
+            size_t due = thread.completed + thread.jobs.size();
+            result.missRate = due ? double(thread.missed) / due : 0;
+            auto& times = thread.responseTimes;
+            std::sort(times.begin(), times.end());
+            if (!times.empty()) {
+                result.p50 = times[times.size() / 2] / US;
+                result.p99 = times[times.size() * 99 / 100] / US;
+                result.worst = times.back() / US;
+            }
+            result.cpuShare = double(thread.cpuTime) / duration;
+            results.push_back(result);
+        }
+        return results;
+    }
+
+private:
+    void release(SimThread& thread, uint64_t now, SimPolicy& policy) {
+        if (now < thread.nextRelease) return;
+        thread.nextRelease += thread.period;
+        uint64_t work = thread.workMin + rng() % (thread.workMax - thread.workMin + 1);
+        if (thread.spikeEvery && ++thread.released % thread.spikeEvery == 0) work = thread.spikeWork;
+        thread.jobs.push_back({now, work});
+        if (thread.jobs.size() == 1) policy.wake(&thread, now);
+    }
+
+    void execute(SimThread& thread, uint64_t end, SimPolicy& policy) {
+        SimThread::Job& job = thread.jobs.front();
+        uint64_t ran = std::min(job.work, STEP);
+        job.work -= ran;
+        thread.cpuTime += ran;
+        if (job.work) return;
+        uint64_t response = end - job.release;
+        thread.responseTimes.push_back(response);
+        if (response > thread.deadline) thread.missed++;
+        thread.completed++;
+        thread.jobs.pop_front();
+        if (thread.jobs.empty()) policy.block(&thread, end);
+    }
+
+    std::vector<SimThread>& threads;
+    std::mt19937 rng;
+};
+
+} // namespace
+
+class DeadlineRunQueuePerformanceTest : public ::testing::Test {
+protected:
+    static constexpr uint64_t FRAME = 16667 * US; // 60 fps
+
+    // A game's render and audio threads next to a shader compiler that
+    // also looks like a game thread to the old guess, boosted above both,
+    // and batch work. The render thread hitches every 40th frame, past
+    // its reservation.
+    static std::vector<SimThread> makeGameLoad() {
+        std::vector<SimThread> threads;
+        threads.push_back(makeThread("render", 14, {10 * MS, FRAME, FRAME}, FRAME, FRAME, 5 * MS, 7 * MS, 40, 14 * MS));
+        threads.push_back(makeThread("audio", 12, {1 * MS, 5 * MS, 5 * MS}, 5 * MS, 5 * MS, 500 * US, 900 * US));
+        threads.push_back(makeThread("compiler", 15, {}, 100 * MS, UINT64_MAX, 30 * MS, 50 * MS));
+        for (int i = 0; i < 3; i++) {
+            threads.push_back(makeThread("batch", 4, {}, 20 * MS, UINT64_MAX, 20 * MS, 20 * MS));
+        }
+        return threads;
+    }
+
+    // The workload description; run state starts value-initialized
+    static SimThread makeThread(const char* name, uint32_t priority, DeadlineParams reserve, uint64_t period,
+                                uint64_t deadline, uint64_t workMin, uint64_t workMax,
+                                size_t spikeEvery = 0, uint64_t spikeWork = 0) {
+        SimThread thread{};
+        thread.name = name;
+        thread.priority = priority;
+        thread.reserve = reserve;
+        thread.period = period;
+        thread.deadline = deadline;
+        thread.workMin = workMin;
+        thread.workMax = workMax;
+        thread.spikeEvery = spikeEvery;
+        thread.spikeWork = spikeWork;
+        return thread;
+    }
+
+    static void report(const char* policy, const std::vector<SimThread>& threads,
+                       const std::vector<ThreadResult>& results) {
+        std::cout << std::fixed << std::setprecision(2);
+        for (size_t i = 0; i < 2; i++) {
+            const ThreadResult& result = results[i];
+            std::cout << policy << " " << std::setw(6) << threads[i].name << ": missed " << std::setw(6)
+                      << result.missRate * 100 << "%, response p50/p99/max " << result.p50 << "/" << result.p99 << "/"
+                      << result.worst << " us, CPU " << result.cpuShare * 100 << "%" << std::endl;
+        }
+        double background = 0;
+        for (size_t i = 2; i < results.size(); i++) background += results[i].cpuShare;
+        std::cout << policy << " background CPU " << background * 100 << "%" << std::endl;
+    }
+};
+
+// Ten simulated seconds of the game load: the deadline class meets every
+// audio deadline and every render frame that fits its budget, where the
+// priority boosts let the compiler starve both and render hitches starve
+// audio
+TEST_F(DeadlineRunQueuePerformanceTest, DeadlineMissesUnderBackgroundLoad) {
+    constexpr uint64_t DURATION = 10000 * MS;
+
+    auto boostThreads = makeGameLoad();
+    PriorityBoostPolicy boost(boostThreads);
+    auto before = FrameSimulator(boostThreads, 5).run(boost, DURATION);
+    report("priority boost", boostThreads, before);
+
+    auto deadlineThreads = makeGameLoad();
+    DeadlinePolicy deadline(deadlineThreads);
+    auto after = FrameSimulator(deadlineThreads, 5).run(deadline, DURATION, &deadline);
+    report("deadline class", deadlineThreads, after);
+    auto stats = deadline.stats();
+    std::cout << "deadline class throttled " << stats.throttles << " times" << std::endl;
+
+    const ThreadResult& render = after[0];
+    const ThreadResult& audio = after[1];
+    EXPECT_EQ(audio.missRate, 0.0);
+    EXPECT_LT(audio.worst, 5000u);
+    EXPECT_LT(audio.p99, before[1].p99);
+    EXPECT_LT(audio.missRate + 0.05, before[1].missRate);
+    // Only the hitch frames, which ask for more than the reservation, may miss
+    EXPECT_LE(render.missRate, 1.5 / 40);
+    EXPECT_LT(render.missRate, before[0].missRate);
+    EXPECT_LT(render.p99, before[0].p99);
+    EXPECT_GT(stats.throttles, 0u);
+    // Background threads keep what the deadline threads leave
+    double background = 0;
+    for (size_t i = 2; i < after.size(); i++) background += after[i].cpuShare;
+    EXPECT_GT(background, 0.3);
+}
+
+// A deadline thread that never blocks gets its reservation and no more
+TEST_F(DeadlineRunQueuePerformanceTest, ThrottlingCapsARunawayThread) {
+    std::vector<SimThread> threads;
+    threads.push_back(makeThread("runaway", 0, {2 * MS, 10 * MS, 10 * MS}, 10000 * MS, UINT64_MAX, 10000 * MS, 10000 * MS));
+    threads.push_back(makeThread("batch", 4, {}, 10000 * MS, UINT64_MAX, 10000 * MS, 10000 * MS));
+    DeadlinePolicy policy(threads);
+    auto results = FrameSimulator(threads, 1).run(policy, 2000 * MS, &policy);
+    std::cout << "Runaway deadline thread reserved 20%: got " << results[0].cpuShare * 100 << "%, batch "
+              << results[1].cpuShare * 100 << "%" << std::endl;
+    EXPECT_NEAR(results[0].cpuShare, 0.2, 0.01);
+    EXPECT_NEAR(results[1].cpuShare, 0.8, 0.01);
+}
+
+} // namespace Test
+} // namespace Kernel
@@ -0,0 +1,46 @@
+#include "../../gtest/gtest.h"
+#include "../../scheduler/DeadlineRunQueue.hpp"
+#include <cstdint>
+
+namespace Kernel {
+namespace Test {
+
+class DeadlineRunQueueTest : public ::testing::Test {
+protected:
+    static constexpr uint64_t MS = 1000 * 1000;
+    static constexpr uint64_t FRAME = 16667 * 1000; // 60 fps
+};
+
+TEST_F(DeadlineRunQueueTest, AdmissionControl) {
+    DeadlineRunQueue queue(0.95);
+    DeadlineEntity render, audio, extra, bad;
+    EXPECT_EQ(queue.admit(&render, {10 * MS, FRAME, FRAME}), Admission::Admitted);
+    EXPECT_EQ(queue.admit(&audio, {1 * MS, 5 * MS, 5 * MS}), Admission::Admitted);
+    // 0.6 + 0.2 reserved; another 0.3 would pass the 0.95 cap
+    EXPECT_EQ(queue.admit(&extra, {3 * MS, 10 * MS, 10 * MS}), Admission::OverCapacity);
+    EXPECT_EQ(extra.bandwidth, 0u);
+    EXPECT_EQ(queue.admit(&extra, {1 * MS, 10 * MS, 10 * MS}), Admission::Admitted);
+
+    EXPECT_EQ(queue.admit(&bad, {0, 5 * MS, 5 * MS}), Admission::InvalidParameters);
+    EXPECT_EQ(queue.admit(&bad, {6 * MS, 5 * MS, 5 * MS}), Admission::InvalidParameters);
+    EXPECT_EQ(queue.admit(&bad, {1 * MS, 6 * MS, 5 * MS}), Admission::InvalidParameters);
+
+    // Constrained deadlines are admitted on density: 1 ms within 2 ms is half a CPU
+    EXPECT_EQ(queue.admit(&bad, {1 * MS, 2 * MS, 20 * MS}), Admission::OverCapacity);
+
+    // Shrinking a reservation or releasing one makes room
+    EXPECT_EQ(queue.admit(&render, {5 * MS, FRAME, FRAME}), Admission::Admitted);
+    queue.release(&extra, 0);
+    EXPECT_EQ(queue.admit(&bad, {1 * MS, 4 * MS, 20 * MS}), Admission::Admitted);
+    EXPECT_LE(queue.reservedBandwidth(), uint64_t(0.95 * DeadlineRunQueue::BANDWIDTH_UNIT));
+
+    // Earliest deadline runs first
+    queue.wake(&render, 0);
+    queue.wake(&audio, 0);
+    EXPECT_EQ(queue.pickNext(0), &audio);
+    queue.block(&audio, 1 * MS);
+    EXPECT_EQ(queue.pickNext(1 * MS), &render);
+}
+
+} // namespace Test
+} // namespace Kernel
@@ -0,0 +1,210 @@
+#include "../../gtest/gtest.h"
+#include "../../scheduler/FairRunQueue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+// The old CFSPlusPlus::updateStats: every quantum walks every process to
+// bump vruntime, and with keys changed in place the tree order is gone,
+// so finding the leftmost means another walk
+class LegacyFairQueue {
+public:
+    struct Process {
+        uint64_t vruntime;
+        uint32_t weight;
+    };
+
+    explicit LegacyFairQueue(std::vector<Process> processes) : processes(std::move(processes)) {}
+
+    size_t tickAndPick(size_t running, uint64_t tick) {
+        for (size_t i = 0; i < processes.size(); i++) {
+            if (i == running) processes[i].vruntime += tick * NICE_0_WEIGHT / processes[i].weight;
+        }
+        size_t best = 0;
+        for (size_t i = 1; i < processes.size(); i++) {
+            if (processes[i].vruntime < processes[best].vruntime) best = i;
+        }
+        return best;
+    }
+
+private:
+    std::vector<Process> processes;
+};
+
+class FairRunQueuePerformanceTest : public ::testing::Test {
+protected:
+    static constexpr uint64_t MS = 1000000;
+    static constexpr uint64_t TICK = 1 * MS; // HZ=1000
+
+    // Drives a queue with a periodic tick on a single simulated CPU, every
+    // task CPU bound. Records each stretch a task runs without a switch.
+    struct Simulator {
+        FairRunQueue& queue;
+        uint64_t now = 0;
+        uint64_t stretchStart = 0;
+        std::vector<std::pair<const FairEntity*, uint64_t>> stretches; // Task, ns run
+        bool recordStretches = false;
+
+        explicit Simulator(FairRunQueue& queue) : queue(queue) {}
+
+        void switchTo() {
+            const FairEntity* previous = queue.current();
+            const FairEntity* next = queue.pickNext(now);
+            if (recordStretches && previous && next != previous) stretches.push_back({previous, now - stretchStart});
+            if (next != previous) stretchStart = now;
+        }
+
+        void run(uint64_t duration) {
+            if (!queue.current()) switchTo();
+            for (uint64_t end = now + duration; now < end;) {
+                now += TICK;
+                if (queue.tickPreempts(now)) switchTo();
+            }
+        }
+
+        void wake(FairEntity* entity, FairRunQueue::Placement placement) {
+            queue.enqueue(entity, now, placement);
+            if (queue.wakeupPreempts(*entity)) switchTo();
+        }
+    };
+};
+
+// 10k CPU-bound tasks at three nice levels share one CPU for fifty
+// minutes of simulated time: each class gets CPU in proportion to its
+// weight, and no task's vruntime drifts more than a few ticks from the rest
+TEST_F(FairRunQueuePerformanceTest, FairnessAtTenThousandTasks) {
+    constexpr size_t TASKS = 10000;
+    constexpr uint64_t DURATION = 3000000 * MS;
+    const int nices[] = {-5, 0, 5};
+
+    FairRunQueue queue;
+    std::vector<FairEntity> tasks(TASKS);
+    for (size_t i = 0; i < TASKS; i++) {
+        tasks[i].weight = weightForNice(nices[i % 3]);
+        queue.enqueue(&tasks[i], 0, FairRunQueue::Placement::New);
+    }
+    uint64_t startVruntime = queue.minVruntime();
+    Simulator sim(queue);
+    auto start = std::chrono::steady_clock::now();
+    sim.run(DURATION);
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    double classRuntime[3] = {}, classWeight[3] = {};
+    double jainSum = 0, jainSquares = 0, worst = 0;
+    uint64_t lowest = UINT64_MAX, highest = 0;
+    for (size_t i = 0; i < TASKS; i++) {
+        double share = double(tasks[i].sumExecRuntime) / (double(DURATION) * tasks[i].weight / queue.load());
+        classRuntime[i % 3] += tasks[i].sumExecRuntime;
+        classWeight[i % 3] += tasks[i].weight;
+        jainSum += share;
+        jainSquares += share * share;
+        worst = std::max(worst, std::abs(share - 1));
+        lowest = std::min(lowest, tasks[i].vruntime);
+        highest = std::max(highest, tasks[i].vruntime);
+    }
+    double jain = jainSum * jainSum / (TASKS * jainSquares);
+    uint64_t progress = queue.minVruntime() - startVruntime;
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << TASKS << " tasks, " << DURATION / MS / 1000 << " s simulated in " << wallMs << " ms: Jain index "
+              << jain << ", worst task " << worst * 100 << "% off its share" << std::endl;
+    for (int c = 0; c < 3; c++) {
+        double share = classRuntime[c] / DURATION, ideal = classWeight[c] / queue.load();
+        std::cout << "  nice " << std::setw(2) << nices[c] << ": " << share * 100 << "% of CPU, weight share "
+                  << ideal * 100 << "%" << std::endl;
+        EXPECT_NEAR(share / ideal, 1.0, 0.02) << "nice " << nices[c];
+    }
+    std::cout << "  vruntime spread " << (highest - lowest) / 1000 << " us over " << progress / 1000
+              << " us of progress" << std::endl;
+
+    EXPECT_GT(jain, 0.99);
+    // The lightest task's vruntime moves 1024/335 ms per tick; every task
+    // sits within a couple of such steps of the floor
+    EXPECT_LT(highest - lowest, 2 * TICK * NICE_0_WEIGHT / weightForNice(5) + TICK);
+}
+
+// A task waking from a long sleep runs at once but gets at most half the
+// latency target of credit; keeping its old vruntime would let it
+// monopolize the CPU for as long as it slept
+TEST_F(FairRunQueuePerformanceTest, SleeperFairness) {
+    for (auto placement : {FairRunQueue::Placement::Requeue, FairRunQueue::Placement::Wakeup}) {
+        FairRunQueue queue;
+        FairEntity hogs[2], sleeper;
+        for (auto& hog : hogs) queue.enqueue(&hog, 0, FairRunQueue::Placement::New);
+        queue.enqueue(&sleeper, 0, FairRunQueue::Placement::New);
+        queue.dequeue(&sleeper, 0); // Goes to sleep before it runs
+
+        Simulator sim(queue);
+        sim.run(1000 * MS);
+        sim.recordStretches = true;
+        sim.wake(&sleeper, placement);
+        EXPECT_EQ(queue.current(), &sleeper); // Wakeup preemption
+        sim.run(1000 * MS);
+
+        uint64_t firstStretch = 0;
+        for (auto [task, ran] : sim.stretches) {
+            if (task == &sleeper) {
+                firstStretch = ran;
+                break;
+            }
+        }
+        bool capped = placement == FairRunQueue::Placement::Wakeup;
+        std::cout << (capped ? "Capped sleeper credit" : "Kept old vruntime    ") << ": first run after waking "
+                  << firstStretch / MS << " ms, " << sleeper.sumExecRuntime / MS << " of 1000 ms in total" << std::endl;
+        if (capped) {
+            EXPECT_LE(firstStretch, 6 * MS);
+            EXPECT_NEAR(double(sleeper.sumExecRuntime) / (1000 * MS), 1.0 / 3, 0.02);
+        } else {
+            EXPECT_GT(firstStretch, 400 * MS);
+        }
+    }
+}
+
+// Cost of one tick plus pick with 10k runnable tasks: the old walk over
+// every process against lazy accrual and the cached leftmost node
+TEST_F(FairRunQueuePerformanceTest, SchedulingOverhead) {
+    constexpr size_t TASKS = 10000;
+    constexpr size_t DECISIONS = 20000;
+    std::mt19937 rng(11);
+    std::vector<LegacyFairQueue::Process> processes(TASKS);
+    std::vector<FairEntity> entities(TASKS);
+    for (size_t i = 0; i < TASKS; i++) {
+        uint32_t weight = weightForNice(static_cast<int>(rng() % 11) - 5);
+        processes[i] = {0, weight};
+        entities[i].weight = weight;
+    }
+
+    LegacyFairQueue legacy(processes);
+    size_t running = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < DECISIONS; i++) running = legacy.tickAndPick(running, TICK);
+    double legacyNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / DECISIONS;
+
+    FairRunQueue queue;
+    for (auto& entity : entities) queue.enqueue(&entity, 0, FairRunQueue::Placement::New);
+    uint64_t now = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < DECISIONS; i++) {
+        now += TICK;
+        queue.tickPreempts(now);
+        queue.pickNext(now);
+    }
+    double treeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / DECISIONS;
+
+    std::cout << "Tick + pick among " << TASKS << " tasks: per-quantum walk " << legacyNs << " ns, vruntime tree "
+              << treeNs << " ns" << std::endl;
+    EXPECT_LT(treeNs * 20, legacyNs);
+    EXPECT_EQ(queue.size(), TASKS); // Queued plus the running one
+}
+
+} // namespace Test
+} // namespace Kernel
@@ -0,0 +1,83 @@
+#include "../../gtest/gtest.h"
+#include "../../scheduler/FairRunQueue.hpp"
+#include <cstdint>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+class FairRunQueueTest : public ::testing::Test {
+protected:
+    // Red-black invariants and key order below node; returns the black
+    // height, or -1 on a violation
+    static int checkSubtree(const FairEntity* node, const FairEntity* parent, size_t& count) {
+        if (!node) return 1;
+        if (node->parent != parent) return -1;
+        if (node->red && ((node->left && node->left->red) || (node->right && node->right->red))) return -1;
+        if (node->left && node->left->vruntime > node->vruntime) return -1;
+        if (node->right && node->right->vruntime < node->vruntime) return -1;
+        int left = checkSubtree(node->left, node, count);
+        int right = checkSubtree(node->right, node, count);
+        if (left < 0 || left != right) return -1;
+        count++;
+        return left + (node->red ? 0 : 1);
+    }
+
+    // Checks the whole tree from the leftmost node; returns its node count
+    static size_t checkTree(const FairRunQueue& queue) {
+        const FairEntity* root = queue.leftmost();
+        if (!root) return 0;
+        while (root->parent) root = root->parent;
+        EXPECT_FALSE(root->red);
+        size_t count = 0;
+        EXPECT_GT(checkSubtree(root, nullptr, count), 0);
+        return count;
+    }
+};
+
+// Random enqueues and dequeues, including equal keys, against std::multiset
+TEST_F(FairRunQueueTest, TreeStaysBalancedAndOrdered) {
+    constexpr size_t TASKS = 4000;
+    std::vector<FairEntity> entities(TASKS);
+    std::multiset<std::pair<uint64_t, const FairEntity*>> expected;
+    std::mt19937 rng(23);
+    FairRunQueue queue;
+
+    for (size_t round = 0; round < 20000; round++) {
+        FairEntity& entity = entities[rng() % TASKS];
+        if (entity.onRunQueue) {
+            expected.erase({entity.vruntime, &entity});
+            queue.dequeue(&entity, 0);
+        } else {
+            entity.vruntime = rng() % 512; // Plenty of ties
+            queue.enqueue(&entity, 0, FairRunQueue::Placement::Requeue);
+            expected.insert({entity.vruntime, &entity});
+        }
+        if (round % 997 == 0) {
+            ASSERT_EQ(checkTree(queue), expected.size());
+            if (!expected.empty()) {
+                EXPECT_EQ(queue.leftmost()->vruntime, expected.begin()->first);
+            }
+        }
+    }
+    ASSERT_EQ(checkTree(queue), expected.size());
+
+    // Draining yields non-decreasing vruntime
+    uint64_t last = 0;
+    for (size_t left = expected.size(); left > 0; left--) {
+        FairEntity* next = queue.pickNext(0);
+        ASSERT_NE(next, nullptr);
+        EXPECT_GE(next->vruntime, last);
+        last = next->vruntime;
+        queue.dequeue(next, 0);
+    }
+    EXPECT_EQ(queue.pickNext(0), nullptr);
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_EQ(queue.load(), 0u);
+}
+
+} // namespace Test
+} // namespace Kernel
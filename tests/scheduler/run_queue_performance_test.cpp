@@ -0,0 +1,398 @@
+#include "../../gtest/gtest.h"
+#include "../../scheduler/RunQueue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+// Simulation helpers are file-local: other test files have their own
+namespace {
+
+// A thread in the arrival trace: it arrives, then alternates CPU bursts
+// and sleeps until its work runs out
+struct TraceThread {
+    uint64_t arrival;  // us
+    uint8_t level;
+    uint64_t burstMin, burstMax;
+    uint64_t sleepMin, sleepMax;
+    size_t bursts;
+};
+
+// Interactive threads (short bursts, frequent sleeps, high level) mixed
+// with batch threads (long bursts, short sleeps), arriving over the first
+// 100 ms. Six threads per core ask for about twice the cores' capacity,
+// so queues build and balancing matters.
+inline std::vector<TraceThread> makeTrace(size_t cores, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<TraceThread> trace;
+    for (size_t i = 0; i < cores * 6; i++) {
+        bool interactive = i % 3 != 0;
+        TraceThread thread{};
+        thread.arrival = rng() % 100000;
+        if (interactive) {
+            thread = {thread.arrival, 40, 50, 400, 1000, 4000, 400};
+        } else {
+            thread = {thread.arrival, 10, 2000, 8000, 200, 2000, 120};
+        }
+        trace.push_back(thread);
+    }
+    return trace;
+}
+
+// What the simulator asks of a scheduling policy
+class SimPolicy {
+public:
+    virtual ~SimPolicy() = default;
+    // A thread became runnable; returns the CPU it was queued for, or -1
+    virtual int wake(SchedEntity* entity) = 0;
+    // Next thread for an idle or preempting cpu
+    virtual SchedEntity* pick(int cpu) = 0;
+    // Highest level waiting for cpu, for tick and wake-up preemption
+    virtual int waitingLevel(int cpu) = 0;
+    virtual void requeue(SchedEntity* entity, int cpu) = 0;
+    virtual void setIdle(int cpu) = 0;
+};
+
+// The old EnhancedScheduler: one global ready list scanned linearly for
+// the highest level on every pick, with no notion of where a thread ran
+class GlobalQueuePolicy : public SimPolicy {
+public:
+    explicit GlobalQueuePolicy(size_t cores) : idle(cores, true) {}
+
+    int wake(SchedEntity* entity) override {
+        ready.push_back(entity);
+        if (entity->lastCpu >= 0 && idle[entity->lastCpu]) return entity->lastCpu;
+        for (size_t cpu = 0; cpu < idle.size(); cpu++) {
+            if (idle[cpu]) return static_cast<int>(cpu);
+        }
+        return -1;
+    }
+
+    SchedEntity* pick(int cpu) override {
+        auto best = ready.end();
+        for (auto it = ready.begin(); it != ready.end(); ++it) {
+            if (best == ready.end() || (*it)->level > (*best)->level) best = it;
+        }
+        if (best == ready.end()) {
+            idle[cpu] = true;
+            return nullptr;
+        }
+        SchedEntity* entity = *best;
+        ready.erase(best);
+        idle[cpu] = false;
+        return entity;
+    }
+
+    int waitingLevel(int) override {
+        int level = -1;
+        for (SchedEntity* entity : ready) level = std::max(level, int(entity->level));
+        return level;
+    }
+
+    void requeue(SchedEntity* entity, int) override { ready.push_back(entity); }
+    void setIdle(int cpu) override { idle[cpu] = true; }
+
+private:
+    std::vector<SchedEntity*> ready;
+    std::vector<bool> idle;
+};
+
+class PerCpuPolicy : public SimPolicy {
+public:
+    PerCpuPolicy(size_t cores, size_t coresPerLlc) : queues(cores, coresPerLlc) {}
+
+    int wake(SchedEntity* entity) override {
+        int cpu = queues.selectCpu(*entity);
+        queues.enqueue(entity, cpu);
+        return cpu;
+    }
+
+    SchedEntity* pick(int cpu) override { return queues.pickNext(cpu); }
+    int waitingLevel(int cpu) override { return queues.highestWaitingLevel(cpu); }
+    void requeue(SchedEntity* entity, int cpu) override { queues.enqueue(entity, cpu); }
+    void setIdle(int cpu) override { queues.setIdle(cpu, true); }
+
+    RunQueueSet::Stats stats() const { return queues.getStats(); }
+
+private:
+    RunQueueSet queues;
+};
+
+struct SimResult {
+    uint64_t contextSwitches = 0;
+    uint64_t migrations = 0;      // Ran on a different CPU than last time
+    uint64_t llcMigrations = 0;   // ... in a different cache domain
+    double wakeP50 = 0, wakeP99 = 0, wakeP999 = 0; // us
+    double utilization = 0;       // Useful work / core time, over the steady-state window
+};
+
+// Discrete-event replay of a trace on simulated cores, 1 us resolution.
+// A context switch costs 2 us; a migration costs a cache refill, 10 us
+// within a cache domain and 40 us across.
+class SchedulerSimulator {
+public:
+    static constexpr uint64_t SLICE = 1000;
+    static constexpr uint64_t SWITCH_COST = 2;
+    static constexpr uint64_t LOCAL_MIGRATION_COST = 10;
+    static constexpr uint64_t REMOTE_MIGRATION_COST = 40;
+    // Every thread has arrived and none has run out of work
+    static constexpr uint64_t WINDOW_START = 100000;
+    static constexpr uint64_t WINDOW_END = 700000;
+
+    // Each thread draws its bursts and sleeps from its own stream, so
+    // every policy replays exactly the same work
+    SchedulerSimulator(size_t cores, size_t coresPerLlc, std::vector<TraceThread> trace, uint32_t seed)
+        : cores(cores), coresPerLlc(coresPerLlc), trace(std::move(trace)), seed(seed), running(cores), sliceEnd(cores, 0),
+          burstEnd(cores, 0), previous(cores, nullptr) {}
+
+    SimResult run(SimPolicy& policy) {
+        threads.assign(trace.size(), Thread{});
+        for (size_t i = 0; i < trace.size(); i++) {
+            threads[i].entity.id = static_cast<uint32_t>(i);
+            threads[i].entity.level = trace[i].level;
+            threads[i].remainingBursts = trace[i].bursts;
+            threads[i].rng.seed(seed * 1000003u + static_cast<uint32_t>(i));
+            push(trace[i].arrival, Event::WAKE, static_cast<int>(i));
+        }
+
+        std::vector<uint64_t> wakeLatency;
+        SimResult result;
+        while (!events.empty()) {
+            Event event = events.top();
+            events.pop();
+            now = event.time;
+
+            if (event.kind == Event::WAKE) {
+                Thread& thread = threads[event.target];
+                thread.wokenAt = now;
+                thread.waitingSinceWake = true;
+                thread.remaining = uniform(thread, trace[event.target].burstMin, trace[event.target].burstMax);
+                int cpu = policy.wake(&thread.entity);
+                if (cpu >= 0) {
+                    if (!running[cpu]) {
+                        dispatch(policy, cpu, result, wakeLatency);
+                    } else if (thread.entity.level > running[cpu]->level && policy.waitingLevel(cpu) > running[cpu]->level) {
+                        preempt(policy, cpu, result, wakeLatency);
+                    }
+                    balance(policy, cpu, result, wakeLatency);
+                }
+            } else if (event.kind == Event::TICK) {
+                int cpu = event.target;
+                if (!running[cpu] || sliceEnd[cpu] != now) continue; // Stale
+                if (policy.waitingLevel(cpu) >= running[cpu]->level) {
+                    preempt(policy, cpu, result, wakeLatency);
+                } else {
+                    armTimer(cpu, now);
+                }
+                balance(policy, cpu, result, wakeLatency);
+            } else {
+                int cpu = event.target;
+                if (!running[cpu] || burstEnd[cpu] != now) continue; // Stale
+                Thread& thread = threads[running[cpu]->id];
+                accountRun(thread);
+                thread.remaining = 0;
+                running[cpu] = nullptr;
+                if (--thread.remainingBursts > 0) {
+                    const TraceThread& spec = trace[thread.entity.id];
+                    push(now + uniform(thread, spec.sleepMin, spec.sleepMax), Event::WAKE, static_cast<int>(thread.entity.id));
+                }
+                policy.setIdle(cpu);
+                dispatch(policy, cpu, result, wakeLatency);
+            }
+        }
+
+        std::sort(wakeLatency.begin(), wakeLatency.end());
+        auto percentile = [&](double p) { return double(wakeLatency[size_t(p * (wakeLatency.size() - 1))]); };
+        result.wakeP50 = percentile(0.5);
+        result.wakeP99 = percentile(0.99);
+        result.wakeP999 = percentile(0.999);
+        result.utilization = double(usefulWork) / (double(cores) * double(WINDOW_END - WINDOW_START));
+        return result;
+    }
+
+private:
+    struct Event {
+        enum Kind { WAKE, TICK, BURST_DONE };
+        uint64_t time;
+        uint64_t sequence;
+        Kind kind;
+        int target;
+        bool operator>(const Event& other) const {
+            return time != other.time ? time > other.time : sequence > other.sequence;
+        }
+    };
+
+    struct Thread {
+        SchedEntity entity;
+        uint64_t remaining = 0; // Work left in the current burst
+        uint64_t startedAt = 0;
+        uint64_t wokenAt = 0;
+        size_t remainingBursts = 0;
+        int ranOn = -1;
+        bool waitingSinceWake = true;
+        std::mt19937 rng;
+    };
+
+    static uint64_t uniform(Thread& thread, uint64_t low, uint64_t high) { return low + thread.rng() % (high - low + 1); }
+
+    // Useful work of the run segment ending now, clipped to the window
+    void accountRun(const Thread& thread) {
+        uint64_t start = std::max(thread.startedAt, WINDOW_START);
+        uint64_t end = std::min(now, WINDOW_END);
+        if (end > start) usefulWork += end - start;
+    }
+
+    void push(uint64_t time, Event::Kind kind, int target) { events.push({time, sequence++, kind, target}); }
+
+    void dispatch(SimPolicy& policy, int cpu, SimResult& result, std::vector<uint64_t>& wakeLatency) {
+        SchedEntity* entity = policy.pick(cpu);
+        if (!entity) return;
+        Thread& thread = threads[entity->id];
+        uint64_t cost = 0;
+        if (previous[cpu] != entity) {
+            result.contextSwitches++;
+            cost += SWITCH_COST;
+        }
+        if (thread.ranOn >= 0 && thread.ranOn != cpu) {
+            result.migrations++;
+            bool remote = size_t(thread.ranOn) / coresPerLlc != size_t(cpu) / coresPerLlc;
+            result.llcMigrations += remote;
+            cost += remote ? REMOTE_MIGRATION_COST : LOCAL_MIGRATION_COST;
+        }
+        if (thread.waitingSinceWake) {
+            wakeLatency.push_back(now - thread.wokenAt);
+            thread.waitingSinceWake = false;
+        }
+        thread.ranOn = cpu;
+        thread.startedAt = now + cost;
+        entity->lastCpu = cpu;
+        running[cpu] = entity;
+        previous[cpu] = entity;
+        burstEnd[cpu] = now + cost + thread.remaining;
+        armTimer(cpu, now + cost);
+    }
+
+    // The burst ends within this slice, or the slice tick comes first
+    void armTimer(int cpu, uint64_t sliceStart) {
+        if (burstEnd[cpu] <= sliceStart + SLICE) {
+            sliceEnd[cpu] = 0;
+            push(burstEnd[cpu], Event::BURST_DONE, cpu);
+        } else {
+            sliceEnd[cpu] = sliceStart + SLICE;
+            push(sliceEnd[cpu], Event::TICK, cpu);
+        }
+    }
+
+    // Idle balancing: while threads wait on cpu, idle CPUs pick (and so
+    // steal), nearest cache domain first
+    void balance(SimPolicy& policy, int cpu, SimResult& result, std::vector<uint64_t>& wakeLatency) {
+        size_t domain = size_t(cpu) / coresPerLlc;
+        for (size_t pass = 0; pass < 2; pass++) {
+            for (size_t other = 0; other < cores; other++) {
+                if (running[other] || (size_t(other) / coresPerLlc == domain) != (pass == 0)) continue;
+                if (policy.waitingLevel(cpu) < 0) return;
+                dispatch(policy, static_cast<int>(other), result, wakeLatency);
+                if (!running[other]) return; // Nothing it could take
+            }
+        }
+    }
+
+    void preempt(SimPolicy& policy, int cpu, SimResult& result, std::vector<uint64_t>& wakeLatency) {
+        Thread& thread = threads[running[cpu]->id];
+        uint64_t ran = now > thread.startedAt ? now - thread.startedAt : 0;
+        accountRun(thread);
+        thread.remaining -= std::min(thread.remaining, ran);
+        SchedEntity* entity = running[cpu];
+        running[cpu] = nullptr;
+        burstEnd[cpu] = 0;
+        sliceEnd[cpu] = 0;
+        policy.requeue(entity, cpu);
+        dispatch(policy, cpu, result, wakeLatency);
+    }
+
+    const size_t cores;
+    const size_t coresPerLlc;
+    std::vector<TraceThread> trace;
+    const uint32_t seed;
+    std::vector<Thread> threads;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    std::vector<SchedEntity*> running;
+    std::vector<uint64_t> sliceEnd, burstEnd;
+    std::vector<SchedEntity*> previous;
+    uint64_t now = 0, sequence = 0, usefulWork = 0;
+};
+
+} // namespace
+
+class RunQueuePerformanceTest : public ::testing::Test {
+protected:
+    static constexpr size_t CORES_PER_LLC = 8;
+};
+
+TEST_F(RunQueuePerformanceTest, TraceReplayAcrossCoreCounts) {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "cores policy    switches migrations cross-LLC  wake p50/p99/p999 (us)  utilization" << std::endl;
+    for (size_t cores : {1, 2, 4, 8, 16, 32, 64, 128}) {
+        auto trace = makeTrace(cores, static_cast<uint32_t>(cores));
+        size_t llc = std::min(cores, CORES_PER_LLC);
+
+        GlobalQueuePolicy global(cores);
+        SimResult before = SchedulerSimulator(cores, llc, trace, 1).run(global);
+        PerCpuPolicy perCpu(cores, llc);
+        SimResult after = SchedulerSimulator(cores, llc, trace, 1).run(perCpu);
+
+        for (auto [name, result] : {std::pair<const char*, SimResult&>{"global ", before}, {"per-cpu", after}}) {
+            std::cout << std::setw(5) << cores << " " << name << " " << std::setw(9) << result.contextSwitches << " "
+                      << std::setw(10) << result.migrations << " " << std::setw(9) << result.llcMigrations << "  "
+                      << std::setw(6) << result.wakeP50 << "/" << result.wakeP99 << "/" << result.wakeP999 << "  "
+                      << std::setw(10) << result.utilization << std::endl;
+        }
+        auto stats = perCpu.stats();
+        std::cout << "      steals " << stats.steals << " in-LLC, " << stats.remoteSteals << " cross-LLC" << std::endl;
+
+        if (cores >= 4) {
+            EXPECT_LT(after.migrations, before.migrations) << cores << " cores";
+            EXPECT_LT(after.llcMigrations, before.llcMigrations + 1) << cores << " cores";
+            EXPECT_GT(after.utilization, before.utilization * 0.95) << cores << " cores";
+        }
+    }
+}
+
+// Cost of one enqueue + pick with 10k runnable threads: the old linear
+// scan against the bitmap-indexed per-CPU queue
+TEST_F(RunQueuePerformanceTest, PickNextCost) {
+    constexpr size_t THREADS = 10000;
+    constexpr size_t PICKS = 20000;
+    std::vector<SchedEntity> entities(THREADS);
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < THREADS; i++) {
+        entities[i].id = static_cast<uint32_t>(i);
+        entities[i].level = static_cast<uint8_t>(rng() % RUNQUEUE_LEVELS);
+    }
+
+    GlobalQueuePolicy global(1);
+    for (auto& entity : entities) global.requeue(&entity, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < PICKS; i++) global.requeue(global.pick(0), 0);
+    double scanNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / PICKS;
+
+    RunQueueSet queues(1, 1);
+    for (auto& entity : entities) queues.enqueue(&entity, 0);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < PICKS; i++) queues.enqueue(queues.pickNext(0), 0);
+    double queueNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / PICKS;
+
+    std::cout << "Pick + requeue among " << THREADS << " threads: linear scan " << scanNs << " ns, per-CPU queue "
+              << queueNs << " ns" << std::endl;
+    EXPECT_LT(queueNs * 20, scanNs);
+}
+
+} // namespace Test
+} // namespace Kernel
@@ -0,0 +1,52 @@
+#include "../../gtest/gtest.h"
+#include "../../scheduler/RunQueue.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+TEST(RunQueueTest, StealPrefersSameCache) {
+    RunQueueSet queues(16, 8);
+    std::vector<SchedEntity> entities(4);
+    for (size_t i = 0; i < entities.size(); i++) {
+        entities[i].id = static_cast<uint32_t>(i);
+        entities[i].level = static_cast<uint8_t>(10 + i);
+    }
+    queues.setIdle(1, false);
+    queues.setIdle(9, false);
+    queues.enqueue(&entities[0], 1);
+    queues.enqueue(&entities[1], 1);
+    queues.enqueue(&entities[2], 9);
+    queues.enqueue(&entities[3], 9);
+
+    // CPU 2 shares a cache with 1: it takes 1's best thread
+    SchedEntity* stolen = queues.pickNext(2);
+    ASSERT_NE(stolen, nullptr);
+    EXPECT_EQ(stolen->id, 1u);
+    EXPECT_EQ(stolen->lastCpu, 2);
+    EXPECT_EQ(queues.getStats().steals, 1u);
+
+    // Nothing left near CPU 0 but one thread: it still prefers 1 over 9
+    EXPECT_EQ(queues.pickNext(0)->id, 0u);
+    // Then crosses to the other domain
+    EXPECT_EQ(queues.pickNext(3)->id, 3u);
+    EXPECT_EQ(queues.getStats().remoteSteals, 1u);
+
+    // Wake-up placement returns to an idle previous CPU, else an idle one sharing its cache
+    SchedEntity waking;
+    waking.lastCpu = 4;
+    EXPECT_EQ(queues.selectCpu(waking), 4);
+    queues.setIdle(4, false);
+    int chosen = queues.selectCpu(waking);
+    EXPECT_LT(chosen, 8);
+    EXPECT_NE(chosen, 4);
+
+    // Dequeue follows a thread wherever it is queued
+    EXPECT_TRUE(queues.dequeue(&entities[2]));
+    EXPECT_FALSE(queues.dequeue(&entities[2]));
+    EXPECT_EQ(queues.load(9), 0u);
+}
+
+} // namespace Test
+} // namespace Kernel
@@ -0,0 +1,114 @@
+#include "../../gtest/gtest.h"
+#include "../../scheduler/CpuTopology.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace Kernel {
+namespace Test {
+
+class ThreadPlacementPerformanceTest : public ::testing::Test {
+protected:
+#ifdef __linux__
+    static void pin(int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    // Round trip of one cache line bounced between threads on two CPUs
+    static double pingPongNs(int cpuA, int cpuB, size_t rounds) {
+        cpu_set_t saved;
+        pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved);
+        alignas(64) std::atomic<uint64_t> ball{0};
+        auto await = [&ball](uint64_t value) {
+            for (unsigned spins = 0; ball.load(std::memory_order_acquire) != value; spins++) {
+                if (spins > 1000) std::this_thread::yield(); // Same CPU: let the other side run
+            }
+        };
+        std::thread partner([&] {
+            pin(cpuB);
+            for (uint64_t i = 1; i <= rounds; i++) {
+                await(2 * i - 1);
+                ball.store(2 * i, std::memory_order_release);
+            }
+        });
+        pin(cpuA);
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 1; i <= rounds; i++) {
+            ball.store(2 * i - 1, std::memory_order_release);
+            await(2 * i);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+        partner.join();
+        pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+        return ns;
+    }
+#endif
+};
+
+// Cache-line round trip for each kind of CPU pair this machine has. The
+// placement policy's choice for a communicating pair is the same-L3,
+// separate-core one.
+TEST_F(ThreadPlacementPerformanceTest, PingPongLatencyPerPlacement) {
+#ifdef __linux__
+    constexpr size_t ROUNDS = 20000;
+    CpuTopology topology = CpuTopology::detect();
+    ThreadPlacement placement(topology);
+    std::vector<int> chosen = placement.placeCommunicating(2);
+
+    int smt[2] = {-1, -1}, sameLlc[2] = {-1, -1}, crossLlc[2] = {-1, -1};
+    for (size_t a = 0; a < topology.cpuCount(); a++) {
+        for (size_t b = a + 1; b < topology.cpuCount(); b++) {
+            int x = int(a), y = int(b);
+            if (!topology.isOnline(x) || !topology.isOnline(y)) continue;
+            int* slot = topology.sharesCore(x, y) ? smt : topology.sharesLlc(x, y) ? sameLlc : crossLlc;
+            if (slot[0] < 0) {
+                slot[0] = x;
+                slot[1] = y;
+            }
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    double results[3] = {};
+    const char* names[] = {"SMT siblings        ", "same L3, two cores  ", "different L3        "};
+    int* pairs[] = {smt, sameLlc, crossLlc};
+    for (int kind = 0; kind < 3; kind++) {
+        if (pairs[kind][0] < 0) {
+            std::cout << names[kind] << ": not on this machine" << std::endl;
+            continue;
+        }
+        results[kind] = pingPongNs(pairs[kind][0], pairs[kind][1], ROUNDS);
+        std::cout << names[kind] << ": CPUs " << pairs[kind][0] << "/" << pairs[kind][1] << " round trip "
+                  << results[kind] << " ns" << std::endl;
+    }
+    if (chosen.size() == 2 && chosen[0] != chosen[1]) {
+        std::cout << "Placement for a communicating pair: CPUs " << chosen[0] << "/" << chosen[1] << std::endl;
+        if (sameLlc[0] >= 0) {
+            EXPECT_TRUE(topology.sharesLlc(chosen[0], chosen[1]));
+            EXPECT_FALSE(topology.sharesCore(chosen[0], chosen[1]));
+        }
+    } else {
+        std::cout << "Single CPU: every placement shares it" << std::endl;
+    }
+    // Timings are reported, not asserted: on a loaded machine the cross-L3
+    // pair can come out ahead
+    if (sameLlc[0] >= 0 && crossLlc[0] >= 0) {
+        std::cout << "Cross-L3 / same-L3 round trip: " << results[2] / results[1] << "x" << std::endl;
+    }
+#endif
+}
+
+} // namespace Test
+} // namespace Kernel
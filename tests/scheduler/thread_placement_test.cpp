@@ -0,0 +1,102 @@
+#include "../../gtest/gtest.h"
+#include "../../scheduler/CpuTopology.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace Kernel {
+namespace Test {
+
+class ThreadPlacementTest : public ::testing::Test {
+protected:
+    // 4 SMT performance cores (CPUs 0-7) and 8 efficiency cores (8-15)
+    // behind one L3, as on a hybrid desktop part
+    static CpuTopology hybridTopology() {
+        std::vector<LogicalCpu> cpus;
+        for (uint32_t cpu = 0; cpu < 16; cpu++) {
+            bool performance = cpu < 8;
+            cpus.push_back({performance ? cpu / 2 : cpu, 0, 0, performance ? CPU_CAPACITY_MAX : EFFICIENCY_CORE_CAPACITY, true});
+        }
+        return CpuTopology(cpus);
+    }
+};
+
+// Two CCXs of 4 cores with 2 threads each
+TEST_F(ThreadPlacementTest, PlacementByRole) {
+    CpuTopology topology(1, 2, 4, 2);
+    ASSERT_EQ(topology.cpuCount(), 16u);
+
+    // Two communicating groups of four: each fills one CCX, one thread per core
+    ThreadPlacement groups(topology);
+    for (int group = 0; group < 2; group++) {
+        std::vector<int> cpus = groups.placeCommunicating(4);
+        ASSERT_EQ(cpus.size(), 4u);
+        std::set<uint32_t> cores, llcs;
+        for (int cpu : cpus) {
+            cores.insert(topology.cpu(cpu).core);
+            llcs.insert(topology.cpu(cpu).llc);
+        }
+        EXPECT_EQ(cores.size(), 4u);
+        EXPECT_EQ(llcs.size(), 1u);
+        EXPECT_EQ(*llcs.begin(), uint32_t(group));
+    }
+
+    // Latency-critical threads get whole cores, in different CCXs;
+    // throughput work stays off their siblings even once it has to double up
+    ThreadPlacement mixed(topology);
+    int first = mixed.placeLatencyCritical();
+    int second = mixed.placeLatencyCritical();
+    EXPECT_FALSE(topology.sharesCore(first, second));
+    EXPECT_FALSE(topology.sharesLlc(first, second));
+    std::vector<int> workers = mixed.placeThroughput(14);
+    std::set<int> firstTwelve(workers.begin(), workers.begin() + 12);
+    EXPECT_EQ(firstTwelve.size(), 12u);
+    std::set<uint32_t> firstSix;
+    size_t perLlc[2] = {};
+    for (size_t i = 0; i < workers.size(); i++) {
+        const LogicalCpu& cpu = topology.cpu(workers[i]);
+        EXPECT_FALSE(topology.sharesCore(workers[i], first) || topology.sharesCore(workers[i], second)) << "worker " << i;
+        if (i < 6) {
+            firstSix.insert(cpu.core);
+            perLlc[cpu.llc]++;
+        }
+    }
+    EXPECT_EQ(firstSix.size(), 6u); // One per free core before any sibling
+    EXPECT_EQ(perLlc[0], 3u);       // Alternating caches
+    EXPECT_EQ(perLlc[1], 3u);
+
+    // Releasing a latency-critical thread frees its core for sharing
+    mixed.release(first);
+    for (int worker : workers) mixed.release(worker);
+    std::vector<int> spread = mixed.placeThroughput(7);
+    EXPECT_EQ(std::count_if(spread.begin(), spread.end(), [&](int cpu) { return topology.sharesCore(cpu, second); }), 0);
+    EXPECT_EQ(std::count_if(spread.begin(), spread.end(), [&](int cpu) { return topology.sharesCore(cpu, first); }), 1);
+}
+
+TEST_F(ThreadPlacementTest, HybridPrefersPerformanceCores) {
+    CpuTopology topology = hybridTopology();
+    EXPECT_TRUE(topology.isHybrid());
+    EXPECT_EQ(topology.coreCount(), 12u);
+
+    ThreadPlacement placement(topology);
+    int critical = placement.placeLatencyCritical();
+    EXPECT_EQ(topology.cpu(critical).capacity, CPU_CAPACITY_MAX);
+
+    // Throughput: the three free performance cores, then efficiency
+    // cores, and only then performance-core siblings
+    std::vector<int> workers = placement.placeThroughput(12);
+    for (size_t i = 0; i < workers.size(); i++) {
+        const LogicalCpu& cpu = topology.cpu(workers[i]);
+        if (i < 3) {
+            EXPECT_EQ(cpu.capacity, CPU_CAPACITY_MAX) << "worker " << i;
+        } else if (i < 11) {
+            EXPECT_EQ(cpu.capacity, EFFICIENCY_CORE_CAPACITY) << "worker " << i;
+        }
+        EXPECT_FALSE(topology.sharesCore(workers[i], critical)) << "worker " << i;
+    }
+    EXPECT_EQ(ThreadPlacement::affinityMask({0, 3, 63}), (1ULL << 0) | (1ULL << 3) | (1ULL << 63));
+}
+
+} // namespace Test
+} // namespace Kernel